@@ -4,6 +4,7 @@ Deepgram Live Transcription Service
 Provides real-time speech-to-text transcription using Deepgram's WebSocket API.
 """
 import asyncio
+import json
 import logging
 from typing import Optional, Callable, Dict, Any
 from deepgram import DeepgramClient, LiveTranscriptionEvents, LiveOptions
@@ -11,6 +12,59 @@ from deepgram import DeepgramClient, LiveTranscriptionEvents, LiveOptions
 logger = logging.getLogger(__name__)
 
 
+def segment_from_result(
+    result: Dict[str, Any],
+    meeting_id: str,
+    segment_number: int,
+    model: str = "nova-2",
+    language: str = "de",
+) -> Optional[Dict[str, Any]]:
+    """
+    Build a transcript segment from a raw Deepgram Results message.
+
+    Used for the results the Zoom Bot relays when it streams to Deepgram itself. Those
+    carry `stream_offset`, the seconds of audio before the connection they came from,
+    which is added to the word times so they stay on the meeting's timeline across
+    reconnects.
+
+    Returns None for messages without a transcript.
+    """
+    if result.get("type", "Results") != "Results":
+        return None
+
+    alternatives = (result.get("channel") or {}).get("alternatives") or []
+    if not alternatives:
+        return None
+
+    transcript = alternatives[0].get("transcript", "")
+    if not transcript.strip():
+        return None
+
+    offset = result.get("stream_offset", 0.0)
+    return {
+        "meeting_id": meeting_id,
+        "segment_number": segment_number,
+        "transcript": transcript,
+        "is_final": result.get("is_final", False),
+        "speech_final": result.get("speech_final", False),
+        "confidence": alternatives[0].get("confidence"),
+        "words": [
+            {
+                "word": w.get("word"),
+                "start": w.get("start", 0.0) + offset,
+                "end": w.get("end", 0.0) + offset,
+                "confidence": w.get("confidence")
+            }
+            for w in alternatives[0].get("words", [])
+        ],
+        "context": {
+            "source": "deepgram",
+            "model": model,
+            "language": language
+        }
+    }
+
+
 class DeepgramTranscriptionService:
     """
     Real-time transcription service using Deepgram's Live API.
@@ -127,6 +181,25 @@ class DeepgramTranscriptionService:
             logger.error(f"Error sending audio to Deepgram: {e}")
             return False
 
+    async def keep_alive(self) -> bool:
+        """
+        Keep the connection open while the bot suppresses silence.
+
+        Deepgram closes live connections that receive no data for about 10 seconds.
+
+        Returns:
+            True if sent successfully, False otherwise
+        """
+        if not self.is_connected or not self.connection:
+            return False
+
+        try:
+            self.connection.send(json.dumps({"type": "KeepAlive"}))
+            return True
+        except Exception as e:
+            logger.error(f"Error sending keepalive to Deepgram: {e}")
+            return False
+
     async def disconnect(self):
         """Disconnect from Deepgram."""
         if self.connection:
@@ -5,13 +5,37 @@ Connects to the Unix socket created by the Zoom Meeting SDK Bot
 and forwards audio data to Deepgram for live transcription.
 """
 import asyncio
+import json
 import logging
 import os
 import socket
 import struct
-from typing import Optional, Callable, Dict, Any
-
-from .deepgram_service import DeepgramTranscriptionService
+import time
+from typing import Optional, Callable, Dict, Any, List, Tuple
+
+from .deepgram_service import DeepgramTranscriptionService, segment_from_result
+from .zoom_bot_protocol import (
+    FLAG_END_OF_STREAM,
+    FLAG_SILENCE,
+    FLAG_SPEECH_END,
+    FLAG_SPEECH_START,
+    HELLO_FRAMED,
+    HELLO_PARTICIPANTS,
+    HELLO_TRANSCRIPT,
+    HELLO_TRANSCRIPT_PARTICIPANTS,
+    PayloadFormat,
+    SHM_REPLY,
+    Frame,
+    FrameReader,
+    ProtocolError,
+    ShmReader,
+    Speaker,
+    StreamStats,
+    StreamType,
+    parse_speakers,
+    shm_hello,
+    speakers_hello,
+)
 
 logger = logging.getLogger(__name__)
 
@@ -29,6 +53,9 @@ def convert_audio_for_deepgram(
     Zoom SDK outputs: 32kHz, mono, 16-bit PCM
     Deepgram expects: 16kHz, mono, 16-bit PCM (linear16)
 
+    When the bot runs with `RawAudio --output-rate 16000` it already resamples
+    and downmixes natively, and the audio is passed through untouched.
+
     Args:
         audio_data: Raw PCM audio bytes (16-bit samples)
         input_sample_rate: Source sample rate (default 32000 for Zoom)
@@ -42,6 +69,10 @@ def convert_audio_for_deepgram(
     if not audio_data:
         return audio_data
 
+    # Bot already delivers Deepgram-ready linear16
+    if input_sample_rate == output_sample_rate and input_channels == output_channels:
+        return audio_data
+
     # Parse 16-bit samples
     num_samples = len(audio_data) // 2
     samples = struct.unpack(f'<{num_samples}h', audio_data)
@@ -82,6 +113,12 @@ class ZoomBotAudioService:
         deepgram_api_key: Optional[str] = None,
         on_transcript: Optional[Callable[[Dict[str, Any]], None]] = None,
         on_status_change: Optional[Callable[[str], None]] = None,
+        bot_sample_rate: int = 32000,
+        use_framing: bool = True,
+        on_participant_audio: Optional[Callable[[int, bytes, int, int], None]] = None,
+        use_shm: bool = False,
+        native_transcription: bool = False,
+        on_speakers: Optional[Callable[[List[Speaker]], None]] = None,
     ):
         """
         Initialize the Zoom Bot Audio Service.
@@ -91,13 +128,42 @@ class ZoomBotAudioService:
             deepgram_api_key: API key for Deepgram
             on_transcript: Callback for transcript segments
             on_status_change: Callback for status changes
+            bot_sample_rate: Sample rate the bot writes to the socket in raw mode
+                (16000 when started with `RawAudio --output-rate 16000`)
+            use_framing: Negotiate the framed protocol, which carries the sample
+                rate, sequence number and capture time of every chunk
+            on_participant_audio: Callback for per-participant audio as
+                (node_id, pcm, sample_rate, channels); needs framing and a bot
+                started with `RawAudio --stream-participants`; with use_shm the
+                pcm is a memoryview that is only valid during the call
+            use_shm: Read the framed audio from a shared memory ring the bot hands
+                over on the socket, which saves the socket copies when both run on
+                the same host; falls back to the socket if the bot has no ring
+            native_transcription: The bot streams to Deepgram itself (started with
+                `RawAudio --deepgram`); only its transcript frames are read then,
+                which needs framing
+            on_speakers: Callback for the list of active speakers whenever it
+                changes; needs framing and a bot started with
+                `RawAudio --stream-speakers`
         """
         self.socket_path = socket_path
+        self.bot_sample_rate = bot_sample_rate
+        self.use_framing = use_framing
+        self.use_shm = use_shm
+        self.native_transcription = native_transcription and use_framing
+        self.on_participant_audio = on_participant_audio
+        self.on_speakers = on_speakers
+        self.stream_stats: Dict[Tuple[int, int], StreamStats] = {}
+        self.frames_received = 0
+        self.encoded_warned = False
+        self.shm_eventfd = -1
         self.deepgram_api_key = deepgram_api_key or os.getenv("DEEPGRAM_API_KEY")
         self.on_transcript = on_transcript
         self.on_status_change = on_status_change
 
         self.deepgram_service: Optional[DeepgramTranscriptionService] = None
+        self.native_segments = 0
+        self.native_transcript: List[str] = []
         self.client_socket: Optional[socket.socket] = None
         self.is_running = False
         self.is_connected = False
@@ -121,6 +187,17 @@ class ZoomBotAudioService:
         self.current_meeting_id = meeting_id
 
         try:
+            if self.native_transcription:
+                # the bot holds the Deepgram connection, transcripts arrive on the socket
+                self.native_segments = 0
+                self.native_transcript = []
+                self.is_running = True
+                self._connect_task = asyncio.create_task(self._connect_loop())
+
+                logger.info(f"Zoom Bot Audio Service started for meeting {meeting_id}, bot transcribes")
+                self._notify_status("running")
+                return True
+
             # Initialize Deepgram connection
             if not self.deepgram_api_key:
                 logger.error("Deepgram API key not configured")
@@ -185,7 +262,24 @@ class ZoomBotAudioService:
                     retry_delay = 1  # Reset retry delay on successful connection
 
                     # Receive audio data
-                    await self._receive_audio_loop()
+                    if self.use_framing:
+                        if self.native_transcription:
+                            hello = HELLO_TRANSCRIPT_PARTICIPANTS if self.on_participant_audio else HELLO_TRANSCRIPT
+                        else:
+                            hello = HELLO_PARTICIPANTS if self.on_participant_audio else HELLO_FRAMED
+                        if self.on_speakers:
+                            hello = speakers_hello(hello)
+                        if self.use_shm:
+                            hello = shm_hello(hello)
+                        await loop.sock_sendall(self.client_socket, hello)
+
+                        shm, initial = await self._accept_shm() if self.use_shm else (None, b"")
+                        if shm:
+                            await self._receive_shm_loop(shm)
+                        else:
+                            await self._receive_framed_loop(initial)
+                    else:
+                        await self._receive_audio_loop()
 
                 except ConnectionRefusedError:
                     logger.debug(f"Connection refused, Zoom Bot not ready yet")
@@ -236,8 +330,8 @@ class ZoomBotAudioService:
                     if chunks_received == 1 or chunks_received % 100 == 0:
                         logger.info(f"Received audio chunk #{chunks_received}: {len(data)} bytes (total: {bytes_received} bytes)")
 
-                    # Convert audio from Zoom format (32kHz stereo) to Deepgram format (16kHz mono)
-                    converted_data = convert_audio_for_deepgram(data)
+                    # Convert audio from Zoom format (32kHz mono) to Deepgram format (16kHz mono)
+                    converted_data = convert_audio_for_deepgram(data, input_sample_rate=self.bot_sample_rate)
 
                     # Forward to Deepgram
                     if self.deepgram_service and self.deepgram_service.is_connected:
@@ -254,6 +348,246 @@ class ZoomBotAudioService:
         finally:
             self.is_connected = False
 
+    async def _receive_framed_loop(self, initial: bytes = b""):
+        """Receive framed audio in large batches and forward the mixed stream to Deepgram."""
+        loop = asyncio.get_event_loop()
+        reader = FrameReader()
+        self.stream_stats = {}
+        self.frames_received = 0
+
+        # bytes that arrived while waiting for a shared memory ring the bot did not offer
+        if initial:
+            reader.writable()[:len(initial)] = initial
+            reader.commit(len(initial))
+            await self._handle_frames(reader.frames())
+
+        try:
+            while self.is_running and self.client_socket:
+                try:
+                    # one recv can deliver many frames
+                    count = await loop.sock_recv_into(self.client_socket, reader.writable())
+                    if not count:
+                        self._on_bot_disconnected()
+                        break
+
+                    reader.commit(count)
+                    await self._handle_frames(reader.frames())
+
+                except asyncio.CancelledError:
+                    break
+                except ProtocolError as e:
+                    logger.error(f"Invalid frame from Zoom Bot: {e}")
+                    break
+                except Exception as e:
+                    logger.error(f"Error receiving audio: {e}")
+                    break
+
+        finally:
+            self.is_connected = False
+
+    async def _accept_shm(self) -> Tuple[Optional[ShmReader], bytes]:
+        """
+        Wait for the bot's answer to `transport=shm`.
+
+        Returns the reader of the ring it handed over, or None and whatever framed audio
+        arrived instead when the bot could not set one up.
+        """
+        loop = asyncio.get_event_loop()
+        sock = self.client_socket
+
+        while True:
+            readable = loop.create_future()
+            loop.add_reader(sock.fileno(), lambda: readable.done() or readable.set_result(None))
+            try:
+                await readable
+            finally:
+                loop.remove_reader(sock.fileno())
+
+            try:
+                data, fds, _, _ = socket.recv_fds(sock, 4096, 2)
+            except BlockingIOError:
+                continue
+            break
+
+        if data.startswith(SHM_REPLY) and len(fds) == 2:
+            size = int(data[len(SHM_REPLY):data.index(b"\n")])
+            memfd, self.shm_eventfd = fds
+            logger.info(f"Reading Zoom Bot audio from {size // 1024}KiB of shared memory")
+            return ShmReader(memfd, size), b""
+
+        for fd in fds:
+            os.close(fd)
+        logger.warning("Zoom Bot did not offer shared memory, reading audio from the socket")
+        return None, data
+
+    async def _receive_shm_loop(self, shm: ShmReader):
+        """Forward frames from the shared memory ring; the socket only tells when the bot goes."""
+        loop = asyncio.get_event_loop()
+        sock = self.client_socket
+        eventfd = self.shm_eventfd
+        wake = asyncio.Event()
+        self.stream_stats = {}
+        self.frames_received = 0
+
+        loop.add_reader(eventfd, wake.set)
+        loop.add_reader(sock.fileno(), wake.set)
+
+        try:
+            while self.is_running and self.client_socket:
+                await wake.wait()
+                wake.clear()
+
+                # reset the eventfd before reading head, so a later write wakes us again
+                try:
+                    os.read(eventfd, 8)
+                except BlockingIOError:
+                    pass
+
+                try:
+                    if not sock.recv(4096):
+                        self._on_bot_disconnected()
+                        break
+                except BlockingIOError:
+                    pass
+
+                try:
+                    await self._handle_frames(shm.frames())
+                    shm.release()
+                except ProtocolError as e:
+                    logger.error(f"Invalid frame in Zoom Bot shared memory: {e}")
+                    break
+
+        except asyncio.CancelledError:
+            pass
+        finally:
+            loop.remove_reader(eventfd)
+            loop.remove_reader(sock.fileno())
+            os.close(eventfd)
+            shm.close()
+            self.is_connected = False
+
+    async def _handle_frames(self, frames: List[Frame]):
+        """Track and forward one batch of frames; payloads are only used during the call."""
+        arrival_ns = time.monotonic_ns()
+
+        batch = []
+        keep_alive = False
+        for frame in frames:
+            if frame.flags & FLAG_END_OF_STREAM:
+                logger.info("Zoom Bot ended the audio stream, it is shutting down")
+                continue
+
+            if frame.stream == StreamType.TRANSCRIPT:
+                self._on_native_transcript(frame.payload)
+                continue
+
+            if frame.stream == StreamType.SPEAKERS:
+                self._on_speakers(frame.payload)
+                continue
+
+            key = (frame.stream, frame.node_id)
+            stats = self.stream_stats.setdefault(key, StreamStats())
+            stats.update(frame, arrival_ns)
+
+            self.frames_received += 1
+            if self.frames_received == 1 or self.frames_received % 1000 == 0:
+                logger.info(
+                    f"Received audio frame #{self.frames_received}: {frame.sample_rate}Hz/"
+                    f"{frame.channels}ch, {self._format_stats()}"
+                )
+
+            # encoded streams are meant for consumers with a decoder, not for this PCM path
+            if frame.format != PayloadFormat.LINEAR16:
+                if not self.encoded_warned:
+                    logger.warning(
+                        f"Zoom Bot sends audio in payload format {frame.format}, which is not "
+                        "forwarded; start the bot with `RawAudio --codec pcm` for this service"
+                    )
+                    self.encoded_warned = True
+                continue
+
+            if frame.stream == StreamType.ONE_WAY and self.on_participant_audio:
+                self.on_participant_audio(
+                    frame.node_id, frame.payload, frame.sample_rate, frame.channels
+                )
+                continue
+
+            if frame.stream != StreamType.MIXED:
+                continue
+
+            # markers from the bot's voice activity gate carry no audio
+            if not frame.payload:
+                if frame.flags & FLAG_SPEECH_START:
+                    logger.debug("Speech started")
+                if frame.flags & FLAG_SPEECH_END:
+                    logger.debug("Speech ended")
+                if frame.flags & FLAG_SILENCE:
+                    keep_alive = True
+                continue
+
+            batch.append(convert_audio_for_deepgram(
+                frame.payload,
+                input_sample_rate=frame.sample_rate or self.bot_sample_rate,
+                input_channels=frame.channels,
+            ))
+
+        if not batch:
+            if keep_alive and self.deepgram_service:
+                await self.deepgram_service.keep_alive()
+            return
+
+        # Forward to Deepgram
+        if self.deepgram_service and self.deepgram_service.is_connected:
+            await self.deepgram_service.send_audio(b"".join(batch))
+        else:
+            logger.warning("Cannot forward audio - Deepgram not connected")
+
+    def _on_native_transcript(self, payload):
+        """Hand a result the bot got from Deepgram to on_transcript like our own ones."""
+        try:
+            result = json.loads(bytes(payload))
+        except ValueError as e:
+            logger.error(f"Invalid transcript from Zoom Bot: {e}")
+            return
+
+        segment = segment_from_result(result, self.current_meeting_id, self.native_segments + 1)
+        if not segment:
+            return
+
+        self.native_segments += 1
+        if segment["is_final"]:
+            logger.info(f"[Deepgram via bot] Final: {segment['transcript']}")
+            self.native_transcript.append(segment["transcript"])
+
+        if self.on_transcript:
+            self.on_transcript(segment)
+
+    def _on_speakers(self, payload):
+        """Hand the active speakers the bot forwards audio of to on_speakers."""
+        try:
+            speakers = parse_speakers(payload)
+        except ProtocolError as e:
+            logger.error(f"Invalid speakers from Zoom Bot: {e}")
+            return
+
+        logger.debug(f"Active speakers: {', '.join(s.name or str(s.node_id) for s in speakers)}")
+        if self.on_speakers:
+            self.on_speakers(speakers)
+
+    def _on_bot_disconnected(self):
+        logger.info("Zoom Bot disconnected from audio socket")
+        logger.info(f"Total frames received: {self.frames_received}, {self._format_stats()}")
+        self.is_connected = False
+        self._notify_status("bot_disconnected")
+
+    def _format_stats(self) -> str:
+        """Summarize loss and jitter per stream."""
+        return ", ".join(
+            f"stream {stream}/{node}: {stats.frames} frames, {stats.lost} lost, "
+            f"{stats.jitter_ms:.1f}ms jitter"
+            for (stream, node), stats in self.stream_stats.items()
+        ) or "no frames"
+
     def _close_client_socket(self):
         """Close the client socket."""
         if self.client_socket:
@@ -311,6 +645,15 @@ class ZoomBotAudioService:
             "meeting_id": self.current_meeting_id,
             "socket_path": self.socket_path,
             "bot_connected": self.is_connected,
+            "streams": {
+                f"{stream}/{node}": {
+                    "frames": stats.frames,
+                    "lost": stats.lost,
+                    "jitter_ms": round(stats.jitter_ms, 2),
+                }
+                for (stream, node), stats in self.stream_stats.items()
+            },
+            "native_transcription": self.native_transcription,
             "deepgram_connected": (
                 self.deepgram_service.is_connected
                 if self.deepgram_service
@@ -325,6 +668,8 @@ class ZoomBotAudioService:
 
     def get_transcript(self) -> str:
         """Get the full transcript accumulated so far."""
+        if self.native_transcription:
+            return " ".join(self.native_transcript)
         if self.deepgram_service:
             return self.deepgram_service.get_full_transcript()
         return ""
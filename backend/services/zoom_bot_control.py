@@ -0,0 +1,337 @@
+"""
+Zoom Bot Control Protocol
+
+Client for the control socket of a Zoom Bot started with `--supervisor`, `--standby`
+or `--control`.
+
+Every message is a 12 byte little-endian header (u32 payload length, u16 opcode,
+u16 flags, u32 request id) followed by TLV fields (u16 type, u16 length, value);
+see zoom-bot/src/control/ControlMessage.h. Responses echo the opcode and request
+id of their request, events carry FLAG_EVENT and are never answered.
+"""
+import asyncio
+import logging
+import struct
+from dataclasses import dataclass, field
+from enum import IntEnum
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+CONTROL_HEADER = struct.Struct("<IHHI")
+FIELD_HEADER = struct.Struct("<HH")
+MAX_PAYLOAD = 64 * 1024
+
+FLAG_RESPONSE = 1
+FLAG_EVENT = 2
+
+
+class Opcode(IntEnum):
+    """Requests and events of the control protocol."""
+    PING = 0x0001
+    SPAWN = 0x0010
+    STOP = 0x0011
+    LIST = 0x0012
+    JOIN = 0x0020
+    LEAVE = 0x0021
+    STATUS = 0x0022
+    SET_AUDIO = 0x0023
+    SET_VIDEO = 0x0024
+    SET_AUDIO_MODE = 0x0025
+    SET_OUTPUT_RATE = 0x0026
+    METRICS = 0x0027
+    WORKER_STARTED = 0x0080
+    MEETING_STATUS = 0x0081
+    WORKER_EXITED = 0x0082
+    READY = 0x0083
+    FIRST_AUDIO = 0x0084
+    PARTICIPANT_JOINED = 0x0085
+    PARTICIPANT_LEFT = 0x0086
+    KEYWORD = 0x0087
+
+
+class Field(IntEnum):
+    """TLV field types."""
+    STATUS = 0x0001
+    MESSAGE = 0x0002
+    MEETING_ID = 0x0010
+    PASSWORD = 0x0011
+    DISPLAY_NAME = 0x0012
+    JOIN_URL = 0x0013
+    ZAK = 0x0014
+    JOIN_TOKEN = 0x0015
+    ON_BEHALF_TOKEN = 0x0016
+    WORKER_ID = 0x0020
+    PID = 0x0021
+    SOCKET_PATH = 0x0022
+    MEETING_STATUS = 0x0023
+    MEETING_RESULT = 0x0024
+    EXIT_CODE = 0x0025
+    SIGNAL = 0x0026
+    STARTUP_MS = 0x0027
+    JOIN_MS = 0x0028
+    FIRST_AUDIO_MS = 0x0029
+    ENABLED = 0x0030
+    AUDIO_MODE = 0x0031
+    SAMPLE_RATE = 0x0032
+    AUDIO = 0x0033
+    VIDEO = 0x0034
+    USER_ID = 0x0035
+    METRICS = 0x0036
+    KEYWORD = 0x0037
+    CONFIDENCE = 0x0038
+    LATENCY_MS = 0x0039
+
+
+class AudioMode(IntEnum):
+    """Values of the AUDIO_MODE field."""
+    MIXED = 0
+    PARTICIPANTS = 1
+    SPEAKERS = 2
+
+
+class ControlStatus(IntEnum):
+    """Result codes carried in the STATUS field of a response."""
+    OK = 0
+    BAD_REQUEST = 1
+    UNKNOWN_OPCODE = 2
+    NOT_FOUND = 3
+    BUSY = 4
+    FAILED = 5
+
+
+# fields decoded as integers, everything else is UTF-8 text
+UNSIGNED_FIELDS = {Field.STATUS, Field.WORKER_ID, Field.PID, Field.STARTUP_MS, Field.JOIN_MS, Field.FIRST_AUDIO_MS,
+                   Field.ENABLED, Field.AUDIO_MODE, Field.SAMPLE_RATE, Field.AUDIO, Field.VIDEO, Field.USER_ID,
+                   Field.CONFIDENCE, Field.LATENCY_MS}
+SIGNED_FIELDS = {Field.MEETING_STATUS, Field.MEETING_RESULT, Field.EXIT_CODE, Field.SIGNAL}
+
+
+class ControlError(Exception):
+    """Raised when a request fails or the control stream is corrupt."""
+
+
+@dataclass
+class ControlMessage:
+    """One control message with its fields in wire order."""
+    opcode: int
+    flags: int = 0
+    request_id: int = 0
+    fields: List[Tuple[int, Any]] = field(default_factory=list)
+
+    def get(self, key: Field, default: Any = None) -> Any:
+        """Return the first value of a field."""
+        for k, value in self.fields:
+            if k == key:
+                return value
+        return default
+
+    @property
+    def status(self) -> ControlStatus:
+        return ControlStatus(self.get(Field.STATUS, ControlStatus.FAILED))
+
+    def groups(self, first: Field) -> List[Dict[int, Any]]:
+        """Split repeated fields into one dict per group, each starting at `first`."""
+        groups: List[Dict[int, Any]] = []
+        for key, value in self.fields:
+            if key == first:
+                groups.append({})
+            if groups:
+                groups[-1][key] = value
+        return groups
+
+
+def encode_field(key: int, value: Any) -> bytes:
+    if key in UNSIGNED_FIELDS:
+        data = struct.pack("<I", value)
+    elif key in SIGNED_FIELDS:
+        data = struct.pack("<i", value)
+    elif isinstance(value, bytes):
+        data = value
+    else:
+        data = str(value).encode("utf-8")
+    return FIELD_HEADER.pack(key, len(data)) + data
+
+
+def encode(msg: ControlMessage) -> bytes:
+    payload = b"".join(encode_field(k, v) for k, v in msg.fields)
+    return CONTROL_HEADER.pack(len(payload), msg.opcode, msg.flags, msg.request_id) + payload
+
+
+def decode_fields(payload: bytes) -> List[Tuple[int, Any]]:
+    fields = []
+    pos = 0
+    while pos + FIELD_HEADER.size <= len(payload):
+        key, length = FIELD_HEADER.unpack_from(payload, pos)
+        pos += FIELD_HEADER.size
+        data = payload[pos:pos + length]
+        if len(data) != length:
+            raise ControlError("truncated control field")
+        pos += length
+
+        if key in UNSIGNED_FIELDS and length == 4:
+            value: Any = struct.unpack("<I", data)[0]
+        elif key in SIGNED_FIELDS and length == 4:
+            value = struct.unpack("<i", data)[0]
+        else:
+            value = data.decode("utf-8", errors="replace")
+        fields.append((key, value))
+    return fields
+
+
+def meeting_fields(join_url: Optional[str], meeting_id: Optional[str],
+                   password: Optional[str], display_name: Optional[str]) -> List[Tuple[int, Any]]:
+    fields: List[Tuple[int, Any]] = []
+    for key, value in ((Field.JOIN_URL, join_url), (Field.MEETING_ID, meeting_id),
+                       (Field.PASSWORD, password), (Field.DISPLAY_NAME, display_name)):
+        if value:
+            fields.append((key, value))
+    return fields
+
+
+class ControlClient:
+    """
+    Asyncio client for the bot's control socket.
+
+    Requests are matched to their responses by request id, so several can be in
+    flight at once; events are handed to `on_event` as they arrive.
+    """
+
+    def __init__(self, path: str, on_event: Optional[Callable[[ControlMessage], None]] = None):
+        self.path = path
+        self.on_event = on_event
+        self.reader: Optional[asyncio.StreamReader] = None
+        self.writer: Optional[asyncio.StreamWriter] = None
+        self.pending: Dict[int, asyncio.Future] = {}
+        self.next_id = 1
+        self.read_task: Optional[asyncio.Task] = None
+
+    async def connect(self):
+        self.reader, self.writer = await asyncio.open_unix_connection(self.path)
+        self.read_task = asyncio.create_task(self._read_loop())
+
+    async def close(self):
+        if self.read_task:
+            self.read_task.cancel()
+            self.read_task = None
+        if self.writer:
+            self.writer.close()
+            self.writer = None
+        self._fail_pending(ControlError("control connection closed"))
+
+    async def request(self, opcode: Opcode, fields: Optional[List[Tuple[int, Any]]] = None,
+                      timeout: float = 10.0) -> ControlMessage:
+        """Send a request and wait for its response."""
+        if not self.writer:
+            await self.connect()
+
+        request_id = self.next_id
+        self.next_id = (self.next_id + 1) & 0xFFFFFFFF or 1
+
+        future = asyncio.get_running_loop().create_future()
+        self.pending[request_id] = future
+
+        self.writer.write(encode(ControlMessage(opcode, 0, request_id, fields or [])))
+        await self.writer.drain()
+
+        try:
+            response = await asyncio.wait_for(future, timeout)
+        finally:
+            self.pending.pop(request_id, None)
+
+        if response.status != ControlStatus.OK:
+            raise ControlError(
+                f"{Opcode(opcode).name} failed: {response.status.name} {response.get(Field.MESSAGE, '')}".strip()
+            )
+        return response
+
+    async def spawn(self, join_url: Optional[str] = None, meeting_id: Optional[str] = None,
+                    password: Optional[str] = None, display_name: Optional[str] = None) -> Dict[str, Any]:
+        """Ask the supervisor for a worker in a meeting; returns its id, pid and socket path."""
+        fields = meeting_fields(join_url, meeting_id, password, display_name)
+        response = await self.request(Opcode.SPAWN, fields)
+        return {
+            "worker_id": response.get(Field.WORKER_ID),
+            "pid": response.get(Field.PID),
+            "socket_path": response.get(Field.SOCKET_PATH),
+        }
+
+    async def join(self, join_url: Optional[str] = None, meeting_id: Optional[str] = None,
+                   password: Optional[str] = None, display_name: Optional[str] = None):
+        """Ask a bot running with --standby to join a meeting."""
+        await self.request(Opcode.JOIN, meeting_fields(join_url, meeting_id, password, display_name))
+
+    async def stop(self, worker_id: int):
+        await self.request(Opcode.STOP, [(Field.WORKER_ID, worker_id)])
+
+    async def list(self) -> List[Dict[int, Any]]:
+        response = await self.request(Opcode.LIST)
+        return response.groups(Field.WORKER_ID)
+
+    # Meeting commands go to a bot's own control socket, or through the supervisor
+    # when `worker_id` names one of its workers.
+
+    async def leave(self, worker_id: Optional[int] = None):
+        await self.request(Opcode.LEAVE, self._worker(worker_id))
+
+    async def status(self, worker_id: Optional[int] = None) -> Dict[int, Any]:
+        """Return the meeting status, enabled streams, audio mode and output rate."""
+        response = await self.request(Opcode.STATUS, self._worker(worker_id))
+        return dict(response.fields)
+
+    async def set_audio(self, enabled: bool, worker_id: Optional[int] = None):
+        await self.request(Opcode.SET_AUDIO, self._worker(worker_id) + [(Field.ENABLED, int(enabled))])
+
+    async def set_video(self, enabled: bool, worker_id: Optional[int] = None):
+        await self.request(Opcode.SET_VIDEO, self._worker(worker_id) + [(Field.ENABLED, int(enabled))])
+
+    async def set_audio_mode(self, mode: AudioMode, worker_id: Optional[int] = None):
+        await self.request(Opcode.SET_AUDIO_MODE, self._worker(worker_id) + [(Field.AUDIO_MODE, int(mode))])
+
+    async def set_output_rate(self, rate: int, worker_id: Optional[int] = None):
+        """Resample socket audio to mono at `rate`, 0 keeps the SDK rate."""
+        await self.request(Opcode.SET_OUTPUT_RATE, self._worker(worker_id) + [(Field.SAMPLE_RATE, rate)])
+
+    async def metrics(self, worker_id: Optional[int] = None) -> str:
+        """Return the bot's counters and latency summaries in the Prometheus text format."""
+        response = await self.request(Opcode.METRICS, self._worker(worker_id))
+        return response.get(Field.METRICS, "")
+
+    @staticmethod
+    def _worker(worker_id: Optional[int]) -> List[Tuple[int, Any]]:
+        return [(Field.WORKER_ID, worker_id)] if worker_id is not None else []
+
+    async def _read_loop(self):
+        try:
+            while True:
+                header = await self.reader.readexactly(CONTROL_HEADER.size)
+                length, opcode, flags, request_id = CONTROL_HEADER.unpack(header)
+                if length > MAX_PAYLOAD:
+                    raise ControlError("control message too large")
+
+                payload = await self.reader.readexactly(length) if length else b""
+                msg = ControlMessage(opcode, flags, request_id, decode_fields(payload))
+
+                if flags & FLAG_EVENT:
+                    if self.on_event:
+                        try:
+                            self.on_event(msg)
+                        except Exception as e:
+                            logger.error(f"Error in control event callback: {e}")
+                    continue
+
+                future = self.pending.get(request_id)
+                if future and not future.done():
+                    future.set_result(msg)
+        except asyncio.CancelledError:
+            raise
+        except (asyncio.IncompleteReadError, ConnectionError, ControlError) as e:
+            logger.warning(f"Control connection lost: {e}")
+            self.writer = None
+            self._fail_pending(ControlError("control connection lost"))
+
+    def _fail_pending(self, error: Exception):
+        for future in self.pending.values():
+            if not future.done():
+                future.set_exception(error)
+        self.pending.clear()
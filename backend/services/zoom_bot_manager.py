@@ -14,6 +14,7 @@ from datetime import datetime
 from enum import Enum
 
 from .zoom_bot_audio_service import ZoomBotAudioService
+from .zoom_bot_control import ControlClient, ControlMessage, Field, Opcode
 
 logger = logging.getLogger(__name__)
 
@@ -41,6 +42,10 @@ class MeetingSession:
     transcript_segments: List[Dict[str, Any]] = field(default_factory=list)
     full_transcript: str = ""
     error_message: Optional[str] = None
+    worker_id: Optional[int] = None
+    socket_path: Optional[str] = None
+    join_ms: Optional[int] = None
+    first_audio_ms: Optional[int] = None
 
 
 class ZoomBotManager:
@@ -58,6 +63,7 @@ class ZoomBotManager:
         self,
         on_transcript: Optional[Callable[[Dict[str, Any]], None]] = None,
         on_status_change: Optional[Callable[[str, Dict[str, Any]], None]] = None,
+        on_keyword: Optional[Callable[[Dict[str, Any]], None]] = None,
         socket_path: str = "/tmp/meeting.sock",
     ):
         """
@@ -66,10 +72,12 @@ class ZoomBotManager:
         Args:
             on_transcript: Callback for new transcript segments
             on_status_change: Callback for bot status changes
+            on_keyword: Callback for keywords the bot's spotter heard, ahead of the transcript
             socket_path: Unix socket path for audio data
         """
         self.on_transcript = on_transcript
         self.on_status_change = on_status_change
+        self.on_keyword = on_keyword
         # Socket path must match C++ SocketServer: /tmp/audio/meeting.sock
         self.socket_path = "/tmp/audio/meeting.sock"
 
@@ -81,6 +89,17 @@ class ZoomBotManager:
         self.zoom_client_id = os.getenv("ZOOM_CLIENT_ID")
         self.zoom_client_secret = os.getenv("ZOOM_CLIENT_SECRET")
         self.deepgram_api_key = os.getenv("DEEPGRAM_API_KEY")
+        # Rate the bot writes to the socket, 16000 if it resamples natively (RawAudio --output-rate)
+        self.bot_output_rate = int(os.getenv("ZOOM_BOT_OUTPUT_RATE", "32000"))
+        # Framed socket protocol; set to 0 for bots that only speak raw PCM
+        self.bot_framing = os.getenv("ZOOM_BOT_FRAMING", "1") == "1"
+        # "shm" reads the framed audio from a shared memory ring when the bot runs on this host
+        self.bot_transport = os.getenv("ZOOM_BOT_AUDIO_TRANSPORT", "socket")
+        # "1" when the bot streams to Deepgram itself (RawAudio --deepgram) and relays transcripts
+        self.bot_native_deepgram = os.getenv("ZOOM_BOT_NATIVE_DEEPGRAM", "0") == "1"
+        # Control socket of a bot running with --supervisor; each meeting then gets its own worker
+        self.control_path = os.getenv("ZOOM_BOT_CONTROL_PATH")
+        self.control: Optional[ControlClient] = None
 
     async def join_meeting(
         self,
@@ -128,17 +147,44 @@ class ZoomBotManager:
         self._notify_status("starting")
 
         try:
-            # Start the audio service first (listens on socket)
+            socket_path = self.socket_path
+            if self.control_path:
+                # The supervisor forks a worker and tells us which socket it serves audio on
+                self.current_session.status = BotStatus.JOINING
+                self._notify_status("joining")
+
+                worker = await self._spawn_worker(join_url, display_name)
+                self.current_session.worker_id = worker["worker_id"]
+                socket_path = worker["socket_path"]
+                logger.info(f"Zoom Bot worker {worker['worker_id']} (pid {worker['pid']}) serving {socket_path}")
+
+            self.current_session.socket_path = socket_path
+
+            # Start the audio service (connects to the bot socket once it exists)
             self.audio_service = ZoomBotAudioService(
-                socket_path=self.socket_path,
+                socket_path=socket_path,
                 deepgram_api_key=self.deepgram_api_key,
                 on_transcript=self._handle_transcript,
                 on_status_change=self._handle_audio_status,
+                bot_sample_rate=self.bot_output_rate,
+                use_framing=self.bot_framing,
+                use_shm=self.bot_transport == "shm",
+                native_transcription=self.bot_native_deepgram,
             )
 
             if not await self.audio_service.start(meeting_id):
                 raise Exception("Failed to start audio service")
 
+            if self.control_path:
+                self.current_session.status = BotStatus.TRANSCRIBING
+                self._notify_status("transcribing")
+
+                return {
+                    "success": True,
+                    "message": "Bot joining meeting",
+                    "session": self._session_to_dict(self.current_session),
+                }
+
             # Start the Zoom Bot (in Docker or directly)
             self.current_session.status = BotStatus.JOINING
             self._notify_status("joining")
@@ -200,6 +246,12 @@ class ZoomBotManager:
                 await self.audio_service.stop()
                 self.audio_service = None
 
+            if self.control and self.current_session.worker_id is not None:
+                try:
+                    await self.control.stop(self.current_session.worker_id)
+                except Exception as stop_error:
+                    logger.warning(f"Failed to stop Zoom Bot worker: {stop_error}")
+
             return {
                 "success": False,
                 "error": str(e),
@@ -230,6 +282,10 @@ class ZoomBotManager:
                 await self.audio_service.stop()
                 self.audio_service = None
 
+            # Stop the supervisor worker serving this meeting
+            if self.control and self.current_session.worker_id is not None:
+                await self.control.stop(self.current_session.worker_id)
+
             # Stop bot process if running
             if self.bot_process:
                 self.bot_process.terminate()
@@ -256,6 +312,55 @@ class ZoomBotManager:
                 "error": str(e),
             }
 
+    async def _spawn_worker(self, join_url: str, display_name: str) -> Dict[str, Any]:
+        """Ask the bot supervisor for a worker in the meeting."""
+        if not self.control:
+            self.control = ControlClient(self.control_path, on_event=self._handle_control_event)
+        return await self.control.spawn(join_url=join_url, display_name=display_name)
+
+    def _handle_control_event(self, event: ControlMessage):
+        """Handle worker events relayed by the bot supervisor."""
+        session = self.current_session
+        worker_id = event.get(Field.WORKER_ID)
+        if not session or worker_id != session.worker_id:
+            return
+
+        if event.opcode == Opcode.WORKER_EXITED:
+            logger.info(f"Zoom Bot worker {worker_id} exited")
+            if session.status not in (BotStatus.LEAVING, BotStatus.STOPPED):
+                session.status = BotStatus.STOPPED
+                self._notify_status("stopped")
+        elif event.opcode == Opcode.MEETING_STATUS:
+            logger.info(f"Zoom Bot worker {worker_id} meeting status {event.get(Field.MEETING_STATUS)}")
+            if event.get(Field.JOIN_MS) is not None:
+                session.join_ms = event.get(Field.JOIN_MS)
+        elif event.opcode == Opcode.FIRST_AUDIO:
+            session.first_audio_ms = event.get(Field.FIRST_AUDIO_MS)
+            logger.info(f"Zoom Bot worker {worker_id} first audio after {session.first_audio_ms}ms")
+        elif event.opcode in (Opcode.PARTICIPANT_JOINED, Opcode.PARTICIPANT_LEFT):
+            users = [value for key, value in event.fields if key == Field.USER_ID]
+            action = "joined" if event.opcode == Opcode.PARTICIPANT_JOINED else "left"
+            logger.info(f"Zoom Bot worker {worker_id}: participants {users} {action}")
+        elif event.opcode == Opcode.KEYWORD:
+            self._handle_keyword({
+                "keyword": event.get(Field.KEYWORD),
+                "confidence": (event.get(Field.CONFIDENCE) or 0) / 1000,
+                "latency_ms": event.get(Field.LATENCY_MS),
+            })
+
+    def _handle_keyword(self, keyword: Dict[str, Any]):
+        """Forward a keyword the bot heard to the external callback."""
+        logger.info(f"Zoom Bot heard {keyword['keyword']!r} ({keyword['confidence']:.2f})")
+
+        if self.on_keyword:
+            try:
+                if asyncio.iscoroutinefunction(self.on_keyword):
+                    asyncio.create_task(self.on_keyword(keyword))
+                else:
+                    self.on_keyword(keyword)
+            except Exception as e:
+                logger.error(f"Error in keyword callback: {e}")
+
     def _handle_transcript(self, segment: Dict[str, Any]):
         """Handle incoming transcript segment."""
         if self.current_session:
@@ -304,6 +409,10 @@ class ZoomBotManager:
             "status": session.status.value,
             "transcript_segments_count": len(session.transcript_segments),
             "error_message": session.error_message,
+            "worker_id": session.worker_id,
+            "socket_path": session.socket_path,
+            "join_ms": session.join_ms,
+            "first_audio_ms": session.first_audio_ms,
         }
 
     def _extract_meeting_id(self, join_url: str) -> Optional[str]:
@@ -0,0 +1,298 @@
+"""
+Zoom Bot Socket Protocol
+
+Parser for the framed audio protocol spoken on the Zoom Bot's Unix socket.
+
+A client opts in by sending `SUB framing=1` right after connecting. Every chunk then
+arrives behind a fixed 40 byte little-endian header (see zoom-bot/src/util/FrameHeader.h).
+Clients that send nothing keep receiving raw PCM.
+
+Co-located clients can add `transport=shm` to get the same frames through a shared
+memory ring instead (see zoom-bot/src/util/ShmRing.h), read in place by `ShmReader`.
+
+A bot started with `RawAudio --deepgram` transcribes by itself and relays Deepgram's
+results as JSON frames on the transcript stream.
+
+A bot started with `RawAudio --stream-speakers` only sends the one-way audio of the active
+speakers and names them in JSON frames on the speakers stream, see `speakers_hello`.
+"""
+import json
+import mmap
+import os
+import struct
+from dataclasses import dataclass
+from enum import IntEnum
+from typing import List, Optional, Union
+
+
+FRAME_MAGIC = b"ZMAF"
+FRAME_VERSION = 1
+FRAME_HEADER = struct.Struct("<4sBBBBIIIIQQ")
+
+HELLO_FRAMED = b"SUB framing=1\n"
+HELLO_PARTICIPANTS = b"SUB framing=1 streams=mixed,one-way\n"
+HELLO_TRANSCRIPT = b"SUB framing=1 streams=transcript\n"
+HELLO_TRANSCRIPT_PARTICIPANTS = b"SUB framing=1 streams=transcript,one-way\n"
+
+SHM_MAGIC = b"ZMSR"
+SHM_PAD = b"ZPAD"
+SHM_VERSION = 1
+SHM_HEADER = struct.Struct("<4sIQQ")
+SHM_POSITION = struct.Struct("<Q")
+SHM_HEAD_OFFSET = 64
+SHM_TAIL_OFFSET = 128
+SHM_REPLY = b"SHM size="
+
+# flags bits; marker frames (speech start/end, silence keepalive) have no payload
+FLAG_DISCONTINUITY = 1
+FLAG_SPEECH_START = 2
+FLAG_SPEECH_END = 4
+FLAG_SILENCE = 8
+# codec setup (OpusHead, FLAC metadata) ahead of the first packet of an encoded stream
+FLAG_CODEC_HEADER = 16
+# silence the bot's jitter buffer inserted where mixed audio arrived late or not at all
+FLAG_CONCEALED = 32
+# last frame before the bot closes the socket on shutdown, a marker without sequence number
+FLAG_END_OF_STREAM = 64
+
+
+class StreamType(IntEnum):
+    """Kind of data carried by a frame."""
+    MIXED = 0
+    ONE_WAY = 1
+    SHARE = 2
+    TRANSCRIPT = 3
+    # the active speakers whose one-way audio is forwarded, sent whenever they change
+    SPEAKERS = 4
+
+
+class PayloadFormat(IntEnum):
+    """Encoding of the frame payload."""
+    LINEAR16 = 0
+    JSON = 1
+    # one packet per frame, from a bot started with `RawAudio --codec opus|flac`
+    OPUS = 2
+    FLAC = 3
+
+
+class ProtocolError(Exception):
+    """Raised when the byte stream is not a valid frame sequence."""
+
+
+@dataclass
+class Frame:
+    """One chunk of audio with its header fields."""
+    stream: int
+    format: int
+    channels: int
+    node_id: int
+    sample_rate: int
+    flags: int
+    seq: int
+    timestamp_ns: int
+    # a memoryview into the ring for frames read by ShmReader, see ShmReader.frames()
+    payload: Union[bytes, memoryview]
+
+
+def shm_hello(hello: bytes, size: Optional[int] = None) -> bytes:
+    """Ask for the shared memory transport in a SUB line, optionally with a ring size in bytes."""
+    option = b" transport=shm" + (f" shm-size={size}".encode() if size else b"")
+    return hello.rstrip(b"\n") + option + b"\n"
+
+
+def speakers_hello(hello: bytes) -> bytes:
+    """Add the speakers stream to a SUB line, next to the streams it already asks for."""
+    tokens = hello.rstrip(b"\n").split(b" ")
+    for i, token in enumerate(tokens):
+        if token.startswith(b"streams="):
+            tokens[i] = token + b",speakers"
+            break
+    else:
+        # without streams= the bot sends the mixed audio only
+        tokens.append(b"streams=mixed,speakers")
+    return b" ".join(tokens) + b"\n"
+
+
+@dataclass
+class Speaker:
+    """An active speaker named in a speakers frame."""
+    node_id: int
+    name: str
+
+
+def parse_speakers(payload) -> List[Speaker]:
+    """Decode the JSON payload of a speakers frame, `{"speakers": [{"node_id": .., "name": ..}]}`."""
+    try:
+        speakers = json.loads(bytes(payload))["speakers"]
+        return [Speaker(int(s["node_id"]), s.get("name", "")) for s in speakers]
+    except (ValueError, KeyError, TypeError) as e:
+        raise ProtocolError(f"bad speakers payload: {e}")
+
+
+def parse_frame_header(buffer, offset: int):
+    """Unpack and check one frame header, returning its fields without the magic and version."""
+    (magic, version, stream, fmt, channels, length,
+     node_id, rate, flags, seq, ts) = FRAME_HEADER.unpack_from(buffer, offset)
+
+    if magic != FRAME_MAGIC:
+        raise ProtocolError(f"bad frame magic {magic!r}")
+    if version != FRAME_VERSION:
+        raise ProtocolError(f"unsupported frame version {version}")
+
+    return stream, fmt, channels, length, node_id, rate, flags, seq, ts
+
+
+class FrameReader:
+    """
+    Incremental frame parser over a large receive buffer.
+
+    Data is received straight into the buffer with `recv_into`, so one syscall can
+    deliver many frames; `frames()` then returns every complete frame in it and keeps
+    a trailing partial frame for the next call.
+    """
+
+    def __init__(self, buffer_size: int = 256 * 1024):
+        self.buffer = bytearray(buffer_size)
+        self.view = memoryview(self.buffer)
+        self.start = 0
+        self.end = 0
+
+    def writable(self) -> memoryview:
+        """Return the free tail of the buffer to receive into."""
+        if self.start > 0 and self.end == len(self.buffer):
+            self._compact()
+        return self.view[self.end:]
+
+    def commit(self, count: int):
+        """Mark `count` bytes received into `writable()` as filled."""
+        self.end += count
+
+    def frames(self) -> List[Frame]:
+        """Parse every complete frame in the buffer."""
+        frames = []
+
+        while self.end - self.start >= FRAME_HEADER.size:
+            (stream, fmt, channels, length,
+             node_id, rate, flags, seq, ts) = parse_frame_header(self.buffer, self.start)
+
+            total = FRAME_HEADER.size + length
+            if total > len(self.buffer):
+                raise ProtocolError(f"frame of {length} bytes exceeds the receive buffer")
+            if self.end - self.start < total:
+                break
+
+            body = self.start + FRAME_HEADER.size
+            frames.append(Frame(stream, fmt, channels, node_id, rate, flags, seq, ts,
+                                bytes(self.view[body:body + length])))
+            self.start += total
+
+        if self.start == self.end:
+            self.start = self.end = 0
+        elif self.end == len(self.buffer):
+            self._compact()
+
+        return frames
+
+    def _compact(self):
+        pending = self.end - self.start
+        self.buffer[:pending] = self.buffer[self.start:self.end]
+        self.start, self.end = 0, pending
+
+
+class ShmReader:
+    """
+    Reader of the bot's shared memory ring.
+
+    Frames are parsed where the bot wrote them and their payloads are memoryviews into
+    the mapping, so audio is never copied on its way in. They stay valid until
+    `release()` hands the space back to the bot; copy a payload with `bytes()` to keep it
+    longer. Positions are plain aligned 64 bit loads and stores, which the x86-64 memory
+    model the bot is built for keeps in order.
+    """
+
+    def __init__(self, memfd: int, size: int):
+        try:
+            self.map = mmap.mmap(memfd, size)
+        finally:
+            os.close(memfd)
+
+        magic, version, capacity, data_offset = SHM_HEADER.unpack_from(self.map, 0)
+        if magic != SHM_MAGIC:
+            self.map.close()
+            raise ProtocolError(f"bad shared memory magic {magic!r}")
+        if version != SHM_VERSION:
+            self.map.close()
+            raise ProtocolError(f"unsupported shared memory version {version}")
+
+        self.capacity = capacity
+        self.view = memoryview(self.map)
+        self.data = self.view[data_offset:data_offset + capacity]
+        self.tail = SHM_POSITION.unpack_from(self.map, SHM_TAIL_OFFSET)[0]
+        self.read = self.tail
+
+    def frames(self) -> List[Frame]:
+        """Parse every frame published since the last call."""
+        frames = []
+        head = SHM_POSITION.unpack_from(self.map, SHM_HEAD_OFFSET)[0]
+        mask = self.capacity - 1
+
+        while self.read < head:
+            pos = self.read & mask
+            if self.data[pos:pos + 4] == SHM_PAD:
+                self.read += self.capacity - pos
+                continue
+
+            (stream, fmt, channels, length,
+             node_id, rate, flags, seq, ts) = parse_frame_header(self.data, pos)
+
+            body = pos + FRAME_HEADER.size
+            frames.append(Frame(stream, fmt, channels, node_id, rate, flags, seq, ts,
+                                self.data[body:body + length]))
+            self.read += (FRAME_HEADER.size + length + 7) & ~7
+
+        return frames
+
+    def release(self):
+        """Let the bot reuse the space of every frame returned so far."""
+        if self.read != self.tail:
+            SHM_POSITION.pack_into(self.map, SHM_TAIL_OFFSET, self.read)
+            self.tail = self.read
+
+    def close(self):
+        try:
+            self.data.release()
+            self.view.release()
+            self.map.close()
+        except BufferError:
+            # a caller still holds a payload; the mapping goes once that is collected
+            pass
+
+
+class StreamStats:
+    """
+    Gap and jitter tracking for one (stream, node_id) sequence.
+
+    Jitter is the smoothed difference between arrival spacing and capture spacing
+    (RFC 3550 style), in milliseconds.
+    """
+
+    def __init__(self):
+        self.last_seq: Optional[int] = None
+        self.last_capture_ns = 0
+        self.last_arrival_ns = 0
+        self.frames = 0
+        self.lost = 0
+        self.jitter_ms = 0.0
+
+    def update(self, frame: Frame, arrival_ns: int):
+        if self.last_seq is not None:
+            if frame.seq > self.last_seq + 1:
+                self.lost += frame.seq - self.last_seq - 1
+
+            transit = (arrival_ns - self.last_arrival_ns) - (frame.timestamp_ns - self.last_capture_ns)
+            self.jitter_ms += (abs(transit) / 1e6 - self.jitter_ms) / 16
+
+        self.last_seq = frame.seq
+        self.last_capture_ns = frame.timestamp_ns
+        self.last_arrival_ns = arrival_ns
+        self.frames += 1
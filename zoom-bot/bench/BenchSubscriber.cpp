@@ -0,0 +1,112 @@
+#include "BenchSubscriber.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/util/FrameHeader.h"
+#include "../src/util/Log.h"
+
+BenchSubscriber::BenchSubscriber(Histogram& latency) : m_latency(latency) {}
+
+BenchSubscriber::~BenchSubscriber() {
+    stop();
+}
+
+bool BenchSubscriber::start(const string& path, const string& hello) {
+    m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd == -1)
+        return false;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (connect(m_fd, (const struct sockaddr*) &addr, sizeof(addr)) == -1) {
+        Log::error("bench subscriber unable to connect to " + path);
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    auto line = hello + "\n";
+    if (send(m_fd, line.data(), line.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(line.size()))
+        return false;
+
+    m_running = true;
+    m_thread = thread(&BenchSubscriber::run, this);
+    return true;
+}
+
+void BenchSubscriber::stop() {
+    if (m_running.exchange(false))
+        m_thread.join();
+
+    if (m_fd != -1) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void BenchSubscriber::run() {
+    vector<char> buffer(256 * 1024);
+    size_t filled = 0;
+
+    // next expected seq per stream and node
+    unordered_map<uint64_t, uint64_t> expected;
+
+    while (m_running) {
+        struct pollfd pfd = {m_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+
+        auto ret = recv(m_fd, buffer.data() + filled, buffer.size() - filled, 0);
+        if (ret == -1 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            break;
+
+        filled += ret;
+        m_bytes.fetch_add(ret, memory_order_relaxed);
+
+        // one clock read for everything this recv brought
+        auto now = FrameHeader::now();
+
+        size_t offset = 0;
+        while (filled - offset >= sizeof(FrameHeader)) {
+            FrameHeader header;
+            memcpy(&header, buffer.data() + offset, sizeof(header));
+
+            if (header.magic != FrameHeader::c_magic) {
+                Log::error("bench subscriber lost the frame boundaries");
+                return;
+            }
+
+            auto size = sizeof(FrameHeader) + header.length;
+            if (filled - offset < size)
+                break;
+
+            if (header.timestamp > 0 && now > header.timestamp)
+                m_latency.record(now - header.timestamp);
+
+            auto key = static_cast<uint64_t>(header.stream) << 32 | header.nodeId;
+            auto it = expected.find(key);
+            if (it != expected.end() && header.seq > it->second)
+                m_gaps.fetch_add(header.seq - it->second, memory_order_relaxed);
+            expected[key] = header.seq + 1;
+
+            m_frames.fetch_add(1, memory_order_relaxed);
+            offset += size;
+        }
+
+        memmove(buffer.data(), buffer.data() + offset, filled - offset);
+        filled -= offset;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_BENCHSUBSCRIBER_H
+#define MEETING_SDK_LINUX_SAMPLE_BENCHSUBSCRIBER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "../src/util/Metrics.h"
+
+using namespace std;
+
+/**
+ * Framed audio socket client on its own thread, timing every frame from the moment the
+ * bot stamped it until it was read here
+ */
+class BenchSubscriber {
+    string m_path;
+    string m_hello;
+    int m_fd = -1;
+
+    thread m_thread;
+    atomic<bool> m_running{false};
+
+    atomic<uint64_t> m_frames{0};
+    atomic<uint64_t> m_bytes{0};
+    atomic<uint64_t> m_gaps{0};
+    Histogram& m_latency;
+
+    void run();
+
+public:
+    /**
+     * @param latency shared by every subscriber of a run
+     */
+    explicit BenchSubscriber(Histogram& latency);
+    ~BenchSubscriber();
+
+    /**
+     * Connect and subscribe
+     * @param hello without the trailing newline, e.g. "SUB framing=1 streams=mixed,one-way"
+     */
+    bool start(const string& path, const string& hello);
+    void stop();
+
+    uint64_t frames() const { return m_frames; }
+    uint64_t bytes() const { return m_bytes; }
+
+    /**
+     * @return frames missing from the sequence of a stream, i.e. dropped on the way
+     */
+    uint64_t gaps() const { return m_gaps; }
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_BENCHSUBSCRIBER_H
@@ -0,0 +1,95 @@
+#include "Capture.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#include "../src/util/Log.h"
+
+static bool readFile(const string& path, vector<char>& out) {
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file)
+        return false;
+
+    out.resize(file.tellg());
+    file.seekg(0);
+    return static_cast<bool>(file.read(out.data(), out.size()));
+}
+
+bool PcmCapture::load(const string& path, unsigned int sampleRate, unsigned int channels) {
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_unit = sampleRate / 100 * channels * sizeof(int16_t);
+
+    if (!readFile(path, m_data) || m_data.size() < m_unit) {
+        Log::error("unable to read a PCM capture from " + path);
+        return false;
+    }
+
+    m_data.resize(m_data.size() - m_data.size() % m_unit);
+    Log::info("replaying ", units() / 100, "s of ", sampleRate, "Hz/", channels, "ch audio from ", path);
+    return true;
+}
+
+void PcmCapture::synthesize(unsigned int sampleRate, unsigned int channels, unsigned int seconds) {
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_unit = sampleRate / 100 * channels * sizeof(int16_t);
+
+    auto frames = static_cast<size_t>(sampleRate) * seconds;
+    m_data.resize(frames * channels * sizeof(int16_t));
+    auto* samples = reinterpret_cast<int16_t*>(m_data.data());
+
+    mt19937 random(1);
+    normal_distribution<float> noise(0, 4000);
+
+    for (size_t i = 0; i < frames; i++) {
+        // 600ms of "speech" every 1.5s
+        auto speaking = (i * 10 / sampleRate) % 15 < 6;
+        auto value = 300 * sin(2 * M_PI * 220 * i / sampleRate) + (speaking ? noise(random) : 0);
+
+        for (unsigned int c = 0; c < channels; c++)
+            samples[i * channels + c] = static_cast<int16_t>(max(-32768.0, min(32767.0, value)));
+    }
+}
+
+bool YuvCapture::load(const string& path, unsigned int width, unsigned int height) {
+    m_width = width;
+    m_height = height;
+    m_unit = static_cast<size_t>(width) * height + 2 * static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+
+    if (!readFile(path, m_data) || m_data.size() < m_unit) {
+        Log::error("unable to read an I420 capture from " + path);
+        return false;
+    }
+
+    m_data.resize(m_data.size() - m_data.size() % m_unit);
+    Log::info("replaying ", units(), " ", width, "x", height, " frames from ", path);
+    return true;
+}
+
+void YuvCapture::synthesize(unsigned int width, unsigned int height, unsigned int frames) {
+    m_width = width;
+    m_height = height;
+
+    auto luma = static_cast<size_t>(width) * height;
+    auto chroma = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+    m_unit = luma + 2 * chroma;
+    m_data.resize(m_unit * frames);
+
+    auto box = height / 3;
+    for (unsigned int f = 0; f < frames; f++) {
+        auto* y = reinterpret_cast<unsigned char*>(at(f));
+        auto left = (f * 4) % max(width - box, 1u);
+        auto top = height / 3;
+
+        for (unsigned int r = 0; r < height; r++)
+            for (unsigned int c = 0; c < width; c++) {
+                auto inside = c >= left && c < left + box && r >= top && r < top + box;
+                y[r * width + c] = inside ? 220 : static_cast<unsigned char>(40 + (c + r) * 100 / (width + height));
+            }
+
+        memset(y + luma, 128, 2 * chroma);
+    }
+}
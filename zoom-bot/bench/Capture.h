@@ -0,0 +1,76 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_CAPTURE_H
+#define MEETING_SDK_LINUX_SAMPLE_CAPTURE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Recorded or synthesized media, played in a loop so a run can be longer than the capture
+ */
+class Capture {
+protected:
+    vector<char> m_data;
+    size_t m_unit = 0;
+
+public:
+    /**
+     * @return number of chunks or frames in one loop
+     */
+    size_t units() const { return m_unit ? m_data.size() / m_unit : 0; }
+
+    /**
+     * @param index any number, wrapped around the capture
+     */
+    char* at(size_t index) { return m_data.data() + (index % units()) * m_unit; }
+
+    size_t unitSize() const { return m_unit; }
+};
+
+/**
+ * 16-bit PCM cut into the 10ms chunks the SDK delivers
+ */
+class PcmCapture : public Capture {
+    unsigned int m_sampleRate = 32000;
+    unsigned int m_channels = 1;
+
+public:
+    /**
+     * Read a raw s16le file as written by the bot, e.g. meeting-audio.pcm
+     * @return false if the file cannot be read or holds less than a chunk
+     */
+    bool load(const string& path, unsigned int sampleRate, unsigned int channels);
+
+    /**
+     * Speech-like noise bursts over a quiet tone, so a VAD has something to gate
+     * @param seconds length of one loop
+     */
+    void synthesize(unsigned int sampleRate, unsigned int channels, unsigned int seconds);
+
+    unsigned int sampleRate() const { return m_sampleRate; }
+    unsigned int channels() const { return m_channels; }
+};
+
+/**
+ * Packed I420 frames, e.g. a .yuv dump of the raw video output
+ */
+class YuvCapture : public Capture {
+    unsigned int m_width = 640;
+    unsigned int m_height = 360;
+
+public:
+    bool load(const string& path, unsigned int width, unsigned int height);
+
+    /**
+     * A face-sized bright box moving over a gradient
+     * @param frames length of one loop
+     */
+    void synthesize(unsigned int width, unsigned int height, unsigned int frames);
+
+    unsigned int width() const { return m_width; }
+    unsigned int height() const { return m_height; }
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_CAPTURE_H
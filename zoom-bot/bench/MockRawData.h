@@ -0,0 +1,72 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_MOCKRAWDATA_H
+#define MEETING_SDK_LINUX_SAMPLE_MOCKRAWDATA_H
+
+#include "zoom_sdk_raw_data_def.h"
+
+/**
+ * Audio chunk as the SDK hands it to IZoomSDKAudioRawDataDelegate, pointing into a
+ * capture that outlives the callback
+ */
+class MockAudioRawData : public AudioRawData {
+    char* m_buffer = nullptr;
+    unsigned int m_len = 0;
+    unsigned int m_sampleRate = 32000;
+    unsigned int m_channels = 1;
+
+public:
+    void set(char* buffer, unsigned int len, unsigned int sampleRate, unsigned int channels) {
+        m_buffer = buffer;
+        m_len = len;
+        m_sampleRate = sampleRate;
+        m_channels = channels;
+    }
+
+    // the delegates copy what they keep, like they have to with the SDK
+    bool CanAddRef() override { return false; }
+    bool AddRef() override { return false; }
+    int Release() override { return 0; }
+
+    char* GetBuffer() override { return m_buffer; }
+    unsigned int GetBufferLen() override { return m_len; }
+    unsigned int GetSampleRate() override { return m_sampleRate; }
+    unsigned int GetChannelNum() override { return m_channels; }
+};
+
+/**
+ * Packed I420 frame as the SDK hands it to IZoomSDKRendererDelegate
+ */
+class MockYUVRawDataI420 : public YUVRawDataI420 {
+    char* m_buffer = nullptr;
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+    unsigned int m_sourceId = 0;
+
+    size_t luma() const { return static_cast<size_t>(m_width) * m_height; }
+    size_t chroma() const { return static_cast<size_t>((m_width + 1) / 2) * ((m_height + 1) / 2); }
+
+public:
+    void set(char* buffer, unsigned int width, unsigned int height, unsigned int sourceId) {
+        m_buffer = buffer;
+        m_width = width;
+        m_height = height;
+        m_sourceId = sourceId;
+    }
+
+    bool CanAddRef() override { return false; }
+    bool AddRef() override { return false; }
+    int Release() override { return 0; }
+
+    char* GetYBuffer() override { return m_buffer; }
+    char* GetUBuffer() override { return m_buffer + luma(); }
+    char* GetVBuffer() override { return m_buffer + luma() + chroma(); }
+    char* GetBuffer() override { return m_buffer; }
+    unsigned int GetBufferLen() override { return luma() + 2 * chroma(); }
+    bool IsLimitedI420() override { return true; }
+    unsigned int GetStreamWidth() override { return m_width; }
+    unsigned int GetStreamHeight() override { return m_height; }
+    unsigned int GetRotation() override { return 0; }
+    unsigned int GetSourceID() override { return m_sourceId; }
+    void* GetResource() override { return nullptr; }
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_MOCKRAWDATA_H
@@ -0,0 +1,326 @@
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <CLI/CLI.hpp>
+
+#include "Capture.h"
+#include "MockRawData.h"
+#include "BenchSubscriber.h"
+
+#include "../src/raw_record/ZoomSDKAudioRawDataDelegate.h"
+#include "../src/raw_record/ZoomSDKRendererDelegate.h"
+#include "../src/util/Log.h"
+#include "../src/util/Metrics.h"
+#include "../src/video/CountingMatAllocator.h"
+
+using namespace std;
+
+/**
+ * Every heap allocation of the process, so a run can tell how much the media paths allocate
+ * once they are warm
+ */
+static atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, memory_order_relaxed);
+    if (auto* p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+struct BenchOptions {
+    string pcm;
+    unsigned int sampleRate = 32000;
+    unsigned int channels = 1;
+
+    string yuv;
+    unsigned int width = 640;
+    unsigned int height = 360;
+    unsigned int fps = 30;
+
+    unsigned int participants = 0;
+    unsigned int subscribers = 1;
+    unsigned int videoStreams = 0;
+    double duration = 10;
+    bool maxSpeed = false;
+
+    unsigned int outputRate = 0;
+    unsigned int batchMs = 0;
+    string codec = Codec::pcm;
+    string encoder = Encoder::opencv;
+    string dir = "/tmp/zoombench";
+    bool metrics = false;
+};
+
+struct Usage {
+    chrono::steady_clock::time_point wall;
+    double cpu;
+    uint64_t allocations;
+    uint64_t matAllocations;
+
+    static Usage now(const CountingMatAllocator& mats) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        auto cpu = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+                   + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+
+        return {chrono::steady_clock::now(), cpu, g_allocations.load(memory_order_relaxed), mats.allocations()};
+    }
+};
+
+static string quantiles(const Histogram& histogram) {
+    auto snapshot = histogram.snapshot();
+
+    stringstream ss;
+    ss << fixed << setprecision(3) << "p50 " << snapshot.quantile(0.5) / 1e6 << "ms, p99 "
+       << snapshot.quantile(0.99) / 1e6 << "ms, p99.9 " << snapshot.quantile(0.999) / 1e6 << "ms ("
+       << snapshot.count << ")";
+    return ss.str();
+}
+
+/**
+ * Wait for the next tick in real time, or not at all at max speed
+ */
+static void pace(const BenchOptions& options, chrono::steady_clock::time_point start,
+                 chrono::nanoseconds period, uint64_t tick) {
+    if (!options.maxSpeed)
+        this_thread::sleep_until(start + period * tick);
+}
+
+static void feedAudio(const BenchOptions& options, ZoomSDKAudioRawDataDelegate& delegate, PcmCapture& capture,
+                      Histogram& callbacks, atomic<bool>& running, uint64_t& chunks) {
+    MockAudioRawData mixed, oneWay;
+    auto start = chrono::steady_clock::now();
+
+    // every participant starts at another point of the capture, like different voices
+    auto spread = max<size_t>(capture.units() / (options.participants + 1), 1);
+
+    for (uint64_t tick = 0; running; tick++) {
+        pace(options, start, chrono::milliseconds(10), tick);
+
+        mixed.set(capture.at(tick), capture.unitSize(), capture.sampleRate(), capture.channels());
+        auto t0 = FrameHeader::now();
+        delegate.onMixedAudioRawDataReceived(&mixed);
+        callbacks.record(FrameHeader::now() - t0);
+        chunks++;
+
+        for (unsigned int p = 0; p < options.participants; p++) {
+            oneWay.set(capture.at(tick + (p + 1) * spread), capture.unitSize(), capture.sampleRate(), capture.channels());
+
+            auto t1 = FrameHeader::now();
+            delegate.onOneWayAudioRawDataReceived(&oneWay, p + 1);
+            callbacks.record(FrameHeader::now() - t1);
+            chunks++;
+        }
+    }
+}
+
+static void feedVideo(const BenchOptions& options, ZoomSDKRendererDelegate& delegate, YuvCapture& capture,
+                      unsigned int stream, Histogram& callbacks, atomic<bool>& running, atomic<uint64_t>& frames) {
+    MockYUVRawDataI420 frame;
+    auto start = chrono::steady_clock::now();
+    auto period = chrono::nanoseconds(1000000000ull / max(options.fps, 1u));
+
+    for (uint64_t tick = 0; running; tick++) {
+        pace(options, start, period, tick);
+
+        frame.set(capture.at(tick + stream * 7), capture.width(), capture.height(), stream + 1);
+
+        auto t0 = FrameHeader::now();
+        delegate.onRawDataFrameReceived(&frame);
+        callbacks.record(FrameHeader::now() - t0);
+        frames.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    CLI::App app{"Replays captured audio and video through the bot's media paths without a meeting", "zoombench"};
+
+    app.add_option("--pcm", options.pcm, "Raw s16le capture to replay, a synthesized one if empty");
+    app.add_option("--rate", options.sampleRate, "Sample rate of the PCM capture")->capture_default_str();
+    app.add_option("--channels", options.channels, "Channels of the PCM capture")->capture_default_str();
+    app.add_option("--yuv", options.yuv, "Packed I420 capture to replay, a synthesized one if empty");
+    app.add_option("--width", options.width, "Width of the I420 capture")->capture_default_str();
+    app.add_option("--height", options.height, "Height of the I420 capture")->capture_default_str();
+    app.add_option("--fps", options.fps, "Frames per second of each video stream in real time")->capture_default_str();
+
+    app.add_option("-n, --participants", options.participants, "Simulated participants with one-way audio")
+        ->capture_default_str();
+    app.add_option("-m, --subscribers", options.subscribers, "Simulated audio socket subscribers")
+        ->check(CLI::Range(0, 1024))
+        ->capture_default_str();
+    app.add_option("--video-streams", options.videoStreams, "Simulated video streams, one renderer each")
+        ->capture_default_str();
+    app.add_option("-t, --duration", options.duration, "Seconds to run")->capture_default_str();
+    app.add_flag("--max-speed", options.maxSpeed, "Feed as fast as the callbacks return instead of in real time");
+
+    app.add_option("--output-rate", options.outputRate, "Resample socket audio to this rate, 0 keeps it")
+        ->capture_default_str();
+    app.add_option("--batch-ms", options.batchMs, "Coalesce one-way audio per node")->capture_default_str();
+    app.add_option("--codec", options.codec, "Codec of the socket audio")
+        ->check(CLI::IsMember({Codec::pcm, Codec::opus, Codec::flac}))
+        ->capture_default_str();
+    app.add_option("--encoder", options.encoder, "Video encoder backend")->capture_default_str();
+    app.add_option("--dir", options.dir, "Directory the video files are written to")->capture_default_str();
+    app.add_flag("--metrics", options.metrics, "Also print the bot's metrics at the end");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError& err) {
+        return app.exit(err);
+    }
+
+    PcmCapture pcm;
+    if (options.pcm.empty())
+        pcm.synthesize(options.sampleRate, options.channels, 10);
+    else if (!pcm.load(options.pcm, options.sampleRate, options.channels))
+        return EXIT_FAILURE;
+
+    YuvCapture yuv;
+    if (options.videoStreams > 0) {
+        if (options.yuv.empty())
+            yuv.synthesize(options.width, options.height, 90);
+        else if (!yuv.load(options.yuv, options.width, options.height))
+            return EXIT_FAILURE;
+    }
+
+    auto socketPath = "/tmp/zoombench-" + to_string(getpid()) + ".sock";
+    auto& mats = CountingMatAllocator::install();
+
+    // the audio path as the bot runs it when transcribing
+    ZoomSDKAudioRawDataDelegate audio(true, true);
+    audio.setSocketPath(socketPath);
+    audio.setOutputRate(options.outputRate);
+    audio.setStreamParticipants(options.participants > 0, options.batchMs);
+
+    EncoderOptions codec;
+    codec.codec = Codec::parse(options.codec);
+    audio.setEncoding(codec, EncoderOptions());
+    audio.start();
+
+    auto& subscriberLatency = Metrics::getInstance().histogram("zoombench_subscriber_latency_seconds",
+                                                               "Time from the callback until a subscriber read the frame");
+    vector<unique_ptr<BenchSubscriber>> subscribers;
+    auto hello = string("SUB framing=1 streams=mixed") + (options.participants > 0 ? ",one-way" : "");
+    for (unsigned int i = 0; i < options.subscribers; i++) {
+        auto subscriber = make_unique<BenchSubscriber>(subscriberLatency);
+        if (!subscriber->start(socketPath, hello))
+            return EXIT_FAILURE;
+        subscribers.push_back(std::move(subscriber));
+    }
+
+    // let the server read every hello before the first chunk
+    this_thread::sleep_for(chrono::milliseconds(200));
+
+    vector<unique_ptr<ZoomSDKRendererDelegate>> renderers;
+    if (options.videoStreams > 0)
+        filesystem::create_directories(options.dir);
+
+    for (unsigned int i = 0; i < options.videoStreams; i++) {
+        auto renderer = make_unique<ZoomSDKRendererDelegate>();
+        renderer->setDir(options.dir);
+        renderer->setFilename("bench-" + to_string(i + 1) + ".mp4");
+        renderer->setEncoder(options.encoder, "/dev/dri/renderD128");
+        renderers.push_back(std::move(renderer));
+    }
+
+    auto& audioCallbacks = Metrics::getInstance().histogram("zoombench_audio_callback_seconds",
+                                                            "Time spent in an audio callback");
+    auto& videoCallbacks = Metrics::getInstance().histogram("zoombench_video_callback_seconds",
+                                                            "Time spent in a video callback");
+
+    Log::info("running for ", options.duration, "s ", options.maxSpeed ? "at max speed" : "in real time", " with ",
+              options.participants, " participants, ", options.subscribers, " subscribers and ",
+              options.videoStreams, " video streams");
+
+    atomic<bool> running{true};
+    uint64_t audioChunks = 0;
+    atomic<uint64_t> videoFrames{0};
+    auto before = Usage::now(mats);
+
+    vector<thread> feeders;
+    feeders.emplace_back(feedAudio, cref(options), ref(audio), ref(pcm), ref(audioCallbacks), ref(running),
+                         ref(audioChunks));
+    for (unsigned int i = 0; i < options.videoStreams; i++)
+        feeders.emplace_back(feedVideo, cref(options), ref(*renderers[i]), ref(yuv), i, ref(videoCallbacks),
+                             ref(running), ref(videoFrames));
+
+    this_thread::sleep_for(chrono::duration<double>(options.duration));
+    running = false;
+    for (auto& feeder : feeders)
+        feeder.join();
+
+    auto after = Usage::now(mats);
+
+    // what is still queued reaches the subscribers before they stop counting
+    this_thread::sleep_for(chrono::milliseconds(200));
+
+    uint64_t frames = 0, bytes = 0, gaps = 0;
+    for (auto& subscriber : subscribers) {
+        subscriber->stop();
+        frames += subscriber->frames();
+        bytes += subscriber->bytes();
+        gaps += subscriber->gaps();
+    }
+
+    auto wall = chrono::duration<double>(after.wall - before.wall).count();
+    auto metrics = options.metrics ? Metrics::getInstance().render() : string();
+
+    renderers.clear();
+    audio.close();
+    unlink(socketPath.c_str());
+    Log::flush();
+
+    cout << fixed << setprecision(1)
+         << "audio:       " << audioChunks / wall << " chunks/s, callback " << quantiles(audioCallbacks) << "\n"
+         << "subscribers: " << frames / wall << " frames/s, " << bytes / wall / 1e6 << " MB/s, "
+         << gaps << " frames lost, latency " << quantiles(subscriberLatency) << "\n";
+
+    if (options.videoStreams > 0)
+        cout << fixed << setprecision(1) << "video:       " << videoFrames / wall << " frames/s, callback "
+             << quantiles(videoCallbacks) << "\n";
+
+    cout << fixed << setprecision(1)
+         << "cpu:         " << (after.cpu - before.cpu) / wall * 100 << "% of a core over " << wall << "s\n"
+         << "allocations: " << (after.allocations - before.allocations) / wall << "/s heap, "
+         << (after.matAllocations - before.matAllocations) / wall << "/s Mat\n";
+
+    if (options.metrics)
+        cout << "\n" << metrics;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+
+# Profile guided release build: instrument the media paths, train them with zoombench and
+# rebuild build/release with the recorded profiles. Pass captures to train on real meetings:
+#
+#   ./bin/pgo.sh --pcm out/meeting-audio.pcm --rate 32000
+#
+# Every argument is handed to each zoombench run.
+
+set -euo pipefail
+
+cd "$(dirname "$0")/.."
+
+BUILD=build/release
+PROFILES=$BUILD/pgo
+
+cmake --preset pgo-generate
+cmake --build --preset pgo-generate
+
+# profiles from an earlier training run would be merged into this one
+rm -rf "$PROFILES"
+
+bench() {
+  echo "=== zoombench $* ==="
+  "./$BUILD/zoombench" --max-speed -t 10 "$@"
+}
+
+# the mixes production runs: plain and resampled linear16, opus and flac subscribers, video
+bench -n 4 -m 2 --video-streams 0 "$@"
+bench -n 8 -m 4 --video-streams 0 --output-rate 16000 "$@"
+bench -n 8 -m 4 --video-streams 0 --codec opus "$@"
+bench -n 2 -m 1 --video-streams 0 --codec flac "$@"
+bench -n 2 -m 1 --video-streams 2 "$@"
+
+cmake --preset pgo-use
+cmake --build --preset pgo-use
@@ -24,13 +24,228 @@ Config::Config() :
 
     m_app.add_flag("-s, --start", m_isMeetingStart, "Start a Zoom Meeting");
 
+    m_app.add_option("--socket-path", m_socketPath, "Unix socket the transcription audio is served on")->capture_default_str();
+
+    m_app.add_flag("--standby", m_standby, "Authenticate, then wait for a Join request on the control socket");
+    m_app.add_flag("--control", m_control, "Serve the control socket to change the meeting and its streams at runtime");
+
+    m_app.add_flag("--supervisor", m_supervisor, "Fork a worker process for every meeting requested over the control socket");
+    m_app.add_option("--control-path", m_controlPath, "Unix socket of the control channel")->capture_default_str();
+    m_app.add_option("--max-workers", m_maxWorkers, "Meetings the supervisor runs at the same time")
+        ->check(CLI::Range(1, 256))
+        ->capture_default_str();
+    m_app.add_option("--pool", m_poolSize, "Authenticated standby workers the supervisor keeps ready")
+        ->check(CLI::Range(0, 64))
+        ->capture_default_str();
+
+    m_app.add_option("--drain-timeout", m_drainSeconds, "Seconds a shutdown may take to flush the media and upload the last segments")
+        ->check(CLI::Range(1, 300))
+        ->capture_default_str();
+
+    m_app.add_option("--metrics-port", m_metricsPort, "Serve Prometheus metrics over HTTP on this port, 0 for off")
+        ->check(CLI::Range(0, 65535))
+        ->capture_default_str();
+
+    m_app.add_option("--thread-cpus", m_threadCpus, "CPUs for a thread role (audio-rt, io, video-worker, control), e.g. audio-rt=2-3");
+    m_app.add_option("--thread-fifo", m_threadFifo, "Run a thread role under SCHED_FIFO with this priority (1-99), e.g. audio-rt=50");
+    m_app.add_option("--thread-nice", m_threadNice, "Nice level (-20-19) for a thread role under the normal scheduler, e.g. io=5");
+    m_app.add_flag("--numa-local", m_threadRoles.numaLocal, "Prefer memory on the NUMA node of a role's CPUs");
+
+    m_app.add_option("--segment-seconds", m_segmentSeconds, "Finish a recording segment after this many seconds, 0 for no limit")
+        ->check(CLI::Range(0, 86400))
+        ->capture_default_str();
+    m_app.add_option("--segment-mb", m_segmentMb, "Finish a recording segment at this size in MiB, 0 for no limit")
+        ->check(CLI::Range(0, 65536))
+        ->capture_default_str();
+    m_app.add_option("--max-disk-mb", m_maxDiskMb, "Delete the oldest finished segments beyond this many MiB, uploaded ones first, 0 for no limit")
+        ->capture_default_str();
+    m_app.add_option("--upload-bucket", m_uploadOptions.s3.bucket, "Upload finished segments to this S3 bucket");
+    m_app.add_option("--upload-prefix", m_uploadOptions.prefix, "Key prefix of the uploaded segments");
+    m_app.add_option("--upload-region", m_uploadOptions.s3.region, "Region of the bucket")->capture_default_str();
+    m_app.add_option("--upload-endpoint", m_uploadOptions.s3.endpoint, "S3 compatible endpoint instead of AWS, e.g. http://minio:9000");
+    m_app.add_option("--upload-access-key", m_uploadOptions.s3.accessKey, "Access key ID")->envname("AWS_ACCESS_KEY_ID");
+    m_app.add_option("--upload-secret-key", m_uploadOptions.s3.secretKey, "Secret access key")->envname("AWS_SECRET_ACCESS_KEY");
+    m_app.add_option("--upload-session-token", m_uploadOptions.s3.sessionToken, "Session token of temporary credentials")->envname("AWS_SESSION_TOKEN");
+    m_app.add_option("--upload-concurrency", m_uploadOptions.concurrency, "Segments uploaded at the same time")
+        ->check(CLI::Range(1, 16))
+        ->capture_default_str();
+    m_app.add_option("--upload-part-mb", m_uploadPartMb, "Segments larger than this many MiB are uploaded in parts of this size")
+        ->check(CLI::Range(5, 5120))
+        ->capture_default_str();
+    m_app.add_flag("--upload-keep", m_uploadOptions.keep, "Move uploaded segments to uploaded/ instead of deleting them");
+
+    m_app.add_option("--log-level", m_logLevel, "Least severe log lines printed")
+        ->check(CLI::IsMember({LogOption::debug, LogOption::info, LogOption::success, LogOption::error}))
+        ->capture_default_str();
+    m_app.add_option("--log-format", m_logFormat, "Print log lines as text or as one JSON object each")
+        ->check(CLI::IsMember({LogOption::text, LogOption::json}))
+        ->capture_default_str();
+
     m_rawRecordAudioCmd->add_option("-f, --file", m_audioFile, "Output PCM audio file");
     m_rawRecordAudioCmd->add_option("-d, --dir", m_audioDir, "Audio Output Directory");
     m_rawRecordAudioCmd->add_flag("-s, --separate-participants", m_separateParticipantAudio, "Output to separate PCM files for each participant");
     m_rawRecordAudioCmd->add_flag("-t, --transcribe", m_transcribe, "Transcribe audio to text");
+    m_rawRecordAudioCmd->add_option("--ring-slots", m_audioRingSlots, "Number of 10ms chunks buffered for the socket writer")->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--overflow", m_audioOverflow, "Chunk to drop when the socket consumer falls behind")
+        ->check(CLI::IsMember({Overflow::dropOldest, Overflow::dropNewest}))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--output-rate", m_audioOutputRate, "Resample socket audio to mono at this rate, e.g. 16000 (0 keeps the SDK rate)")
+        ->check(CLI::Validator([](string& value) {
+            char* end = nullptr;
+            auto rate = strtoul(value.c_str(), &end, 10);
+            auto valid = !value.empty() && *end == '\0' && rate <= 48000 && validOutputRate(rate);
+
+            return valid ? string() : string("must be 0 or 8000-48000");
+        }, "0 or 8000-48000"))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--subscriber-queue", m_subscriberQueue, "Chunks buffered for each socket subscriber")->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--subscriber-overflow", m_subscriberOverflow, "Chunk a slow socket subscriber loses when its queue is full")
+        ->check(CLI::IsMember({Overflow::dropOldest, Overflow::dropNewest}))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_flag("--stream-participants", m_streamParticipants, "Multiplex every participant's audio over the socket when transcribing");
+    m_rawRecordAudioCmd->add_option("--batch-ms", m_batchMs, "Coalesce each participant's audio into frames of this many milliseconds")
+        ->check(CLI::Range(10, 1000))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_flag("--stream-speakers", m_streamSpeakers, "Send only the one-way audio of the active speakers over the socket, named in speaker frames");
+    m_rawRecordAudioCmd->add_option("--max-speakers", m_speakerOptions.maxSpeakers, "Active speakers streamed at once")
+        ->check(CLI::Range(1, 16))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--speaker-hold-ms", m_speakerOptions.holdMs, "Time a speaker who went quiet keeps streaming unless someone else starts talking")
+        ->check(CLI::Range(0, 10000))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--speaker-preroll-ms", m_speakerOptions.prerollMs, "Audio sent ahead of a new speaker, the SDK reports speakers late")
+        ->check(CLI::Range(0, 2000))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--vad", m_vad, "Suppress silence in the mixed socket stream")
+        ->check(CLI::IsMember({Vad::off, Vad::energy, Vad::subband}))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--participant-vad", m_participantVad, "Suppress silence in each participant's socket stream")
+        ->check(CLI::IsMember({Vad::off, Vad::energy, Vad::subband}))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--vad-threshold", m_vadThreshold, "Speech level above the noise floor in dB")->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--vad-hangover", m_vadHangover, "Milliseconds of audio kept after speech ends")->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--vad-preroll", m_vadPreroll, "Milliseconds of audio sent ahead of detected speech")->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--vad-keepalive", m_vadKeepalive, "Milliseconds between silence markers")->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--codec", m_codec, "Encode the socket streams before they leave the bot")
+        ->check(CLI::IsMember({Codec::pcm, Codec::opus, Codec::flac}))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--file-codec", m_fileCodec, "Encode the audio files, e.g. flac for lossless archives")
+        ->check(CLI::IsMember({Codec::pcm, Codec::opus, Codec::flac}))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--codec-frame-ms", m_codecFrameMs, "Milliseconds of audio per encoded packet")
+        ->check(CLI::IsMember(vector<unsigned int>{10, 20, 40, 60}))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--opus-bitrate", m_opusBitrate, "Opus bitrate in bits per second")
+        ->check(CLI::Range(6000, 510000))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--opus-complexity", m_opusComplexity, "Opus encoder complexity, higher costs more CPU")
+        ->check(CLI::Range(0, 10))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--flac-level", m_flacLevel, "FLAC compression level")
+        ->check(CLI::Range(0, 8))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_flag("--deepgram", m_deepgram, "Stream the mixed audio to Deepgram from the bot and relay the transcripts over the socket");
+    m_rawRecordAudioCmd->add_option("--deepgram-key", m_deepgramOptions.apiKey, "Deepgram API key")->envname("DEEPGRAM_API_KEY");
+    m_rawRecordAudioCmd->add_option("--deepgram-url", m_deepgramOptions.url, "Deepgram live endpoint")->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--deepgram-model", m_deepgramOptions.model, "Deepgram model")->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--deepgram-language", m_deepgramOptions.language, "Language of the meeting")->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--deepgram-ca", m_deepgramOptions.caFile, "CA bundle to verify the endpoint with instead of the system store");
+    m_rawRecordAudioCmd->add_option("--replay-ms", m_deepgramOptions.replayMs, "Milliseconds of audio resent after a reconnect")
+        ->check(CLI::Range(0, 60000))
+        ->capture_default_str();
+
+    m_rawRecordAudioCmd->add_option("--jitter-ms", m_jitterOptions.targetMs, "Re-pace the mixed socket audio through a jitter buffer this deep, 0 for off")
+        ->check(CLI::Range(0, 2000))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--jitter-max-ms", m_jitterOptions.maxMs, "Most latency the jitter buffer may add before it catches up")
+        ->check(CLI::Range(10, 10000))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--jitter-tick-ms", m_jitterOptions.tickMs, "Period of the paced output")
+        ->check(CLI::IsMember(vector<unsigned int>{10, 20}))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--jitter-max-gap-ms", m_jitterOptions.maxGapMs, "Longest gap filled with silence before the output pauses")
+        ->check(CLI::Range(0, 600000))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--jitter-late", m_jitterLate, "How the jitter buffer catches up: drop the oldest or compress out the quietest audio")
+        ->check(CLI::IsMember({Late::drop, Late::compress}))
+        ->capture_default_str();
+
+    m_rawRecordAudioCmd->add_option("--kws-model", m_keywordOptions.model, "Spot keywords in the mixed audio with this model, e.g. ONNX");
+    m_rawRecordAudioCmd->add_option("--kws-labels", m_keywordOptions.labels, "Label of each model output, those starting with _ never trigger")
+        ->delimiter(',');
+    m_rawRecordAudioCmd->add_option("--kws-threshold", m_keywordOptions.threshold, "Smoothed posterior a keyword needs to trigger")
+        ->check(CLI::Range(0.0, 1.0))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--kws-window-ms", m_keywordOptions.windowMs, "Audio the keyword model sees at once")
+        ->check(CLI::Range(100, 3000))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--kws-hop-ms", m_keywordOptions.hopMs, "Period of the keyword model's inferences")
+        ->check(CLI::Range(10, 1000))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--kws-mels", m_keywordOptions.mels, "Mel bands of the keyword features")
+        ->check(CLI::Range(8, 128))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--kws-mfcc", m_keywordOptions.mfcc, "Cepstral coefficients instead of the log-mel energies, 0 for off")
+        ->check(CLI::Range(0, 128))
+        ->capture_default_str();
+    m_rawRecordAudioCmd->add_option("--kws-refractory-ms", m_keywordOptions.refractoryMs, "Time before a keyword can trigger again")
+        ->check(CLI::Range(0, 60000))
+        ->capture_default_str();
 
     m_rawRecordVideoCmd->add_option("-f, --file", m_videoFile, "Output YUV video file")->required();
     m_rawRecordVideoCmd->add_option("-d, --dir", m_videoDir, "Video Output Directory");
+    m_rawRecordVideoCmd->add_option("--workers", m_videoWorkers, "Number of frame processing threads")->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--frame-queue", m_videoQueue, "Frames that can wait for a free worker")->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--frame-skip", m_videoFrameSkip, "Frame to skip when face detection falls behind")
+        ->check(CLI::IsMember({Overflow::dropOldest, Overflow::dropNewest}))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--encoder", m_videoEncoder, "Video encoder, falls back to the CPU if unavailable")
+        ->check(CLI::IsMember({Encoder::automatic, Encoder::vaapi, Encoder::nvenc, Encoder::x264, Encoder::opencv}))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--vaapi-device", m_vaapiDevice, "DRM render node for the vaapi encoder")->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--detect-min-interval", m_detectionOptions.minInterval, "Fewest frames between two full face detections")
+        ->check(CLI::Range(1, 300))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--detect-max-interval", m_detectionOptions.maxInterval, "Most frames faces are only tracked for")
+        ->check(CLI::Range(1, 300))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--detect-load", m_detectionOptions.targetLoad, "Share of the workers' time face detection may take")
+        ->check(CLI::Range(0.05, 1.0))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--scene-change", m_detectionOptions.sceneThreshold, "Mean change in gray levels that triggers a detection")
+        ->check(CLI::Range(1.0, 255.0))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--detector", m_detectorOptions.backend, "Face detector, dnn falls back to haar if its model fails to load")
+        ->check(CLI::IsMember({Detector::haar, Detector::dnn}))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--cascade", m_detectorOptions.cascade, "Haar cascade file")->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--detector-model", m_detectorOptions.model, "Weights of an SSD detection network for the dnn detector");
+    m_rawRecordVideoCmd->add_option("--detector-config", m_detectorOptions.config, "Network description, if the weights do not carry it");
+    m_rawRecordVideoCmd->add_option("--detector-target", m_detectorOptions.target, "Where the dnn detector runs")
+        ->check(CLI::IsMember({Detector::cpu, Detector::opencl, Detector::openvino, Detector::cuda, Detector::cudaFp16}))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--detector-confidence", m_detectorOptions.confidence, "Lowest score of a dnn detection")
+        ->check(CLI::Range(0.0, 1.0))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--detector-class", m_detectorOptions.classId, "Class the dnn detector reports, -1 for all")->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--detector-batch", m_detectorOptions.batch, "Most frames of all streams in one dnn inference")
+        ->check(CLI::Range(1, 64))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--detector-input", m_detectorOptions.inputSize, "Input size of the dnn detector in pixels")
+        ->check(CLI::Range(64, 1024))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--participants", m_videoParticipants, "Participants whose video is received at once")
+        ->check(CLI::Range(1, 49))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--speaker-resolution", m_speakerResolution, "Resolution of the active speaker's video")
+        ->check(CLI::IsMember({Resolution::p360, Resolution::p720, Resolution::p1080}))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--thumbnail-resolution", m_thumbnailResolution, "Resolution of everyone else's video")
+        ->check(CLI::IsMember({Resolution::p90, Resolution::p180, Resolution::p360}))
+        ->capture_default_str();
+    m_rawRecordVideoCmd->add_option("--speaker-hold-ms", m_speakerHold, "Time the speaker's video stays large before another speaker takes over")
+        ->check(CLI::Range(0, 60000))
+        ->capture_default_str();
 
 }
 
@@ -46,15 +261,69 @@ int Config::read(int ac, char **av) {
     if (!m_joinUrl.empty())
         parseUrl(m_joinUrl);
 
+    if (!parseThreadRoles())
+        return 1;
+
+    // the bot's own stream to Deepgram taps the same audio path as the socket
+    if (m_deepgram)
+        m_transcribe = true;
+
+    // only finished segments are uploaded, so a bucket needs them
+    if (!m_uploadOptions.s3.bucket.empty() && !segmentOptions().enabled())
+        m_segmentSeconds = 60;
+
    return 0;
 }
 
+bool Config::parseThreadRoles() {
+    auto each = [this](const vector<string>& entries, const string& option,
+                       const function<bool(const string& value, RoleOptions& role)>& set) {
+        for (auto& entry : entries) {
+            auto eq = entry.find('=');
+            ThreadRole role;
+
+            if (eq == string::npos || !Role::parse(entry.substr(0, eq), role)) {
+                Log::error(option, " expects role=value with a role of audio-rt, io, video-worker or control: ", entry);
+                return false;
+            }
+
+            if (!set(entry.substr(eq + 1), m_threadRoles[role])) {
+                Log::error("invalid value for ", option, ": ", entry);
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    auto number = [](const string& value, int lo, int hi, int& out) {
+        char* end;
+        errno = 0;
+        auto n = strtol(value.c_str(), &end, 10);
+        if (value.empty() || *end || errno || n < lo || n > hi)
+            return false;
+
+        out = static_cast<int>(n);
+        return true;
+    };
+
+    return each(m_threadCpus, "--thread-cpus", [](const string& value, RoleOptions& role) {
+               return ThreadRoles::parseCpus(value, role.cpus);
+           })
+        && each(m_threadFifo, "--thread-fifo", [&](const string& value, RoleOptions& role) {
+               return number(value, 1, 99, role.fifoPriority);
+           })
+        && each(m_threadNice, "--thread-nice", [&](const string& value, RoleOptions& role) {
+               return number(value, -20, 19, role.nice);
+           });
+}
+
 // Your updated Config::parseUrl function
 bool Config::parseUrl(const string& join_url) {
     auto url = UrlParser::parse(join_url);
     
     if (!url.valid) {
-        cerr << "unable to parse join URL" << endl;
+        Log::error("unable to parse join URL");
         return false;
     }
     
@@ -85,6 +354,24 @@ bool Config::parseUrl(const string& join_url) {
     
     return true;
 }
+bool Config::join(const JoinRequest& request) {
+    m_meetingId = request.meetingId;
+    m_password = request.password;
+    m_zak = request.zak;
+    m_joinToken = request.joinToken;
+    m_onBehalfToken = request.onBehalfToken;
+    m_joinUrl = request.joinUrl;
+    m_isMeetingStart = false;
+
+    if (!request.displayName.empty())
+        m_displayName = request.displayName;
+
+    if (!m_joinUrl.empty())
+        return parseUrl(m_joinUrl);
+
+    return true;
+}
+
 const string& Config::clientId() const {
     return m_clientId;
 }
@@ -135,6 +422,215 @@ bool Config::separateParticipantAudio() const {
     return m_separateParticipantAudio;
 }
 
+size_t Config::videoWorkers() const {
+    return m_videoWorkers;
+}
+
+size_t Config::videoQueueSize() const {
+    return m_videoQueue;
+}
+
+OverflowPolicy Config::videoFrameSkip() const {
+    return Overflow::parse(m_videoFrameSkip);
+}
+
+const string& Config::videoEncoder() const {
+    return m_videoEncoder;
+}
+
+const string& Config::vaapiDevice() const {
+    return m_vaapiDevice;
+}
+
+const DetectionOptions& Config::detectionOptions() const {
+    return m_detectionOptions;
+}
+
+const DetectorOptions& Config::detectorOptions() const {
+    return m_detectorOptions;
+}
+
+SubscriptionOptions Config::subscriptionOptions() const {
+    SubscriptionOptions options;
+    options.maxStreams = m_videoParticipants;
+    options.speaker = Resolution::parse(m_speakerResolution);
+    options.others = Resolution::parse(m_thumbnailResolution);
+    options.hold = chrono::milliseconds(m_speakerHold);
+
+    return options;
+}
+
+size_t Config::audioRingSlots() const {
+    return m_audioRingSlots;
+}
+
+OverflowPolicy Config::audioOverflowPolicy() const {
+    return Overflow::parse(m_audioOverflow);
+}
+
+unsigned int Config::audioOutputRate() const {
+    return m_audioOutputRate;
+}
+
+void Config::setAudioOutputRate(unsigned int rate) {
+    m_audioOutputRate = rate;
+}
+
+bool Config::validOutputRate(unsigned int rate) {
+    return rate == 0 || (rate >= 8000 && rate <= 48000);
+}
+
+size_t Config::subscriberQueue() const {
+    return m_subscriberQueue;
+}
+
+OverflowPolicy Config::subscriberOverflowPolicy() const {
+    return Overflow::parse(m_subscriberOverflow);
+}
+
+bool Config::streamParticipants() const {
+    return m_streamParticipants;
+}
+
+void Config::setParticipantAudio(bool participants) {
+    if (m_transcribe)
+        m_streamParticipants = participants;
+    else
+        m_separateParticipantAudio = participants;
+}
+
+bool Config::participantAudio() const {
+    return m_transcribe ? m_streamParticipants : m_separateParticipantAudio;
+}
+
+unsigned int Config::batchMs() const {
+    return m_batchMs;
+}
+
+void Config::setSpeakerAudio(bool speakers) {
+    m_streamSpeakers = speakers;
+}
+
+bool Config::speakerAudio() const {
+    return m_transcribe && m_streamSpeakers;
+}
+
+SpeakerOptions Config::speakerOptions() const {
+    return m_speakerOptions;
+}
+
+VadOptions Config::vadOptions(bool participants) const {
+    VadOptions options;
+    options.mode = Vad::parse(participants ? m_participantVad : m_vad);
+    options.thresholdDb = m_vadThreshold;
+    options.hangoverMs = m_vadHangover;
+    options.prerollMs = m_vadPreroll;
+    options.keepaliveMs = m_vadKeepalive;
+
+    return options;
+}
+
+EncoderOptions Config::encoderOptions(bool file) const {
+    EncoderOptions options;
+    options.codec = Codec::parse(file ? m_fileCodec : m_codec);
+    options.frameMs = m_codecFrameMs;
+    options.bitrate = m_opusBitrate;
+    options.complexity = m_opusComplexity;
+    options.flacLevel = m_flacLevel;
+
+    return options;
+}
+
+JitterOptions Config::jitterOptions() const {
+    auto options = m_jitterOptions;
+    options.compress = m_jitterLate == Late::compress;
+
+    return options;
+}
+
+const KeywordOptions& Config::keywordOptions() const {
+    return m_keywordOptions;
+}
+
+SegmentOptions Config::segmentOptions() const {
+    SegmentOptions options;
+    options.seconds = m_segmentSeconds;
+    options.bytes = static_cast<uint64_t>(m_segmentMb) << 20;
+
+    return options;
+}
+
+UploadOptions Config::uploadOptions() const {
+    auto options = m_uploadOptions;
+    options.s3.partSize = static_cast<size_t>(m_uploadPartMb) << 20;
+    options.maxDiskBytes = static_cast<uint64_t>(m_maxDiskMb) << 20;
+
+    return options;
+}
+
+DeepgramOptions Config::deepgramOptions() const {
+    auto options = m_deepgramOptions;
+    options.enabled = m_deepgram;
+
+    return options;
+}
+
+const string& Config::socketPath() const {
+    return m_socketPath;
+}
+
+void Config::setSocketPath(const string& path) {
+    m_socketPath = path;
+}
+
+bool Config::isStandby() const {
+    return m_standby;
+}
+
+void Config::setStandby(bool standby) {
+    m_standby = standby;
+}
+
+bool Config::useControl() const {
+    return m_control;
+}
+
+bool Config::isSupervisor() const {
+    return m_supervisor;
+}
+
+const string& Config::controlPath() const {
+    return m_controlPath;
+}
+
+size_t Config::maxWorkers() const {
+    return m_maxWorkers;
+}
+
+size_t Config::poolSize() const {
+    return m_poolSize;
+}
+
+chrono::seconds Config::drainTimeout() const {
+    return chrono::seconds(m_drainSeconds);
+}
+
+uint16_t Config::metricsPort() const {
+    return m_metricsPort;
+}
+
+const ThreadRoleOptions& Config::threadRoleOptions() const {
+    return m_threadRoles;
+}
+
+LogLevel Config::logLevel() const {
+    return LogOption::parseLevel(m_logLevel);
+}
+
+LogFormat Config::logFormat() const {
+    return LogOption::parseFormat(m_logFormat);
+}
+
 bool Config::isMeetingStart() const {
     return m_isMeetingStart;
 }
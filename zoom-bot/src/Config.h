@@ -5,6 +5,7 @@
 #include <fstream>
 #include <iterator>
 
+#include <chrono>
 #include <codecvt>
 #include <algorithm>
 #include <locale>
@@ -13,6 +14,21 @@
 #include <CLI/CLI.hpp>
 
 #include "util/UrlParser.h"
+#include "util/OverflowPolicy.h"
+#include "util/Log.h"
+#include "util/ThreadRoles.h"
+#include "video/VideoEncoder.h"
+#include "video/DetectionScheduler.h"
+#include "video/FaceDetector.h"
+#include "video/VideoSubscriptions.h"
+#include "audio/VoiceActivityDetector.h"
+#include "audio/AudioEncoder.h"
+#include "audio/SpeakerSelector.h"
+#include "audio/JitterBuffer.h"
+#include "audio/KeywordSpotter.h"
+#include "control/JoinRequest.h"
+#include "egress/DeepgramSink.h"
+#include "storage/SegmentUploader.h"
 
 using namespace std;
 
@@ -28,10 +44,47 @@ class Config {
     string m_audioFile;
     bool m_separateParticipantAudio;
     bool m_transcribe;
+    size_t m_audioRingSlots = 64;
+    string m_audioOverflow = Overflow::dropOldest;
+    unsigned int m_audioOutputRate = 0;
+    size_t m_subscriberQueue = 200;
+    string m_subscriberOverflow = Overflow::dropOldest;
+    bool m_streamParticipants = false;
+    unsigned int m_batchMs = 40;
+    bool m_streamSpeakers = false;
+    SpeakerOptions m_speakerOptions;
+    string m_vad = Vad::off;
+    string m_participantVad = Vad::off;
+    float m_vadThreshold = 9.0f;
+    unsigned int m_vadHangover = 300;
+    unsigned int m_vadPreroll = 100;
+    unsigned int m_vadKeepalive = 1000;
+    string m_codec = Codec::pcm;
+    string m_fileCodec = Codec::pcm;
+    unsigned int m_codecFrameMs = 20;
+    unsigned int m_opusBitrate = 24000;
+    unsigned int m_opusComplexity = 5;
+    unsigned int m_flacLevel = 5;
+    bool m_deepgram = false;
+    DeepgramOptions m_deepgramOptions;
+    JitterOptions m_jitterOptions;
+    string m_jitterLate = Late::compress;
+    KeywordOptions m_keywordOptions;
 
     CLI::App* m_rawRecordVideoCmd;
     string m_videoDir="out";
     string m_videoFile;
+    size_t m_videoWorkers = 2;
+    size_t m_videoQueue = 4;
+    string m_videoFrameSkip = Overflow::dropOldest;
+    string m_videoEncoder = Encoder::automatic;
+    string m_vaapiDevice = "/dev/dri/renderD128";
+    DetectionOptions m_detectionOptions;
+    DetectorOptions m_detectorOptions;
+    size_t m_videoParticipants = 1;
+    string m_speakerResolution = Resolution::p720;
+    string m_thumbnailResolution = Resolution::p180;
+    unsigned int m_speakerHold = 2000;
 
     string m_joinUrl;
     string m_meetingId;
@@ -48,6 +101,39 @@ class Config {
 
     bool m_isMeetingStart;
 
+    string m_socketPath = "/tmp/audio/meeting.sock";
+
+    bool m_standby = false;
+    bool m_control = false;
+
+    bool m_supervisor = false;
+    string m_controlPath = "/tmp/audio/control.sock";
+    size_t m_maxWorkers = 8;
+    size_t m_poolSize = 0;
+    unsigned int m_drainSeconds = 8;
+
+    uint16_t m_metricsPort = 0;
+
+    unsigned int m_segmentSeconds = 0;
+    unsigned int m_segmentMb = 0;
+    UploadOptions m_uploadOptions;
+    unsigned int m_uploadPartMb = 8;
+    unsigned int m_maxDiskMb = 0;
+
+    string m_logLevel = LogOption::info;
+    string m_logFormat = LogOption::text;
+
+    vector<string> m_threadCpus;
+    vector<string> m_threadFifo;
+    vector<string> m_threadNice;
+    ThreadRoleOptions m_threadRoles;
+
+    /**
+     * Fill m_threadRoles from the role=value lists of --thread-cpus, --thread-fifo and --thread-nice
+     * @return false if a role or value is invalid
+     */
+    bool parseThreadRoles();
+
 
 public:
     Config();
@@ -56,6 +142,12 @@ public:
 
     bool parseUrl(const string& join_url);
 
+    /**
+     * Replace the meeting to join with the one a control client asked for
+     * @return false if its join URL cannot be parsed
+     */
+    bool join(const JoinRequest& request);
+
     const string& meetingId() const;
     const string& password() const;
     const string& displayName() const;
@@ -86,6 +178,108 @@ public:
     const string& videoDir() const;
 
     bool separateParticipantAudio() const;
+
+    size_t videoWorkers() const;
+    size_t videoQueueSize() const;
+    OverflowPolicy videoFrameSkip() const;
+    const string& videoEncoder() const;
+    const string& vaapiDevice() const;
+    const DetectionOptions& detectionOptions() const;
+    const DetectorOptions& detectorOptions() const;
+    SubscriptionOptions subscriptionOptions() const;
+
+    size_t audioRingSlots() const;
+    OverflowPolicy audioOverflowPolicy() const;
+    unsigned int audioOutputRate() const;
+    void setAudioOutputRate(unsigned int rate);
+
+    /**
+     * The one check for --output-rate and SetOutputRate
+     * @return true for 0, the SDK rate, or a rate the resampler supports
+     */
+    static bool validOutputRate(unsigned int rate);
+    size_t subscriberQueue() const;
+    OverflowPolicy subscriberOverflowPolicy() const;
+    bool streamParticipants() const;
+
+    /**
+     * Stream or record each participant's audio instead of only the mixed audio
+     */
+    void setParticipantAudio(bool participants);
+    bool participantAudio() const;
+    unsigned int batchMs() const;
+
+    /**
+     * Stream only the one-way audio of whoever is talking; only when transcribing
+     */
+    void setSpeakerAudio(bool speakers);
+    bool speakerAudio() const;
+    SpeakerOptions speakerOptions() const;
+
+    const string& socketPath() const;
+    void setSocketPath(const string& path);
+
+    bool isStandby() const;
+    void setStandby(bool standby);
+    bool useControl() const;
+
+    bool isSupervisor() const;
+    const string& controlPath() const;
+    size_t maxWorkers() const;
+    size_t poolSize() const;
+
+    /**
+     * @return how long a SIGTERM may take before the process exits with whatever is left
+     */
+    chrono::seconds drainTimeout() const;
+
+    /**
+     * @return TCP port of the Prometheus endpoint, 0 if it is off
+     */
+    uint16_t metricsPort() const;
+
+    /**
+     * @return CPUs, scheduling and memory placement of the bot's threads by role
+     */
+    const ThreadRoleOptions& threadRoleOptions() const;
+
+    /**
+     * How the audio and video files are cut into segments, disabled for one file each
+     */
+    SegmentOptions segmentOptions() const;
+
+    /**
+     * Where finished segments go and how much disk they may take
+     */
+    UploadOptions uploadOptions() const;
+
+    LogLevel logLevel() const;
+    LogFormat logFormat() const;
+
+    /**
+     * @param participants options for the one-way streams instead of the mixed one
+     */
+    VadOptions vadOptions(bool participants) const;
+
+    /**
+     * @param file options for the audio files instead of the socket streams
+     */
+    EncoderOptions encoderOptions(bool file) const;
+
+    /**
+     * Where the bot streams the mixed audio for transcription itself, if enabled
+     */
+    DeepgramOptions deepgramOptions() const;
+
+    /**
+     * How the mixed socket audio is re-paced, if at all
+     */
+    JitterOptions jitterOptions() const;
+
+    /**
+     * Model and labels of the keyword spotter on the mixed audio, if enabled
+     */
+    const KeywordOptions& keywordOptions() const;
 };
 
 
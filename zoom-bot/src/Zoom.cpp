@@ -7,9 +7,48 @@ SDKError Zoom::config(int ac, char** av) {
         return SDKERR_INTERNAL_ERROR;
     }
 
+    LogWriter::getInstance().setLevel(m_config.logLevel());
+    LogWriter::getInstance().setFormat(m_config.logFormat());
+    ThreadRoles::getInstance().configure(m_config.threadRoleOptions());
+
+    m_started = m_joinRequested = chrono::steady_clock::now();
+    m_audioEnabled = m_config.useRawAudio();
+    m_videoEnabled = m_config.useRawVideo();
+
     return SDKERR_SUCCESS;
 }
 
+bool Zoom::supervise() {
+    Supervisor supervisor(m_config);
+    Supervisor::Launch launch;
+
+    if (!supervisor.run(launch))
+        exit(supervisor.failed() ? EXIT_FAILURE : EXIT_SUCCESS);
+
+    m_workerId = launch.id;
+    m_started = m_joinRequested = chrono::steady_clock::now();
+    m_config.setSocketPath(launch.socketPath);
+    m_config.setStandby(launch.standby);
+
+    if (!launch.standby && !m_config.join(launch.request))
+        Log::error("unable to parse the join URL of worker " + to_string(m_workerId));
+
+    m_link = make_unique<ControlConnection>(launch.link);
+    m_link->attach([&](ControlConnection& link, const ControlMessage& msg) {
+        handleControl(link, msg);
+    }, [&](ControlConnection& link) {
+        Log::error("lost the link to the supervisor");
+        m_link.reset();
+    });
+
+    if (launch.standby)
+        Log::info("worker " + to_string(m_workerId) + " warming up as a standby");
+    else
+        Log::info("worker " + to_string(m_workerId) + " joining meeting " + m_config.meetingId());
+
+    return true;
+}
+
 SDKError Zoom::init() { 
     InitParam initParam;
 
@@ -29,9 +68,34 @@ SDKError Zoom::init() {
         return err;
     }
 
+    m_initialized = true;
+
+    if ((m_config.isStandby() || m_config.useControl()) && !serveControl())
+        return SDKERR_INTERNAL_ERROR;
+
+    // workers of a supervisor would fight over the port, they answer Metrics requests instead
+    if (m_config.metricsPort() && !m_link && !m_metrics.start(m_config.metricsPort()))
+        return SDKERR_INTERNAL_ERROR;
+
+    // also finishes and queues what a killed predecessor left behind
+    if (m_config.useRawRecording() && m_config.segmentOptions().enabled())
+        m_uploader.start(m_config.uploadOptions(), {m_config.audioDir(), m_config.videoDir()});
+
     return createServices();
 }
 
+bool Zoom::serveControl() {
+    // a supervised worker takes its requests over the link instead
+    if (m_link)
+        return true;
+
+    m_control.setOnRequest([&](ControlConnection& client, const ControlMessage& request) {
+        handleControl(client, request);
+    });
+
+    return m_control.listen(m_config.controlPath());
+}
+
 SDKError Zoom::createServices() {
     auto err = CreateMeetingService(&m_meetingService);
     if (hasError(err)) return err;
@@ -41,6 +105,9 @@ SDKError Zoom::createServices() {
 
     auto meetingServiceEvent = new MeetingServiceEvent();
     meetingServiceEvent->setOnMeetingJoin(onJoin);
+    meetingServiceEvent->setOnStatus([&](MeetingStatus status, int result) {
+        reportStatus(status, result);
+    });
 
     err = m_meetingService->SetEvent(meetingServiceEvent);
     if (hasError(err)) return err;
@@ -48,6 +115,336 @@ SDKError Zoom::createServices() {
     return CreateAuthService(&m_authService);
 }
 
+void Zoom::reportStatus(MeetingStatus status, int result) {
+    auto event = ControlMessage::event(Opcode::MeetingStatus);
+    event.add(Field::MeetingStatus, static_cast<int32_t>(status))
+         .add(Field::MeetingResult, static_cast<int32_t>(result));
+
+    if (status == MEETING_STATUS_INMEETING) {
+        auto ms = elapsedMs(m_joinRequested);
+        Log::info("joined " + to_string(ms) + "ms after the join request");
+        event.add(Field::JoinMs, ms);
+    }
+
+    publish(event);
+
+    if (status == MEETING_STATUS_ENDED || status == MEETING_STATUS_FAILED) {
+        // the SDK drops the renderers and the audio subscription along with the meeting
+        if (m_video)
+            m_video->release();
+        m_recording = m_audioSubscribed = false;
+    }
+
+    // a worker only exists for its meeting, exit once the callback has returned
+    if (m_link && (status == MEETING_STATUS_ENDED || status == MEETING_STATUS_FAILED))
+        g_idle_add(onWorkerDone, nullptr);
+}
+
+void Zoom::publish(const ControlMessage& event) {
+    if (m_link)
+        m_link->send(event);
+
+    m_control.broadcast(event);
+}
+
+void Zoom::standby() {
+    if (m_ready) {
+        Log::success("refreshed the SDK authorization");
+        return;
+    }
+
+    m_ready = true;
+    auto ms = elapsedMs(m_started);
+    Log::success("standing by, " + to_string(ms) + "ms after start");
+
+    auto event = ControlMessage::event(Opcode::Ready);
+    event.add(Field::StartupMs, ms);
+    publish(event);
+}
+
+void Zoom::scheduleRefresh() {
+    if (!m_config.isStandby())
+        return;
+
+    if (m_refreshTimer)
+        g_source_remove(m_refreshTimer);
+
+    auto left = chrono::duration_cast<chrono::seconds>(m_exp - chrono::system_clock::now() - c_refreshMargin);
+    auto delay = max<long long>(left.count(), c_refreshRetry);
+
+    m_refreshTimer = g_timeout_add_seconds(delay, onRefresh, this);
+}
+
+void Zoom::refreshNow() {
+    if (m_refreshTimer)
+        g_source_remove(m_refreshTimer);
+
+    m_refreshTimer = g_idle_add(onRefresh, this);
+}
+
+gboolean Zoom::onRefresh(gpointer data) {
+    auto* self = static_cast<Zoom*>(data);
+    self->m_refreshTimer = 0;
+
+    // the JWT only gates new joins, so a meeting in progress is left alone until it is over
+    if (!self->isIdle()) {
+        self->m_refreshTimer = g_timeout_add_seconds(self->c_refreshRetry, onRefresh, self);
+        return G_SOURCE_REMOVE;
+    }
+
+    auto err = self->auth();
+    if (hasError(err, "refresh the SDK authorization"))
+        self->m_refreshTimer = g_timeout_add_seconds(self->c_refreshRetry, onRefresh, self);
+
+    return G_SOURCE_REMOVE;
+}
+
+gboolean Zoom::onFirstAudio(gpointer data) {
+    auto* self = static_cast<Zoom*>(data);
+    auto ms = self->m_firstAudioMs.load();
+
+    Log::success("first audio " + to_string(ms) + "ms after the join request");
+
+    auto event = ControlMessage::event(Opcode::FirstAudio);
+    event.add(Field::FirstAudioMs, ms);
+    self->publish(event);
+
+    return G_SOURCE_REMOVE;
+}
+
+gboolean Zoom::onKeyword(gpointer data) {
+    unique_ptr<ControlMessage> event(static_cast<ControlMessage*>(data));
+    getInstance().publish(*event);
+
+    return G_SOURCE_REMOVE;
+}
+
+void Zoom::handleControl(ControlConnection& peer, const ControlMessage& request) {
+    if (request.flags & (ControlMessage::c_flagResponse | ControlMessage::c_flagEvent))
+        return;
+
+    switch (request.opcode) {
+        case Opcode::Join:
+            joinRequested(peer, request);
+            break;
+        case Opcode::Leave:
+            if (isIdle()) {
+                peer.send(ControlMessage::response(request, ControlStatus::Busy, "not in a meeting"));
+                break;
+            }
+            peer.send(ControlMessage::response(request, hasError(leave(), "leave the meeting") ?
+                ControlStatus::Failed : ControlStatus::Ok));
+            break;
+        case Opcode::Status:
+            statusRequested(peer, request);
+            break;
+        case Opcode::SetAudio:
+        case Opcode::SetVideo:
+            toggleRequested(peer, request);
+            break;
+        case Opcode::SetAudioMode:
+            audioModeRequested(peer, request);
+            break;
+        case Opcode::SetOutputRate:
+            outputRateRequested(peer, request);
+            break;
+        case Opcode::Metrics:
+            metricsRequested(peer, request);
+            break;
+        default:
+            peer.send(ControlMessage::response(request, ControlStatus::UnknownOpcode));
+            break;
+    }
+}
+
+void Zoom::joinRequested(ControlConnection& peer, const ControlMessage& request) {
+    if (!m_ready) {
+        peer.send(ControlMessage::response(request, ControlStatus::Busy, "not authorized yet"));
+        return;
+    }
+
+    if (!isIdle()) {
+        peer.send(ControlMessage::response(request, ControlStatus::Busy, "already in a meeting"));
+        return;
+    }
+
+    JoinRequest meeting;
+    if (!meeting.read(request)) {
+        peer.send(ControlMessage::response(request, ControlStatus::BadRequest, "meeting ID or join URL required"));
+        return;
+    }
+
+    if (!m_config.join(meeting)) {
+        peer.send(ControlMessage::response(request, ControlStatus::BadRequest, "unable to parse the join URL"));
+        return;
+    }
+
+    m_joinRequested = chrono::steady_clock::now();
+
+    auto err = isMeetingStart() ? start() : join();
+    if (hasError(err, "join meeting " + m_config.meetingId())) {
+        peer.send(ControlMessage::response(request, ControlStatus::Failed, "join failed with status " + to_string(err)));
+        return;
+    }
+
+    peer.send(ControlMessage::response(request, ControlStatus::Ok));
+}
+
+void Zoom::statusRequested(ControlConnection& peer, const ControlMessage& request) {
+    auto status = m_meetingService ? m_meetingService->GetMeetingStatus() : MEETING_STATUS_IDLE;
+    auto mode = m_config.speakerAudio() ? AudioMode::Speakers
+              : m_config.participantAudio() ? AudioMode::Participants : AudioMode::Mixed;
+
+    auto response = ControlMessage::response(request, ControlStatus::Ok);
+    response.add(Field::MeetingStatus, static_cast<int32_t>(status))
+            .add(Field::Audio, static_cast<uint32_t>(m_audioEnabled))
+            .add(Field::Video, static_cast<uint32_t>(m_videoEnabled))
+            .add(Field::AudioMode, static_cast<uint32_t>(mode))
+            .add(Field::SampleRate, m_config.audioOutputRate());
+
+    if (m_workerId)
+        response.add(Field::WorkerId, m_workerId);
+
+    if (!m_config.meetingId().empty())
+        response.add(Field::MeetingId, m_config.meetingId());
+
+    peer.send(response);
+}
+
+void Zoom::toggleRequested(ControlConnection& peer, const ControlMessage& request) {
+    auto audio = request.opcode == Opcode::SetAudio;
+
+    uint32_t enabled;
+    if (!request.get(Field::Enabled, enabled)) {
+        peer.send(ControlMessage::response(request, ControlStatus::BadRequest, "enabled field required"));
+        return;
+    }
+
+    // raw data needs the recording privilege, only asked for when a raw stream was configured
+    if (audio ? !m_config.useRawAudio() : !m_config.useRawVideo()) {
+        auto command = audio ? "RawAudio" : "RawVideo";
+        peer.send(ControlMessage::response(request, ControlStatus::BadRequest, string("start the bot with the ") + command + " command"));
+        return;
+    }
+
+    (audio ? m_audioEnabled : m_videoEnabled) = enabled;
+
+    SDKError err = SDKERR_SUCCESS;
+    if (m_recording) {
+        if (audio)
+            err = enabled ? startRawAudio() : stopRawAudio();
+        else
+            err = enabled ? startRawVideo() : stopRawVideo();
+    }
+
+    if (hasError(err, string(enabled ? "enable" : "disable") + " raw " + (audio ? "audio" : "video"))) {
+        peer.send(ControlMessage::response(request, ControlStatus::Failed, "failed with status " + to_string(err)));
+        return;
+    }
+
+    peer.send(ControlMessage::response(request, ControlStatus::Ok));
+}
+
+void Zoom::audioModeRequested(ControlConnection& peer, const ControlMessage& request) {
+    uint32_t mode;
+    if (!request.get(Field::AudioMode, mode) || mode > static_cast<uint32_t>(AudioMode::Speakers)) {
+        peer.send(ControlMessage::response(request, ControlStatus::BadRequest, "audio mode must be 0 (mixed), 1 (participants) or 2 (speakers)"));
+        return;
+    }
+
+    auto participants = static_cast<AudioMode>(mode) == AudioMode::Participants;
+    auto speakers = static_cast<AudioMode>(mode) == AudioMode::Speakers;
+
+    // speaker frames only exist on the socket
+    if (speakers && !m_config.transcribe()) {
+        peer.send(ControlMessage::response(request, ControlStatus::BadRequest, "speaker audio needs RawAudio --transcribe"));
+        return;
+    }
+
+    m_config.setParticipantAudio(participants);
+    m_config.setSpeakerAudio(speakers);
+
+    if (m_audioSource) {
+        m_audioSource->setParticipantAudio(participants);
+        m_audioSource->setSpeakerAudio(speakers);
+    }
+
+    Log::info("switched to ", speakers ? "active speaker" : participants ? "per-participant" : "mixed", " audio");
+    peer.send(ControlMessage::response(request, ControlStatus::Ok));
+}
+
+void Zoom::outputRateRequested(ControlConnection& peer, const ControlMessage& request) {
+    uint32_t rate;
+    if (!request.get(Field::SampleRate, rate) || !Config::validOutputRate(rate)) {
+        peer.send(ControlMessage::response(request, ControlStatus::BadRequest, "sample rate must be 0 or 8000-48000"));
+        return;
+    }
+
+    m_config.setAudioOutputRate(rate);
+
+    if (m_audioSource)
+        m_audioSource->setOutputRate(rate);
+
+    Log::info("socket audio output rate set to " + (rate ? to_string(rate) : string("the SDK rate")));
+    peer.send(ControlMessage::response(request, ControlStatus::Ok));
+}
+
+void Zoom::metricsRequested(ControlConnection& peer, const ControlMessage& request) {
+    auto text = Metrics::getInstance().render();
+
+    // a message carries at most 64KiB, cut at a line so every sample that is sent is whole
+    if (text.size() > c_maxMetrics) {
+        auto end = text.rfind('\n', c_maxMetrics - 1);
+        text.resize(end == string::npos ? 0 : end + 1);
+    }
+
+    auto response = ControlMessage::response(request, ControlStatus::Ok);
+    response.add(Field::Metrics, text);
+    peer.send(response);
+}
+
+void Zoom::publishParticipants(Opcode opcode, const vector<unsigned int>& userIds) {
+    auto event = ControlMessage::event(opcode);
+    for (auto id : userIds)
+        event.add(Field::UserId, static_cast<uint32_t>(id));
+
+    publish(event);
+}
+
+vector<pair<uint32_t, string>> Zoom::speakerNames(const vector<unsigned int>& userIds) {
+    vector<pair<uint32_t, string>> speakers;
+    speakers.reserve(userIds.size());
+
+    auto* participantsCtl = m_meetingService->GetMeetingParticipantsController();
+
+    for (auto id : userIds) {
+        auto* user = participantsCtl ? participantsCtl->GetUserByUserID(id) : nullptr;
+        if (user && user->IsMySelf())
+            continue;
+
+        auto* name = user ? user->GetUserName() : nullptr;
+        speakers.emplace_back(id, name ? name : "");
+    }
+
+    return speakers;
+}
+
+bool Zoom::isIdle() {
+    if (!m_meetingService)
+        return true;
+
+    auto status = m_meetingService->GetMeetingStatus();
+    return status == MEETING_STATUS_IDLE || status == MEETING_STATUS_ENDED || status == MEETING_STATUS_FAILED;
+}
+
+uint32_t Zoom::elapsedMs(chrono::steady_clock::time_point since) {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - since).count();
+}
+
+gboolean Zoom::onWorkerDone(gpointer data) {
+    exit(EXIT_SUCCESS);
+}
+
 SDKError Zoom::auth() {
     SDKError err{SDKERR_UNINITIALIZE};
 
@@ -65,15 +462,29 @@ SDKError Zoom::auth() {
         return err;
     }
 
-    err = m_authService->SetEvent(new AuthServiceEvent(onAuth));
-    if (hasError(err)) return err;
+    if (!m_authEvent) {
+        m_authEvent = new AuthServiceEvent(onAuth);
+        m_authEvent->setOnZoomAuthIdentityExpired([&]() {
+            if (!m_config.isStandby()) return;
+
+            Log::info("SDK authorization expires soon");
+            refreshNow();
+        });
+
+        err = m_authService->SetEvent(m_authEvent);
+        if (hasError(err)) return err;
+    }
 
     generateJWT(m_config.clientId(), m_config.clientSecret());
 
     AuthContext ctx;
     ctx.jwt_token =  m_jwt.c_str();
 
-    return m_authService->SDKAuth(ctx);
+    err = m_authService->SDKAuth(ctx);
+    if (!hasError(err))
+        scheduleRefresh();
+
+    return err;
 }
 
 void Zoom::generateJWT(const string& key, const string& secret) {
@@ -185,7 +596,50 @@ SDKError Zoom::leave() {
     return  m_meetingService->Leave(LEAVE_MEETING);
 }
 
+void Zoom::drain() {
+    if (!m_initialized || m_drained)
+        return;
+
+    m_drained = true;
+
+    auto timeout = m_config.drainTimeout();
+    auto deadline = chrono::steady_clock::now() + timeout;
+
+    // whatever hangs, an unreachable bucket or a stuck encoder, must not hold up the exit
+    thread([abort = deadline + c_drainGrace, timeout]() {
+        ThreadRoles::assign(ThreadRole::Control);
+        this_thread::sleep_until(abort);
+
+        Log::error("shutdown took longer than ", timeout.count(), "s, exiting anyway");
+        Log::flush();
+        _Exit(EXIT_FAILURE);
+    }).detach();
+
+    Log::info("draining the media streams, for at most ", timeout.count(), "s");
+
+    // nothing new is queued behind the flush
+    if (m_audioHelper)
+        m_audioHelper->unSubscribe();
+    m_audioSubscribed = false;
+
+    if (m_audioSource)
+        m_audioSource->close(deadline);
+
+    // unsubscribes every participant, then the delegates finish their frames and close their files
+    m_video.reset();
+
+    // the segments finished just now go along if there is time
+    m_uploader.drain(deadline);
+
+    Log::success("drained the media streams");
+}
+
 SDKError Zoom::clean() {
+    if (!m_initialized)
+        return SDKERR_UNINITIALIZE;
+
+    drain();
+
     if (m_meetingService)
         DestroyMeetingService(m_meetingService);
 
@@ -195,13 +649,9 @@ SDKError Zoom::clean() {
     if (m_authService)
         DestroyAuthService(m_authService);
 
-    if (m_audioHelper)
-        m_audioHelper->unSubscribe();
+    m_metrics.stop();
+    m_initialized = false;
 
-    if (m_videoHelper)
-        m_videoHelper->unSubscribe();
-
-    delete m_renderDelegate;
     return CleanUPSDK();
 }
 
@@ -221,85 +671,156 @@ SDKError Zoom::startRawRecording() {
     if (hasError(err, "start raw recording"))
         return err;
 
-    if (m_config.useRawVideo()) {
-        if (!m_renderDelegate) {
-            m_renderDelegate = new ZoomSDKRendererDelegate();
-            m_videoSource = new ZoomSDKVideoSource();
-        }
+    m_recording = true;
 
-        err = createRenderer(&m_videoHelper, m_renderDelegate);
-        if (hasError(err, "create raw video renderer"))
+    if (m_videoEnabled) {
+        err = startRawVideo();
+        if (hasError(err))
             return err;
+    }
 
-        m_renderDelegate->setDir(m_config.videoDir());
-        m_renderDelegate->setFilename(m_config.videoFile());
-        
-        auto participantCtl = m_meetingService->GetMeetingParticipantsController();
-        auto uid = participantCtl->GetParticipantsList()->GetItem(0);
-
-        m_videoHelper->setRawDataResolution(ZoomSDKResolution_720P);
-        err = m_videoHelper->subscribe(uid, RAW_DATA_TYPE_VIDEO);
-        if (hasError(err, "subscribe to raw video"))
+    if (m_audioEnabled) {
+        err = startRawAudio();
+        if (hasError(err))
             return err;
+    }
 
-        Log::info("writing video raw data to " + m_renderDelegate->dir() + "/" + m_renderDelegate->filename());
+    return SDKERR_SUCCESS;
+}
 
-  /*      auto* videoSourceHelper = GetRawdataVideoSourceHelper();
-        if (!videoSourceHelper) {
-            Log::error("Initializing Video Source Helper");
-            return SDKERR_UNINITIALIZE;
-        }
+SDKError Zoom::startRawVideo() {
+    if (m_video && m_video->isActive())
+        return SDKERR_SUCCESS;
 
-        err = videoSourceHelper->setExternalVideoSource(m_videoSource);
-        if (hasError(err, "set video source"))
-            return err;
+    if (!m_video) {
+        m_videoSource = new ZoomSDKVideoSource();
 
-        auto* videoSettings = m_settingService->GetVideoSettings();
-        videoSettings->EnableAutoTurnOffVideoWhenJoinMeeting(false);
+        auto participantCtl = m_meetingService->GetMeetingParticipantsController();
+        m_video = make_unique<VideoSubscriptions>(participantCtl, m_config.subscriptionOptions(), [&](ZoomSDKRendererDelegate& delegate) {
+            delegate.setDir(m_config.videoDir());
+            delegate.setFilename(m_config.videoFile());
+            delegate.configureWorkers(m_config.videoWorkers(), m_config.videoQueueSize(), m_config.videoFrameSkip());
+            delegate.configureDetection(m_config.detectionOptions());
+            delegate.setDetector(m_config.detectorOptions());
+            delegate.setEncoder(m_config.videoEncoder(), m_config.vaapiDevice());
+            delegate.setSegments(m_config.segmentOptions(), [this](const string& path) { m_uploader.add(path); });
+        });
+    }
 
-       auto* sender = m_videoSource->getSender();
-        SDKError e;
-        do {
-            Log::info("attempting unmute");
-            auto* videoCtl = m_meetingService->GetMeetingVideoController();
-            e = videoCtl->UnmuteVideo();
-            if (hasError(e, "unmute")) sleep(1);
-        } while (hasError(e));*/
+    if (!m_video->start()) {
+        Log::error("failed to subscribe to raw video");
+        return SDKERR_INTERNAL_ERROR;
+    }
 
+  /*      auto* videoSourceHelper = GetRawdataVideoSourceHelper();
+    if (!videoSourceHelper) {
+        Log::error("Initializing Video Source Helper");
+        return SDKERR_UNINITIALIZE;
     }
 
-    if (m_config.useRawAudio()) {
-        auto* audioController = m_meetingService->GetMeetingAudioController();
-        if (audioController) {
-            auto voipErr = audioController->JoinVoip();
-            if (hasError(voipErr, "join VoIP")) {
-                Log::error("Failed to join VoIP audio");
-            }
-        }
+    err = videoSourceHelper->setExternalVideoSource(m_videoSource);
+    if (hasError(err, "set video source"))
+        return err;
 
-        m_audioHelper = GetAudioRawdataHelper();
-        if (!m_audioHelper)
-            return SDKERR_UNINITIALIZE;
+    auto* videoSettings = m_settingService->GetVideoSettings();
+    videoSettings->EnableAutoTurnOffVideoWhenJoinMeeting(false);
 
-        if (!m_audioSource) {
-            auto mixedAudio = !m_config.separateParticipantAudio();
-            auto transcribe = m_config.transcribe();
+   auto* sender = m_videoSource->getSender();
+    SDKError e;
+    do {
+        Log::info("attempting unmute");
+        auto* videoCtl = m_meetingService->GetMeetingVideoController();
+        e = videoCtl->UnmuteVideo();
+        if (hasError(e, "unmute")) sleep(1);
+    } while (hasError(e));*/
 
-            m_audioSource = new ZoomSDKAudioRawDataDelegate(mixedAudio, transcribe);
-            m_audioSource->setDir(m_config.audioDir());
-            m_audioSource->setFilename(m_config.audioFile());
+    return SDKERR_SUCCESS;
+}
+
+SDKError Zoom::stopRawVideo() {
+    if (!m_video || !m_video->isActive())
+        return SDKERR_SUCCESS;
+
+    m_video->stop();
+    Log::success("unsubscribe from raw video");
+
+    return SDKERR_SUCCESS;
+}
+
+SDKError Zoom::startRawAudio() {
+    if (m_audioSubscribed)
+        return SDKERR_SUCCESS;
+
+    SDKError err;
+
+    auto* audioController = m_meetingService->GetMeetingAudioController();
+    if (audioController) {
+        auto voipErr = audioController->JoinVoip();
+        if (hasError(voipErr, "join VoIP")) {
+            Log::error("Failed to join VoIP audio");
         }
+    }
 
-        err = m_audioHelper->subscribe(m_audioSource);
-        if (hasError(err, "subscribe to raw audio"))
-            return err;
+    m_audioHelper = GetAudioRawdataHelper();
+    if (!m_audioHelper)
+        return SDKERR_UNINITIALIZE;
 
-        Log::info("writing audio raw data to " + m_audioSource->dir() + "/" + m_audioSource->filename());
+    if (!m_audioSource) {
+        auto mixedAudio = !m_config.separateParticipantAudio();
+        auto transcribe = m_config.transcribe();
+
+        m_audioSource = new ZoomSDKAudioRawDataDelegate(mixedAudio, transcribe);
+        m_audioSource->setDir(m_config.audioDir());
+        m_audioSource->setFilename(m_config.audioFile());
+        m_audioSource->setSocketPath(m_config.socketPath());
+        m_audioSource->setRingOptions(m_config.audioRingSlots(), m_config.audioOverflowPolicy());
+        m_audioSource->setSubscriberOptions(m_config.subscriberQueue(), m_config.subscriberOverflowPolicy());
+        m_audioSource->setOutputRate(m_config.audioOutputRate());
+        m_audioSource->setStreamParticipants(m_config.streamParticipants(), m_config.batchMs());
+        m_audioSource->setStreamSpeakers(m_config.speakerAudio(), m_config.speakerOptions());
+        m_audioSource->setVad(m_config.vadOptions(false), m_config.vadOptions(true));
+        m_audioSource->setDeepgram(m_config.deepgramOptions());
+        m_audioSource->setJitter(m_config.jitterOptions());
+        m_audioSource->setKeywords(m_config.keywordOptions(), [this](const KeywordEvent& keyword) {
+            auto event = ControlMessage::event(Opcode::Keyword);
+            event.add(Field::Keyword, keyword.keyword);
+            event.add(Field::Confidence, static_cast<uint32_t>(lround(keyword.confidence * 1000)));
+            event.add(Field::LatencyMs, static_cast<uint32_t>((FrameHeader::now() - keyword.timestamp) / 1000000));
+
+            // built here, sent from the loop, which owns the control connections
+            g_idle_add(onKeyword, new ControlMessage(std::move(event)));
+        });
+        m_audioSource->setEncoding(m_config.encoderOptions(false), m_config.encoderOptions(true));
+        m_audioSource->setSegments(m_config.segmentOptions(), [this](const string& path) { m_uploader.add(path); });
+        m_audioSource->start();
     }
 
+    m_audioSource->setOnFirstAudio([&]() {
+        m_firstAudioMs = elapsedMs(m_joinRequested);
+        g_idle_add(onFirstAudio, this);
+    });
+
+    err = m_audioHelper->subscribe(m_audioSource);
+    if (hasError(err, "subscribe to raw audio"))
+        return err;
+
+    Log::info("writing audio raw data to " + m_audioSource->dir() + "/" + m_audioSource->filename());
+
+    m_audioSubscribed = true;
     return SDKERR_SUCCESS;
 }
 
+SDKError Zoom::stopRawAudio() {
+    if (!m_audioSubscribed || !m_audioHelper)
+        return SDKERR_SUCCESS;
+
+    auto err = m_audioHelper->unSubscribe();
+    hasError(err, "unsubscribe from raw audio");
+
+    m_audioSubscribed = false;
+    return err;
+}
+
 SDKError Zoom::stopRawRecording() {
     auto recCtrl = m_meetingService->GetMeetingRecordingController();
     auto err = recCtrl->StopRawRecording();
@@ -312,6 +833,10 @@ bool Zoom::isMeetingStart() {
     return m_config.isMeetingStart();
 }
 
+bool Zoom::isSupervisor() {
+    return m_config.isSupervisor();
+}
+
 
 bool Zoom::hasError(const SDKError e, const string& action) {
     auto isError = e != SDKERR_SUCCESS;
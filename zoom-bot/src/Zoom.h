@@ -1,16 +1,19 @@
 #ifndef MEETING_SDK_LINUX_SAMPLE_ZOOM_H
 #define MEETING_SDK_LINUX_SAMPLE_ZOOM_H
 
+#include <atomic>
 #include <iostream>
 #include <chrono>
 #include <string>
 #include <sstream>
+#include <thread>
 
 #include <jwt-cpp/jwt.h>
 
 #include "Config.h"
 #include "util/Singleton.h"
 #include "util/Log.h"
+#include "util/MetricsServer.h"
 
 
 #include "zoom_sdk.h"
@@ -26,12 +29,19 @@
 #include "events/MeetingServiceEvent.h"
 #include "events/MeetingReminderEvent.h"
 #include "events/MeetingRecordingCtrlEvent.h"
+#include "events/MeetingParticipantsCtrlEvent.h"
+#include "events/MeetingAudioCtrlEvent.h"
 
 #include "raw_record/ZoomSDKRendererDelegate.h"
 #include "raw_record/ZoomSDKAudioRawDataDelegate.h"
 
+#include "video/VideoSubscriptions.h"
+
 #include "raw_send/ZoomSDKVideoSource.h"
 
+#include "control/ControlConnection.h"
+#include "control/Supervisor.h"
+
 using namespace std;
 using namespace jwt;
 using namespace ZOOMSDK;
@@ -53,21 +63,115 @@ class Zoom : public Singleton<Zoom> {
     ISettingService* m_settingService;
     IAuthService* m_authService;
 
-    IZoomSDKRenderer* m_videoHelper;
-    ZoomSDKRendererDelegate* m_renderDelegate;
+    // declared before the delegates, which hand it their last segments when they close
+    SegmentUploader m_uploader;
+
+    unique_ptr<VideoSubscriptions> m_video;
 
     IZoomSDKAudioRawDataHelper* m_audioHelper;
     ZoomSDKAudioRawDataDelegate* m_audioSource;
 
     ZoomSDKVideoSource* m_videoSource;
 
+    MeetingParticipantsCtrlEvent* m_participantsEvent;
+
+    bool m_initialized = false;
+
+    // a shutdown flushes the media within --drain-timeout, the SDK cleanup gets this on top
+    const chrono::seconds c_drainGrace{2};
+    bool m_drained = false;
+
+    // set in a worker forked by the supervisor
+    uint32_t m_workerId = 0;
+    unique_ptr<ControlConnection> m_link;
+
+    // standby: authenticated and waiting for a Join, with the JWT renewed before it expires
+    const chrono::minutes c_refreshMargin{10};
+    const guint c_refreshRetry = 60;
+
+    AuthServiceEvent* m_authEvent = nullptr;
+    ControlServer m_control;
+    bool m_ready = false;
+
+    // the Prometheus text of a Metrics response, leaving room for the header fields
+    const size_t c_maxMetrics = 60 * 1024;
+    MetricsServer m_metrics;
+    guint m_refreshTimer = 0;
+
+    // what the control plane has switched on, applied whenever raw recording is allowed
+    bool m_audioEnabled = false;
+    bool m_videoEnabled = false;
+    bool m_recording = false;
+    bool m_audioSubscribed = false;
+
+    chrono::steady_clock::time_point m_started;
+    chrono::steady_clock::time_point m_joinRequested;
+    atomic<uint32_t> m_firstAudioMs{0};
+
     SDKError createServices();
     void generateJWT(const string& key, const string& secret);
 
+    /**
+     * Tell the supervisor about a meeting status change
+     */
+    void reportStatus(MeetingStatus status, int result);
+    static gboolean onWorkerDone(gpointer data);
+
+    /**
+     * Send an event to the supervisor and every control client
+     */
+    void publish(const ControlMessage& event);
+
+    /**
+     * Accept control clients on --control-path, unless a supervisor link serves instead
+     * @return false if the socket cannot be bound
+     */
+    bool serveControl();
+    void standby();
+    void scheduleRefresh();
+    void refreshNow();
+    static gboolean onRefresh(gpointer data);
+    static gboolean onFirstAudio(gpointer data);
+    static gboolean onKeyword(gpointer data);
+
+    void handleControl(ControlConnection& peer, const ControlMessage& request);
+    void joinRequested(ControlConnection& peer, const ControlMessage& request);
+    void statusRequested(ControlConnection& peer, const ControlMessage& request);
+    void toggleRequested(ControlConnection& peer, const ControlMessage& request);
+    void audioModeRequested(ControlConnection& peer, const ControlMessage& request);
+    void outputRateRequested(ControlConnection& peer, const ControlMessage& request);
+    void metricsRequested(ControlConnection& peer, const ControlMessage& request);
+
+    /**
+     * @return the talking users other than the bot, with their display names
+     */
+    vector<pair<uint32_t, string>> speakerNames(const vector<unsigned int>& userIds);
+
+    /**
+     * Tell control clients who came or went
+     */
+    void publishParticipants(Opcode opcode, const vector<unsigned int>& userIds);
+
+    SDKError startRawVideo();
+    SDKError stopRawVideo();
+    SDKError startRawAudio();
+    SDKError stopRawAudio();
+
+    /**
+     * @return true if there is no meeting to disturb
+     */
+    bool isIdle();
+    static uint32_t elapsedMs(chrono::steady_clock::time_point since);
+
     /**
      * Callback fired when the SDK authenticates the credentials
     */
     function<void()> onAuth = [&]() {
+        if (m_config.isStandby())
+            return standby();
+
+        m_ready = true;
+
         auto e = isMeetingStart() ? start() : join();
         string action = isMeetingStart() ? "start" : "join";
         
@@ -81,6 +185,39 @@ class Zoom : public Singleton<Zoom> {
         auto* reminderController = m_meetingService->GetMeetingReminderController();
         reminderController->SetEvent(new MeetingReminderEvent());
 
+        m_participantsEvent = new MeetingParticipantsCtrlEvent();
+        m_participantsEvent->setOnUserJoin([&](const vector<unsigned int>& userIds) {
+            publishParticipants(Opcode::ParticipantJoined, userIds);
+            if (m_video)
+                m_video->joined(userIds);
+        });
+        m_participantsEvent->setOnUserLeft([&](const vector<unsigned int>& userIds) {
+            publishParticipants(Opcode::ParticipantLeft, userIds);
+            if (m_video)
+                m_video->left(userIds);
+
+            if (!m_audioSource) return;
+
+            for (auto id : userIds)
+                m_audioSource->closeParticipant(id);
+        });
+
+        auto* participantsCtl = m_meetingService->GetMeetingParticipantsController();
+        participantsCtl->SetEvent(m_participantsEvent);
+
+        // who is talking decides whose video is received large
+        auto* audioCtl = m_meetingService->GetMeetingAudioController();
+        if (audioCtl) {
+            auto* audioEvent = new MeetingAudioCtrlEvent();
+            audioEvent->setOnActiveAudioChange([&](const vector<unsigned int>& userIds) {
+                if (m_video)
+                    m_video->speaking(userIds);
+                if (m_audioSource)
+                    m_audioSource->setActiveSpeakers(speakerNames(userIds));
+            });
+            audioCtl->SetEvent(audioEvent);
+        }
+
         if (!m_config.useRawRecording())  
             return;
 
@@ -112,16 +249,30 @@ public:
     SDKError auth();
     SDKError config(int ac, char** av);
 
+    /**
+     * Serve the supervisor control socket; call before init()
+     * @return true in a forked worker, which continues with the meeting it was given
+     */
+    bool supervise();
+
     SDKError join();
     SDKError start();
     SDKError leave();
 
+    /**
+     * Stop the raw data callbacks and flush what is on its way out: the audio stages and
+     * socket subscribers, the queued video frames and encoders, and the segment uploads.
+     * Should that hang, the process exits by itself --drain-timeout later.
+     */
+    void drain();
+
     SDKError clean();
 
     SDKError startRawRecording();
     SDKError stopRawRecording();
 
     bool isMeetingStart();
+    bool isSupervisor();
 
     static bool hasError(SDKError e, const string& action="");
 
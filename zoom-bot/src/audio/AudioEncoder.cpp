@@ -0,0 +1,106 @@
+#include "AudioEncoder.h"
+
+#include "OpusAudioEncoder.h"
+#include "FlacAudioEncoder.h"
+
+AudioEncoder::AudioEncoder(const EncoderOptions& options, unsigned int inRate, unsigned int inChannels,
+                           unsigned int rate, unsigned int channels)
+    : m_options(options), m_inRate(inRate), m_inChannels(inChannels), m_rate(rate), m_channels(channels),
+      m_frameSamples(static_cast<size_t>(rate) * options.frameMs / 1000) {
+
+    if (rate != inRate || channels != inChannels)
+        m_resampler = make_unique<Resampler>(inRate, inChannels, rate);
+
+    m_pending.reserve(m_frameSamples * channels * 2);
+}
+
+bool AudioEncoder::write(const FrameHeader& header, const char* buf, size_t len, const Emit& emit) {
+    if (len == 0)
+        return true;
+
+    auto* samples = reinterpret_cast<const int16_t*>(buf);
+    auto count = len / sizeof(int16_t);
+
+    if (m_resampler) {
+        count = m_resampler->process(samples, count / m_inChannels, m_resampled);
+        samples = m_resampled.data();
+    }
+
+    if (m_pending.empty())
+        m_pendingTimestamp = header.timestamp;
+    m_pendingFlags |= header.flags & FrameHeader::c_flagDiscontinuity;
+
+    m_pending.insert(m_pending.end(), samples, samples + count);
+
+    auto frameLen = m_frameSamples * m_channels;
+    auto frameNs = m_frameSamples * 1000000000ull / m_rate;
+    auto ok = true;
+
+    size_t offset = 0;
+    for (; m_pending.size() - offset >= frameLen; offset += frameLen) {
+        ok &= encodeFrame(m_pending.data() + offset, m_pendingTimestamp, m_pendingFlags, m_packets);
+        m_pendingTimestamp += frameNs;
+        m_pendingFlags = 0;
+    }
+    m_pending.erase(m_pending.begin(), m_pending.begin() + offset);
+
+    drain(header, emit);
+    return ok;
+}
+
+bool AudioEncoder::flush(const FrameHeader& header, const Emit& emit) {
+    if (m_pending.empty())
+        return true;
+
+    m_pending.resize(m_frameSamples * m_channels, 0);
+    auto ok = encodeFrame(m_pending.data(), m_pendingTimestamp, m_pendingFlags, m_packets);
+    m_pending.clear();
+    m_pendingFlags = 0;
+
+    drain(header, emit);
+    return ok;
+}
+
+void AudioEncoder::finish(const FrameHeader& header, const Emit& emit) {
+    flush(header, emit);
+    finishStream(m_packets);
+    drain(header, emit);
+}
+
+void AudioEncoder::drain(const FrameHeader& header, const Emit& emit) {
+    for (auto& packet : m_packets) {
+        auto out = header;
+        out.format = format();
+        out.sampleRate = m_rate;
+        out.channels = m_channels;
+        out.timestamp = packet.timestamp;
+        out.flags = packet.flags;
+
+        emit(out, packet.data.data(), packet.data.size());
+    }
+
+    m_packets.clear();
+}
+
+bool AudioEncoder::accepts(unsigned int inRate, unsigned int inChannels) const {
+    return m_inRate == inRate && m_inChannels == inChannels;
+}
+
+unsigned int AudioEncoder::sampleRate() const {
+    return m_rate;
+}
+
+unsigned int AudioEncoder::channels() const {
+    return m_channels;
+}
+
+unique_ptr<AudioEncoder> AudioEncoder::create(const EncoderOptions& options, unsigned int rate, unsigned int channels) {
+    switch (options.codec) {
+        case AudioCodec::Opus:
+            return OpusAudioEncoder::create(options, rate, channels);
+        case AudioCodec::Flac:
+            return FlacAudioEncoder::create(options, rate, channels);
+        default:
+            return nullptr;
+    }
+}
@@ -0,0 +1,147 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_AUDIOENCODER_H
+#define MEETING_SDK_LINUX_SAMPLE_AUDIOENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Resampler.h"
+#include "../util/FrameHeader.h"
+
+using namespace std;
+
+enum class AudioCodec {
+    Pcm,
+    Opus,
+    Flac
+};
+
+namespace Codec {
+    const string pcm = "pcm";
+    const string opus = "opus";
+    const string flac = "flac";
+
+    inline AudioCodec parse(const string& name) {
+        if (name == opus) return AudioCodec::Opus;
+        if (name == flac) return AudioCodec::Flac;
+        return AudioCodec::Pcm;
+    }
+}
+
+struct EncoderOptions {
+    AudioCodec codec = AudioCodec::Pcm;
+
+    // audio per packet; Opus takes 10, 20, 40 or 60
+    unsigned int frameMs = 20;
+
+    unsigned int bitrate = 24000;
+    unsigned int complexity = 5;
+    unsigned int flacLevel = 5;
+};
+
+/**
+ * Turns linear16 chunks of one stream into codec packets of a fixed duration.
+ *
+ * Chunks of any size are collected until a whole frame is there, so the codec always sees
+ * frameMs of audio. Every packet leaves with the capture time of its first sample. Formats
+ * a codec cannot take are resampled to mono at a rate it can, once, before collecting.
+ */
+class AudioEncoder {
+public:
+    typedef function<void(const FrameHeader& header, const char* buf, size_t len)> Emit;
+
+    struct Packet {
+        string data;
+        uint64_t timestamp = 0;
+        uint32_t flags = 0;
+    };
+
+protected:
+    EncoderOptions m_options;
+
+    unsigned int m_inRate;
+    unsigned int m_inChannels;
+    unsigned int m_rate;
+    unsigned int m_channels;
+    size_t m_frameSamples;
+
+    unique_ptr<Resampler> m_resampler;
+    vector<int16_t> m_resampled;
+
+    vector<int16_t> m_pending;
+    uint64_t m_pendingTimestamp = 0;
+    uint32_t m_pendingFlags = 0;
+
+    vector<Packet> m_packets;
+
+    AudioEncoder(const EncoderOptions& options, unsigned int inRate, unsigned int inChannels,
+                 unsigned int rate, unsigned int channels);
+
+    /**
+     * Encode exactly one frame of interleaved samples
+     * @param out receives the packets that are done, which may lag behind for some codecs
+     * @return false if the codec failed
+     */
+    virtual bool encodeFrame(const int16_t* samples, uint64_t timestamp, uint32_t flags, vector<Packet>& out) = 0;
+
+    /**
+     * End the codec's stream, handing out whatever it still holds
+     */
+    virtual void finishStream(vector<Packet>& /*out*/) {}
+
+    void drain(const FrameHeader& header, const Emit& emit);
+
+public:
+    virtual ~AudioEncoder() {};
+
+    AudioEncoder(const AudioEncoder&) = delete;
+    AudioEncoder& operator=(const AudioEncoder&) = delete;
+
+    /**
+     * Add a chunk and emit every packet that is complete
+     * @param header stream, format and capture time of the chunk
+     * @param buf interleaved linear16 samples
+     * @param len number of bytes
+     * @return false if the codec failed and the encoder should be replaced
+     */
+    bool write(const FrameHeader& header, const char* buf, size_t len, const Emit& emit);
+
+    /**
+     * Emit the partial frame padded with silence, e.g. when speech ends
+     */
+    bool flush(const FrameHeader& header, const Emit& emit);
+
+    /**
+     * Flush and end the stream; the encoder is done afterwards
+     */
+    void finish(const FrameHeader& header, const Emit& emit);
+
+    /**
+     * Codec setup a decoder needs before the first packet, empty if there is none
+     */
+    virtual string codecHeader() const { return ""; }
+
+    virtual PayloadFormat format() const = 0;
+    virtual const string& name() const = 0;
+
+    /**
+     * @return true if this encoder was built for chunks of this format
+     */
+    bool accepts(unsigned int inRate, unsigned int inChannels) const;
+
+    unsigned int sampleRate() const;
+    unsigned int channels() const;
+
+    /**
+     * Create an encoder for one stream
+     * @param rate sample rate of the stream's chunks
+     * @param channels channels of the stream's chunks
+     * @return nullptr for pcm or if the codec cannot be set up
+     */
+    static unique_ptr<AudioEncoder> create(const EncoderOptions& options, unsigned int rate, unsigned int channels);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_AUDIOENCODER_H
@@ -0,0 +1,263 @@
+#include "AudioKernels.h"
+#include "AudioKernelsImpl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace AudioKernels {
+
+namespace Baseline {
+
+void toMonoFloat(const int16_t* in, size_t frames, unsigned int channels, float* out) {
+    size_t i = 0;
+
+    if (channels == 2) {
+#if defined(__AVX2__)
+        const __m256 half = _mm256_set1_ps(0.5f);
+        for (; i + 8 <= frames; i += 8) {
+            // widen 16 samples to int32 and add each L/R pair horizontally; hadd works per 128 bit
+            // lane, leaving frames 0-1, 4-5, 2-3, 6-7, so the permute puts the middle pairs back
+            auto lr = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i)));
+            auto lr2 = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 8)));
+            auto sum = _mm256_hadd_epi32(lr, lr2);
+            sum = _mm256_permute4x64_epi64(sum, 0xD8);
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(sum), half));
+        }
+#elif defined(__SSE2__)
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; i + 4 <= frames; i += 4) {
+            auto lr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+            auto sum = _mm_madd_epi16(lr, ones);
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(sum), half));
+        }
+#elif defined(__ARM_NEON)
+        for (; i + 4 <= frames; i += 4) {
+            auto lr = vld2_s16(in + 2 * i);
+            auto sum = vaddl_s16(lr.val[0], lr.val[1]);
+            vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(sum), 0.5f));
+        }
+#endif
+        for (; i < frames; i++)
+            out[i] = (static_cast<float>(in[2 * i]) + static_cast<float>(in[2 * i + 1])) * 0.5f;
+        return;
+    }
+
+    if (channels != 1) {
+        for (; i < frames; i++) {
+            float sum = 0;
+            for (unsigned int c = 0; c < channels; c++)
+                sum += in[i * channels + c];
+            out[i] = sum / channels;
+        }
+        return;
+    }
+
+#if defined(__AVX2__)
+    for (; i + 8 <= frames; i += 8) {
+        auto s = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_ps(out + i, _mm256_cvtepi32_ps(s));
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= frames; i += 8) {
+        auto s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        auto sign = _mm_srai_epi16(s, 15);
+        _mm_storeu_ps(out + i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(s, sign)));
+        _mm_storeu_ps(out + i + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(s, sign)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= frames; i += 8) {
+        auto s = vld1q_s16(in + i);
+        vst1q_f32(out + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))));
+        vst1q_f32(out + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))));
+    }
+#endif
+    for (; i < frames; i++)
+        out[i] = in[i];
+}
+
+float dot(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+    float sum = 0;
+
+#if defined(__AVX2__)
+    auto acc = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+#if defined(__FMA__)
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+#else
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+#endif
+    }
+    auto lo = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+    sum = _mm_cvtss_f32(lo);
+#elif defined(__SSE2__)
+    auto acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sum = _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON)
+    auto acc = vdupq_n_f32(0);
+    for (; i + 4 <= n; i += 4)
+        acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    sum = vaddvq_f32(acc);
+#endif
+
+    for (; i < n; i++)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+size_t zeroCrossings(const float* in, size_t n) {
+    if (n < 2)
+        return 0;
+
+    size_t i = 0;
+    size_t count = 0;
+    auto pairs = n - 1;
+
+    // a crossing is a sign bit that differs from the next sample's
+#if defined(__AVX2__)
+    for (; i + 8 <= pairs; i += 8) {
+        auto x = _mm256_xor_ps(_mm256_loadu_ps(in + i), _mm256_loadu_ps(in + i + 1));
+        count += __builtin_popcount(_mm256_movemask_ps(x));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= pairs; i += 4) {
+        auto x = _mm_xor_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(in + i + 1));
+        count += __builtin_popcount(_mm_movemask_ps(x));
+    }
+#elif defined(__ARM_NEON)
+    auto acc = vdupq_n_u32(0);
+    for (; i + 4 <= pairs; i += 4) {
+        auto x = veorq_u32(vreinterpretq_u32_f32(vld1q_f32(in + i)), vreinterpretq_u32_f32(vld1q_f32(in + i + 1)));
+        acc = vaddq_u32(acc, vshrq_n_u32(x, 31));
+    }
+    count += vaddvq_u32(acc);
+#endif
+
+    for (; i < pairs; i++)
+        count += std::signbit(in[i]) != std::signbit(in[i + 1]);
+
+    return count;
+}
+
+void toInt16(const float* in, size_t n, int16_t* out) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // cvtps rounds to nearest, packs saturates to the int16 range
+    for (; i + 8 <= n; i += 8) {
+        auto lo = _mm_cvtps_epi32(_mm_loadu_ps(in + i));
+        auto hi = _mm_cvtps_epi32(_mm_loadu_ps(in + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= n; i += 8) {
+        auto lo = vqmovn_s32(vcvtnq_s32_f32(vld1q_f32(in + i)));
+        auto hi = vqmovn_s32(vcvtnq_s32_f32(vld1q_f32(in + i + 4)));
+        vst1q_s16(out + i, vcombine_s16(lo, hi));
+    }
+#endif
+
+    for (; i < n; i++)
+        out[i] = static_cast<int16_t>(std::clamp(std::lrint(in[i]), -32768L, 32767L));
+}
+
+const char* name() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#elif defined(__ARM_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+}
+
+namespace {
+
+/**
+ * Whether the kernels built for isa may be picked, ZOOM_BOT_ISA=avx2 for example keeps
+ * a host on AVX2 even though it has AVX-512
+ */
+bool allowed(const char* isa) {
+    static const char* order[] = {"avx512", "avx2"};
+
+    auto* cap = getenv("ZOOM_BOT_ISA");
+    if (!cap || !*cap)
+        return true;
+
+    for (auto* name : order) {
+        if (strcmp(name, cap) == 0)
+            return true;
+        if (strcmp(name, isa) == 0)
+            return false;
+    }
+
+    // anything else, e.g. sse2, leaves only the baseline
+    return false;
+}
+
+KernelTable select() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && allowed("avx512"))
+        return {Avx512::toMonoFloat, Avx512::dot, Avx512::zeroCrossings, Avx512::toInt16, "avx512"};
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && allowed("avx2"))
+        return {Avx2::toMonoFloat, Avx2::dot, Avx2::zeroCrossings, Avx2::toInt16, "avx2"};
+#endif
+
+    return {Baseline::toMonoFloat, Baseline::dot, Baseline::zeroCrossings, Baseline::toInt16, Baseline::name()};
+}
+
+// picked once before main(), every call after that is one indirect jump
+const KernelTable c_kernels = select();
+
+}
+
+void toMonoFloat(const int16_t* in, size_t frames, unsigned int channels, float* out) {
+    c_kernels.toMonoFloat(in, frames, channels, out);
+}
+
+float dot(const float* a, const float* b, size_t n) {
+    return c_kernels.dot(a, b, n);
+}
+
+float meanSquare(const float* in, size_t n) {
+    return n == 0 ? 0.0f : c_kernels.dot(in, in, n) / n;
+}
+
+size_t zeroCrossings(const float* in, size_t n) {
+    return c_kernels.zeroCrossings(in, n);
+}
+
+void toInt16(const float* in, size_t n, int16_t* out) {
+    c_kernels.toInt16(in, n, out);
+}
+
+const char* isa() {
+    return c_kernels.name;
+}
+
+}
@@ -0,0 +1,50 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_AUDIOKERNELS_H
+#define MEETING_SDK_LINUX_SAMPLE_AUDIOKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Vectorized inner loops for the audio pipeline.
+ * Each kernel has a baseline SSE2/NEON body and, on x86, AVX2 and AVX-512 bodies; the best
+ * one the CPU supports is picked at startup, so one build runs well on any host.
+ * ZOOM_BOT_ISA=avx2 or sse2 caps the choice.
+ */
+namespace AudioKernels {
+
+    /**
+     * Convert interleaved linear16 to float, averaging all channels down to mono
+     * @param in interleaved samples
+     * @param frames number of frames (samples per channel)
+     * @param channels channels per frame, 1 or 2
+     * @param out frames floats in the int16 range
+     */
+    void toMonoFloat(const int16_t* in, size_t frames, unsigned int channels, float* out);
+
+    /**
+     * Dot product of two float vectors
+     */
+    float dot(const float* a, const float* b, size_t n);
+
+    /**
+     * Mean of the squared samples
+     */
+    float meanSquare(const float* in, size_t n);
+
+    /**
+     * Number of sign changes between neighbouring samples
+     */
+    size_t zeroCrossings(const float* in, size_t n);
+
+    /**
+     * Round floats back to linear16 with saturation
+     */
+    void toInt16(const float* in, size_t n, int16_t* out);
+
+    /**
+     * Name of the instruction set the kernels run with
+     */
+    const char* isa();
+}
+
+#endif //MEETING_SDK_LINUX_SAMPLE_AUDIOKERNELS_H
@@ -0,0 +1,55 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_AUDIOKERNELSIMPL_H
+#define MEETING_SDK_LINUX_SAMPLE_AUDIOKERNELSIMPL_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * One set of kernel bodies per instruction set, AudioKernels dispatches to the best one
+ * the CPU supports. Only AudioKernels*.cpp include this.
+ */
+namespace AudioKernels {
+
+    struct KernelTable {
+        void (*toMonoFloat)(const int16_t* in, size_t frames, unsigned int channels, float* out);
+        float (*dot)(const float* a, const float* b, size_t n);
+        size_t (*zeroCrossings)(const float* in, size_t n);
+        void (*toInt16)(const float* in, size_t n, int16_t* out);
+        const char* name;
+    };
+
+    /**
+     * Whatever the build targets: SSE2 on x86-64, NEON on aarch64, otherwise scalar
+     */
+    namespace Baseline {
+        void toMonoFloat(const int16_t* in, size_t frames, unsigned int channels, float* out);
+        float dot(const float* a, const float* b, size_t n);
+        size_t zeroCrossings(const float* in, size_t n);
+        void toInt16(const float* in, size_t n, int16_t* out);
+        const char* name();
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    /**
+     * AVX2 with FMA, built with target attributes so the rest of the binary stays baseline
+     */
+    namespace Avx2 {
+        void toMonoFloat(const int16_t* in, size_t frames, unsigned int channels, float* out);
+        float dot(const float* a, const float* b, size_t n);
+        size_t zeroCrossings(const float* in, size_t n);
+        void toInt16(const float* in, size_t n, int16_t* out);
+    }
+
+    /**
+     * AVX-512 F and BW
+     */
+    namespace Avx512 {
+        void toMonoFloat(const int16_t* in, size_t frames, unsigned int channels, float* out);
+        float dot(const float* a, const float* b, size_t n);
+        size_t zeroCrossings(const float* in, size_t n);
+        void toInt16(const float* in, size_t n, int16_t* out);
+    }
+#endif
+}
+
+#endif //MEETING_SDK_LINUX_SAMPLE_AUDIOKERNELSIMPL_H
@@ -0,0 +1,154 @@
+#include "AudioKernelsImpl.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+// each body vectorizes the bulk and leaves the tail to the baseline kernel
+
+#define AVX2 __attribute__((target("avx2,fma")))
+#define AVX512 __attribute__((target("avx512f,avx512bw")))
+
+namespace AudioKernels {
+
+namespace Avx2 {
+
+AVX2 void toMonoFloat(const int16_t* in, size_t frames, unsigned int channels, float* out) {
+    size_t i = 0;
+
+    if (channels == 2) {
+        const __m256 half = _mm256_set1_ps(0.5f);
+        for (; i + 8 <= frames; i += 8) {
+            // hadd of the widened L/R pairs sums each frame into one int32 lane
+            auto lr = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i)));
+            auto lr2 = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 8)));
+            auto sum = _mm256_hadd_epi32(lr, lr2);
+            sum = _mm256_permute4x64_epi64(sum, 0xD8);
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(sum), half));
+        }
+    } else if (channels == 1) {
+        for (; i + 8 <= frames; i += 8) {
+            auto s = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+            _mm256_storeu_ps(out + i, _mm256_cvtepi32_ps(s));
+        }
+    }
+
+    Baseline::toMonoFloat(in + i * channels, frames - i, channels, out + i);
+}
+
+AVX2 float dot(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+
+    auto acc = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+
+    auto lo = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+
+    return _mm_cvtss_f32(lo) + Baseline::dot(a + i, b + i, n - i);
+}
+
+AVX2 size_t zeroCrossings(const float* in, size_t n) {
+    if (n < 2)
+        return 0;
+
+    size_t i = 0;
+    size_t count = 0;
+    auto pairs = n - 1;
+
+    for (; i + 8 <= pairs; i += 8) {
+        auto x = _mm256_xor_ps(_mm256_loadu_ps(in + i), _mm256_loadu_ps(in + i + 1));
+        count += __builtin_popcount(_mm256_movemask_ps(x));
+    }
+
+    return count + Baseline::zeroCrossings(in + i, n - i);
+}
+
+AVX2 void toInt16(const float* in, size_t n, int16_t* out) {
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        auto lo = _mm256_cvtps_epi32(_mm256_loadu_ps(in + i));
+        auto hi = _mm256_cvtps_epi32(_mm256_loadu_ps(in + i + 8));
+        // packs works per 128-bit lane, the permute puts the four quarters back in order
+        auto packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+
+    Baseline::toInt16(in + i, n - i, out + i);
+}
+
+}
+
+namespace Avx512 {
+
+AVX512 void toMonoFloat(const int16_t* in, size_t frames, unsigned int channels, float* out) {
+    size_t i = 0;
+
+    if (channels == 2) {
+        const __m512i ones = _mm512_set1_epi16(1);
+        const __m512 half = _mm512_set1_ps(0.5f);
+        for (; i + 16 <= frames; i += 16) {
+            // madd of L/R pairs with ones sums each frame into one int32 lane, in order
+            auto lr = _mm512_loadu_si512(in + 2 * i);
+            auto sum = _mm512_madd_epi16(lr, ones);
+            _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_cvtepi32_ps(sum), half));
+        }
+    } else if (channels == 1) {
+        for (; i + 16 <= frames; i += 16) {
+            auto s = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+            _mm512_storeu_ps(out + i, _mm512_cvtepi32_ps(s));
+        }
+    }
+
+    Baseline::toMonoFloat(in + i * channels, frames - i, channels, out + i);
+}
+
+AVX512 float dot(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+
+    auto acc = _mm512_setzero_ps();
+    for (; i + 16 <= n; i += 16)
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc);
+
+    return _mm512_reduce_add_ps(acc) + Baseline::dot(a + i, b + i, n - i);
+}
+
+AVX512 size_t zeroCrossings(const float* in, size_t n) {
+    if (n < 2)
+        return 0;
+
+    size_t i = 0;
+    size_t count = 0;
+    auto pairs = n - 1;
+
+    // the xor of two floats is negative as an int32 exactly when their signs differ
+    const __m512i zero = _mm512_setzero_si512();
+    for (; i + 16 <= pairs; i += 16) {
+        auto x = _mm512_xor_si512(_mm512_castps_si512(_mm512_loadu_ps(in + i)),
+                                  _mm512_castps_si512(_mm512_loadu_ps(in + i + 1)));
+        count += __builtin_popcount(_mm512_cmplt_epi32_mask(x, zero));
+    }
+
+    return count + Baseline::zeroCrossings(in + i, n - i);
+}
+
+AVX512 void toInt16(const float* in, size_t n, int16_t* out) {
+    size_t i = 0;
+
+    // cvtps rounds to nearest, cvtsepi32 saturates to the int16 range
+    for (; i + 16 <= n; i += 16) {
+        auto s = _mm512_cvtps_epi32(_mm512_loadu_ps(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm512_cvtsepi32_epi16(s));
+    }
+
+    Baseline::toInt16(in + i, n - i, out + i);
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,211 @@
+#include "EncodedFileWriter.h"
+
+#include <array>
+#include <cstring>
+#include <random>
+
+EncodedFileWriter::~EncodedFileWriter() {
+    close();
+}
+
+bool EncodedFileWriter::open(const string& path, PayloadFormat format, const SegmentOptions& segments,
+                             const SegmentSequence::Finished& onFinished) {
+    close();
+
+    m_format = format;
+    m_codecHeader.clear();
+    m_fileSegments = segments.enabled() ? SegmentSequence(path, segments, onFinished) : SegmentSequence();
+
+    return openFile(m_fileSegments.enabled() ? m_fileSegments.next() : path);
+}
+
+bool EncodedFileWriter::openFile(const string& path) {
+    if (!m_file.open(path, true))
+        return false;
+
+    m_started = false;
+    m_bytes = 0;
+    m_serial = random_device()();
+    m_pageSequence = 0;
+    m_granule = 0;
+    m_page.clear();
+    m_segments.clear();
+
+    return true;
+}
+
+void EncodedFileWriter::write(const FrameHeader& header, const char* buf, size_t len) {
+    if (!m_file.isOpen() || len == 0)
+        return;
+
+    auto setup = (header.flags & FrameHeader::c_flagCodecHeader) != 0;
+
+    // packets cannot be decoded without the header, which a failed open may have lost
+    if (!setup && !m_started)
+        return;
+
+    if (setup && !m_started)
+        m_codecHeader.assign(buf, len);
+
+    if (!setup && m_fileSegments.due(m_bytes)) {
+        nextSegment();
+        if (!m_started)
+            return;
+    }
+
+    m_bytes += len;
+
+    if (m_format != PayloadFormat::Opus) {
+        m_file.write(buf, len);
+        m_started = true;
+        return;
+    }
+
+    if (setup) {
+        if (m_started)
+            return;
+
+        // the identification header is alone on the first page, the comment header follows
+        addPacket(buf, len);
+        writePage(0x02);
+
+        static const string vendor = opus_get_version_string();
+        auto put = [](string& out, uint32_t value) {
+            for (int i = 0; i < 4; i++)
+                out.push_back(static_cast<char>(value >> (8 * i)));
+        };
+
+        string tags = "OpusTags";
+        put(tags, vendor.size());
+        tags += vendor;
+        put(tags, 0);
+
+        addPacket(tags.data(), tags.size());
+        writePage(0x00);
+
+        m_started = true;
+        return;
+    }
+
+    auto segments = len / 255 + 1;
+    if (m_segments.size() + segments > c_maxSegments)
+        writePage(0x00);
+
+    addPacket(buf, len);
+
+    auto samples = opus_packet_get_nb_samples(reinterpret_cast<const unsigned char*>(buf), len, 48000);
+    if (samples > 0)
+        m_granule += samples;
+
+    if (m_page.size() >= c_pageSize)
+        writePage(0x00);
+}
+
+void EncodedFileWriter::nextSegment() {
+    endFile();
+
+    if (!openFile(m_fileSegments.next()))
+        return;
+
+    FrameHeader header;
+    header.flags = FrameHeader::c_flagCodecHeader;
+    write(header, m_codecHeader.data(), m_codecHeader.size());
+}
+
+void EncodedFileWriter::addPacket(const char* buf, size_t len) {
+    // lacing: 255 for every full segment, then the remainder, which may be 0
+    for (size_t left = len; ; left -= 255) {
+        m_segments.push_back(static_cast<uint8_t>(min<size_t>(left, 255)));
+        if (left < 255)
+            break;
+    }
+
+    m_page.append(buf, len);
+}
+
+void EncodedFileWriter::writePage(uint8_t type) {
+    uint8_t header[27 + 255];
+
+    memcpy(header, "OggS", 4);
+    header[4] = 0;
+    header[5] = type;
+    for (int i = 0; i < 8; i++)
+        header[6 + i] = static_cast<uint8_t>(m_granule >> (8 * i));
+    for (int i = 0; i < 4; i++) {
+        header[14 + i] = static_cast<uint8_t>(m_serial >> (8 * i));
+        header[18 + i] = static_cast<uint8_t>(m_pageSequence >> (8 * i));
+        header[22 + i] = 0;
+    }
+    header[26] = static_cast<uint8_t>(m_segments.size());
+    memcpy(header + 27, m_segments.data(), m_segments.size());
+
+    auto headerLen = 27 + m_segments.size();
+    auto sum = crc(header, headerLen, 0);
+    sum = crc(reinterpret_cast<const uint8_t*>(m_page.data()), m_page.size(), sum);
+    for (int i = 0; i < 4; i++)
+        header[22 + i] = static_cast<uint8_t>(sum >> (8 * i));
+
+    m_file.write(reinterpret_cast<const char*>(header), headerLen);
+    m_file.write(m_page.data(), m_page.size());
+
+    m_pageSequence++;
+    m_page.clear();
+    m_segments.clear();
+}
+
+void EncodedFileWriter::endFile() {
+    if (!m_file.isOpen())
+        return;
+
+    // the last page has to say it is the last, even without packets on it
+    if (m_format == PayloadFormat::Opus && m_started)
+        writePage(0x04);
+
+    m_file.close();
+    m_started = false;
+
+    if (m_fileSegments.enabled())
+        m_fileSegments.finish();
+}
+
+void EncodedFileWriter::close() {
+    endFile();
+}
+
+bool EncodedFileWriter::isOpen() const {
+    return m_file.isOpen();
+}
+
+const string& EncodedFileWriter::path() const {
+    return m_file.path();
+}
+
+string EncodedFileWriter::extension(PayloadFormat format) {
+    switch (format) {
+        case PayloadFormat::Opus:
+            return ".opus";
+        case PayloadFormat::Flac:
+            return ".flac";
+        default:
+            return ".pcm";
+    }
+}
+
+uint32_t EncodedFileWriter::crc(const uint8_t* buf, size_t len, uint32_t crc) {
+    // CRC-32 with polynomial 0x04c11db7, unreflected and without final xor, as Ogg wants it
+    static const auto table = [] {
+        array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            auto r = i << 24;
+            for (int j = 0; j < 8; j++)
+                r = r & 0x80000000 ? (r << 1) ^ 0x04c11db7 : r << 1;
+            t[i] = r;
+        }
+        return t;
+    }();
+
+    for (size_t i = 0; i < len; i++)
+        crc = (crc << 8) ^ table[((crc >> 24) ^ buf[i]) & 0xff];
+
+    return crc;
+}
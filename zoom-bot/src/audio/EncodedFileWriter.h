@@ -0,0 +1,89 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_ENCODEDFILEWRITER_H
+#define MEETING_SDK_LINUX_SAMPLE_ENCODEDFILEWRITER_H
+
+#include <opus/opus.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../util/BufferedFileWriter.h"
+#include "../util/FrameHeader.h"
+#include "../util/Log.h"
+#include "../storage/SegmentSequence.h"
+
+using namespace std;
+
+/**
+ * Writes the output of an encoder stream to a playable file.
+ *
+ * FLAC needs no container, so header and packets go to the file as they are. Opus
+ * packets are wrapped in an Ogg stream (RFC 7845): the OpusHead and OpusTags pages first,
+ * then pages of about 4KiB of packets each, and a final page marked end of stream.
+ *
+ * With segments every file is a complete stream of its own: the current one is ended
+ * between two packets and the next starts over with the codec header.
+ */
+class EncodedFileWriter {
+    const size_t c_pageSize = 4096;
+    const size_t c_maxSegments = 255;
+
+    BufferedFileWriter m_file;
+    PayloadFormat m_format = PayloadFormat::Linear16;
+    bool m_started = false;
+
+    SegmentSequence m_fileSegments;
+    string m_codecHeader;
+    uint64_t m_bytes = 0;
+
+    // Ogg state of a single logical stream
+    uint32_t m_serial = 0;
+    uint32_t m_pageSequence = 0;
+    uint64_t m_granule = 0;
+    string m_page;
+    vector<uint8_t> m_segments;
+
+    bool openFile(const string& path);
+    void endFile();
+    void nextSegment();
+    void addPacket(const char* buf, size_t len);
+    void writePage(uint8_t type);
+
+    static uint32_t crc(const uint8_t* buf, size_t len, uint32_t crc);
+
+public:
+    EncodedFileWriter() = default;
+    ~EncodedFileWriter();
+
+    EncodedFileWriter(EncodedFileWriter&& other) noexcept = default;
+    EncodedFileWriter& operator=(EncodedFileWriter&& other) noexcept = default;
+
+    /**
+     * Create the file, replacing an older one at the same path
+     * @param format codec of the packets that will be written
+     * @param segments split the stream into files of this length, named after path
+     * @param onFinished called with every finished segment
+     */
+    bool open(const string& path, PayloadFormat format, const SegmentOptions& segments = SegmentOptions(),
+              const SegmentSequence::Finished& onFinished = nullptr);
+
+    /**
+     * Write a codec header or packet as it came from the encoder; the header has to come first
+     */
+    void write(const FrameHeader& header, const char* buf, size_t len);
+
+    /**
+     * End the stream and close the file
+     */
+    void close();
+
+    bool isOpen() const;
+    const string& path() const;
+
+    /**
+     * @return file extension for a codec, with the dot
+     */
+    static string extension(PayloadFormat format);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_ENCODEDFILEWRITER_H
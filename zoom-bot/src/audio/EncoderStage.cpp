@@ -0,0 +1,224 @@
+#include "EncoderStage.h"
+
+#include <cstring>
+#include <sstream>
+
+#include "../util/ThreadRoles.h"
+
+EncoderStage::EncoderStage(const EncoderOptions& options, const Output& output, const Closed& onClosed)
+    : m_options(options), m_output(output), m_onClosed(onClosed) {}
+
+EncoderStage::~EncoderStage() {
+    stop();
+}
+
+bool EncoderStage::start() {
+    if (m_running)
+        return true;
+
+    if (!m_ring)
+        m_ring = make_unique<AudioRing>(c_ringSlots, c_slotSize, OverflowPolicy::DropOldest);
+
+    m_running = true;
+    m_thread = thread(&EncoderStage::run, this);
+
+    return true;
+}
+
+void EncoderStage::stop() {
+    if (!m_running.exchange(false))
+        return;
+
+    m_ring->wake();
+    m_thread.join();
+}
+
+void EncoderStage::write(const FrameHeader& header, const char* buf, size_t len) {
+    if (!m_running)
+        return;
+
+    if (len == 0) {
+        m_ring->push(&header, sizeof(header), nullptr, 0);
+        return;
+    }
+
+    // split on whole sample frames so every piece carries the timestamp of its first sample
+    size_t frameBytes = sizeof(int16_t) * max<uint8_t>(header.channels, 1);
+    auto room = c_slotSize - sizeof(FrameHeader);
+    room -= room % frameBytes;
+
+    for (size_t offset = 0; offset < len; offset += room) {
+        auto piece = header;
+        piece.length = min(room, len - offset);
+        if (header.sampleRate > 0)
+            piece.timestamp += offset / frameBytes * 1000000000ull / header.sampleRate;
+
+        m_ring->push(&piece, sizeof(piece), buf + offset, piece.length);
+    }
+}
+
+void EncoderStage::close(StreamType stream, uint32_t nodeId) {
+    if (!m_running)
+        return;
+
+    {
+        lock_guard<mutex> lock(m_closingMutex);
+        m_closing.push_back(key(stream, nodeId));
+    }
+
+    m_ring->wake();
+}
+
+void EncoderStage::run() {
+    ThreadRoles::assign(ThreadRole::AudioRt);
+    m_lastSweep = chrono::steady_clock::now();
+
+    while (m_running) {
+        // only block once the ring is empty, otherwise the producer would not wake us
+        auto timeout = m_ring->sleep() ? 1000 : 0;
+
+        struct pollfd fd = {m_ring->fd(), POLLIN, 0};
+        if (poll(&fd, 1, timeout) == -1 && errno != EINTR) {
+            Log::error("audio encoder poll failed");
+            break;
+        }
+
+        if (fd.revents & POLLIN)
+            m_ring->clear();
+
+        drain();
+        closeRequested();
+        closeIdle();
+    }
+
+    drain();
+    while (!m_streams.empty())
+        finish(m_streams.begin()->first);
+}
+
+void EncoderStage::drain() {
+    while (auto* slot = m_ring->acquire()) {
+        FrameHeader header;
+        memcpy(&header, slot->data, sizeof(header));
+
+        process(header, slot->data + sizeof(FrameHeader), slot->len - sizeof(FrameHeader));
+        m_ring->release(slot);
+    }
+}
+
+void EncoderStage::process(const FrameHeader& header, const char* buf, size_t len) {
+    auto it = m_streams.find(key(header.stream, header.nodeId));
+
+    if (len == 0) {
+        // the partial frame before a pause must not wait for the next speech
+        if (it != m_streams.end() && (header.flags & (FrameHeader::c_flagSpeechEnd | FrameHeader::c_flagSilence)))
+            it->second.encoder->flush(it->second.header, m_output);
+
+        auto marker = header;
+        if (it != m_streams.end()) {
+            // silence keepalives keep a gated stream and its encoder alive
+            it->second.lastWrite = chrono::steady_clock::now();
+            marker.format = it->second.encoder->format();
+            marker.sampleRate = it->second.encoder->sampleRate();
+            marker.channels = it->second.encoder->channels();
+        }
+
+        m_output(marker, nullptr, 0);
+        return;
+    }
+
+    auto* stream = it != m_streams.end() && it->second.encoder->accepts(header.sampleRate, header.channels)
+                   ? &it->second : open(header);
+    if (!stream)
+        return;
+
+    stream->lastWrite = chrono::steady_clock::now();
+    if (!stream->encoder->write(header, buf, len, m_output))
+        finish(key(header.stream, header.nodeId));
+}
+
+EncoderStage::Stream* EncoderStage::open(const FrameHeader& header) {
+    auto id = key(header.stream, header.nodeId);
+
+    // a stream that changed format starts over with a new encoder
+    if (m_streams.count(id))
+        finish(id);
+
+    auto encoder = AudioEncoder::create(m_options, header.sampleRate, header.channels);
+    if (!encoder)
+        return nullptr;
+
+    if (header.stream == StreamType::Mixed) {
+        stringstream ss;
+        ss << "encoding " << header.sampleRate << "Hz/" << static_cast<int>(header.channels) << "ch audio as "
+           << encoder->name() << " at " << encoder->sampleRate() << "Hz/" << encoder->channels() << "ch, "
+           << m_options.frameMs << "ms per packet";
+        Log::info(ss.str());
+    }
+
+    auto setup = encoder->codecHeader();
+    auto out = header;
+    out.format = encoder->format();
+    out.sampleRate = encoder->sampleRate();
+    out.channels = encoder->channels();
+    out.flags = FrameHeader::c_flagCodecHeader;
+
+    if (!setup.empty())
+        m_output(out, setup.data(), setup.size());
+
+    auto& stream = m_streams[id];
+    stream.encoder = std::move(encoder);
+    stream.header = header;
+    stream.header.flags = 0;
+
+    return &stream;
+}
+
+void EncoderStage::finish(uint64_t id) {
+    auto it = m_streams.find(id);
+    if (it == m_streams.end())
+        return;
+
+    auto header = it->second.header;
+    it->second.encoder->finish(header, m_output);
+    m_streams.erase(it);
+
+    if (m_onClosed)
+        m_onClosed(header.stream, header.nodeId);
+}
+
+void EncoderStage::closeRequested() {
+    vector<uint64_t> closing;
+    {
+        lock_guard<mutex> lock(m_closingMutex);
+        closing.swap(m_closing);
+    }
+
+    // chunks queued before the request are encoded by now
+    for (auto id : closing)
+        finish(id);
+}
+
+void EncoderStage::closeIdle() {
+    auto now = chrono::steady_clock::now();
+    if (now - m_lastSweep < chrono::seconds(1))
+        return;
+    m_lastSweep = now;
+
+    // catches participants whose leave event we missed
+    vector<uint64_t> idle;
+    for (auto& [id, stream] : m_streams)
+        if (now - stream.lastWrite > c_idleTimeout)
+            idle.push_back(id);
+
+    for (auto id : idle)
+        finish(id);
+}
+
+const EncoderOptions& EncoderStage::options() const {
+    return m_options;
+}
+
+uint64_t EncoderStage::key(StreamType stream, uint32_t nodeId) {
+    return static_cast<uint64_t>(stream) << 32 | nodeId;
+}
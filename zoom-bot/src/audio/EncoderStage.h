@@ -0,0 +1,109 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_ENCODERSTAGE_H
+#define MEETING_SDK_LINUX_SAMPLE_ENCODERSTAGE_H
+
+#include <poll.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "AudioEncoder.h"
+#include "../util/AudioRing.h"
+#include "../util/FrameHeader.h"
+#include "../util/Log.h"
+
+using namespace std;
+
+/**
+ * Encodes every stream of a sink on its own thread, between the SDK callbacks and the sink.
+ *
+ * The SDK thread only copies linear16 chunks into a ring. The worker keeps one encoder per
+ * stream and node for as long as the stream lives, and hands the output to the sink
+ * in order: a codec header frame when a stream starts, then one frame per packet. Markers
+ * pass through behind the packets they end, after the partial frame before them is padded
+ * out. Streams are finished when their participant leaves, after a stretch without audio,
+ * or when the stage stops.
+ */
+class EncoderStage {
+public:
+    typedef AudioEncoder::Emit Output;
+    typedef function<void(StreamType stream, uint32_t nodeId)> Closed;
+
+private:
+    const size_t c_slotSize = 4096;
+    const size_t c_ringSlots = 512;
+    const chrono::seconds c_idleTimeout{30};
+
+    struct Stream {
+        unique_ptr<AudioEncoder> encoder;
+        FrameHeader header;
+        chrono::steady_clock::time_point lastWrite;
+    };
+
+    EncoderOptions m_options;
+    Output m_output;
+    Closed m_onClosed;
+
+    unique_ptr<AudioRing> m_ring;
+    thread m_thread;
+    atomic<bool> m_running{false};
+
+    // streams other threads asked to finish, guarded by m_closingMutex
+    mutex m_closingMutex;
+    vector<uint64_t> m_closing;
+
+    // owned by the worker
+    unordered_map<uint64_t, Stream> m_streams;
+    chrono::steady_clock::time_point m_lastSweep;
+
+    void run();
+    void drain();
+    void process(const FrameHeader& header, const char* buf, size_t len);
+    Stream* open(const FrameHeader& header);
+    void finish(uint64_t key);
+    void closeRequested();
+    void closeIdle();
+
+    static uint64_t key(StreamType stream, uint32_t nodeId);
+
+public:
+    /**
+     * @param options codec and its settings, the same for every stream
+     * @param output receives codec headers, packets and markers on the worker thread
+     * @param onClosed called on the worker thread after a stream's last packet
+     */
+    EncoderStage(const EncoderOptions& options, const Output& output, const Closed& onClosed = nullptr);
+    ~EncoderStage();
+
+    EncoderStage(const EncoderStage&) = delete;
+    EncoderStage& operator=(const EncoderStage&) = delete;
+
+    bool start();
+
+    /**
+     * Encode what is queued, finish every stream and stop the worker
+     */
+    void stop();
+
+    /**
+     * Queue a chunk or marker. Called from the SDK audio thread only.
+     * @param header stream, node, format and capture time of the chunk
+     * @param buf interleaved linear16 samples
+     * @param len number of bytes
+     */
+    void write(const FrameHeader& header, const char* buf, size_t len);
+
+    /**
+     * Finish the stream of a node, e.g. when its participant left. Safe from any thread.
+     */
+    void close(StreamType stream, uint32_t nodeId);
+
+    const EncoderOptions& options() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_ENCODERSTAGE_H
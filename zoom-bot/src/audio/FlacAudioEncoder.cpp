@@ -0,0 +1,96 @@
+#include "FlacAudioEncoder.h"
+
+FlacAudioEncoder::FlacAudioEncoder(const EncoderOptions& options, unsigned int rate, unsigned int channels)
+    : AudioEncoder(options, rate, channels, rate, channels) {}
+
+FlacAudioEncoder::~FlacAudioEncoder() {
+    if (m_encoder)
+        FLAC__stream_encoder_delete(m_encoder);
+}
+
+bool FlacAudioEncoder::init() {
+    m_encoder = FLAC__stream_encoder_new();
+    if (!m_encoder) {
+        Log::error("failed to create FLAC encoder");
+        return false;
+    }
+
+    FLAC__stream_encoder_set_channels(m_encoder, m_channels);
+    FLAC__stream_encoder_set_bits_per_sample(m_encoder, 16);
+    FLAC__stream_encoder_set_sample_rate(m_encoder, m_rate);
+    FLAC__stream_encoder_set_compression_level(m_encoder, m_options.flacLevel);
+    FLAC__stream_encoder_set_blocksize(m_encoder, m_frameSamples);
+
+    // the metadata is written right here, before any audio
+    auto status = FLAC__stream_encoder_init_stream(m_encoder, onWrite, nullptr, nullptr, nullptr, this);
+    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+        Log::error("failed to set up FLAC encoder: " + string(FLAC__StreamEncoderInitStatusString[status]));
+        return false;
+    }
+
+    return true;
+}
+
+FLAC__StreamEncoderWriteStatus FlacAudioEncoder::onWrite(const FLAC__StreamEncoder* encoder, const FLAC__byte buffer[],
+                                                         size_t bytes, uint32_t samples, uint32_t frame, void* data) {
+    auto* self = static_cast<FlacAudioEncoder*>(data);
+    auto* buf = reinterpret_cast<const char*>(buffer);
+
+    // metadata blocks come without samples
+    if (samples == 0 || !self->m_out) {
+        self->m_header.append(buf, bytes);
+        return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+    }
+
+    auto& packet = self->m_out->emplace_back();
+    packet.data.assign(buf, bytes);
+
+    if (!self->m_frames.empty()) {
+        packet.timestamp = self->m_frames.front().first;
+        packet.flags = self->m_frames.front().second;
+        self->m_frames.pop_front();
+    }
+
+    return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+}
+
+bool FlacAudioEncoder::encodeFrame(const int16_t* samples, uint64_t timestamp, uint32_t flags, vector<Packet>& out) {
+    auto count = m_frameSamples * m_channels;
+    m_samples.assign(samples, samples + count);
+    m_frames.emplace_back(timestamp, flags);
+
+    m_out = &out;
+    auto ok = FLAC__stream_encoder_process_interleaved(m_encoder, m_samples.data(), m_frameSamples);
+    m_out = nullptr;
+
+    if (!ok)
+        Log::error("FLAC encoding failed: " + string(FLAC__StreamEncoderStateString[FLAC__stream_encoder_get_state(m_encoder)]));
+
+    return ok;
+}
+
+void FlacAudioEncoder::finishStream(vector<Packet>& out) {
+    m_out = &out;
+    FLAC__stream_encoder_finish(m_encoder);
+    m_out = nullptr;
+}
+
+string FlacAudioEncoder::codecHeader() const {
+    return m_header;
+}
+
+PayloadFormat FlacAudioEncoder::format() const {
+    return PayloadFormat::Flac;
+}
+
+const string& FlacAudioEncoder::name() const {
+    return Codec::flac;
+}
+
+unique_ptr<AudioEncoder> FlacAudioEncoder::create(const EncoderOptions& options, unsigned int rate, unsigned int channels) {
+    unique_ptr<FlacAudioEncoder> encoder(new FlacAudioEncoder(options, rate, channels));
+    if (!encoder->init())
+        return nullptr;
+
+    return encoder;
+}
@@ -0,0 +1,50 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_FLACAUDIOENCODER_H
+#define MEETING_SDK_LINUX_SAMPLE_FLACAUDIOENCODER_H
+
+#include <FLAC/stream_encoder.h>
+
+#include <deque>
+
+#include "AudioEncoder.h"
+#include "../util/Log.h"
+
+/**
+ * Lossless FLAC through libFLAC, for archiving.
+ *
+ * The audio keeps its rate and channels and one FLAC frame holds frameMs of it. The codec
+ * header is the "fLaC" marker with the metadata blocks, so header and packets written
+ * one after another make a complete .flac file. libFLAC holds a frame back until the
+ * next one starts, so packets trail the audio by a frame until finish().
+ */
+class FlacAudioEncoder : public AudioEncoder {
+    FLAC__StreamEncoder* m_encoder = nullptr;
+    vector<FLAC__int32> m_samples;
+
+    string m_header;
+    vector<Packet>* m_out = nullptr;
+
+    // capture times of the frames libFLAC has not written yet
+    deque<pair<uint64_t, uint32_t>> m_frames;
+
+    FlacAudioEncoder(const EncoderOptions& options, unsigned int rate, unsigned int channels);
+
+    bool init();
+
+    static FLAC__StreamEncoderWriteStatus onWrite(const FLAC__StreamEncoder* encoder, const FLAC__byte buffer[],
+                                                  size_t bytes, uint32_t samples, uint32_t frame, void* data);
+
+protected:
+    bool encodeFrame(const int16_t* samples, uint64_t timestamp, uint32_t flags, vector<Packet>& out) override;
+    void finishStream(vector<Packet>& out) override;
+
+public:
+    ~FlacAudioEncoder();
+
+    string codecHeader() const override;
+    PayloadFormat format() const override;
+    const string& name() const override;
+
+    static unique_ptr<AudioEncoder> create(const EncoderOptions& options, unsigned int rate, unsigned int channels);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_FLACAUDIOENCODER_H
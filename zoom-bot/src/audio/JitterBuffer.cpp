@@ -0,0 +1,290 @@
+#include "JitterBuffer.h"
+
+#include <sys/timerfd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "AudioKernels.h"
+#include "../util/ThreadRoles.h"
+
+JitterBuffer::JitterBuffer(const JitterOptions& options, const Output& output) :
+        m_options(options), m_output(output),
+        m_concealed(Metrics::getInstance().counter("zoombot_audio_jitter_concealed_ms_total",
+                                                   "Milliseconds of silence inserted for mixed audio that arrived late or not at all")),
+        m_dropped(Metrics::getInstance().counter("zoombot_audio_jitter_dropped_ms_total",
+                                                 "Milliseconds of mixed audio dropped because it was too late")),
+        m_compressed(Metrics::getInstance().counter("zoombot_audio_jitter_compressed_ms_total",
+                                                    "Milliseconds of quiet mixed audio removed to catch up")),
+        m_depth(Metrics::getInstance().gauge("zoombot_audio_jitter_depth_ms",
+                                             "Milliseconds of mixed audio waiting in the jitter buffer")) {
+    m_options.tickMs = max(m_options.tickMs, 1u);
+    m_options.maxMs = max(m_options.maxMs, m_options.targetMs + m_options.tickMs);
+}
+
+JitterBuffer::~JitterBuffer() {
+    stop();
+}
+
+bool JitterBuffer::start() {
+    if (m_running)
+        return true;
+
+    if (!m_ring)
+        m_ring = make_unique<AudioRing>(c_ringSlots, c_slotSize, OverflowPolicy::DropOldest);
+
+    m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (m_timerFd == -1) {
+        Log::error("unable to create the jitter buffer clock");
+        return false;
+    }
+
+    struct itimerspec period = {};
+    period.it_interval.tv_sec = m_options.tickMs / 1000;
+    period.it_interval.tv_nsec = (m_options.tickMs % 1000) * 1000000l;
+    period.it_value = period.it_interval;
+    timerfd_settime(m_timerFd, 0, &period, nullptr);
+
+    m_running = true;
+    m_thread = thread(&JitterBuffer::run, this);
+
+    Log::info("pacing mixed audio every ", m_options.tickMs, "ms, ", m_options.targetMs, " to ",
+              m_options.maxMs, "ms behind");
+
+    return true;
+}
+
+void JitterBuffer::stop() {
+    if (!m_running.exchange(false))
+        return;
+
+    m_ring->wake();
+    m_thread.join();
+
+    ::close(m_timerFd);
+    m_timerFd = -1;
+}
+
+void JitterBuffer::write(const FrameHeader& header, const char* buf, size_t len) {
+    if (!m_running)
+        return;
+
+    // split on whole sample frames so every piece carries the timestamp of its first sample
+    size_t frameBytes = sizeof(int16_t) * max<uint8_t>(header.channels, 1);
+    auto room = c_slotSize - sizeof(FrameHeader);
+    room -= room % frameBytes;
+
+    for (size_t offset = 0; offset < len; offset += room) {
+        auto piece = header;
+        piece.length = min(room, len - offset);
+        if (header.sampleRate > 0)
+            piece.timestamp += offset / frameBytes * 1000000000ull / header.sampleRate;
+
+        m_ring->push(&piece, sizeof(piece), buf + offset, piece.length);
+    }
+}
+
+void JitterBuffer::run() {
+    ThreadRoles::assign(ThreadRole::AudioRt);
+
+    struct pollfd fds[2] = {{m_ring->fd(), POLLIN, 0}, {m_timerFd, POLLIN, 0}};
+
+    while (m_running) {
+        // the clock wakes us every tick anyway, the ring only needs to if it filled meanwhile
+        auto timeout = m_ring->sleep() ? 1000 : 0;
+
+        if (poll(fds, 2, timeout) == -1 && errno != EINTR) {
+            Log::error("jitter buffer poll failed");
+            break;
+        }
+
+        if (fds[0].revents & POLLIN)
+            m_ring->clear();
+
+        drain();
+
+        uint64_t expirations = 0;
+        if ((fds[1].revents & POLLIN) && read(m_timerFd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+            // ticks missed while the worker was descheduled are caught up, not skipped
+            for (uint64_t i = 0; i < min<uint64_t>(expirations, m_options.maxGapMs / m_options.tickMs + 1); i++)
+                tick();
+        }
+    }
+
+    drain();
+    flush();
+}
+
+void JitterBuffer::drain() {
+    while (auto* slot = m_ring->acquire()) {
+        FrameHeader header;
+        memcpy(&header, slot->data, sizeof(header));
+
+        auto* buf = slot->data + sizeof(FrameHeader);
+        auto len = slot->len - sizeof(FrameHeader);
+
+        if (header.stream == StreamType::Mixed && len > 0)
+            append(header, buf, len);
+        else
+            m_output(header, buf, len);
+
+        m_ring->release(slot);
+    }
+
+    m_depth.set(toMs(bufferedFrames()));
+}
+
+void JitterBuffer::append(const FrameHeader& header, const char* buf, size_t len) {
+    if (m_live && (header.sampleRate != m_format.sampleRate || header.channels != m_format.channels))
+        flush();
+
+    if (!m_live) {
+        m_format = header;
+        m_format.seq = 0;
+        m_live = true;
+        m_gapMs = 0;
+    }
+
+    auto* samples = reinterpret_cast<const int16_t*>(buf);
+    m_samples.insert(m_samples.end(), samples, samples + len / sizeof(int16_t));
+}
+
+void JitterBuffer::tick() {
+    if (!m_live)
+        return;
+
+    auto frames = framesPerTick();
+    if (frames == 0)
+        return;
+
+    if (toMs(bufferedFrames()) > m_options.maxMs)
+        cutBack();
+
+    // after an underrun playout waits for the full target again, or it would underrun right away
+    if (m_playing && bufferedFrames() < frames)
+        m_playing = false;
+    if (!m_playing && bufferedFrames() >= frames && toMs(bufferedFrames()) >= m_options.targetMs)
+        m_playing = true;
+
+    if (m_playing) {
+        send(m_samples.data() + m_read, frames, m_flags);
+        m_flags = 0;
+        m_gapMs = 0;
+        m_read += frames * m_format.channels;
+
+        if (m_read >= m_samples.size() / 2) {
+            m_samples.erase(m_samples.begin(), m_samples.begin() + m_read);
+            m_read = 0;
+        }
+
+        return;
+    }
+
+    // still filling up for the first time
+    if (m_clock == 0)
+        return;
+
+    m_silence.assign(frames * m_format.channels, 0);
+    send(m_silence.data(), frames, FrameHeader::c_flagConcealed);
+    m_concealed.add(m_options.tickMs);
+
+    m_gapMs += m_options.tickMs;
+    if (m_gapMs < m_options.maxGapMs)
+        return;
+
+    // the meeting has no audio to pace, e.g. while the bot is alone; resume when it comes back
+    Log::info("no mixed audio for ", m_gapMs, "ms, pausing playout");
+    m_live = false;
+    m_clock = 0;
+    m_flags = FrameHeader::c_flagDiscontinuity;
+}
+
+void JitterBuffer::cutBack() {
+    auto frames = framesPerTick();
+    auto channels = m_format.channels;
+    auto target = max<size_t>(static_cast<size_t>(m_format.sampleRate) * m_options.targetMs / 1000, frames);
+    auto excess = bufferedFrames() - min(target, bufferedFrames());
+
+    if (m_options.compress) {
+        // oldest first, every quiet tick goes until the excess is made up
+        vector<int16_t> kept;
+        kept.reserve(m_samples.size() - m_read);
+        m_mono.resize(frames);
+
+        size_t removed = 0;
+        auto pos = m_read;
+        auto step = frames * channels;
+
+        for (; pos + step <= m_samples.size(); pos += step) {
+            if (removed < excess) {
+                AudioKernels::toMonoFloat(m_samples.data() + pos, frames, channels, m_mono.data());
+                if (AudioKernels::meanSquare(m_mono.data(), frames) < c_quietLevel) {
+                    removed += frames;
+                    continue;
+                }
+            }
+
+            kept.insert(kept.end(), m_samples.begin() + pos, m_samples.begin() + pos + step);
+        }
+
+        kept.insert(kept.end(), m_samples.begin() + pos, m_samples.end());
+        m_samples.swap(kept);
+        m_read = 0;
+
+        m_compressed.add(toMs(removed));
+        excess -= min(removed, excess);
+    }
+
+    if (excess == 0)
+        return;
+
+    // the audio in between is gone, downstream should know
+    m_read += excess * channels;
+    m_dropped.add(toMs(excess));
+    m_flags |= FrameHeader::c_flagDiscontinuity;
+
+    Log::debug("jitter buffer dropped ", toMs(excess), "ms of late audio");
+}
+
+void JitterBuffer::flush() {
+    auto frames = framesPerTick();
+
+    while (m_live && frames > 0 && bufferedFrames() > 0) {
+        auto n = min(frames, bufferedFrames());
+        send(m_samples.data() + m_read, n, m_flags);
+        m_flags = 0;
+        m_read += n * m_format.channels;
+    }
+
+    m_samples.clear();
+    m_read = 0;
+    m_live = false;
+    m_playing = false;
+    m_clock = 0;
+}
+
+void JitterBuffer::send(const int16_t* samples, size_t frames, uint32_t flags) {
+    if (m_clock == 0)
+        m_clock = FrameHeader::now();
+
+    auto header = m_format;
+    header.timestamp = m_clock;
+    header.flags = flags;
+    header.length = frames * m_format.channels * sizeof(int16_t);
+
+    m_output(header, reinterpret_cast<const char*>(samples), header.length);
+
+    m_clock += frames * 1000000000ull / m_format.sampleRate;
+}
+
+size_t JitterBuffer::bufferedFrames() const {
+    return m_format.channels ? (m_samples.size() - m_read) / m_format.channels : 0;
+}
+
+size_t JitterBuffer::framesPerTick() const {
+    return static_cast<size_t>(m_format.sampleRate) * m_options.tickMs / 1000;
+}
+
+unsigned int JitterBuffer::toMs(size_t frames) const {
+    return m_format.sampleRate ? frames * 1000 / m_format.sampleRate : 0;
+}
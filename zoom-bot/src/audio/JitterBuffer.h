@@ -0,0 +1,129 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_JITTERBUFFER_H
+#define MEETING_SDK_LINUX_SAMPLE_JITTERBUFFER_H
+
+#include <poll.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../util/AudioRing.h"
+#include "../util/FrameHeader.h"
+#include "../util/Metrics.h"
+#include "../util/Log.h"
+
+using namespace std;
+
+namespace Late {
+    const string drop = "drop";
+    const string compress = "compress";
+}
+
+struct JitterOptions {
+    // audio held before playout starts and again after an underrun, 0 turns the buffer off
+    unsigned int targetMs = 0;
+    // most the buffer may add; beyond it the buffer is cut back to targetMs
+    unsigned int maxMs = 200;
+    // period of the output clock
+    unsigned int tickMs = 10;
+    // gaps are filled with silence for this long, after that the stream is considered paused
+    unsigned int maxGapMs = 10000;
+    // cut back by removing the quietest audio instead of the oldest
+    bool compress = true;
+
+    bool enabled() const { return targetMs > 0; }
+};
+
+/**
+ * Re-paces the mixed audio onto a steady clock between the SDK callbacks and the socket.
+ *
+ * The SDK delivers in bursts after network trouble and not at all while reconnecting, so
+ * the capture timestamps downstream would bunch up and jump. Here the SDK thread only
+ * copies chunks into a ring; a worker woken by a timerfd every tickMs sends exactly one
+ * tick of audio per tick, stamped on an even timeline. A tick without enough audio is
+ * padded with silence marked concealed, and playout waits for targetMs of audio again.
+ * When a burst pushes the buffer beyond maxMs it is cut back to targetMs, dropping the
+ * oldest audio or, with compress, the quietest ticks first so speech survives.
+ *
+ * Other streams pass the worker unpaced, which keeps it the only producer downstream.
+ */
+class JitterBuffer {
+public:
+    typedef function<void(const FrameHeader& header, const char* buf, size_t len)> Output;
+
+private:
+    const size_t c_slotSize = 4096;
+    const size_t c_ringSlots = 512;
+    // mean square of a tick quiet enough to drop, about -50 dBFS
+    const float c_quietLevel = 100.0f * 100.0f;
+
+    JitterOptions m_options;
+    Output m_output;
+
+    unique_ptr<AudioRing> m_ring;
+    int m_timerFd = -1;
+    thread m_thread;
+    atomic<bool> m_running{false};
+
+    // owned by the worker: buffered interleaved samples from m_read on
+    FrameHeader m_format;
+    vector<int16_t> m_samples;
+    size_t m_read = 0;
+
+    bool m_live = false;
+    bool m_playing = false;
+    uint64_t m_clock = 0;
+    unsigned int m_gapMs = 0;
+    uint32_t m_flags = 0;
+
+    vector<int16_t> m_silence;
+    vector<float> m_mono;
+
+    Counter& m_concealed;
+    Counter& m_dropped;
+    Counter& m_compressed;
+    Gauge& m_depth;
+
+    void run();
+    void drain();
+    void append(const FrameHeader& header, const char* buf, size_t len);
+    void tick();
+    void cutBack();
+    void flush();
+    void send(const int16_t* samples, size_t frames, uint32_t flags);
+
+    size_t bufferedFrames() const;
+    size_t framesPerTick() const;
+    unsigned int toMs(size_t frames) const;
+
+public:
+    /**
+     * @param output receives the paced mixed audio and everything else on the worker thread
+     */
+    JitterBuffer(const JitterOptions& options, const Output& output);
+    ~JitterBuffer();
+
+    JitterBuffer(const JitterBuffer&) = delete;
+    JitterBuffer& operator=(const JitterBuffer&) = delete;
+
+    bool start();
+
+    /**
+     * Send what is buffered without pacing and stop the worker
+     */
+    void stop();
+
+    /**
+     * Queue a chunk. Called from the SDK audio thread only.
+     * @param header stream, node, format and capture time of the chunk
+     * @param buf interleaved linear16 samples
+     * @param len number of bytes
+     */
+    void write(const FrameHeader& header, const char* buf, size_t len);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_JITTERBUFFER_H
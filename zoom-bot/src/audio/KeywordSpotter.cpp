@@ -0,0 +1,350 @@
+#include "KeywordSpotter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../util/ThreadRoles.h"
+
+KeywordSpotter::KeywordSpotter(const KeywordOptions& options, cv::dnn::Net net, const Trigger& onTrigger) :
+        m_options(options), m_net(std::move(net)), m_onTrigger(onTrigger),
+        m_inference(Metrics::getInstance().histogram("zoombot_keyword_inference_seconds",
+                                                     "Time the keyword model takes for one window")),
+        m_latency(Metrics::getInstance().histogram("zoombot_keyword_latency_seconds",
+                                                   "Time from the capture of a keyword's audio until it triggered")) {
+    m_options.hopMs = max(m_options.hopMs, 10u);
+
+    m_coefficients = m_options.mfcc ? m_options.mfcc : m_options.mels;
+    m_windowFrames = 1 + (max<size_t>(m_options.windowMs * c_sampleRate / 1000, c_frameSamples) - c_frameSamples) / c_hopSamples;
+    m_hopFrames = m_options.hopMs / 10;
+
+    for (auto& label : m_options.labels)
+        m_triggers.push_back(&Metrics::getInstance().counter("zoombot_keyword_triggers_total", "Keywords heard in the mixed audio",
+                                                             MetricsText::labels({{"keyword", label}})));
+
+    design();
+}
+
+KeywordSpotter::~KeywordSpotter() {
+    stop();
+}
+
+unique_ptr<KeywordSpotter> KeywordSpotter::load(const KeywordOptions& options, const Trigger& onTrigger) {
+    if (options.labels.empty()) {
+        Log::error("the keyword spotter needs the labels of its model");
+        return nullptr;
+    }
+
+    if (options.mfcc > options.mels) {
+        Log::error("the keyword spotter cannot take ", options.mfcc, " cepstral coefficients from ", options.mels, " mel bands");
+        return nullptr;
+    }
+
+    cv::dnn::Net net;
+    try {
+        net = cv::dnn::readNet(options.model);
+    } catch (const cv::Exception& e) {
+        Log::error("failed to read keyword model " + options.model + ": " + e.what());
+        return nullptr;
+    }
+
+    if (net.empty()) {
+        Log::error("failed to read keyword model " + options.model);
+        return nullptr;
+    }
+
+    // a window every hopMs is well within what one CPU core does for these models
+    net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+
+    auto spotter = make_unique<KeywordSpotter>(options, std::move(net), onTrigger);
+
+    // one silent window shows whether the model takes our features and has an output per label
+    try {
+        spotter->m_net.setInput(spotter->m_blob);
+        auto out = spotter->m_net.forward();
+
+        if (out.total() != options.labels.size()) {
+            Log::error("keyword model ", options.model, " has ", out.total(), " outputs for ",
+                       options.labels.size(), " labels");
+            return nullptr;
+        }
+    } catch (const cv::Exception& e) {
+        Log::error("keyword model " + options.model + " does not take " + to_string(spotter->m_windowFrames) + "x" +
+                   to_string(spotter->m_coefficients) + " features: " + e.what());
+        return nullptr;
+    }
+
+    return spotter;
+}
+
+bool KeywordSpotter::start() {
+    if (m_running)
+        return true;
+
+    if (!m_ring)
+        m_ring = make_unique<AudioRing>(c_ringSlots, c_slotSize, OverflowPolicy::DropOldest);
+
+    m_running = true;
+    m_thread = thread(&KeywordSpotter::run, this);
+
+    Log::info("spotting ", m_options.labels.size(), " labels in ", m_options.windowMs, "ms windows every ",
+              m_options.hopMs, "ms with ", m_options.model);
+
+    return true;
+}
+
+void KeywordSpotter::stop() {
+    if (!m_running.exchange(false))
+        return;
+
+    m_ring->wake();
+    m_thread.join();
+}
+
+void KeywordSpotter::write(const FrameHeader& header, const char* buf, size_t len) {
+    if (!m_running)
+        return;
+
+    // split on whole sample frames so every piece carries the timestamp of its first sample
+    size_t frameBytes = sizeof(int16_t) * max<uint8_t>(header.channels, 1);
+    auto room = c_slotSize - sizeof(FrameHeader);
+    room -= room % frameBytes;
+
+    for (size_t offset = 0; offset < len; offset += room) {
+        auto piece = header;
+        piece.length = min(room, len - offset);
+        if (header.sampleRate > 0)
+            piece.timestamp += offset / frameBytes * 1000000000ull / header.sampleRate;
+
+        m_ring->push(&piece, sizeof(piece), buf + offset, piece.length);
+    }
+}
+
+void KeywordSpotter::design() {
+    // periodic Hann window, zero padded to the FFT size by m_frame
+    m_window.resize(c_frameSamples);
+    for (size_t i = 0; i < c_frameSamples; i++)
+        m_window[i] = 0.5f - 0.5f * cos(2 * M_PI * i / c_frameSamples);
+
+    // triangular filters evenly spaced on the HTK mel scale from 20Hz to Nyquist
+    auto bins = static_cast<size_t>(c_fftSize / 2 + 1);
+    auto mel = [](double hz) { return 2595.0 * log10(1.0 + hz / 700.0); };
+    auto hz = [](double mel) { return 700.0 * (pow(10.0, mel / 2595.0) - 1.0); };
+
+    vector<double> edges(m_options.mels + 2);
+    auto low = mel(20.0), high = mel(c_sampleRate / 2.0);
+    for (size_t i = 0; i < edges.size(); i++)
+        edges[i] = hz(low + (high - low) * i / (edges.size() - 1));
+
+    m_filters.assign(m_options.mels * bins, 0.0f);
+    for (size_t m = 0; m < m_options.mels; m++) {
+        for (size_t k = 0; k < bins; k++) {
+            auto f = static_cast<double>(k) * c_sampleRate / c_fftSize;
+            auto rising = (f - edges[m]) / (edges[m + 1] - edges[m]);
+            auto falling = (edges[m + 2] - f) / (edges[m + 2] - edges[m + 1]);
+
+            m_filters[m * bins + k] = static_cast<float>(max(0.0, min(rising, falling)));
+        }
+    }
+
+    // orthonormal DCT-II
+    m_dct.assign(m_options.mfcc * m_options.mels, 0.0f);
+    for (size_t c = 0; c < m_options.mfcc; c++) {
+        auto scale = sqrt((c == 0 ? 1.0 : 2.0) / m_options.mels);
+        for (size_t m = 0; m < m_options.mels; m++)
+            m_dct[c * m_options.mels + m] = static_cast<float>(scale * cos(M_PI / m_options.mels * (m + 0.5) * c));
+    }
+
+    m_bands.resize(m_options.mels);
+    m_features.assign(m_windowFrames * m_coefficients, 0.0f);
+    m_posteriors.assign(c_smoothing * m_options.labels.size(), 0.0f);
+    m_quietUntil.assign(m_options.labels.size(), 0);
+
+    m_frame = cv::Mat::zeros(1, c_fftSize, CV_32F);
+    int shape[] = {1, 1, static_cast<int>(m_windowFrames), static_cast<int>(m_coefficients)};
+    m_blob = cv::Mat(4, shape, CV_32F, cv::Scalar(0));
+}
+
+void KeywordSpotter::run() {
+    // an inference every hop is model work, it must not compete with the audio callbacks
+    ThreadRoles::assign(ThreadRole::VideoWorker);
+
+    while (m_running) {
+        // only block once the ring is empty, otherwise the producer would not wake us
+        auto timeout = m_ring->sleep() ? 1000 : 0;
+
+        struct pollfd fd = {m_ring->fd(), POLLIN, 0};
+        if (poll(&fd, 1, timeout) == -1 && errno != EINTR) {
+            Log::error("keyword spotter poll failed");
+            break;
+        }
+
+        if (fd.revents & POLLIN)
+            m_ring->clear();
+
+        drain();
+    }
+}
+
+void KeywordSpotter::drain() {
+    while (auto* slot = m_ring->acquire()) {
+        FrameHeader header;
+        memcpy(&header, slot->data, sizeof(header));
+
+        if (!m_failed)
+            process(header, slot->data + sizeof(FrameHeader), slot->len - sizeof(FrameHeader));
+        m_ring->release(slot);
+    }
+}
+
+void KeywordSpotter::process(const FrameHeader& header, const char* buf, size_t len) {
+    if (header.sampleRate == 0 || len == 0)
+        return;
+
+    if (m_expected && header.timestamp > m_expected + c_maxGapNs)
+        reset();
+
+    auto channels = max<uint8_t>(header.channels, 1);
+    auto frames = len / (sizeof(int16_t) * channels);
+    m_expected = header.timestamp + frames * 1000000000ull / header.sampleRate;
+
+    if (!m_resampler || !m_resampler->accepts(header.sampleRate, channels))
+        m_resampler = make_unique<Resampler>(header.sampleRate, channels, c_sampleRate);
+
+    auto samples = m_resampler->process(reinterpret_cast<const int16_t*>(buf), frames, m_resampled);
+    for (size_t i = 0; i < samples; i++)
+        m_samples.push_back(m_resampled[i] / 32768.0f);
+
+    while (m_samples.size() - m_read >= c_frameSamples) {
+        addFrame(m_samples.data() + m_read);
+        m_read += c_hopSamples;
+
+        if (++m_sinceInference >= m_hopFrames && m_frames >= m_windowFrames) {
+            m_sinceInference = 0;
+            infer(header.timestamp);
+        }
+    }
+
+    m_samples.erase(m_samples.begin(), m_samples.begin() + m_read);
+    m_read = 0;
+}
+
+void KeywordSpotter::addFrame(const float* samples) {
+    auto* frame = m_frame.ptr<float>();
+    for (size_t i = 0; i < c_frameSamples; i++)
+        frame[i] = samples[i] * m_window[i];
+
+    cv::dft(m_frame, m_spectrum, cv::DFT_COMPLEX_OUTPUT);
+
+    auto* spectrum = m_spectrum.ptr<float>();
+    auto bins = static_cast<size_t>(c_fftSize / 2 + 1);
+
+    for (size_t m = 0; m < m_options.mels; m++) {
+        auto* filter = m_filters.data() + m * bins;
+        float energy = 0;
+
+        for (size_t k = 0; k < bins; k++) {
+            if (filter[k] == 0)
+                continue;
+
+            auto re = spectrum[2 * k], im = spectrum[2 * k + 1];
+            energy += filter[k] * (re * re + im * im);
+        }
+
+        m_bands[m] = log(energy + c_minEnergy);
+    }
+
+    auto* out = m_features.data() + m_next * m_coefficients;
+    if (m_options.mfcc == 0) {
+        copy(m_bands.begin(), m_bands.end(), out);
+    } else {
+        for (size_t c = 0; c < m_options.mfcc; c++) {
+            auto* basis = m_dct.data() + c * m_options.mels;
+            float sum = 0;
+
+            for (size_t m = 0; m < m_options.mels; m++)
+                sum += basis[m] * m_bands[m];
+
+            out[c] = sum;
+        }
+    }
+
+    m_next = (m_next + 1) % m_windowFrames;
+    m_frames++;
+}
+
+void KeywordSpotter::infer(uint64_t timestamp) {
+    // the window oldest frame first, which is the one about to be overwritten next
+    auto* blob = m_blob.ptr<float>();
+    auto tail = m_windowFrames - m_next;
+    memcpy(blob, m_features.data() + m_next * m_coefficients, tail * m_coefficients * sizeof(float));
+    memcpy(blob + tail * m_coefficients, m_features.data(), m_next * m_coefficients * sizeof(float));
+
+    auto started = FrameHeader::now();
+    cv::Mat out;
+    try {
+        m_net.setInput(m_blob);
+        out = m_net.forward();
+    } catch (const cv::Exception& e) {
+        Log::error(string("keyword spotting failed, turning it off: ") + e.what());
+        m_failed = true;
+        return;
+    }
+    m_inference.record(FrameHeader::now() - started);
+
+    auto labels = m_options.labels.size();
+    auto* scores = out.ptr<float>();
+    auto* posteriors = m_posteriors.data() + (m_inferences++ % c_smoothing) * labels;
+
+    // a model ending in logits still needs its softmax
+    float sum = 0;
+    auto probabilities = true;
+    for (size_t i = 0; i < labels; i++) {
+        sum += scores[i];
+        probabilities &= scores[i] >= 0 && scores[i] <= 1;
+    }
+
+    if (probabilities && fabs(sum - 1) < 1e-3f) {
+        copy(scores, scores + labels, posteriors);
+    } else {
+        auto peak = *max_element(scores, scores + labels);
+        sum = 0;
+
+        for (size_t i = 0; i < labels; i++)
+            sum += posteriors[i] = exp(scores[i] - peak);
+        for (size_t i = 0; i < labels; i++)
+            posteriors[i] /= sum;
+    }
+
+    auto rows = min(m_inferences, c_smoothing);
+    for (size_t i = 0; i < labels; i++) {
+        auto& label = m_options.labels[i];
+        if (label.empty() || label[0] == '_' || timestamp < m_quietUntil[i])
+            continue;
+
+        float mean = 0;
+        for (size_t r = 0; r < rows; r++)
+            mean += m_posteriors[r * labels + i];
+        mean /= rows;
+
+        if (mean < m_options.threshold)
+            continue;
+
+        m_quietUntil[i] = timestamp + m_options.refractoryMs * 1000000ull;
+        m_triggers[i]->add();
+        m_latency.record(FrameHeader::now() - timestamp);
+
+        Log::info("heard \"", label, "\" with ", mean);
+        if (m_onTrigger)
+            m_onTrigger({label, mean, timestamp});
+    }
+}
+
+void KeywordSpotter::reset() {
+    m_samples.clear();
+    m_read = 0;
+
+    m_next = m_frames = m_sinceInference = 0;
+    m_inferences = 0;
+}
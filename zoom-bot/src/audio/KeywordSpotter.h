@@ -0,0 +1,161 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_KEYWORDSPOTTER_H
+#define MEETING_SDK_LINUX_SAMPLE_KEYWORDSPOTTER_H
+
+#include <poll.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+
+#include "Resampler.h"
+#include "../util/AudioRing.h"
+#include "../util/FrameHeader.h"
+#include "../util/Metrics.h"
+#include "../util/Log.h"
+
+using namespace std;
+
+struct KeywordOptions {
+    // cv::dnn model over the features of a window, e.g. ONNX; empty turns spotting off
+    string model;
+    // one per model output; labels starting with _ like _silence_ or _unknown_ never trigger
+    vector<string> labels;
+    // mean posterior of the last inferences a keyword needs to trigger
+    float threshold = 0.8f;
+    // audio the model sees in one inference
+    unsigned int windowMs = 1000;
+    // period of the inferences
+    unsigned int hopMs = 100;
+    unsigned int mels = 40;
+    // cepstral coefficients from the mel bands, 0 feeds the log-mel energies directly
+    unsigned int mfcc = 0;
+    // a keyword that triggered cannot trigger again for this long
+    unsigned int refractoryMs = 1000;
+
+    bool enabled() const { return !model.empty(); }
+};
+
+struct KeywordEvent {
+    string keyword;
+    float confidence;
+    // CLOCK_MONOTONIC capture time of the chunk that completed the window
+    uint64_t timestamp;
+};
+
+/**
+ * Listens for keywords in the mixed audio, so the assistant can react to a spoken command
+ * without waiting for a transcript.
+ *
+ * The SDK thread only copies chunks into a ring. A worker resamples them to 16kHz mono and
+ * turns every 10ms into a frame of features: the log energies of mels bands over a 25ms
+ * Hann window or, with mfcc, cepstral coefficients from them. Every hopMs the last windowMs
+ * of frames go through the model as a 1x1xframesxcoefficients blob, the input of the CNN
+ * and DS-CNN models of the speech commands family; int8 models quantized to ONNX QDQ run
+ * as well. Outputs that are not probabilities yet go through a softmax.
+ *
+ * A keyword triggers when its posterior averaged over the last c_smoothing inferences
+ * reaches the threshold, which with the default hop is about 200ms after it was said.
+ * A gap in the audio starts the window over, so speech from both sides is never mixed.
+ */
+class KeywordSpotter {
+public:
+    typedef function<void(const KeywordEvent& event)> Trigger;
+
+private:
+    const unsigned int c_sampleRate = 16000;
+    const size_t c_frameSamples = 400;
+    const size_t c_hopSamples = 160;
+    const int c_fftSize = 512;
+    const size_t c_smoothing = 3;
+
+    const size_t c_slotSize = 4096;
+    const size_t c_ringSlots = 256;
+    const uint64_t c_maxGapNs = 200000000;
+    const float c_minEnergy = 1e-6f;
+
+    KeywordOptions m_options;
+    cv::dnn::Net m_net;
+    Trigger m_onTrigger;
+
+    unique_ptr<AudioRing> m_ring;
+    thread m_thread;
+    atomic<bool> m_running{false};
+
+    Histogram& m_inference;
+    Histogram& m_latency;
+    vector<Counter*> m_triggers;
+
+    // owned by the worker from here on
+    unique_ptr<Resampler> m_resampler;
+    vector<int16_t> m_resampled;
+    vector<float> m_samples;
+    size_t m_read = 0;
+    uint64_t m_expected = 0;
+
+    size_t m_coefficients;
+    size_t m_windowFrames;
+    size_t m_hopFrames;
+
+    vector<float> m_window;
+    // mels rows of c_fftSize / 2 + 1 weights, and mfcc rows of mels for the DCT
+    vector<float> m_filters;
+    vector<float> m_dct;
+    vector<float> m_bands;
+
+    // the last m_windowFrames frames, m_next being the oldest once it is full
+    vector<float> m_features;
+    size_t m_next = 0;
+    size_t m_frames = 0;
+    size_t m_sinceInference = 0;
+
+    vector<float> m_posteriors;
+    size_t m_inferences = 0;
+    vector<uint64_t> m_quietUntil;
+    bool m_failed = false;
+
+    cv::Mat m_frame;
+    cv::Mat m_spectrum;
+    cv::Mat m_blob;
+
+    void design();
+    void run();
+    void drain();
+    void process(const FrameHeader& header, const char* buf, size_t len);
+    void addFrame(const float* samples);
+    void infer(uint64_t timestamp);
+    void reset();
+
+public:
+    KeywordSpotter(const KeywordOptions& options, cv::dnn::Net net, const Trigger& onTrigger);
+    ~KeywordSpotter();
+
+    KeywordSpotter(const KeywordSpotter&) = delete;
+    KeywordSpotter& operator=(const KeywordSpotter&) = delete;
+
+    /**
+     * Read the model and check it against the labels
+     * @param onTrigger called on the worker thread for every keyword heard
+     * @return nullptr if the model cannot be read or the options do not fit it
+     */
+    static unique_ptr<KeywordSpotter> load(const KeywordOptions& options, const Trigger& onTrigger);
+
+    bool start();
+    void stop();
+
+    /**
+     * Queue a chunk of the mixed audio. Called from the SDK audio thread only.
+     * @param header format and capture time of the chunk
+     * @param buf interleaved linear16 samples
+     * @param len number of bytes
+     */
+    void write(const FrameHeader& header, const char* buf, size_t len);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_KEYWORDSPOTTER_H
@@ -0,0 +1,91 @@
+#include "OpusAudioEncoder.h"
+
+OpusAudioEncoder::OpusAudioEncoder(const EncoderOptions& options, unsigned int inRate, unsigned int inChannels,
+                                   unsigned int rate, unsigned int channels)
+    : AudioEncoder(options, inRate, inChannels, rate, channels) {}
+
+OpusAudioEncoder::~OpusAudioEncoder() {
+    if (m_encoder)
+        opus_encoder_destroy(m_encoder);
+}
+
+bool OpusAudioEncoder::init() {
+    int err;
+    m_encoder = opus_encoder_create(m_rate, m_channels, OPUS_APPLICATION_VOIP, &err);
+    if (err != OPUS_OK) {
+        Log::error("failed to create Opus encoder: " + string(opus_strerror(err)));
+        m_encoder = nullptr;
+        return false;
+    }
+
+    opus_encoder_ctl(m_encoder, OPUS_SET_BITRATE(m_options.bitrate));
+    opus_encoder_ctl(m_encoder, OPUS_SET_COMPLEXITY(m_options.complexity));
+    opus_encoder_ctl(m_encoder, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(m_encoder, OPUS_GET_LOOKAHEAD(&lookahead));
+    m_lookahead = lookahead;
+
+    return true;
+}
+
+bool OpusAudioEncoder::encodeFrame(const int16_t* samples, uint64_t timestamp, uint32_t flags, vector<Packet>& out) {
+    auto& packet = out.emplace_back();
+    packet.timestamp = timestamp;
+    packet.flags = flags;
+    packet.data.resize(c_maxPacket);
+
+    auto len = opus_encode(m_encoder, samples, m_frameSamples,
+                           reinterpret_cast<unsigned char*>(packet.data.data()), c_maxPacket);
+    if (len < 0) {
+        Log::error("Opus encoding failed: " + string(opus_strerror(len)));
+        out.pop_back();
+        return false;
+    }
+
+    packet.data.resize(len);
+    return true;
+}
+
+string OpusAudioEncoder::codecHeader() const {
+    // RFC 7845 identification header, all fields little endian
+    string head = "OpusHead";
+    auto put = [&head](uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++)
+            head.push_back(static_cast<char>(value >> (8 * i)));
+    };
+
+    put(1, 1);
+    put(m_channels, 1);
+    put(m_lookahead * 48000 / m_rate, 2);
+    put(m_inRate, 4);
+    put(0, 2);
+    put(0, 1);
+
+    return head;
+}
+
+PayloadFormat OpusAudioEncoder::format() const {
+    return PayloadFormat::Opus;
+}
+
+const string& OpusAudioEncoder::name() const {
+    return Codec::opus;
+}
+
+bool OpusAudioEncoder::supports(unsigned int rate) {
+    return rate == 8000 || rate == 12000 || rate == 16000 || rate == 24000 || rate == 48000;
+}
+
+unique_ptr<AudioEncoder> OpusAudioEncoder::create(const EncoderOptions& options, unsigned int rate, unsigned int channels) {
+    // anything else goes through the resampler, which also downmixes to mono
+    auto native = supports(rate) && channels <= 2;
+    auto outRate = native ? rate : 48000;
+    auto outChannels = native ? channels : 1;
+
+    unique_ptr<OpusAudioEncoder> encoder(new OpusAudioEncoder(options, rate, channels, outRate, outChannels));
+    if (!encoder->init())
+        return nullptr;
+
+    return encoder;
+}
@@ -0,0 +1,46 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_OPUSAUDIOENCODER_H
+#define MEETING_SDK_LINUX_SAMPLE_OPUSAUDIOENCODER_H
+
+#include <opus/opus.h>
+
+#include "AudioEncoder.h"
+#include "../util/Log.h"
+
+/**
+ * Opus through libopus, tuned for speech.
+ *
+ * Opus only runs at 8, 12, 16, 24 or 48kHz, so the SDK's 32kHz audio is resampled to
+ * 48kHz mono first. Every packet is self-contained; the codec header is an RFC 7845
+ * OpusHead, which a file sink can put straight into an Ogg stream.
+ */
+class OpusAudioEncoder : public AudioEncoder {
+    // the largest packet libopus recommends for a single frame
+    const size_t c_maxPacket = 4000;
+
+    OpusEncoder* m_encoder = nullptr;
+    int m_lookahead = 0;
+
+    OpusAudioEncoder(const EncoderOptions& options, unsigned int inRate, unsigned int inChannels,
+                     unsigned int rate, unsigned int channels);
+
+    bool init();
+
+protected:
+    bool encodeFrame(const int16_t* samples, uint64_t timestamp, uint32_t flags, vector<Packet>& out) override;
+
+public:
+    ~OpusAudioEncoder();
+
+    string codecHeader() const override;
+    PayloadFormat format() const override;
+    const string& name() const override;
+
+    /**
+     * @return true if Opus encodes this rate without resampling
+     */
+    static bool supports(unsigned int rate);
+
+    static unique_ptr<AudioEncoder> create(const EncoderOptions& options, unsigned int rate, unsigned int channels);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_OPUSAUDIOENCODER_H
@@ -0,0 +1,104 @@
+#include "Resampler.h"
+
+#include <cmath>
+#include <numeric>
+
+Resampler::Resampler(unsigned int inRate, unsigned int channels, unsigned int outRate) :
+        m_inRate(inRate), m_outRate(outRate), m_channels(channels) {
+    auto g = gcd(inRate, outRate);
+    m_up = outRate / g;
+    m_down = inRate / g;
+
+    design();
+
+    m_historyLen = c_tapsPerPhase - 1;
+    m_history.assign(m_historyLen, 0.0f);
+}
+
+void Resampler::design() {
+    // prototype filter at up * inRate, cut off just below the lower Nyquist frequency
+    auto len = m_up * c_tapsPerPhase;
+    auto cutoff = 0.45 / max(m_up, m_down);
+    auto center = (len - 1) / 2.0;
+
+    vector<double> h(len);
+    for (unsigned int k = 0; k < len; k++) {
+        auto x = k - center;
+        auto sinc = x == 0 ? 2 * cutoff : sin(2 * M_PI * cutoff * x) / (M_PI * x);
+        auto blackman = 0.42 - 0.5 * cos(2 * M_PI * k / (len - 1)) + 0.08 * cos(4 * M_PI * k / (len - 1));
+        h[k] = sinc * blackman;
+    }
+
+    // unity gain at DC after zero stuffing
+    auto sum = accumulate(h.begin(), h.end(), 0.0);
+    for (auto& tap : h)
+        tap *= m_up / sum;
+
+    // phase p uses h[p + j * up] against input x[i - j], stored reversed for a forward dot product
+    m_coeffs.resize(len);
+    for (unsigned int p = 0; p < m_up; p++)
+        for (unsigned int j = 0; j < c_tapsPerPhase; j++)
+            m_coeffs[p * c_tapsPerPhase + (c_tapsPerPhase - 1 - j)] = h[p + j * m_up];
+}
+
+size_t Resampler::process(const int16_t* in, size_t frames, vector<int16_t>& out) {
+    auto needed = m_historyLen + frames;
+    if (m_history.size() < needed)
+        m_history.resize(needed);
+
+    AudioKernels::toMonoFloat(in, frames, m_channels, m_history.data() + m_historyLen);
+
+    if (m_up == m_down) {
+        // same rate, downmix only
+        if (out.size() < frames)
+            out.resize(frames);
+
+        AudioKernels::toInt16(m_history.data() + m_historyLen, frames, out.data());
+        return frames;
+    }
+
+    m_historyLen = needed;
+
+    auto maxOut = (frames * m_up) / m_down + 2;
+    if (out.size() < maxOut)
+        out.resize(maxOut);
+    if (m_output.size() < maxOut)
+        m_output.resize(maxOut);
+
+    size_t start = 0;
+    size_t count = 0;
+    const float* coeffs = m_coeffs.data();
+
+    while (start + c_tapsPerPhase <= m_historyLen) {
+        m_output[count++] = AudioKernels::dot(m_history.data() + start, coeffs + m_phase * c_tapsPerPhase, c_tapsPerPhase);
+
+        m_phase += m_down;
+        start += m_phase / m_up;
+        m_phase %= m_up;
+    }
+
+    AudioKernels::toInt16(m_output.data(), count, out.data());
+
+    // keep the tail that the next output still needs
+    auto keep = m_historyLen - start;
+    copy(m_history.begin() + start, m_history.begin() + m_historyLen, m_history.begin());
+    m_historyLen = keep;
+
+    return count;
+}
+
+bool Resampler::accepts(unsigned int inRate, unsigned int channels) const {
+    return inRate == m_inRate && channels == m_channels;
+}
+
+unsigned int Resampler::inRate() const {
+    return m_inRate;
+}
+
+unsigned int Resampler::outRate() const {
+    return m_outRate;
+}
+
+unsigned int Resampler::channels() const {
+    return m_channels;
+}
@@ -0,0 +1,63 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_RESAMPLER_H
+#define MEETING_SDK_LINUX_SAMPLE_RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AudioKernels.h"
+
+using namespace std;
+
+/**
+ * Streaming polyphase resampler with stereo to mono downmix.
+ *
+ * Converts interleaved linear16 at any input rate to mono linear16 at the output rate
+ * through a windowed-sinc low-pass, so 32kHz SDK audio can leave the bot Deepgram-ready.
+ * Filter state carries over between calls, so chunks can be fed as the SDK delivers them.
+ */
+class Resampler {
+    const unsigned int c_tapsPerPhase = 32;
+
+    unsigned int m_inRate;
+    unsigned int m_outRate;
+    unsigned int m_channels;
+
+    unsigned int m_up;
+    unsigned int m_down;
+    unsigned int m_phase = 0;
+
+    // one reversed block of c_tapsPerPhase coefficients per phase
+    vector<float> m_coeffs;
+
+    // mono input, starting with the c_tapsPerPhase - 1 samples kept from the last call
+    vector<float> m_history;
+    size_t m_historyLen;
+
+    vector<float> m_output;
+
+    void design();
+
+public:
+    Resampler(unsigned int inRate, unsigned int channels, unsigned int outRate);
+
+    /**
+     * Resample one chunk
+     * @param in interleaved samples
+     * @param frames samples per channel in the chunk
+     * @param out receives the mono output
+     * @return number of samples written to out
+     */
+    size_t process(const int16_t* in, size_t frames, vector<int16_t>& out);
+
+    /**
+     * @return true if this resampler was built for the given input format
+     */
+    bool accepts(unsigned int inRate, unsigned int channels) const;
+
+    unsigned int inRate() const;
+    unsigned int outRate() const;
+    unsigned int channels() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_RESAMPLER_H
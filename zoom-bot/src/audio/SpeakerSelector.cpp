@@ -0,0 +1,135 @@
+#include "SpeakerSelector.h"
+
+#include <algorithm>
+
+SpeakerSelector::SpeakerSelector(const SpeakerOptions& options) : m_options(options) {
+    m_options.maxSpeakers = max(1u, options.maxSpeakers);
+
+    // 10ms chunks, like VadGate
+    m_prerollChunks = (options.prerollMs + 9) / 10;
+}
+
+SpeakerSelector::Speaker* SpeakerSelector::slot(uint32_t nodeId) {
+    auto it = find_if(m_speakers.begin(), m_speakers.end(), [nodeId](const Speaker& s) { return s.nodeId == nodeId; });
+    return it == m_speakers.end() ? nullptr : &*it;
+}
+
+bool SpeakerSelector::update(const vector<uint32_t>& active, uint64_t now) {
+    auto changed = false;
+
+    // the hold of whoever dropped off the list starts now
+    for (auto& speaker : m_speakers) {
+        auto listed = std::find(active.begin(), active.end(), speaker.nodeId) != active.end();
+        if (speaker.active && !listed)
+            speaker.lastActive = now;
+
+        speaker.active = listed;
+        if (listed)
+            speaker.lastActive = now;
+    }
+
+    for (auto nodeId : active) {
+        if (slot(nodeId))
+            continue;
+
+        Speaker speaker{nodeId, true, now};
+
+        if (m_speakers.size() < m_options.maxSpeakers) {
+            m_speakers.push_back(speaker);
+            changed = true;
+            continue;
+        }
+
+        Speaker* quiet = nullptr;
+        for (auto& candidate : m_speakers)
+            if (!candidate.active && (!quiet || candidate.lastActive < quiet->lastActive))
+                quiet = &candidate;
+
+        // every slot is talking, the rest wait for the next change
+        if (!quiet)
+            break;
+
+        *quiet = speaker;
+        changed = true;
+    }
+
+    return changed;
+}
+
+bool SpeakerSelector::expire(uint64_t now) {
+    auto hold = m_options.holdMs * 1000000ull;
+    auto before = m_speakers.size();
+
+    m_speakers.erase(remove_if(m_speakers.begin(), m_speakers.end(), [&](const Speaker& s) {
+        return !s.active && now - s.lastActive > hold;
+    }), m_speakers.end());
+
+    return m_speakers.size() != before;
+}
+
+bool SpeakerSelector::forwarding(uint32_t nodeId) const {
+    return any_of(m_speakers.begin(), m_speakers.end(), [nodeId](const Speaker& s) { return s.nodeId == nodeId; });
+}
+
+void SpeakerSelector::hold(const FrameHeader& header, const char* buf, size_t len) {
+    if (m_prerollChunks == 0)
+        return;
+
+    auto& preroll = m_preroll[header.nodeId];
+    if (preroll.chunks.empty())
+        preroll.chunks.resize(m_prerollChunks);
+
+    auto slot = (preroll.head + preroll.count) % preroll.chunks.size();
+    if (preroll.count == preroll.chunks.size()) {
+        // overwrite the oldest
+        slot = preroll.head;
+        preroll.head = (preroll.head + 1) % preroll.chunks.size();
+    } else {
+        preroll.count++;
+    }
+
+    auto& pending = preroll.chunks[slot];
+    pending.header = header;
+    pending.data.assign(buf, buf + len);
+}
+
+void SpeakerSelector::drain(uint32_t nodeId, uint64_t now, const Emit& emit) {
+    auto it = m_preroll.find(nodeId);
+    if (it == m_preroll.end())
+        return;
+
+    auto& preroll = it->second;
+    auto oldest = now - min<uint64_t>(now, m_options.prerollMs * 1000000ull);
+
+    // audio from before the node last went quiet is not part of this turn
+    for (; preroll.count > 0; preroll.count--) {
+        auto& pending = preroll.chunks[preroll.head];
+        if (pending.header.timestamp >= oldest)
+            emit(pending.header, pending.data.data(), pending.data.size());
+
+        preroll.head = (preroll.head + 1) % preroll.chunks.size();
+    }
+    preroll.head = 0;
+}
+
+void SpeakerSelector::remove(uint32_t nodeId) {
+    m_preroll.erase(nodeId);
+    m_speakers.erase(remove_if(m_speakers.begin(), m_speakers.end(), [nodeId](const Speaker& s) {
+        return s.nodeId == nodeId;
+    }), m_speakers.end());
+}
+
+void SpeakerSelector::clear() {
+    m_preroll.clear();
+    m_speakers.clear();
+}
+
+vector<uint32_t> SpeakerSelector::speakers() const {
+    vector<uint32_t> ids;
+    ids.reserve(m_speakers.size());
+
+    for (auto& speaker : m_speakers)
+        ids.push_back(speaker.nodeId);
+
+    return ids;
+}
@@ -0,0 +1,110 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_SPEAKERSELECTOR_H
+#define MEETING_SDK_LINUX_SAMPLE_SPEAKERSELECTOR_H
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "../util/FrameHeader.h"
+
+using namespace std;
+
+struct SpeakerOptions {
+    // one-way streams forwarded at once
+    unsigned int maxSpeakers = 2;
+
+    // a speaker who went quiet keeps the slot this long, unless a new speaker needs it
+    unsigned int holdMs = 1000;
+
+    // each node's latest audio, sent ahead of it once it becomes a speaker
+    unsigned int prerollMs = 500;
+};
+
+/**
+ * Picks whose one-way audio reaches the socket by following the SDK's active speaker
+ * callbacks, so speech arrives attributed to its node for about the price of one stream.
+ *
+ * At most maxSpeakers nodes are forwarded. The callbacks trail the speech they report, so
+ * every other node's last prerollMs of audio is kept and handed over when it takes a slot.
+ * Not thread safe, the caller serializes the SDK callbacks and the audio thread.
+ */
+class SpeakerSelector {
+public:
+    typedef function<void(const FrameHeader& header, const char* buf, size_t len)> Emit;
+
+private:
+    struct Speaker {
+        uint32_t nodeId;
+        bool active;
+        // when the SDK last listed the node, for the hold
+        uint64_t lastActive;
+    };
+
+    struct Pending {
+        FrameHeader header;
+        vector<char> data;
+    };
+
+    struct Preroll {
+        vector<Pending> chunks;
+        size_t head = 0;
+        size_t count = 0;
+    };
+
+    SpeakerOptions m_options;
+    size_t m_prerollChunks;
+
+    vector<Speaker> m_speakers;
+    unordered_map<uint32_t, Preroll> m_preroll;
+
+    Speaker* slot(uint32_t nodeId);
+
+public:
+    explicit SpeakerSelector(const SpeakerOptions& options);
+
+    /**
+     * Take the SDK's list of who is talking; a new speaker replaces the quiet speaker that
+     * was heard longest ago if every slot is taken
+     * @param active user IDs of everyone talking, in the SDK's order
+     * @param now CLOCK_MONOTONIC time in nanoseconds
+     * @return true if the forwarded nodes changed
+     */
+    bool update(const vector<uint32_t>& active, uint64_t now);
+
+    /**
+     * Free the slots of quiet speakers whose hold ran out
+     * @return true if the forwarded nodes changed
+     */
+    bool expire(uint64_t now);
+
+    /**
+     * @return true if the node's audio should leave
+     */
+    bool forwarding(uint32_t nodeId) const;
+
+    /**
+     * Keep a chunk of a node that is not forwarded, in case it is about to be
+     * @param header complete header of the chunk, including a capture timestamp
+     */
+    void hold(const FrameHeader& header, const char* buf, size_t len);
+
+    /**
+     * Hand over what was kept of a node, oldest first, and forget it
+     * @param now chunks older than the pre-roll at this time are left out
+     */
+    void drain(uint32_t nodeId, uint64_t now, const Emit& emit);
+
+    /**
+     * Forget a node that left the meeting
+     */
+    void remove(uint32_t nodeId);
+    void clear();
+
+    /**
+     * @return the forwarded nodes, in slot order
+     */
+    vector<uint32_t> speakers() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_SPEAKERSELECTOR_H
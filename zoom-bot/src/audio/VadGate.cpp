@@ -0,0 +1,70 @@
+#include "VadGate.h"
+
+VadGate::VadGate(const VadOptions& options) : m_options(options), m_vad(options) {
+    // enough 10ms chunks to cover the pre-roll
+    m_preroll.resize(max(1u, (options.prerollMs + 9) / 10));
+}
+
+void VadGate::process(const FrameHeader& header, const char* buf, size_t len, const Emit& emit) {
+    auto frames = len / (sizeof(int16_t) * max<uint8_t>(header.channels, 1));
+    auto decision = m_vad.process(reinterpret_cast<const int16_t*>(buf), frames, header.channels, header.sampleRate);
+
+    if (decision.event == VoiceActivityDetector::Event::SpeechStart) {
+        auto start = m_count > 0 ? m_preroll[m_head].header : header;
+        marker(start, FrameHeader::c_flagSpeechStart, emit);
+
+        for (; m_count > 0; m_count--) {
+            auto& pending = m_preroll[m_head];
+            emit(pending.header, pending.data.data(), pending.data.size());
+            m_head = (m_head + 1) % m_preroll.size();
+        }
+        m_head = 0;
+    }
+
+    if (decision.speech) {
+        emit(header, buf, len);
+        m_lastEmit = header.timestamp;
+        return;
+    }
+
+    if (decision.event == VoiceActivityDetector::Event::SpeechEnd)
+        marker(header, FrameHeader::c_flagSpeechEnd, emit);
+
+    hold(header, buf, len);
+    m_suppressed++;
+
+    if (header.timestamp - m_lastEmit >= m_options.keepaliveMs * 1000000ull)
+        marker(header, FrameHeader::c_flagSilence, emit);
+}
+
+void VadGate::hold(const FrameHeader& header, const char* buf, size_t len) {
+    auto slot = (m_head + m_count) % m_preroll.size();
+    if (m_count == m_preroll.size()) {
+        // overwrite the oldest
+        slot = m_head;
+        m_head = (m_head + 1) % m_preroll.size();
+    } else {
+        m_count++;
+    }
+
+    auto& pending = m_preroll[slot];
+    pending.header = header;
+    pending.data.assign(buf, buf + len);
+}
+
+void VadGate::marker(const FrameHeader& header, uint32_t flags, const Emit& emit) {
+    auto marker = header;
+    marker.length = 0;
+    marker.flags = flags;
+
+    emit(marker, nullptr, 0);
+    m_lastEmit = header.timestamp;
+}
+
+bool VadGate::speech() const {
+    return m_vad.speech();
+}
+
+uint64_t VadGate::suppressed() const {
+    return m_suppressed;
+}
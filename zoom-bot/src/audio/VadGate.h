@@ -0,0 +1,60 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_VADGATE_H
+#define MEETING_SDK_LINUX_SAMPLE_VADGATE_H
+
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "VoiceActivityDetector.h"
+#include "../util/FrameHeader.h"
+
+using namespace std;
+
+/**
+ * Drops the silent chunks of one stream before they reach the socket.
+ *
+ * Speech leaves together with a short pre-roll of the chunks before it, so onsets are not
+ * clipped. Silence is replaced by empty marker frames: one at speech start and end, and a
+ * keepalive every keepaliveMs so consumers can tell a quiet stream from a dead one.
+ */
+class VadGate {
+public:
+    typedef function<void(const FrameHeader& header, const char* buf, size_t len)> Emit;
+
+private:
+    struct Pending {
+        FrameHeader header;
+        vector<char> data;
+    };
+
+    VadOptions m_options;
+    VoiceActivityDetector m_vad;
+
+    // pre-roll kept while silent, oldest first
+    vector<Pending> m_preroll;
+    size_t m_head = 0;
+    size_t m_count = 0;
+
+    uint64_t m_lastEmit = 0;
+    uint64_t m_suppressed = 0;
+
+    void hold(const FrameHeader& header, const char* buf, size_t len);
+    void marker(const FrameHeader& header, uint32_t flags, const Emit& emit);
+
+public:
+    explicit VadGate(const VadOptions& options);
+
+    /**
+     * Pass one chunk through the gate
+     * @param header complete header of the chunk, including a capture timestamp
+     * @param buf interleaved linear16
+     * @param len bytes in buf
+     * @param emit receives every frame that should leave, in order
+     */
+    void process(const FrameHeader& header, const char* buf, size_t len, const Emit& emit);
+
+    bool speech() const;
+    uint64_t suppressed() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_VADGATE_H
@@ -0,0 +1,114 @@
+#include "VoiceActivityDetector.h"
+
+#include <cmath>
+
+VoiceActivityDetector::VoiceActivityDetector(const VadOptions& options) : m_options(options) {}
+
+void VoiceActivityDetector::designBand(unsigned int rate) {
+    // RBJ cookbook sections with Butterworth Q
+    auto design = [rate](Biquad& section, double cutoff, bool high) {
+        auto w = 2 * M_PI * cutoff / rate;
+        auto alpha = sin(w) / (2 * M_SQRT1_2);
+        auto c = cos(w);
+        auto a0 = 1 + alpha;
+
+        auto gain = high ? (1 + c) / 2 : (1 - c) / 2;
+        section = Biquad();
+        section.b0 = gain / a0;
+        section.b1 = (high ? -2 * gain : 2 * gain) / a0;
+        section.b2 = gain / a0;
+        section.a1 = -2 * c / a0;
+        section.a2 = (1 - alpha) / a0;
+    };
+
+    design(m_highPass, 250.0, true);
+    design(m_lowPass, min(3400.0, rate * 0.45), false);
+    m_rate = rate;
+}
+
+float VoiceActivityDetector::bandMeanSquare(size_t frames) {
+    double sum = 0;
+
+    for (size_t i = 0; i < frames; i++) {
+        auto y = m_lowPass.step(m_highPass.step(m_mono[i]));
+        sum += y * y;
+    }
+
+    return frames == 0 ? 0.0f : sum / frames;
+}
+
+void VoiceActivityDetector::trackNoise(float db, size_t frames, unsigned int rate) {
+    if (!m_primed) {
+        m_noiseDb = m_blockMin = m_lastBlockMin = db;
+        m_primed = true;
+    }
+
+    m_blockMin = min(m_blockMin, db);
+    m_blockFrames += frames;
+
+    // the floor follows drops at once and rises only when a whole block stayed louder
+    if (m_blockFrames >= rate) {
+        m_lastBlockMin = m_blockMin;
+        m_blockMin = db;
+        m_blockFrames = 0;
+    }
+
+    m_noiseDb = min(m_blockMin, m_lastBlockMin);
+}
+
+VoiceActivityDetector::Decision VoiceActivityDetector::process(const int16_t* in, size_t frames, unsigned int channels, unsigned int rate) {
+    Decision decision;
+    if (frames == 0 || rate == 0)
+        return decision;
+
+    if (m_mono.size() < frames)
+        m_mono.resize(frames);
+
+    AudioKernels::toMonoFloat(in, frames, channels, m_mono.data());
+
+    auto meanSquare = AudioKernels::meanSquare(m_mono.data(), frames);
+    auto zcr = static_cast<float>(AudioKernels::zeroCrossings(m_mono.data(), frames)) / frames;
+
+    if (m_options.mode == VadMode::Subband) {
+        if (rate != m_rate)
+            designBand(rate);
+
+        meanSquare = bandMeanSquare(frames);
+    }
+
+    // level relative to a full-scale int16 square wave
+    auto db = 10.0f * log10f(meanSquare / (32768.0f * 32768.0f) + 1e-10f);
+
+    trackNoise(db, frames, rate);
+    auto active = db > c_minDb && db > m_noiseDb + m_options.thresholdDb && zcr < c_maxZcr;
+
+    m_active = active ? m_active + 1 : 0;
+    auto hangover = static_cast<size_t>(m_options.hangoverMs) * rate / 1000;
+
+    if (m_active >= c_attackChunks) {
+        if (!m_speech)
+            decision.event = Event::SpeechStart;
+
+        m_speech = true;
+        m_hangoverLeft = hangover;
+    } else if (m_speech) {
+        if (m_hangoverLeft > frames) {
+            m_hangoverLeft -= frames;
+        } else {
+            m_hangoverLeft = 0;
+            m_speech = false;
+            decision.event = Event::SpeechEnd;
+        }
+    }
+
+    decision.speech = m_speech;
+    return decision;
+}
+
+bool VoiceActivityDetector::speech() const {
+    return m_speech;
+}
+
+float VoiceActivityDetector::noiseFloorDb() const {
+    return m_noiseDb;
+}
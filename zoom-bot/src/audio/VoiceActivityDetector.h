@@ -0,0 +1,125 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_VOICEACTIVITYDETECTOR_H
+#define MEETING_SDK_LINUX_SAMPLE_VOICEACTIVITYDETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AudioKernels.h"
+
+using namespace std;
+
+enum class VadMode {
+    Off,
+    Energy,
+    Subband
+};
+
+namespace Vad {
+    const string off = "off";
+    const string energy = "energy";
+    const string subband = "subband";
+
+    inline VadMode parse(const string& name) {
+        if (name == energy) return VadMode::Energy;
+        if (name == subband) return VadMode::Subband;
+        return VadMode::Off;
+    }
+}
+
+struct VadOptions {
+    VadMode mode = VadMode::Off;
+
+    // how far above the tracked noise floor a chunk has to be to count as speech
+    float thresholdDb = 9.0f;
+
+    unsigned int hangoverMs = 300;
+    unsigned int prerollMs = 100;
+    unsigned int keepaliveMs = 1000;
+};
+
+/**
+ * Per-stream speech detector over 10ms chunks.
+ *
+ * Energy mode compares the chunk level against a noise floor and uses the zero-crossing
+ * rate to reject hiss. The floor is the minimum level seen over the last one to two
+ * seconds, so stationary noise can never pass for speech for long. Subband mode does the
+ * same on the 250-3400Hz speech band, which ignores rumble and hum that carry energy but
+ * no voice.
+ */
+class VoiceActivityDetector {
+public:
+    enum class Event {
+        None,
+        SpeechStart,
+        SpeechEnd
+    };
+
+    struct Decision {
+        bool speech = false;
+        Event event = Event::None;
+    };
+
+private:
+    // chunks quieter than this are never speech, however low the floor gets
+    const float c_minDb = -60.0f;
+    const float c_maxZcr = 0.4f;
+    const unsigned int c_attackChunks = 2;
+
+    VadOptions m_options;
+
+    // minimum statistics over two alternating blocks of about a second each
+    float m_noiseDb = 0.0f;
+    float m_blockMin = 0.0f;
+    float m_lastBlockMin = 0.0f;
+    size_t m_blockFrames = 0;
+    bool m_primed = false;
+
+    unsigned int m_active = 0;
+    bool m_speech = false;
+    size_t m_hangoverLeft = 0;
+
+    /**
+     * Direct form I biquad section
+     */
+    struct Biquad {
+        float b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+        float x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+
+        float step(float x) {
+            auto y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+            x2 = x1; x1 = x;
+            y2 = y1; y1 = y;
+            return y;
+        }
+    };
+
+    // speech band as a high-pass and a low-pass section, designed for m_rate
+    unsigned int m_rate = 0;
+    Biquad m_highPass;
+    Biquad m_lowPass;
+
+    vector<float> m_mono;
+
+    void designBand(unsigned int rate);
+    float bandMeanSquare(size_t frames);
+    void trackNoise(float db, size_t frames, unsigned int rate);
+
+public:
+    explicit VoiceActivityDetector(const VadOptions& options);
+
+    /**
+     * Classify one chunk
+     * @param in interleaved linear16
+     * @param frames samples per channel
+     * @param channels channels per frame
+     * @param rate sample rate in Hz
+     */
+    Decision process(const int16_t* in, size_t frames, unsigned int channels, unsigned int rate);
+
+    bool speech() const;
+    float noiseFloorDb() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_VOICEACTIVITYDETECTOR_H
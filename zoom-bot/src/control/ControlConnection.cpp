@@ -0,0 +1,182 @@
+#include "ControlConnection.h"
+
+#include <cstring>
+
+ControlConnection::ControlConnection(int fd) : m_fd(fd) {
+    auto flags = fcntl(m_fd, F_GETFL);
+    if (flags != -1)
+        fcntl(m_fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+ControlConnection::~ControlConnection() {
+    close();
+}
+
+unique_ptr<ControlConnection> ControlConnection::connect(const string& path) {
+    auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        return nullptr;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (::connect(fd, (const struct sockaddr*) &addr, sizeof(addr)) == -1) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    return make_unique<ControlConnection>(fd);
+}
+
+void ControlConnection::attach(MessageHandler onMessage, CloseHandler onClose) {
+    m_onMessage = std::move(onMessage);
+    m_onClose = std::move(onClose);
+
+    watch(!m_out.empty());
+}
+
+void ControlConnection::detach() {
+    if (m_watch)
+        g_source_remove(m_watch);
+
+    m_watch = 0;
+}
+
+void ControlConnection::watch(bool writable) {
+    if (m_fd == -1 || (m_watch && writable == m_writable))
+        return;
+
+    detach();
+
+    auto condition = static_cast<GIOCondition>(G_IO_IN | G_IO_HUP | G_IO_ERR | (writable ? G_IO_OUT : 0));
+    m_watch = g_unix_fd_add(m_fd, condition, onReady, this);
+    m_writable = writable;
+}
+
+gboolean ControlConnection::onReady(int fd, GIOCondition condition, gpointer data) {
+    auto* self = static_cast<ControlConnection*>(data);
+
+    auto ok = true;
+    if (condition & G_IO_OUT)
+        ok = self->flush();
+
+    if (ok && (condition & (G_IO_IN | G_IO_HUP | G_IO_ERR))) {
+        vector<ControlMessage> messages;
+        ok = self->receive(messages);
+
+        // a peer may send and hang up in one go, so deliver before closing
+        for (auto& msg : messages)
+            if (self->m_onMessage) self->m_onMessage(*self, msg);
+    }
+
+    if (ok) {
+        self->watch(!self->m_out.empty());
+        return G_SOURCE_CONTINUE;
+    }
+
+    // the source goes away with our return value, and the handler may delete us
+    self->m_watch = 0;
+    if (self->m_onClose)
+        self->m_onClose(*self);
+
+    return G_SOURCE_REMOVE;
+}
+
+bool ControlConnection::send(const ControlMessage& msg) {
+    if (m_fd == -1)
+        return false;
+
+    if (m_out.size() > c_maxQueued) {
+        Log::error("control peer is not reading, dropping message");
+        return false;
+    }
+
+    m_out.append(msg.encode());
+    if (!flush())
+        return false;
+
+    if (m_watch)
+        watch(!m_out.empty());
+
+    return true;
+}
+
+bool ControlConnection::flush() {
+    while (!m_out.empty()) {
+        auto ret = ::send(m_fd, m_out.data(), m_out.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+
+            return false;
+        }
+
+        m_out.erase(0, ret);
+    }
+
+    return true;
+}
+
+bool ControlConnection::receive(vector<ControlMessage>& out) {
+    if (m_fd == -1)
+        return false;
+
+    char buf[c_readSize];
+    for (;;) {
+        auto ret = recv(m_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (ret == 0)
+            break;
+
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) ret = 0;
+            else break;
+        }
+
+        if (ret > 0)
+            m_in.append(buf, ret);
+
+        size_t pos = 0;
+        for (;;) {
+            ControlMessage msg;
+            auto used = ControlMessage::decode(m_in.data() + pos, m_in.size() - pos, msg);
+            if (used < 0) {
+                Log::error("corrupt control stream");
+                return false;
+            }
+
+            if (used == 0) break;
+
+            out.push_back(std::move(msg));
+            pos += used;
+        }
+        m_in.erase(0, pos);
+
+        if (ret == 0)
+            return true;
+    }
+
+    // EOF or a hard error; the caller still gets what arrived before it
+    return false;
+}
+
+void ControlConnection::close() {
+    detach();
+
+    if (m_fd != -1)
+        ::close(m_fd);
+
+    m_fd = -1;
+    m_in.clear();
+    m_out.clear();
+}
+
+int ControlConnection::fd() const {
+    return m_fd;
+}
+
+bool ControlConnection::isOpen() const {
+    return m_fd != -1;
+}
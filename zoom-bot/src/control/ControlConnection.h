@@ -0,0 +1,103 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_CONTROLCONNECTION_H
+#define MEETING_SDK_LINUX_SAMPLE_CONTROLCONNECTION_H
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glib.h>
+#include <glib-unix.h>
+
+#include "ControlMessage.h"
+#include "../util/Log.h"
+
+using namespace std;
+
+/**
+ * Non-blocking stream socket speaking the control protocol on the glib main loop.
+ *
+ * Writes that do not fit the socket buffer are queued and sent once the peer reads,
+ * so a slow peer never stalls the SDK callbacks that share the loop.
+ */
+class ControlConnection {
+public:
+    typedef function<void(ControlConnection& conn, const ControlMessage& msg)> MessageHandler;
+    typedef function<void(ControlConnection& conn)> CloseHandler;
+
+private:
+    const size_t c_readSize = 4096;
+    const size_t c_maxQueued = 1024 * 1024;
+
+    int m_fd;
+    string m_in;
+    string m_out;
+
+    guint m_watch = 0;
+    bool m_writable = false;
+
+    MessageHandler m_onMessage;
+    CloseHandler m_onClose;
+
+    static gboolean onReady(int fd, GIOCondition condition, gpointer data);
+    void watch(bool writable);
+
+public:
+    /**
+     * @param fd connected stream socket, switched to non-blocking and owned from here on
+     */
+    explicit ControlConnection(int fd);
+    ~ControlConnection();
+
+    ControlConnection(const ControlConnection&) = delete;
+    ControlConnection& operator=(const ControlConnection&) = delete;
+
+    /**
+     * Connect to a control socket
+     * @return nullptr if nothing listens on the path
+     */
+    static unique_ptr<ControlConnection> connect(const string& path);
+
+    /**
+     * Deliver messages from the default glib main context. The close handler runs last
+     * and may destroy the connection; the message handler must not.
+     */
+    void attach(MessageHandler onMessage, CloseHandler onClose = nullptr);
+
+    /**
+     * Stop watching the socket, keeping it open
+     */
+    void detach();
+
+    /**
+     * Send a message, queueing whatever the socket does not take right away
+     * @return false if the peer is gone or too far behind
+     */
+    bool send(const ControlMessage& msg);
+
+    /**
+     * Read everything the socket has
+     * @param out receives the complete messages
+     * @return false on EOF, error or a corrupt stream
+     */
+    bool receive(vector<ControlMessage>& out);
+
+    /**
+     * Write queued bytes
+     * @return false if the peer is gone
+     */
+    bool flush();
+
+    void close();
+
+    int fd() const;
+    bool isOpen() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_CONTROLCONNECTION_H
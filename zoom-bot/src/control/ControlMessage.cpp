@@ -0,0 +1,154 @@
+#include "ControlMessage.h"
+
+#include <algorithm>
+#include <cstring>
+
+ControlMessage::ControlMessage(Opcode op, uint16_t flags, uint32_t requestId) :
+        opcode(op), flags(flags), requestId(requestId) {}
+
+ControlMessage ControlMessage::response(const ControlMessage& request, ControlStatus status, const string& message) {
+    ControlMessage msg(request.opcode, c_flagResponse, request.requestId);
+    msg.add(Field::Status, static_cast<uint32_t>(status));
+
+    if (!message.empty())
+        msg.add(Field::Message, message);
+
+    return msg;
+}
+
+ControlMessage ControlMessage::event(Opcode op) {
+    return ControlMessage(op, c_flagEvent);
+}
+
+ControlMessage& ControlMessage::add(Field field, const string& value) {
+    auto type = static_cast<uint16_t>(field);
+    auto len = static_cast<uint16_t>(min<size_t>(value.size(), UINT16_MAX));
+
+    m_payload.append(reinterpret_cast<const char*>(&type), sizeof(type));
+    m_payload.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    m_payload.append(value.data(), len);
+
+    return *this;
+}
+
+ControlMessage& ControlMessage::add(Field field, uint32_t value) {
+    return add(field, string(reinterpret_cast<const char*>(&value), sizeof(value)));
+}
+
+ControlMessage& ControlMessage::add(Field field, int32_t value) {
+    return add(field, static_cast<uint32_t>(value));
+}
+
+ControlMessage& ControlMessage::append(const ControlMessage& other) {
+    m_payload.append(other.m_payload);
+    return *this;
+}
+
+bool ControlMessage::find(Field field, const char*& value, uint16_t& len) const {
+    auto type = static_cast<uint16_t>(field);
+    size_t pos = 0;
+
+    while (pos + 4 <= m_payload.size()) {
+        uint16_t t, l;
+        memcpy(&t, m_payload.data() + pos, sizeof(t));
+        memcpy(&l, m_payload.data() + pos + 2, sizeof(l));
+        pos += 4;
+
+        if (pos + l > m_payload.size())
+            return false;
+
+        if (t == type) {
+            value = m_payload.data() + pos;
+            len = l;
+            return true;
+        }
+
+        pos += l;
+    }
+
+    return false;
+}
+
+bool ControlMessage::get(Field field, string& value) const {
+    const char* data;
+    uint16_t len;
+    if (!find(field, data, len))
+        return false;
+
+    value.assign(data, len);
+    return true;
+}
+
+bool ControlMessage::get(Field field, uint32_t& value) const {
+    const char* data;
+    uint16_t len;
+    if (!find(field, data, len) || len != sizeof(value))
+        return false;
+
+    memcpy(&value, data, sizeof(value));
+    return true;
+}
+
+bool ControlMessage::get(Field field, int32_t& value) const {
+    uint32_t raw;
+    if (!get(field, raw))
+        return false;
+
+    value = static_cast<int32_t>(raw);
+    return true;
+}
+
+bool ControlMessage::has(Field field) const {
+    const char* data;
+    uint16_t len;
+    return find(field, data, len);
+}
+
+ControlStatus ControlMessage::status() const {
+    uint32_t status;
+    if (!get(Field::Status, status))
+        return ControlStatus::Failed;
+
+    return static_cast<ControlStatus>(status);
+}
+
+const string& ControlMessage::payload() const {
+    return m_payload;
+}
+
+string ControlMessage::encode() const {
+    ControlHeader header;
+    header.length = m_payload.size();
+    header.opcode = static_cast<uint16_t>(opcode);
+    header.flags = flags;
+    header.requestId = requestId;
+
+    string out;
+    out.reserve(sizeof(header) + m_payload.size());
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.append(m_payload);
+
+    return out;
+}
+
+ptrdiff_t ControlMessage::decode(const char* buf, size_t len, ControlMessage& msg) {
+    if (len < sizeof(ControlHeader))
+        return 0;
+
+    ControlHeader header;
+    memcpy(&header, buf, sizeof(header));
+
+    if (header.length > c_maxPayload)
+        return -1;
+
+    auto total = sizeof(header) + header.length;
+    if (len < total)
+        return 0;
+
+    msg.opcode = static_cast<Opcode>(header.opcode);
+    msg.flags = header.flags;
+    msg.requestId = header.requestId;
+    msg.m_payload.assign(buf + sizeof(header), header.length);
+
+    return total;
+}
@@ -0,0 +1,191 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_CONTROLMESSAGE_H
+#define MEETING_SDK_LINUX_SAMPLE_CONTROLMESSAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+/**
+ * Request, response and event codes of the control protocol
+ */
+enum class Opcode : uint16_t {
+    Ping = 0x0001,
+
+    // supervisor
+    Spawn = 0x0010,
+    Stop = 0x0011,
+    List = 0x0012,
+
+    // bot, or a worker addressed by its WorkerId through the supervisor
+    Join = 0x0020,
+    Leave = 0x0021,
+    Status = 0x0022,
+    SetAudio = 0x0023,
+    SetVideo = 0x0024,
+    SetAudioMode = 0x0025,
+    SetOutputRate = 0x0026,
+    Metrics = 0x0027,
+
+    // events, never answered
+    WorkerStarted = 0x0080,
+    MeetingStatus = 0x0081,
+    WorkerExited = 0x0082,
+    Ready = 0x0083,
+    FirstAudio = 0x0084,
+    ParticipantJoined = 0x0085,
+    ParticipantLeft = 0x0086,
+    // the keyword spotter heard one of its keywords
+    Keyword = 0x0087,
+};
+
+/**
+ * Types of the TLV fields carried in the payload
+ */
+enum class Field : uint16_t {
+    Status = 0x0001,
+    Message = 0x0002,
+
+    MeetingId = 0x0010,
+    Password = 0x0011,
+    DisplayName = 0x0012,
+    JoinUrl = 0x0013,
+    Zak = 0x0014,
+    JoinToken = 0x0015,
+    OnBehalfToken = 0x0016,
+
+    WorkerId = 0x0020,
+    Pid = 0x0021,
+    SocketPath = 0x0022,
+    MeetingStatus = 0x0023,
+    MeetingResult = 0x0024,
+    ExitCode = 0x0025,
+    Signal = 0x0026,
+    StartupMs = 0x0027,
+    JoinMs = 0x0028,
+    FirstAudioMs = 0x0029,
+
+    Enabled = 0x0030,
+    AudioMode = 0x0031,
+    SampleRate = 0x0032,
+    Audio = 0x0033,
+    Video = 0x0034,
+    UserId = 0x0035,
+    Metrics = 0x0036,
+
+    Keyword = 0x0037,
+    // posterior of the keyword in thousandths
+    Confidence = 0x0038,
+    LatencyMs = 0x0039,
+};
+
+/**
+ * Values of the AudioMode field
+ */
+enum class AudioMode : uint32_t {
+    Mixed = 0,
+    Participants = 1,
+    // one-way audio of the active speakers only, see --stream-speakers
+    Speakers = 2,
+};
+
+/**
+ * Result codes in the Status field of a response
+ */
+enum class ControlStatus : uint32_t {
+    Ok = 0,
+    BadRequest = 1,
+    UnknownOpcode = 2,
+    NotFound = 3,
+    Busy = 4,
+    Failed = 5,
+};
+
+#pragma pack(push, 1)
+/**
+ * Header in front of every control message, all fields little-endian.
+ * A length-prefixed payload of TLV fields follows: u16 type, u16 length, value.
+ */
+struct ControlHeader {
+    uint32_t length;
+    uint16_t opcode;
+    uint16_t flags;
+    uint32_t requestId;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ControlHeader) == 12, "control header must stay 12 bytes on the wire");
+
+/**
+ * One message of the control protocol, with its TLV payload kept encoded
+ */
+class ControlMessage {
+    string m_payload;
+
+    bool find(Field field, const char*& value, uint16_t& len) const;
+
+public:
+    static const uint16_t c_flagResponse = 1;
+    static const uint16_t c_flagEvent = 2;
+    static const uint32_t c_maxPayload = 64 * 1024;
+
+    Opcode opcode = Opcode::Ping;
+    uint16_t flags = 0;
+    uint32_t requestId = 0;
+
+    ControlMessage() = default;
+    ControlMessage(Opcode op, uint16_t flags = 0, uint32_t requestId = 0);
+
+    /**
+     * Build the response to a request, echoing its opcode and request id
+     */
+    static ControlMessage response(const ControlMessage& request, ControlStatus status, const string& message = "");
+
+    /**
+     * Build an unsolicited event
+     */
+    static ControlMessage event(Opcode op);
+
+    ControlMessage& add(Field field, const string& value);
+    ControlMessage& add(Field field, uint32_t value);
+    ControlMessage& add(Field field, int32_t value);
+
+    /**
+     * Copy every field of another message, e.g. to relay it with extra fields
+     */
+    ControlMessage& append(const ControlMessage& other);
+
+    /**
+     * Read the first field of a type
+     * @return false if the message has no such field or it has the wrong size
+     */
+    bool get(Field field, string& value) const;
+    bool get(Field field, uint32_t& value) const;
+    bool get(Field field, int32_t& value) const;
+
+    bool has(Field field) const;
+
+    /**
+     * @return the Status field of a response, Failed if it has none
+     */
+    ControlStatus status() const;
+
+    const string& payload() const;
+
+    /**
+     * @return header and payload ready for the wire
+     */
+    string encode() const;
+
+    /**
+     * Take one message off the front of a receive buffer
+     * @param buf bytes received so far
+     * @param len number of bytes
+     * @param msg receives the message
+     * @return bytes consumed, 0 if the message is incomplete, -1 if the stream is corrupt
+     */
+    static ptrdiff_t decode(const char* buf, size_t len, ControlMessage& msg);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_CONTROLMESSAGE_H
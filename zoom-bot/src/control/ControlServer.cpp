@@ -0,0 +1,122 @@
+#include "ControlServer.h"
+
+#include <cstring>
+
+ControlServer::~ControlServer() {
+    close();
+}
+
+bool ControlServer::listen(const string& path) {
+    close();
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listenFd == -1) {
+        Log::error("unable to create control socket");
+        return false;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    unlink(path.c_str());
+
+    if (bind(m_listenFd, (const struct sockaddr*) &addr, sizeof(addr)) == -1) {
+        Log::error("unable to bind control socket " + path);
+        close();
+        return false;
+    }
+
+    if (::listen(m_listenFd, 8) == -1) {
+        Log::error("unable to listen on control socket " + path);
+        close();
+        return false;
+    }
+
+    m_path = path;
+    m_watch = g_unix_fd_add(m_listenFd, G_IO_IN, onAccept, this);
+
+    Log::info("listening for control clients on " + path);
+    return true;
+}
+
+gboolean ControlServer::onAccept(int fd, GIOCondition condition, gpointer data) {
+    static_cast<ControlServer*>(data)->accept();
+    return G_SOURCE_CONTINUE;
+}
+
+void ControlServer::accept() {
+    for (;;) {
+        auto fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        auto client = make_unique<ControlConnection>(fd);
+        client->attach(
+            [this](ControlConnection& conn, const ControlMessage& msg) { dispatch(conn, msg); },
+            [this](ControlConnection& conn) { m_clients.erase(conn.fd()); }
+        );
+
+        m_clients[fd] = std::move(client);
+    }
+}
+
+void ControlServer::dispatch(ControlConnection& client, const ControlMessage& msg) {
+    // clients only send requests; anything flagged is a confused peer
+    if (msg.flags & (ControlMessage::c_flagResponse | ControlMessage::c_flagEvent))
+        return;
+
+    if (msg.opcode == Opcode::Ping) {
+        client.send(ControlMessage::response(msg, ControlStatus::Ok));
+        return;
+    }
+
+    if (!m_onRequest) {
+        client.send(ControlMessage::response(msg, ControlStatus::UnknownOpcode));
+        return;
+    }
+
+    m_onRequest(client, msg);
+}
+
+void ControlServer::setOnRequest(const RequestHandler& handler) {
+    m_onRequest = handler;
+}
+
+void ControlServer::broadcast(const ControlMessage& event) {
+    for (auto& [fd, client] : m_clients)
+        client->send(event);
+}
+
+void ControlServer::close(bool unlinkPath) {
+    if (m_watch)
+        g_source_remove(m_watch);
+    m_watch = 0;
+
+    m_clients.clear();
+
+    if (m_listenFd != -1) {
+        ::close(m_listenFd);
+
+        if (unlinkPath && !m_path.empty())
+            unlink(m_path.c_str());
+    }
+
+    m_listenFd = -1;
+}
+
+ControlConnection* ControlServer::client(int fd) {
+    auto it = m_clients.find(fd);
+    return it == m_clients.end() ? nullptr : it->second.get();
+}
+
+const string& ControlServer::path() const {
+    return m_path;
+}
+
+size_t ControlServer::clients() const {
+    return m_clients.size();
+}
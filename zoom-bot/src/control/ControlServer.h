@@ -0,0 +1,81 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_CONTROLSERVER_H
+#define MEETING_SDK_LINUX_SAMPLE_CONTROLSERVER_H
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <glib.h>
+#include <glib-unix.h>
+
+#include "ControlConnection.h"
+#include "ControlMessage.h"
+#include "../util/Log.h"
+
+using namespace std;
+
+/**
+ * Unix socket accepting control clients on the glib main loop.
+ *
+ * Requests are handed to one handler together with the client they came from, so it
+ * can answer right away or later; events go to every connected client.
+ */
+class ControlServer {
+public:
+    typedef function<void(ControlConnection& client, const ControlMessage& request)> RequestHandler;
+
+private:
+    string m_path;
+    int m_listenFd = -1;
+    guint m_watch = 0;
+
+    unordered_map<int, unique_ptr<ControlConnection>> m_clients;
+    RequestHandler m_onRequest;
+
+    static gboolean onAccept(int fd, GIOCondition condition, gpointer data);
+    void accept();
+    void dispatch(ControlConnection& client, const ControlMessage& msg);
+
+public:
+    ControlServer() = default;
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    /**
+     * Bind the socket, replacing a stale one, and start accepting
+     * @param path socket path
+     * @return false if the socket cannot be bound
+     */
+    bool listen(const string& path);
+
+    void setOnRequest(const RequestHandler& handler);
+
+    /**
+     * Send an event to every client
+     */
+    void broadcast(const ControlMessage& event);
+
+    /**
+     * Close the listen socket and every client
+     * @param unlinkPath remove the socket path, false in a forked child that must leave it to its parent
+     */
+    void close(bool unlinkPath = true);
+
+    /**
+     * @return the connected client with this socket, nullptr once it has gone
+     */
+    ControlConnection* client(int fd);
+
+    const string& path() const;
+    size_t clients() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_CONTROLSERVER_H
@@ -0,0 +1,59 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_JOINREQUEST_H
+#define MEETING_SDK_LINUX_SAMPLE_JOINREQUEST_H
+
+#include <string>
+
+#include "ControlMessage.h"
+
+using namespace std;
+
+/**
+ * Meeting a control client asks the bot to join, as carried in a control message
+ */
+struct JoinRequest {
+    string meetingId;
+    string password;
+    string displayName;
+    string joinUrl;
+    string zak;
+    string joinToken;
+    string onBehalfToken;
+
+    /**
+     * Read the meeting fields of a request
+     * @return false if it names neither a meeting ID nor a join URL
+     */
+    bool read(const ControlMessage& msg) {
+        msg.get(Field::MeetingId, meetingId);
+        msg.get(Field::Password, password);
+        msg.get(Field::DisplayName, displayName);
+        msg.get(Field::JoinUrl, joinUrl);
+        msg.get(Field::Zak, zak);
+        msg.get(Field::JoinToken, joinToken);
+        msg.get(Field::OnBehalfToken, onBehalfToken);
+
+        return !meetingId.empty() || !joinUrl.empty();
+    }
+
+    /**
+     * @return true if no meeting has been given yet
+     */
+    bool empty() const {
+        return meetingId.empty() && joinUrl.empty();
+    }
+
+    /**
+     * Add the non-empty meeting fields to a message
+     */
+    void write(ControlMessage& msg) const {
+        if (!meetingId.empty()) msg.add(Field::MeetingId, meetingId);
+        if (!password.empty()) msg.add(Field::Password, password);
+        if (!displayName.empty()) msg.add(Field::DisplayName, displayName);
+        if (!joinUrl.empty()) msg.add(Field::JoinUrl, joinUrl);
+        if (!zak.empty()) msg.add(Field::Zak, zak);
+        if (!joinToken.empty()) msg.add(Field::JoinToken, joinToken);
+        if (!onBehalfToken.empty()) msg.add(Field::OnBehalfToken, onBehalfToken);
+    }
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_JOINREQUEST_H
@@ -0,0 +1,539 @@
+#include "Supervisor.h"
+
+Supervisor::Supervisor(const Config& config) : m_config(config) {
+    sigemptyset(&m_signals);
+    sigaddset(&m_signals, SIGCHLD);
+    sigaddset(&m_signals, SIGINT);
+    sigaddset(&m_signals, SIGTERM);
+}
+
+Supervisor::~Supervisor() {
+    if (m_signalFd != -1)
+        ::close(m_signalFd);
+}
+
+bool Supervisor::run(Launch& launch) {
+    // taken from a signalfd on the loop, which also keeps glib from starting a thread for SIGCHLD
+    sigprocmask(SIG_BLOCK, &m_signals, nullptr);
+
+    m_signalFd = signalfd(-1, &m_signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (m_signalFd == -1) {
+        Log::error("unable to watch worker signals");
+        sigprocmask(SIG_UNBLOCK, &m_signals, nullptr);
+        m_failed = true;
+        return false;
+    }
+
+    m_control.setOnRequest([this](ControlConnection& client, const ControlMessage& request) {
+        handle(client, request);
+    });
+
+    if (!m_control.listen(m_config.controlPath())) {
+        sigprocmask(SIG_UNBLOCK, &m_signals, nullptr);
+        m_failed = true;
+        return false;
+    }
+
+    m_signalWatch = g_unix_fd_add(m_signalFd, G_IO_IN, onSignal, this);
+    m_loop = g_main_loop_new(NULL, FALSE);
+
+    Log::success("supervising up to " + to_string(m_config.maxWorkers()) + " meetings");
+    fill();
+
+    // a pool worker forked by fill() must not enter the loop it was quitting
+    if (!m_isChild)
+        g_main_loop_run(m_loop);
+
+    g_main_loop_unref(m_loop);
+    m_loop = nullptr;
+
+    detach();
+
+    if (!m_isChild) {
+        Log::success("supervisor stopped");
+        return false;
+    }
+
+    launch = std::move(m_launch);
+    return true;
+}
+
+bool Supervisor::failed() const {
+    return m_failed;
+}
+
+void Supervisor::detach() {
+    // a child leaves the control socket path to its parent
+    m_control.close(!m_isChild);
+
+    if (m_signalWatch)
+        g_source_remove(m_signalWatch);
+    m_signalWatch = 0;
+
+    if (m_shutdownTimer)
+        g_source_remove(m_shutdownTimer);
+    m_shutdownTimer = 0;
+
+    if (m_poolTimer)
+        g_source_remove(m_poolTimer);
+    m_poolTimer = 0;
+
+    if (m_signalFd != -1)
+        ::close(m_signalFd);
+    m_signalFd = -1;
+
+    m_workers.clear();
+    sigprocmask(SIG_UNBLOCK, &m_signals, nullptr);
+}
+
+gboolean Supervisor::onSignal(int fd, GIOCondition condition, gpointer data) {
+    auto* self = static_cast<Supervisor*>(data);
+
+    struct signalfd_siginfo info;
+    while (!self->m_isChild && ::read(fd, &info, sizeof(info)) == sizeof(info)) {
+        if (info.ssi_signo == SIGCHLD)
+            self->reap();
+        else
+            self->shutdown();
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean Supervisor::onShutdownTimeout(gpointer data) {
+    auto* self = static_cast<Supervisor*>(data);
+    self->m_shutdownTimer = 0;
+
+    for (auto& [id, worker] : self->m_workers) {
+        if (worker.pid <= 0) continue;
+
+        Log::error("worker " + to_string(id) + " did not leave in time, killing it");
+        kill(worker.pid, SIGKILL);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+gboolean Supervisor::onPoolRetry(gpointer data) {
+    auto* self = static_cast<Supervisor*>(data);
+    self->m_poolTimer = 0;
+    self->fill();
+
+    return G_SOURCE_REMOVE;
+}
+
+void Supervisor::fill() {
+    if (m_isChild || m_shuttingDown || m_poolTimer)
+        return;
+
+    size_t pooled = 0;
+    for (auto& [id, worker] : m_workers)
+        if (worker.pooled()) pooled++;
+
+    while (pooled < m_config.poolSize() && m_workers.size() < m_config.maxWorkers()) {
+        auto id = m_nextId++;
+        auto& worker = m_workers[id];
+        worker.id = id;
+        worker.socketPath = socketPath(id);
+
+        if (!fork(worker)) {
+            m_workers.erase(id);
+            return;
+        }
+
+        if (m_isChild)
+            return;
+
+        pooled++;
+    }
+}
+
+bool Supervisor::handOver(Worker& worker, const JoinRequest& join) {
+    ControlMessage msg(Opcode::Join);
+    join.write(msg);
+
+    if (!worker.link || !worker.link->send(msg))
+        return false;
+
+    worker.request = join;
+    worker.ready = false;
+
+    Log::info("handed meeting " + join.meetingId + " to standby worker " + to_string(worker.id));
+    return true;
+}
+
+void Supervisor::handle(ControlConnection& client, const ControlMessage& request) {
+    // a freshly forked child only unwinds back to run()
+    if (m_isChild)
+        return;
+
+    switch (request.opcode) {
+        case Opcode::Spawn:
+            spawn(client, request);
+            break;
+        case Opcode::Stop:
+            stopWorker(client, request);
+            break;
+        case Opcode::List:
+            list(client, request);
+            break;
+        case Opcode::Leave:
+        case Opcode::Status:
+        case Opcode::SetAudio:
+        case Opcode::SetVideo:
+        case Opcode::SetAudioMode:
+        case Opcode::SetOutputRate:
+        case Opcode::Metrics:
+            forward(client, request);
+            break;
+        default:
+            client.send(ControlMessage::response(request, ControlStatus::UnknownOpcode));
+            break;
+    }
+}
+
+void Supervisor::spawn(ControlConnection& client, const ControlMessage& request) {
+    JoinRequest join;
+    if (!join.read(request)) {
+        client.send(ControlMessage::response(request, ControlStatus::BadRequest, "meeting ID or join URL required"));
+        return;
+    }
+
+    if (m_shuttingDown) {
+        client.send(ControlMessage::response(request, ControlStatus::Busy, "supervisor is shutting down"));
+        return;
+    }
+
+    Worker* standby = nullptr;
+    for (auto& [id, worker] : m_workers) {
+        if (worker.ready && worker.pooled() && handOver(worker, join)) {
+            standby = &worker;
+            break;
+        }
+    }
+
+    if (!standby && m_workers.size() >= m_config.maxWorkers()) {
+        client.send(ControlMessage::response(request, ControlStatus::Busy, "all workers are in use"));
+        return;
+    }
+
+    auto id = standby ? standby->id : m_nextId++;
+    auto& worker = m_workers[id];
+
+    if (!standby) {
+        worker.id = id;
+        worker.socketPath = socketPath(id);
+        worker.request = join;
+
+        if (!fork(worker)) {
+            m_workers.erase(id);
+            client.send(ControlMessage::response(request, ControlStatus::Failed, "unable to fork a worker"));
+            return;
+        }
+
+        if (m_isChild)
+            return;
+    }
+
+    auto response = ControlMessage::response(request, ControlStatus::Ok);
+    response.add(Field::WorkerId, id)
+            .add(Field::Pid, static_cast<uint32_t>(worker.pid))
+            .add(Field::SocketPath, worker.socketPath);
+    client.send(response);
+
+    auto event = ControlMessage::event(Opcode::WorkerStarted);
+    event.add(Field::WorkerId, id)
+         .add(Field::Pid, static_cast<uint32_t>(worker.pid))
+         .add(Field::SocketPath, worker.socketPath)
+         .add(Field::MeetingId, join.meetingId);
+    m_control.broadcast(event);
+
+    // replace the standby worker that was just used up
+    fill();
+}
+
+void Supervisor::stopWorker(ControlConnection& client, const ControlMessage& request) {
+    uint32_t id;
+    if (!request.get(Field::WorkerId, id)) {
+        client.send(ControlMessage::response(request, ControlStatus::BadRequest, "worker ID required"));
+        return;
+    }
+
+    auto it = m_workers.find(id);
+    if (it == m_workers.end()) {
+        client.send(ControlMessage::response(request, ControlStatus::NotFound));
+        return;
+    }
+
+    // the worker leaves the meeting from its SIGTERM handler and is reaped like any other exit
+    it->second.stopping = true;
+    kill(it->second.pid, SIGTERM);
+
+    client.send(ControlMessage::response(request, ControlStatus::Ok));
+}
+
+void Supervisor::list(ControlConnection& client, const ControlMessage& request) {
+    auto response = ControlMessage::response(request, ControlStatus::Ok);
+
+    // one group of fields per worker, each starting with its WorkerId
+    for (auto& [id, worker] : m_workers) {
+        response.add(Field::WorkerId, id)
+                .add(Field::Pid, static_cast<uint32_t>(worker.pid))
+                .add(Field::SocketPath, worker.socketPath)
+                .add(Field::MeetingId, worker.request.meetingId)
+                .add(Field::MeetingStatus, worker.meetingStatus);
+    }
+
+    client.send(response);
+}
+
+void Supervisor::forward(ControlConnection& client, const ControlMessage& request) {
+    uint32_t id;
+    if (!request.get(Field::WorkerId, id)) {
+        client.send(ControlMessage::response(request, ControlStatus::BadRequest, "worker ID required"));
+        return;
+    }
+
+    auto it = m_workers.find(id);
+    if (it == m_workers.end()) {
+        client.send(ControlMessage::response(request, ControlStatus::NotFound));
+        return;
+    }
+
+    auto msg = request;
+    msg.requestId = m_nextForward++;
+    if (m_nextForward == 0)
+        m_nextForward = 1;
+
+    if (!it->second.link || !it->second.link->send(msg)) {
+        client.send(ControlMessage::response(request, ControlStatus::Failed, "worker is not reachable"));
+        return;
+    }
+
+    m_forwards[msg.requestId] = {id, client.fd(), request.requestId, request.opcode};
+}
+
+void Supervisor::answer(const ControlMessage& response) {
+    auto it = m_forwards.find(response.requestId);
+    if (it == m_forwards.end())
+        return;
+
+    auto msg = response;
+    msg.requestId = it->second.requestId;
+
+    // the client may have hung up while the worker was busy
+    if (auto* client = m_control.client(it->second.client))
+        client->send(msg);
+
+    m_forwards.erase(it);
+}
+
+void Supervisor::abandon(uint32_t worker) {
+    for (auto it = m_forwards.begin(); it != m_forwards.end();) {
+        if (it->second.worker != worker) {
+            it++;
+            continue;
+        }
+
+        if (auto* client = m_control.client(it->second.client)) {
+            auto response = ControlMessage::response(ControlMessage(it->second.opcode, 0, it->second.requestId),
+                                                     ControlStatus::Failed, "worker exited");
+            client->send(response);
+        }
+
+        it = m_forwards.erase(it);
+    }
+}
+
+bool Supervisor::fork(Worker& worker) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1) {
+        Log::error("unable to create worker link");
+        return false;
+    }
+
+    auto parent = getpid();
+    auto pid = ::fork();
+    if (pid == -1) {
+        Log::error("unable to fork worker");
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        ::close(fds[0]);
+
+        // leave the meeting rather than linger in it when the supervisor goes away
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (getppid() != parent)
+            _exit(EXIT_FAILURE);
+
+        m_isChild = true;
+        m_launch.id = worker.id;
+        m_launch.socketPath = worker.socketPath;
+        m_launch.request = worker.request;
+        m_launch.link = fds[1];
+        m_launch.standby = worker.pooled();
+
+        g_main_loop_quit(m_loop);
+        return true;
+    }
+
+    ::close(fds[1]);
+
+    worker.pid = pid;
+    worker.meetingStatus = -1;
+    worker.ready = false;
+    worker.link = make_unique<ControlConnection>(fds[0]);
+
+    auto id = worker.id;
+    worker.link->attach([this, id](ControlConnection& link, const ControlMessage& msg) {
+        auto it = m_workers.find(id);
+        if (it != m_workers.end())
+            relay(it->second, msg);
+    });
+
+    Log::info("started worker " + to_string(id) + " with pid " + to_string(pid) + " on " + worker.socketPath);
+    return true;
+}
+
+void Supervisor::relay(Worker& worker, const ControlMessage& msg) {
+    if (msg.flags & ControlMessage::c_flagResponse) {
+        answer(msg);
+        return;
+    }
+
+    if (!(msg.flags & ControlMessage::c_flagEvent))
+        return;
+
+    if (msg.opcode == Opcode::MeetingStatus)
+        msg.get(Field::MeetingStatus, worker.meetingStatus);
+
+    if (msg.opcode == Opcode::Ready && worker.pooled()) {
+        worker.ready = true;
+        Log::info("worker " + to_string(worker.id) + " is standing by");
+    }
+
+    auto event = ControlMessage::event(msg.opcode);
+    event.add(Field::WorkerId, worker.id).append(msg);
+    m_control.broadcast(event);
+}
+
+void Supervisor::reap() {
+    for (;;) {
+        int status;
+        auto pid = waitpid(-1, &status, WNOHANG);
+        if (pid <= 0)
+            break;
+
+        for (auto& [id, worker] : m_workers) {
+            if (worker.pid != pid) continue;
+
+            exited(worker, status);
+            break;
+        }
+
+        if (m_isChild)
+            return;
+    }
+
+    if (m_shuttingDown && m_workers.empty())
+        g_main_loop_quit(m_loop);
+}
+
+void Supervisor::exited(Worker& worker, int status) {
+    auto event = ControlMessage::event(Opcode::WorkerExited);
+    event.add(Field::WorkerId, worker.id).add(Field::Pid, static_cast<uint32_t>(worker.pid));
+
+    if (WIFEXITED(status))
+        event.add(Field::ExitCode, static_cast<int32_t>(WEXITSTATUS(status)));
+    else if (WIFSIGNALED(status))
+        event.add(Field::Signal, static_cast<int32_t>(WTERMSIG(status)));
+
+    m_control.broadcast(event);
+
+    auto id = worker.id;
+    auto crashed = WIFSIGNALED(status) && !worker.stopping && !m_shuttingDown;
+    abandon(id);
+
+    worker.link.reset();
+    worker.pid = -1;
+
+    // a standby worker has no meeting to restart; refill the pool, slowly if it never got ready
+    if (worker.pooled()) {
+        auto wasReady = worker.ready;
+        m_workers.erase(id);
+
+        if (!wasReady && !m_shuttingDown && !m_poolTimer) {
+            Log::error("standby worker " + to_string(id) + " exited before it was ready");
+            m_poolTimer = g_timeout_add_seconds(c_poolRetry, onPoolRetry, this);
+        }
+
+        fill();
+        return;
+    }
+
+    if (!crashed) {
+        Log::info("worker " + to_string(id) + " exited");
+        m_workers.erase(id);
+        fill();
+        return;
+    }
+
+    if (worker.restarts >= c_maxRestarts) {
+        Log::error("worker " + to_string(id) + " crashed too often, giving up on its meeting");
+        m_workers.erase(id);
+        return;
+    }
+
+    // same ID and socket path, so subscribers reconnect to the replacement unchanged
+    worker.restarts++;
+    Log::error("worker " + to_string(id) + " crashed, restarting it");
+
+    if (!fork(worker)) {
+        m_workers.erase(id);
+        return;
+    }
+
+    if (m_isChild)
+        return;
+
+    auto started = ControlMessage::event(Opcode::WorkerStarted);
+    started.add(Field::WorkerId, id)
+           .add(Field::Pid, static_cast<uint32_t>(worker.pid))
+           .add(Field::SocketPath, worker.socketPath)
+           .add(Field::MeetingId, worker.request.meetingId);
+    m_control.broadcast(started);
+}
+
+void Supervisor::shutdown() {
+    if (m_shuttingDown)
+        return;
+
+    m_shuttingDown = true;
+
+    if (m_workers.empty()) {
+        g_main_loop_quit(m_loop);
+        return;
+    }
+
+    Log::info("stopping " + to_string(m_workers.size()) + " workers");
+    for (auto& [id, worker] : m_workers) {
+        worker.stopping = true;
+        kill(worker.pid, SIGTERM);
+    }
+
+    m_shutdownTimer = g_timeout_add_seconds(m_config.drainTimeout().count() + c_shutdownGrace, onShutdownTimeout, this);
+}
+
+string Supervisor::socketPath(uint32_t id) const {
+    auto base = m_config.socketPath();
+    auto slash = base.rfind('/');
+    auto dot = base.rfind('.');
+
+    if (dot == string::npos || (slash != string::npos && dot < slash))
+        return base + "-" + to_string(id);
+
+    return base.substr(0, dot) + "-" + to_string(id) + base.substr(dot);
+}
@@ -0,0 +1,156 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_SUPERVISOR_H
+#define MEETING_SDK_LINUX_SAMPLE_SUPERVISOR_H
+
+#include <sys/prctl.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <glib.h>
+#include <glib-unix.h>
+
+#include "ControlConnection.h"
+#include "ControlMessage.h"
+#include "ControlServer.h"
+#include "JoinRequest.h"
+#include "../Config.h"
+#include "../util/Log.h"
+
+using namespace std;
+
+/**
+ * Runs one forked worker process per meeting, requested over a shared control socket.
+ *
+ * The supervisor never initializes the SDK: it resolves the SDK libraries once and then
+ * forks, so every worker starts from an already linked image whose pages it shares
+ * copy-on-write, and still runs InitSDK in a process that has no other threads yet.
+ * Each worker serves its audio on its own socket path and reports meeting status over a
+ * socketpair, which the supervisor relays as events to every control client.
+ *
+ * Meeting commands naming a WorkerId are forwarded over its link, and the worker's
+ * response goes back to the client that asked.
+ *
+ * With a pool, that many workers are kept initialized and authenticated in standby, and
+ * a Spawn hands its meeting to one of them over the link so the join starts at once.
+ */
+class Supervisor {
+public:
+    /**
+     * What a forked child needs to become a worker
+     */
+    struct Launch {
+        uint32_t id = 0;
+        string socketPath;
+        JoinRequest request;
+        int link = -1;
+
+        // authenticate and wait for a Join on the link instead of joining right away
+        bool standby = false;
+    };
+
+private:
+    struct Worker {
+        uint32_t id;
+        pid_t pid = -1;
+        string socketPath;
+        JoinRequest request;
+        unique_ptr<ControlConnection> link;
+        int32_t meetingStatus = -1;
+        unsigned int restarts = 0;
+        bool stopping = false;
+
+        // authenticated standby worker that has not been handed a meeting yet
+        bool ready = false;
+
+        bool pooled() const {
+            return request.empty();
+        }
+    };
+
+    /**
+     * Request passed on to a worker, answered once the worker responds
+     */
+    struct Forward {
+        uint32_t worker;
+        int client;
+        uint32_t requestId;
+        Opcode opcode;
+    };
+
+    const unsigned int c_maxRestarts = 3;
+    // on top of the workers' own --drain-timeout before they are killed
+    const guint c_shutdownGrace = 2;
+    const guint c_poolRetry = 5;
+
+    const Config& m_config;
+    ControlServer m_control;
+
+    map<uint32_t, Worker> m_workers;
+    uint32_t m_nextId = 1;
+
+    // keyed by the request ID used on the link; 0 is left to the supervisor's own Join
+    map<uint32_t, Forward> m_forwards;
+    uint32_t m_nextForward = 1;
+
+    GMainLoop* m_loop = nullptr;
+    int m_signalFd = -1;
+    guint m_signalWatch = 0;
+    guint m_shutdownTimer = 0;
+    guint m_poolTimer = 0;
+    sigset_t m_signals;
+    bool m_shuttingDown = false;
+    bool m_failed = false;
+
+    bool m_isChild = false;
+    Launch m_launch;
+
+    static gboolean onSignal(int fd, GIOCondition condition, gpointer data);
+    static gboolean onShutdownTimeout(gpointer data);
+    static gboolean onPoolRetry(gpointer data);
+
+    void handle(ControlConnection& client, const ControlMessage& request);
+    void spawn(ControlConnection& client, const ControlMessage& request);
+    void stopWorker(ControlConnection& client, const ControlMessage& request);
+    void list(ControlConnection& client, const ControlMessage& request);
+    void forward(ControlConnection& client, const ControlMessage& request);
+    void answer(const ControlMessage& response);
+    void abandon(uint32_t worker);
+
+    bool fork(Worker& worker);
+    bool handOver(Worker& worker, const JoinRequest& join);
+    void fill();
+    void reap();
+    void exited(Worker& worker, int status);
+    void relay(Worker& worker, const ControlMessage& msg);
+    void shutdown();
+    void detach();
+
+    string socketPath(uint32_t id) const;
+
+public:
+    explicit Supervisor(const Config& config);
+    ~Supervisor();
+
+    Supervisor(const Supervisor&) = delete;
+    Supervisor& operator=(const Supervisor&) = delete;
+
+    /**
+     * Serve the control socket until SIGINT or SIGTERM has stopped every worker
+     * @param launch receives the worker to become when this returns in a forked child
+     * @return true in a forked child, false once the supervisor is done
+     */
+    bool run(Launch& launch);
+
+    /**
+     * @return true if run() returned because the control socket could not be served
+     */
+    bool failed() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_SUPERVISOR_H
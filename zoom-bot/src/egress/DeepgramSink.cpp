@@ -0,0 +1,375 @@
+#include "DeepgramSink.h"
+
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#include <picojson/picojson.h>
+
+#include "../util/ThreadRoles.h"
+#include "../util/UrlParser.h"
+
+DeepgramSink::DeepgramSink(const DeepgramOptions& options) : m_options(options) {}
+
+DeepgramSink::~DeepgramSink() {
+    stop();
+}
+
+void DeepgramSink::setOnTranscript(const TranscriptHandler& handler) {
+    m_onTranscript = handler;
+}
+
+bool DeepgramSink::parseUrl() {
+    auto url = UrlParser::parse(m_options.url);
+    if (!url.valid || (url.scheme != "wss" && url.scheme != "ws")) {
+        Log::error("Deepgram URL must start with wss:// or ws://: " + m_options.url);
+        return false;
+    }
+
+    m_tls = url.scheme == "wss";
+    m_host = url.host;
+    m_port = m_tls ? "443" : "80";
+
+    auto colon = m_host.rfind(':');
+    if (colon != string::npos) {
+        m_port = m_host.substr(colon + 1);
+        m_host.resize(colon);
+    }
+
+    m_target = url.path.empty() ? "/v1/listen" : url.path;
+    m_target += "?" + (url.query.empty() ? "" : url.query + "&");
+
+    return true;
+}
+
+bool DeepgramSink::start() {
+    if (m_running)
+        return true;
+
+    if (m_options.apiKey.empty()) {
+        Log::error("streaming to Deepgram needs an API key (--deepgram-key or DEEPGRAM_API_KEY)");
+        return false;
+    }
+
+    if (!parseUrl())
+        return false;
+
+    if (!m_options.caFile.empty())
+        m_socket.setCaFile(m_options.caFile);
+
+    m_ring = make_unique<AudioRing>(c_ringSlots, c_slotSize, OverflowPolicy::DropOldest);
+    m_running = true;
+    m_thread = thread(&DeepgramSink::run, this);
+
+    Log::info("streaming mixed audio to Deepgram at " + m_host);
+    return true;
+}
+
+void DeepgramSink::stop() {
+    if (!m_running.exchange(false))
+        return;
+
+    m_ring->wake();
+    m_thread.join();
+}
+
+void DeepgramSink::write(const FrameHeader& header, const char* buf, size_t len) {
+    if (!m_running)
+        return;
+
+    m_ring->push(&header, sizeof(header), buf, len);
+}
+
+void DeepgramSink::run() {
+    ThreadRoles::assign(ThreadRole::Io);
+    m_lastSend = chrono::steady_clock::now();
+
+    while (m_running) {
+        auto now = chrono::steady_clock::now();
+        if (!m_socket.isOpen() && m_sampleRate && now >= m_nextAttempt)
+            connect();
+
+        struct pollfd fds[2];
+        fds[0] = {m_ring->fd(), POLLIN, 0};
+        nfds_t count = 1;
+
+        if (m_socket.isOpen()) {
+            fds[1] = {m_socket.fd(), static_cast<short>(POLLIN | (m_socket.wantsWrite() ? POLLOUT : 0)), 0};
+            count = 2;
+        }
+
+        auto timeout = 1000;
+        if (!m_socket.isOpen() && m_sampleRate) {
+            auto wait = chrono::duration_cast<chrono::milliseconds>(m_nextAttempt - now).count();
+            timeout = max<int>(0, min<int>(wait, timeout));
+        }
+
+        // only block once the ring is empty, otherwise the producer would not wake us
+        if (!m_ring->sleep())
+            timeout = 0;
+
+        if (poll(fds, count, timeout) == -1 && errno != EINTR) {
+            Log::error("Deepgram egress poll failed");
+            break;
+        }
+
+        if (fds[0].revents & POLLIN)
+            m_ring->clear();
+
+        drain();
+
+        if (count == 2 && m_socket.isOpen() && (fds[1].revents & (POLLIN | POLLHUP | POLLERR)))
+            receive();
+
+        if (m_socket.isOpen() && !m_socket.flush())
+            lost(m_socket.error());
+
+        // Deepgram closes connections that get nothing for about 10 seconds
+        if (m_socket.isOpen() && chrono::steady_clock::now() - m_lastSend > c_keepalive) {
+            m_socket.sendText("{\"type\":\"KeepAlive\"}");
+            m_lastSend = chrono::steady_clock::now();
+        }
+    }
+
+    finish();
+}
+
+void DeepgramSink::drain() {
+    auto keepalive = false;
+
+    while (auto* slot = m_ring->acquire()) {
+        FrameHeader header;
+        memcpy(&header, slot->data, sizeof(header));
+
+        auto* payload = slot->data + sizeof(FrameHeader);
+        auto len = slot->len - sizeof(FrameHeader);
+
+        if (len == 0) {
+            keepalive |= (header.flags & FrameHeader::c_flagSilence) != 0;
+            m_ring->release(slot);
+            continue;
+        }
+
+        if (header.sampleRate != m_sampleRate || header.channels != m_channels) {
+            // the batch so far was in the old format
+            if (!m_batch.empty())
+                send(m_batch.data(), m_batch.size());
+            m_batch.clear();
+
+            setFormat(header.sampleRate, header.channels);
+        }
+
+        append(payload, len);
+        m_batch.append(payload, len);
+        m_ring->release(slot);
+
+        if (m_batch.size() >= c_maxFrame) {
+            send(m_batch.data(), m_batch.size());
+            m_batch.clear();
+        }
+    }
+
+    if (!m_batch.empty()) {
+        send(m_batch.data(), m_batch.size());
+        m_batch.clear();
+    } else if (keepalive && m_socket.isOpen()) {
+        m_socket.sendText("{\"type\":\"KeepAlive\"}");
+        m_lastSend = chrono::steady_clock::now();
+    }
+}
+
+void DeepgramSink::setFormat(unsigned int sampleRate, unsigned int channels) {
+    if (m_sampleRate) {
+        stringstream ss;
+        ss << "audio format changed to " << sampleRate << "Hz/" << channels << "ch, reconnecting to Deepgram";
+        Log::info(ss.str());
+
+        if (m_socket.isOpen())
+            m_socket.close();
+    }
+
+    m_sampleRate = sampleRate;
+    m_channels = max(channels, 1u);
+
+    // audio in the old format is of no use to the new connection
+    m_replay.assign(bytesPerSecond() * m_options.replayMs / 1000, 0);
+    m_replayStart = m_replayEnd;
+    m_connectionBase = m_replayEnd;
+    m_nextAttempt = chrono::steady_clock::now();
+}
+
+void DeepgramSink::append(const char* buf, size_t len) {
+    auto capacity = m_replay.size();
+    if (capacity == 0)
+        return;
+
+    // only the newest capacity bytes can be kept
+    if (len > capacity) {
+        buf += len - capacity;
+        m_replayEnd += len - capacity;
+        len = capacity;
+    }
+
+    auto pos = m_replayEnd % capacity;
+    auto first = min(len, capacity - pos);
+    memcpy(m_replay.data() + pos, buf, first);
+    memcpy(m_replay.data(), buf + first, len - first);
+    m_replayEnd += len;
+
+    if (m_replayEnd - m_replayStart > capacity) {
+        m_lost += m_replayEnd - capacity - m_replayStart;
+        m_replayStart = m_replayEnd - capacity;
+    }
+}
+
+bool DeepgramSink::connect() {
+    stringstream target;
+    target << m_target << "encoding=linear16&sample_rate=" << m_sampleRate << "&channels=" << m_channels
+           << "&model=" << m_options.model << "&language=" << m_options.language
+           << "&interim_results=true&smart_format=true&endpointing=300";
+
+    vector<string> headers = {"Authorization: Token " + m_options.apiKey};
+
+    if (!m_socket.connect(m_tls, m_host, m_port, target.str(), headers, c_connectTimeoutMs)) {
+        lost(m_socket.error());
+        return false;
+    }
+
+    m_backoff = c_minBackoff;
+    m_connectionBase = m_replayStart;
+    m_lastSend = chrono::steady_clock::now();
+
+    stringstream ss;
+    ss << "connected to Deepgram";
+    if (m_replayEnd > m_replayStart)
+        ss << ", replaying " << (m_replayEnd - m_replayStart) * 1000 / bytesPerSecond() << "ms of audio";
+    if (m_lost > 0)
+        ss << " (" << m_lost * 1000 / bytesPerSecond() << "ms lost since the last connection)";
+    Log::success(ss.str());
+
+    m_lost = 0;
+    replay();
+    return true;
+}
+
+void DeepgramSink::replay() {
+    auto capacity = m_replay.size();
+    if (capacity == 0)
+        return;
+
+    // the batch of this pass is part of the buffer already, so it goes out with the replay
+    m_batch.clear();
+
+    for (auto pos = m_replayStart; pos < m_replayEnd;) {
+        auto offset = pos % capacity;
+        auto len = min<uint64_t>({m_replayEnd - pos, capacity - offset, c_maxFrame});
+
+        m_socket.sendBinary(m_replay.data() + offset, len);
+        pos += len;
+    }
+}
+
+bool DeepgramSink::send(const char* buf, size_t len) {
+    if (!m_socket.isOpen())
+        return false;
+
+    m_lastSend = chrono::steady_clock::now();
+    if (!m_socket.sendBinary(buf, len))
+        return false;
+
+    // more than the replay buffer is waiting for the socket, Deepgram is not keeping up
+    if (m_socket.pending() > m_replay.size() + 1024 * 1024) {
+        lost("Deepgram is not reading audio fast enough");
+        return false;
+    }
+
+    return true;
+}
+
+void DeepgramSink::receive() {
+    vector<WebSocketClient::Message> messages;
+    auto open = m_socket.receive(messages);
+
+    for (auto& message : messages)
+        if (message.text)
+            handle(message.data);
+
+    if (!open)
+        lost(m_socket.error());
+}
+
+void DeepgramSink::handle(const string& json) {
+    picojson::value result;
+    auto err = picojson::parse(result, json);
+    if (!err.empty() || !result.is<picojson::object>()) {
+        Log::error("unexpected message from Deepgram: " + json.substr(0, 200));
+        return;
+    }
+
+    auto& fields = result.get<picojson::object>();
+    auto rate = bytesPerSecond();
+
+    // a final result covers its audio, which then no longer needs to be replayed
+    auto& isFinal = result.get("is_final");
+    auto& start = result.get("start");
+    auto& duration = result.get("duration");
+    if (isFinal.is<bool>() && isFinal.get<bool>() && start.is<double>() && duration.is<double>() && rate) {
+        auto frame = sizeof(int16_t) * m_channels;
+        auto end = static_cast<uint64_t>(llround((start.get<double>() + duration.get<double>()) * m_sampleRate)) * frame;
+
+        m_replayStart = max(m_replayStart, min(m_connectionBase + end, m_replayEnd));
+    }
+
+    if (!m_onTranscript)
+        return;
+
+    fields["stream_offset"] = picojson::value(rate ? static_cast<double>(m_connectionBase) / rate : 0.0);
+    m_onTranscript(result.serialize());
+}
+
+void DeepgramSink::lost(const string& reason) {
+    m_socket.close();
+
+    m_nextAttempt = chrono::steady_clock::now() + m_backoff;
+    Log::error("Deepgram connection lost (" + reason + "), retrying in " + to_string(m_backoff.count()) + "ms");
+
+    m_backoff = min<chrono::milliseconds>(m_backoff * 2, c_maxBackoff);
+}
+
+void DeepgramSink::finish() {
+    drain();
+
+    if (!m_socket.isOpen())
+        return;
+
+    // let Deepgram finalize the audio it has and wait for those results
+    m_socket.sendText("{\"type\":\"CloseStream\"}");
+
+    auto deadline = chrono::steady_clock::now() + c_finishTimeout;
+    while (m_socket.isOpen() && chrono::steady_clock::now() < deadline) {
+        if (!m_socket.flush())
+            break;
+
+        struct pollfd fd = {m_socket.fd(), static_cast<short>(POLLIN | (m_socket.wantsWrite() ? POLLOUT : 0)), 0};
+        if (poll(&fd, 1, 100) <= 0)
+            continue;
+
+        // Deepgram closes the connection once the last results are out
+        vector<WebSocketClient::Message> messages;
+        auto open = m_socket.receive(messages);
+
+        for (auto& message : messages)
+            if (message.text)
+                handle(message.data);
+
+        if (!open)
+            break;
+    }
+
+    m_socket.close();
+    Log::info("disconnected from Deepgram");
+}
+
+size_t DeepgramSink::bytesPerSecond() const {
+    return static_cast<size_t>(m_sampleRate) * m_channels * sizeof(int16_t);
+}
@@ -0,0 +1,137 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_DEEPGRAMSINK_H
+#define MEETING_SDK_LINUX_SAMPLE_DEEPGRAMSINK_H
+
+#include <poll.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "WebSocketClient.h"
+#include "../util/AudioRing.h"
+#include "../util/FrameHeader.h"
+#include "../util/Log.h"
+
+using namespace std;
+
+/**
+ * Where and how the bot streams to Deepgram itself
+ */
+struct DeepgramOptions {
+    bool enabled = false;
+    string url = "wss://api.deepgram.com/v1/listen";
+    string apiKey;
+    string model = "nova-2";
+    string language = "de";
+    string caFile;
+    // audio kept for a reconnect until Deepgram has finalized it
+    unsigned int replayMs = 10000;
+};
+
+/**
+ * Streams the mixed audio to Deepgram's live API from the bot, without the Python hop.
+ *
+ * The SDK thread only copies chunks into a ring; an egress thread owns the websocket and
+ * sends everything the ring holds in one frame per pass. Transcript JSON comes back on the
+ * same thread and is handed to the transcript callback.
+ *
+ * Sent audio is also kept in a replay buffer until a final result covers it. When the
+ * connection drops, the audio since the last final result and everything captured while
+ * reconnecting is sent again first, so up to replayMs of audio survives an outage. A new
+ * connection starts its own timeline, so every relayed result carries stream_offset, the
+ * seconds of audio before that connection, to place it on the meeting's timeline.
+ */
+class DeepgramSink {
+public:
+    typedef function<void(const string& json)> TranscriptHandler;
+
+private:
+    const size_t c_slotSize = 4096;
+    const size_t c_ringSlots = 256;
+    const size_t c_maxFrame = 32 * 1024;
+    const int c_connectTimeoutMs = 5000;
+    const chrono::milliseconds c_minBackoff{500};
+    const chrono::seconds c_maxBackoff{30};
+    const chrono::seconds c_keepalive{5};
+    const chrono::seconds c_finishTimeout{3};
+
+    DeepgramOptions m_options;
+    bool m_tls = true;
+    string m_host;
+    string m_port;
+    string m_target;
+
+    unique_ptr<AudioRing> m_ring;
+    thread m_thread;
+    atomic<bool> m_running{false};
+    TranscriptHandler m_onTranscript;
+
+    // owned by the egress thread from here on
+    WebSocketClient m_socket;
+    unsigned int m_sampleRate = 0;
+    unsigned int m_channels = 0;
+    string m_batch;
+
+    // positions count bytes of audio since the meeting started
+    vector<char> m_replay;
+    uint64_t m_replayStart = 0;
+    uint64_t m_replayEnd = 0;
+    uint64_t m_connectionBase = 0;
+    uint64_t m_lost = 0;
+
+    chrono::milliseconds m_backoff = c_minBackoff;
+    chrono::steady_clock::time_point m_nextAttempt;
+    chrono::steady_clock::time_point m_lastSend;
+
+    bool parseUrl();
+    void run();
+    void drain();
+    void setFormat(unsigned int sampleRate, unsigned int channels);
+    void append(const char* buf, size_t len);
+    bool connect();
+    void replay();
+    bool send(const char* buf, size_t len);
+    void receive();
+    void handle(const string& json);
+    void lost(const string& reason);
+    void finish();
+
+    size_t bytesPerSecond() const;
+
+public:
+    explicit DeepgramSink(const DeepgramOptions& options);
+    ~DeepgramSink();
+
+    DeepgramSink(const DeepgramSink&) = delete;
+    DeepgramSink& operator=(const DeepgramSink&) = delete;
+
+    /**
+     * Handler for every message Deepgram sends, called on the egress thread
+     */
+    void setOnTranscript(const TranscriptHandler& handler);
+
+    /**
+     * Start the egress thread; it connects once the first audio shows its format
+     * @return false if the options cannot work
+     */
+    bool start();
+
+    /**
+     * Ask Deepgram to finalize what it has, wait briefly for the results and disconnect
+     */
+    void stop();
+
+    /**
+     * Queue audio for Deepgram. Called from the SDK audio thread only.
+     * @param header format of the chunk; silence markers without payload keep the connection alive
+     * @param buf linear16 samples
+     * @param len number of bytes
+     */
+    void write(const FrameHeader& header, const char* buf, size_t len);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_DEEPGRAMSINK_H
@@ -0,0 +1,343 @@
+#include "HttpClient.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+HttpClient::HttpClient(bool tls, const string& host, const string& port, int timeoutMs) :
+        m_tls(tls), m_host(host), m_port(port), m_timeoutMs(timeoutMs) {}
+
+HttpClient::~HttpClient() {
+    close();
+
+    if (m_ctx)
+        SSL_CTX_free(m_ctx);
+}
+
+void HttpClient::setCaFile(const string& path) {
+    m_caFile = path;
+}
+
+bool HttpClient::request(const string& method, const string& target, const vector<string>& headers,
+                         const char* body, size_t len, Response& response) {
+    string head = method + " " + target + " HTTP/1.1\r\n"
+                  "Host: " + hostHeader() + "\r\n"
+                  "Content-Length: " + to_string(len) + "\r\n";
+    for (auto& header : headers)
+        head += header + "\r\n";
+    head += "\r\n";
+
+    // the server may have dropped a kept-alive connection since the last request
+    auto reused = m_fd != -1;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        m_error.clear();
+
+        if (m_fd == -1 && !connect())
+            return false;
+
+        if (send(head, body, len) && receive(response)) {
+            auto it = response.headers.find("connection");
+            if (it != response.headers.end() && it->second == "close")
+                close();
+            return true;
+        }
+
+        close();
+        if (!reused)
+            return false;
+
+        reused = false;
+    }
+
+    return false;
+}
+
+bool HttpClient::connect() {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* addrs = nullptr;
+    auto ret = getaddrinfo(m_host.c_str(), m_port.c_str(), &hints, &addrs);
+    if (ret != 0)
+        return fail("unable to resolve " + m_host + ": " + gai_strerror(ret));
+
+    struct timeval timeout;
+    timeout.tv_sec = m_timeoutMs / 1000;
+    timeout.tv_usec = (m_timeoutMs % 1000) * 1000;
+
+    for (auto* addr = addrs; addr; addr = addr->ai_next) {
+        m_fd = socket(addr->ai_family, addr->ai_socktype | SOCK_CLOEXEC, addr->ai_protocol);
+        if (m_fd == -1)
+            continue;
+
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(m_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        if (::connect(m_fd, addr->ai_addr, addr->ai_addrlen) == 0)
+            break;
+
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    freeaddrinfo(addrs);
+
+    if (m_fd == -1)
+        return fail("unable to connect to " + m_host + ":" + m_port);
+
+    int one = 1;
+    setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (m_tls && !connectTls()) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool HttpClient::connectTls() {
+    if (!m_ctx) {
+        m_ctx = SSL_CTX_new(TLS_client_method());
+        if (!m_ctx)
+            return fail("unable to create TLS context");
+
+        SSL_CTX_set_min_proto_version(m_ctx, TLS1_2_VERSION);
+        SSL_CTX_set_verify(m_ctx, SSL_VERIFY_PEER, nullptr);
+
+        auto loaded = m_caFile.empty() ? SSL_CTX_set_default_verify_paths(m_ctx)
+                                       : SSL_CTX_load_verify_locations(m_ctx, m_caFile.c_str(), nullptr);
+        if (loaded != 1)
+            return fail("unable to load trusted certificates");
+    }
+
+    m_ssl = SSL_new(m_ctx);
+    SSL_set_fd(m_ssl, m_fd);
+    SSL_set_tlsext_host_name(m_ssl, m_host.c_str());
+    SSL_set1_host(m_ssl, m_host.c_str());
+
+    if (SSL_connect(m_ssl) != 1) {
+        char reason[256];
+        ERR_error_string_n(ERR_get_error(), reason, sizeof(reason));
+        return fail("TLS handshake with " + m_host + " failed: " + reason);
+    }
+
+    return true;
+}
+
+bool HttpClient::send(const string& head, const char* body, size_t len) {
+    if (!writeAll(head.data(), head.size()) || (len > 0 && !writeAll(body, len)))
+        return fail("unable to send request to " + m_host);
+
+    return true;
+}
+
+bool HttpClient::receive(Response& response) {
+    response = Response();
+
+    size_t end;
+    while ((end = m_in.find("\r\n\r\n")) == string::npos) {
+        if (m_in.size() > c_maxHeader)
+            return fail("response header from " + m_host + " is too large");
+        if (!fill())
+            return fail("no response from " + m_host);
+    }
+
+    auto head = m_in.substr(0, end + 2);
+    m_in.erase(0, end + 4);
+
+    auto lineEnd = head.find("\r\n");
+    auto status = head.substr(0, lineEnd);
+    auto space = status.find(' ');
+    if (status.compare(0, 5, "HTTP/") != 0 || space == string::npos)
+        return fail("malformed response from " + m_host + ": " + status);
+
+    response.status = atoi(status.c_str() + space + 1);
+
+    for (auto pos = lineEnd + 2; pos < head.size();) {
+        auto next = head.find("\r\n", pos);
+        auto line = head.substr(pos, next - pos);
+        pos = next + 2;
+
+        auto colon = line.find(':');
+        if (colon == string::npos)
+            continue;
+
+        auto name = line.substr(0, colon);
+        transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+        auto value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t") + 1);
+
+        response.headers[name] = value;
+    }
+
+    if (response.status == 204 || response.status == 304)
+        return true;
+
+    auto encoding = response.headers.find("transfer-encoding");
+    if (encoding != response.headers.end() && encoding->second.find("chunked") != string::npos)
+        return readChunked(response.body);
+
+    auto length = response.headers.find("content-length");
+    if (length != response.headers.end())
+        return readBody(strtoull(length->second.c_str(), nullptr, 10), response.body);
+
+    // without a length the body ends with the connection
+    while (fill()) {
+        if (m_in.size() > c_maxBody)
+            return fail("response body from " + m_host + " is too large");
+    }
+
+    response.body = std::move(m_in);
+    m_in.clear();
+    response.headers["connection"] = "close";
+
+    return true;
+}
+
+bool HttpClient::fill() {
+    char buf[c_readSize];
+
+    while (true) {
+        auto n = readSome(buf, sizeof(buf));
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        m_in.append(buf, n);
+        return true;
+    }
+}
+
+bool HttpClient::readBody(size_t len, string& body) {
+    if (len > c_maxBody)
+        return fail("response body from " + m_host + " is too large");
+
+    while (m_in.size() < len) {
+        if (!fill())
+            return fail("response from " + m_host + " was cut short");
+    }
+
+    body.append(m_in, 0, len);
+    m_in.erase(0, len);
+
+    return true;
+}
+
+bool HttpClient::readChunked(string& body) {
+    string line;
+
+    while (true) {
+        if (!readLine(line))
+            return false;
+
+        auto size = strtoull(line.c_str(), nullptr, 16);
+        if (size == 0)
+            break;
+
+        if (body.size() + size > c_maxBody)
+            return fail("response body from " + m_host + " is too large");
+
+        if (!readBody(size, body) || !readLine(line))
+            return false;
+    }
+
+    // trailers end with an empty line
+    do {
+        if (!readLine(line))
+            return false;
+    } while (!line.empty());
+
+    return true;
+}
+
+bool HttpClient::readLine(string& line) {
+    size_t end;
+    while ((end = m_in.find("\r\n")) == string::npos) {
+        if (m_in.size() > c_maxHeader)
+            return fail("response line from " + m_host + " is too long");
+        if (!fill())
+            return fail("response from " + m_host + " was cut short");
+    }
+
+    line = m_in.substr(0, end);
+    m_in.erase(0, end + 2);
+
+    return true;
+}
+
+ssize_t HttpClient::readSome(char* buf, size_t len) {
+    if (!m_ssl)
+        return ::recv(m_fd, buf, len, 0);
+
+    auto n = SSL_read(m_ssl, buf, len);
+    if (n > 0)
+        return n;
+
+    if (SSL_get_error(m_ssl, n) == SSL_ERROR_ZERO_RETURN)
+        return 0;
+
+    errno = EIO;
+    return -1;
+}
+
+ssize_t HttpClient::writeSome(const char* buf, size_t len) {
+    if (!m_ssl)
+        return ::send(m_fd, buf, len, MSG_NOSIGNAL);
+
+    auto n = SSL_write(m_ssl, buf, len);
+    if (n > 0)
+        return n;
+
+    errno = EIO;
+    return -1;
+}
+
+bool HttpClient::writeAll(const char* buf, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        auto n = writeSome(buf + sent, len - sent);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        sent += n;
+    }
+
+    return true;
+}
+
+void HttpClient::close() {
+    if (m_ssl) {
+        SSL_free(m_ssl);
+        m_ssl = nullptr;
+    }
+
+    if (m_fd != -1) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    m_in.clear();
+}
+
+string HttpClient::hostHeader() const {
+    if ((m_tls && m_port == "443") || (!m_tls && m_port == "80"))
+        return m_host;
+
+    return m_host + ":" + m_port;
+}
+
+bool HttpClient::fail(const string& error) {
+    m_error = error;
+    return false;
+}
+
+const string& HttpClient::error() const {
+    return m_error;
+}
@@ -0,0 +1,106 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_HTTPCLIENT_H
+#define MEETING_SDK_LINUX_SAMPLE_HTTPCLIENT_H
+
+#include <sys/socket.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include "../util/Log.h"
+
+using namespace std;
+
+/**
+ * Blocking HTTP/1.1 client for one host, optionally TLS through OpenSSL.
+ *
+ * Meant for a thread that owns it, like an upload worker: every call blocks with the
+ * socket timeout. The connection is kept alive between requests, and a request on a
+ * connection the server has meanwhile closed is sent once more on a new one.
+ */
+class HttpClient {
+public:
+    struct Response {
+        int status = 0;
+        // names in lower case
+        unordered_map<string, string> headers;
+        string body;
+    };
+
+private:
+    const size_t c_readSize = 16 * 1024;
+    const size_t c_maxHeader = 64 * 1024;
+    const size_t c_maxBody = 16 * 1024 * 1024;
+
+    bool m_tls;
+    string m_host;
+    string m_port;
+    int m_timeoutMs;
+    string m_caFile;
+
+    int m_fd = -1;
+    SSL_CTX* m_ctx = nullptr;
+    SSL* m_ssl = nullptr;
+    string m_in;
+    string m_error;
+
+    bool connect();
+    bool connectTls();
+    bool send(const string& head, const char* body, size_t len);
+    bool receive(Response& response);
+    bool fill();
+    bool readBody(size_t len, string& body);
+    bool readChunked(string& body);
+    bool readLine(string& line);
+
+    ssize_t readSome(char* buf, size_t len);
+    ssize_t writeSome(const char* buf, size_t len);
+    bool writeAll(const char* buf, size_t len);
+    bool fail(const string& error);
+
+public:
+    /**
+     * @param tls https instead of http
+     * @param host server name, also checked against its certificate
+     * @param port TCP port
+     * @param timeoutMs bound on connecting and on every read and write
+     */
+    HttpClient(bool tls, const string& host, const string& port, int timeoutMs = 30000);
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    /**
+     * Trust only this CA bundle instead of the system store
+     */
+    void setCaFile(const string& path);
+
+    /**
+     * Send a request and read the whole response
+     * @param target path with query string
+     * @param headers extra request header lines without line break; Host and
+     *        Content-Length are added
+     * @return false with error() set if no response arrived, whatever its status
+     */
+    bool request(const string& method, const string& target, const vector<string>& headers,
+                 const char* body, size_t len, Response& response);
+
+    void close();
+
+    /**
+     * @return the Host header value, with the port unless it is the scheme's default
+     */
+    string hostHeader() const;
+    const string& error() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_HTTPCLIENT_H
@@ -0,0 +1,256 @@
+#include "S3Client.h"
+
+#include <fcntl.h>
+
+#include <ctime>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/sha.h>
+
+#include "../util/UrlParser.h"
+
+S3Client::S3Client(const S3Options& options) : m_options(options) {
+    auto tls = true;
+    string host, port = "443";
+
+    if (options.endpoint.empty()) {
+        host = options.bucket + ".s3." + options.region + ".amazonaws.com";
+    } else {
+        // self-hosted stores rarely have a DNS name per bucket
+        auto url = UrlParser::parse(options.endpoint);
+        tls = url.scheme != "http";
+        host = url.host;
+        port = tls ? "443" : "80";
+
+        auto colon = host.rfind(':');
+        if (colon != string::npos && host.find(']', colon) == string::npos) {
+            port = host.substr(colon + 1);
+            host.resize(colon);
+        }
+
+        m_pathStyle = true;
+    }
+
+    m_http = make_unique<HttpClient>(tls, host, port);
+}
+
+bool S3Client::upload(const string& key, const string& path, uint64_t size) {
+    m_error.clear();
+
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return fail("unable to open " + path);
+
+    auto ok = size <= m_options.partSize ? putObject(key, fd, size) : putMultipart(key, fd, size);
+    ::close(fd);
+
+    return ok;
+}
+
+bool S3Client::putObject(const string& key, int fd, uint64_t size) {
+    if (!readAt(fd, 0, size))
+        return false;
+
+    HttpClient::Response response;
+    return send("PUT", key, "", m_buffer.data(), size, response);
+}
+
+bool S3Client::putMultipart(const string& key, int fd, uint64_t size) {
+    HttpClient::Response response;
+    if (!send("POST", key, "uploads=", nullptr, 0, response))
+        return false;
+
+    auto uploadId = xmlValue(response.body, "UploadId");
+    if (uploadId.empty())
+        return fail("no upload ID for " + key);
+
+    auto id = encode(uploadId, true);
+    string parts;
+    unsigned int number = 1;
+
+    for (uint64_t offset = 0; offset < size; offset += m_options.partSize, number++) {
+        auto len = static_cast<size_t>(min<uint64_t>(m_options.partSize, size - offset));
+        if (!readAt(fd, offset, len)) {
+            abort(key, uploadId);
+            return false;
+        }
+
+        auto query = "partNumber=" + to_string(number) + "&uploadId=" + id;
+        auto sent = false;
+
+        for (unsigned int attempt = 0; attempt < c_partAttempts && !sent; attempt++)
+            sent = send("PUT", key, query, m_buffer.data(), len, response);
+
+        auto etag = response.headers.find("etag");
+        if (!sent || etag == response.headers.end()) {
+            abort(key, uploadId);
+            return sent ? fail("no ETag for part " + to_string(number) + " of " + key) : false;
+        }
+
+        parts += "<Part><PartNumber>" + to_string(number) + "</PartNumber><ETag>" + etag->second + "</ETag></Part>";
+    }
+
+    auto complete = "<CompleteMultipartUpload>" + parts + "</CompleteMultipartUpload>";
+    auto completed = send("POST", key, "uploadId=" + id, complete.data(), complete.size(), response);
+
+    // S3 can report a failed completion in the body of a 200
+    if (completed && response.body.find("<Error>") != string::npos)
+        completed = fail("completing " + key + " failed: " + xmlValue(response.body, "Message"));
+
+    if (!completed)
+        abort(key, uploadId);
+
+    return completed;
+}
+
+void S3Client::abort(const string& key, const string& uploadId) {
+    auto error = m_error;
+
+    HttpClient::Response response;
+    if (!send("DELETE", key, "uploadId=" + encode(uploadId, true), nullptr, 0, response))
+        Log::error("unable to abort the upload of ", key, ": ", m_error);
+
+    m_error = error;
+}
+
+bool S3Client::readAt(int fd, uint64_t offset, size_t len) {
+    if (m_buffer.size() < len)
+        m_buffer.resize(len);
+
+    size_t done = 0;
+    while (done < len) {
+        auto n = pread(fd, m_buffer.data() + done, len - done, offset + done);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return fail("unable to read the file at " + to_string(offset + done));
+
+        done += n;
+    }
+
+    return true;
+}
+
+bool S3Client::send(const string& method, const string& key, const string& query, const char* body, size_t len,
+                    HttpClient::Response& response) {
+    char amzDate[32];
+    auto now = time(nullptr);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    strftime(amzDate, sizeof(amzDate), "%Y%m%dT%H%M%SZ", &utc);
+
+    auto date = string(amzDate, 8);
+    auto scope = date + "/" + m_options.region + "/s3/aws4_request";
+    auto uri = (m_pathStyle ? "/" + encode(m_options.bucket, false) : string()) + "/" + encode(key, false);
+    auto payloadHash = sha256(body, len);
+
+    // canonical headers are sorted by name, the token sorts after the date
+    auto canonicalHeaders = "host:" + m_http->hostHeader() + "\n"
+                            "x-amz-content-sha256:" + payloadHash + "\n"
+                            "x-amz-date:" + amzDate + "\n";
+    string signedHeaders = "host;x-amz-content-sha256;x-amz-date";
+
+    vector<string> headers = {
+        "x-amz-content-sha256: " + payloadHash,
+        string("x-amz-date: ") + amzDate
+    };
+
+    if (!m_options.sessionToken.empty()) {
+        canonicalHeaders += "x-amz-security-token:" + m_options.sessionToken + "\n";
+        signedHeaders += ";x-amz-security-token";
+        headers.push_back("x-amz-security-token: " + m_options.sessionToken);
+    }
+
+    auto canonical = method + "\n" + uri + "\n" + query + "\n" + canonicalHeaders + "\n" + signedHeaders + "\n" + payloadHash;
+    auto stringToSign = string("AWS4-HMAC-SHA256\n") + amzDate + "\n" + scope + "\n" + sha256(canonical.data(), canonical.size());
+
+    auto signingKey = hmac(hmac(hmac(hmac("AWS4" + m_options.secretKey, date), m_options.region), "s3"), "aws4_request");
+    auto signature = hmac(signingKey, stringToSign);
+
+    headers.push_back("Authorization: AWS4-HMAC-SHA256 Credential=" + m_options.accessKey + "/" + scope +
+                      ", SignedHeaders=" + signedHeaders +
+                      ", Signature=" + hex(reinterpret_cast<const unsigned char*>(signature.data()), signature.size()));
+
+    if (len > 0)
+        headers.push_back("Content-Type: application/octet-stream");
+
+    auto target = query.empty() ? uri : uri + "?" + query;
+    if (!m_http->request(method, target, headers, body, len, response))
+        return fail(m_http->error());
+
+    if (response.status < 200 || response.status >= 300) {
+        auto code = xmlValue(response.body, "Code");
+        return fail(method + " " + key + " answered " + to_string(response.status) + (code.empty() ? "" : " " + code));
+    }
+
+    return true;
+}
+
+bool S3Client::fail(const string& error) {
+    m_error = error;
+    return false;
+}
+
+const string& S3Client::error() const {
+    return m_error;
+}
+
+string S3Client::encode(const string& value, bool slash) {
+    static const char* digits = "0123456789ABCDEF";
+    string out;
+
+    for (unsigned char c : value) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' || (c == '/' && !slash)) {
+            out.push_back(c);
+        } else {
+            out.push_back('%');
+            out.push_back(digits[c >> 4]);
+            out.push_back(digits[c & 0xf]);
+        }
+    }
+
+    return out;
+}
+
+string S3Client::hex(const unsigned char* buf, size_t len) {
+    static const char* digits = "0123456789abcdef";
+    string out;
+    out.reserve(len * 2);
+
+    for (size_t i = 0; i < len; i++) {
+        out.push_back(digits[buf[i] >> 4]);
+        out.push_back(digits[buf[i] & 0xf]);
+    }
+
+    return out;
+}
+
+string S3Client::sha256(const char* buf, size_t len) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(buf), len, digest);
+
+    return hex(digest, sizeof(digest));
+}
+
+string S3Client::hmac(const string& key, const string& data) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+
+    HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+         reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest, &len);
+
+    return string(reinterpret_cast<char*>(digest), len);
+}
+
+string S3Client::xmlValue(const string& xml, const string& tag) {
+    auto open = "<" + tag + ">";
+    auto start = xml.find(open);
+    if (start == string::npos)
+        return "";
+
+    start += open.size();
+    auto end = xml.find("</" + tag + ">", start);
+
+    return end == string::npos ? "" : xml.substr(start, end - start);
+}
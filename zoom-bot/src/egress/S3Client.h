@@ -0,0 +1,80 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_S3CLIENT_H
+#define MEETING_SDK_LINUX_SAMPLE_S3CLIENT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "HttpClient.h"
+
+using namespace std;
+
+struct S3Options {
+    string bucket;
+    string region = "us-east-1";
+    // e.g. http://minio:9000 for an S3 compatible store, addressed path style; empty for AWS
+    string endpoint;
+    string accessKey;
+    string secretKey;
+    // only for temporary credentials
+    string sessionToken;
+    // files up to this size are sent in one PUT, larger ones in parts of this size
+    size_t partSize = 8 * 1024 * 1024;
+};
+
+/**
+ * Uploads files to S3 or a compatible store with Signature Version 4.
+ *
+ * Blocking, on a thread that owns the client, which keeps its connection alive between
+ * requests. A multipart upload reads its parts from the file one at a time, retries a
+ * part that failed a few times and aborts the whole upload if it fails for good, so no
+ * orphaned parts keep costing storage.
+ */
+class S3Client {
+    const unsigned int c_partAttempts = 3;
+
+    S3Options m_options;
+    unique_ptr<HttpClient> m_http;
+    bool m_pathStyle = false;
+
+    vector<char> m_buffer;
+    string m_error;
+
+    bool putObject(const string& key, int fd, uint64_t size);
+    bool putMultipart(const string& key, int fd, uint64_t size);
+    void abort(const string& key, const string& uploadId);
+    bool readAt(int fd, uint64_t offset, size_t len);
+
+    /**
+     * Sign and send one request
+     * @param query canonical query string: sorted, encoded and with = after every name
+     * @return true for a 2xx response
+     */
+    bool send(const string& method, const string& key, const string& query, const char* body, size_t len,
+              HttpClient::Response& response);
+
+    bool fail(const string& error);
+
+    static string encode(const string& value, bool slash);
+    static string hex(const unsigned char* buf, size_t len);
+    static string sha256(const char* buf, size_t len);
+    static string hmac(const string& key, const string& data);
+    static string xmlValue(const string& xml, const string& tag);
+
+public:
+    explicit S3Client(const S3Options& options);
+
+    /**
+     * Upload a file as an object
+     * @param key object key
+     * @param path local file
+     * @param size bytes of the file
+     * @return false with error() set if the object was not stored
+     */
+    bool upload(const string& key, const string& path, uint64_t size);
+
+    const string& error() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_S3CLIENT_H
@@ -0,0 +1,474 @@
+#include "WebSocketClient.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const char* c_acceptGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+WebSocketClient::~WebSocketClient() {
+    close();
+
+    if (m_ctx)
+        SSL_CTX_free(m_ctx);
+}
+
+void WebSocketClient::setCaFile(const string& path) {
+    m_caFile = path;
+}
+
+bool WebSocketClient::connect(bool tls, const string& host, const string& port, const string& target,
+                              const vector<string>& headers, int timeoutMs) {
+    close();
+    m_error.clear();
+
+    if (!connectTcp(host, port, timeoutMs))
+        return false;
+
+    if (tls && !connectTls(host))
+        return false;
+
+    if (!upgrade(host, target, headers))
+        return false;
+
+    // the handshake is done, everything else goes through the owner's poll loop
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+    m_open = true;
+
+    return true;
+}
+
+bool WebSocketClient::connectTcp(const string& host, const string& port, int timeoutMs) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* addrs = nullptr;
+    auto ret = getaddrinfo(host.c_str(), port.c_str(), &hints, &addrs);
+    if (ret != 0)
+        return fail("unable to resolve " + host + ": " + gai_strerror(ret));
+
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+    for (auto* addr = addrs; addr; addr = addr->ai_next) {
+        m_fd = socket(addr->ai_family, addr->ai_socktype | SOCK_CLOEXEC, addr->ai_protocol);
+        if (m_fd == -1)
+            continue;
+
+        // also bounds the blocking TLS and HTTP handshakes that follow
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(m_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        if (::connect(m_fd, addr->ai_addr, addr->ai_addrlen) == 0)
+            break;
+
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    freeaddrinfo(addrs);
+
+    if (m_fd == -1)
+        return fail("unable to connect to " + host + ":" + port);
+
+    // audio goes out in small frames that should not wait for Nagle
+    int one = 1;
+    setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    return true;
+}
+
+bool WebSocketClient::connectTls(const string& host) {
+    if (!m_ctx) {
+        m_ctx = SSL_CTX_new(TLS_client_method());
+        if (!m_ctx)
+            return fail("unable to create TLS context");
+
+        SSL_CTX_set_min_proto_version(m_ctx, TLS1_2_VERSION);
+        SSL_CTX_set_verify(m_ctx, SSL_VERIFY_PEER, nullptr);
+
+        auto loaded = m_caFile.empty() ? SSL_CTX_set_default_verify_paths(m_ctx)
+                                       : SSL_CTX_load_verify_locations(m_ctx, m_caFile.c_str(), nullptr);
+        if (loaded != 1)
+            return fail("unable to load trusted certificates");
+    }
+
+    m_ssl = SSL_new(m_ctx);
+    SSL_set_fd(m_ssl, m_fd);
+    SSL_set_tlsext_host_name(m_ssl, host.c_str());
+    SSL_set1_host(m_ssl, host.c_str());
+
+    // flush() retries from wherever the output buffer has moved to
+    SSL_set_mode(m_ssl, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    if (SSL_connect(m_ssl) != 1) {
+        char reason[256];
+        ERR_error_string_n(ERR_get_error(), reason, sizeof(reason));
+        return fail("TLS handshake with " + host + " failed: " + reason);
+    }
+
+    return true;
+}
+
+bool WebSocketClient::upgrade(const string& host, const string& target, const vector<string>& headers) {
+    unsigned char nonce[16];
+    RAND_bytes(nonce, sizeof(nonce));
+    auto key = base64(nonce, sizeof(nonce));
+
+    string request = "GET " + target + " HTTP/1.1\r\n"
+                     "Host: " + host + "\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Key: " + key + "\r\n"
+                     "Sec-WebSocket-Version: 13\r\n";
+    for (auto& header : headers)
+        request += header + "\r\n";
+    request += "\r\n";
+
+    if (!writeAll(request))
+        return fail("unable to send the websocket upgrade to " + host);
+
+    string response;
+    size_t end;
+    char buf[1024];
+
+    while ((end = response.find("\r\n\r\n")) == string::npos) {
+        if (response.size() > c_maxHeader)
+            return fail("websocket upgrade response from " + host + " is too large");
+
+        auto n = readSome(buf, sizeof(buf));
+        if (n <= 0)
+            return fail("no websocket upgrade response from " + host);
+
+        response.append(buf, n);
+    }
+
+    // frames may follow the headers in the same read
+    m_in = response.substr(end + 4);
+    response.resize(end);
+
+    auto status = response.substr(0, response.find("\r\n"));
+    if (status.find(" 101") == string::npos)
+        return fail("websocket upgrade refused by " + host + ": " + status);
+
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    auto expected = key + c_acceptGuid;
+    SHA1(reinterpret_cast<const unsigned char*>(expected.data()), expected.size(), digest);
+    auto accept = base64(digest, sizeof(digest));
+
+    string lower = response;
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+    auto pos = lower.find("\r\nsec-websocket-accept:");
+    if (pos == string::npos)
+        return fail("websocket upgrade response from " + host + " has no accept key");
+
+    auto value = response.substr(pos + 23, response.find("\r\n", pos + 2) - pos - 23);
+    value.erase(0, value.find_first_not_of(" \t"));
+    value.erase(value.find_last_not_of(" \t") + 1);
+
+    if (value != accept)
+        return fail("websocket upgrade response from " + host + " has a wrong accept key");
+
+    return true;
+}
+
+ssize_t WebSocketClient::readSome(char* buf, size_t len) {
+    if (!m_ssl) {
+        auto n = ::recv(m_fd, buf, len, 0);
+        if (n == -1 && errno == EWOULDBLOCK)
+            errno = EAGAIN;
+        return n;
+    }
+
+    auto n = SSL_read(m_ssl, buf, len);
+    if (n > 0)
+        return n;
+
+    switch (SSL_get_error(m_ssl, n)) {
+        case SSL_ERROR_WANT_READ:
+        case SSL_ERROR_WANT_WRITE:
+            errno = EAGAIN;
+            return -1;
+        case SSL_ERROR_ZERO_RETURN:
+            return 0;
+        default:
+            errno = EIO;
+            return -1;
+    }
+}
+
+ssize_t WebSocketClient::writeSome(const char* buf, size_t len) {
+    if (!m_ssl) {
+        auto n = ::send(m_fd, buf, len, MSG_NOSIGNAL);
+        if (n == -1 && errno == EWOULDBLOCK)
+            errno = EAGAIN;
+        return n;
+    }
+
+    auto n = SSL_write(m_ssl, buf, len);
+    if (n > 0)
+        return n;
+
+    switch (SSL_get_error(m_ssl, n)) {
+        case SSL_ERROR_WANT_READ:
+        case SSL_ERROR_WANT_WRITE:
+            errno = EAGAIN;
+            return -1;
+        default:
+            errno = EIO;
+            return -1;
+    }
+}
+
+bool WebSocketClient::writeAll(const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        auto n = writeSome(data.data() + sent, data.size() - sent);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        sent += n;
+    }
+
+    return true;
+}
+
+void WebSocketClient::queueFrame(Opcode opcode, const char* buf, size_t len) {
+    // compact once most of the buffer has been written
+    if (m_outOffset > 0 && m_outOffset >= m_out.size() / 2) {
+        m_out.erase(0, m_outOffset);
+        m_outOffset = 0;
+    }
+
+    unsigned char header[14];
+    size_t headerLen = 2;
+
+    header[0] = 0x80 | static_cast<uint8_t>(opcode);
+    if (len < 126) {
+        header[1] = 0x80 | len;
+    } else if (len <= 0xFFFF) {
+        header[1] = 0x80 | 126;
+        header[2] = len >> 8;
+        header[3] = len;
+        headerLen = 4;
+    } else {
+        header[1] = 0x80 | 127;
+        for (int i = 0; i < 8; i++)
+            header[2 + i] = static_cast<uint64_t>(len) >> (56 - 8 * i);
+        headerLen = 10;
+    }
+
+    // clients must mask every frame
+    unsigned char* mask = header + headerLen;
+    RAND_bytes(mask, 4);
+    headerLen += 4;
+
+    auto start = m_out.size();
+    m_out.append(reinterpret_cast<char*>(header), headerLen);
+    m_out.append(buf, len);
+
+    auto* payload = m_out.data() + start + headerLen;
+    for (size_t i = 0; i < len; i++)
+        payload[i] ^= mask[i & 3];
+}
+
+bool WebSocketClient::sendBinary(const char* buf, size_t len) {
+    if (!m_open)
+        return false;
+
+    queueFrame(Opcode::Binary, buf, len);
+    return true;
+}
+
+bool WebSocketClient::sendText(const string& text) {
+    if (!m_open)
+        return false;
+
+    queueFrame(Opcode::Text, text.data(), text.size());
+    return true;
+}
+
+bool WebSocketClient::flush() {
+    while (m_open && m_outOffset < m_out.size()) {
+        auto n = writeSome(m_out.data() + m_outOffset, m_out.size() - m_outOffset);
+        if (n == -1 && errno == EINTR)
+            continue;
+
+        if (n == -1 && errno == EAGAIN)
+            return true;
+
+        if (n <= 0)
+            return fail("websocket write failed");
+
+        m_outOffset += n;
+    }
+
+    m_out.clear();
+    m_outOffset = 0;
+    return m_open;
+}
+
+bool WebSocketClient::receive(vector<Message>& messages) {
+    if (!m_open)
+        return false;
+
+    char buf[c_readSize];
+    for (;;) {
+        auto n = readSome(buf, sizeof(buf));
+        if (n == -1 && errno == EINTR)
+            continue;
+
+        if (n == -1 && errno == EAGAIN)
+            break;
+
+        if (n <= 0) {
+            parse(messages);
+            return fail("websocket closed by the server");
+        }
+
+        m_in.append(buf, n);
+    }
+
+    return parse(messages);
+}
+
+bool WebSocketClient::parse(vector<Message>& messages) {
+    size_t pos = 0;
+
+    while (m_in.size() - pos >= 2) {
+        auto* data = reinterpret_cast<const unsigned char*>(m_in.data() + pos);
+        auto available = m_in.size() - pos;
+
+        auto fin = data[0] & 0x80;
+        auto opcode = static_cast<Opcode>(data[0] & 0x0F);
+        auto masked = data[1] & 0x80;
+        uint64_t len = data[1] & 0x7F;
+        size_t headerLen = 2;
+
+        if (len == 126) {
+            if (available < 4) break;
+            len = (data[2] << 8) | data[3];
+            headerLen = 4;
+        } else if (len == 127) {
+            if (available < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; i++)
+                len = (len << 8) | data[2 + i];
+            headerLen = 10;
+        }
+
+        if (masked)
+            headerLen += 4;
+
+        if (len > c_maxMessage)
+            return fail("websocket message too large");
+
+        if (available < headerLen + len)
+            break;
+
+        string payload(m_in.data() + pos + headerLen, len);
+        if (masked)
+            for (size_t i = 0; i < len; i++)
+                payload[i] ^= data[headerLen - 4 + (i & 3)];
+
+        pos += headerLen + len;
+
+        switch (opcode) {
+            case Opcode::Ping:
+                queueFrame(Opcode::Pong, payload.data(), payload.size());
+                break;
+            case Opcode::Pong:
+                break;
+            case Opcode::Close:
+                m_in.erase(0, pos);
+                queueFrame(Opcode::Close, payload.data(), min<size_t>(payload.size(), 2));
+                flush();
+                return fail("websocket closed by the server");
+            case Opcode::Text:
+            case Opcode::Binary:
+            case Opcode::Continuation:
+                if (opcode != Opcode::Continuation) {
+                    m_fragments.clear();
+                    m_fragmentText = opcode == Opcode::Text;
+                }
+
+                m_fragments += payload;
+                if (m_fragments.size() > c_maxMessage)
+                    return fail("websocket message too large");
+
+                if (fin) {
+                    messages.push_back({m_fragmentText, std::move(m_fragments)});
+                    m_fragments.clear();
+                }
+                break;
+            default:
+                return fail("unknown websocket opcode");
+        }
+    }
+
+    m_in.erase(0, pos);
+    return true;
+}
+
+void WebSocketClient::close() {
+    if (m_open) {
+        // 1000, normal closure
+        const char code[2] = {0x03, static_cast<char>(0xE8)};
+        queueFrame(Opcode::Close, code, sizeof(code));
+        flush();
+    }
+    m_open = false;
+
+    if (m_ssl) {
+        SSL_shutdown(m_ssl);
+        SSL_free(m_ssl);
+        m_ssl = nullptr;
+    }
+
+    if (m_fd != -1) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    m_out.clear();
+    m_outOffset = 0;
+    m_in.clear();
+    m_fragments.clear();
+}
+
+bool WebSocketClient::fail(const string& error) {
+    m_error = error;
+    m_open = false;
+    return false;
+}
+
+string WebSocketClient::base64(const unsigned char* buf, size_t len) {
+    string out(4 * ((len + 2) / 3), '\0');
+    auto n = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(out.data()), buf, len);
+    out.resize(n);
+    return out;
+}
+
+bool WebSocketClient::wantsWrite() const {
+    return m_outOffset < m_out.size();
+}
+
+size_t WebSocketClient::pending() const {
+    return m_out.size() - m_outOffset;
+}
+
+bool WebSocketClient::isOpen() const {
+    return m_open;
+}
+
+int WebSocketClient::fd() const {
+    return m_fd;
+}
+
+const string& WebSocketClient::error() const {
+    return m_error;
+}
@@ -0,0 +1,137 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_WEBSOCKETCLIENT_H
+#define MEETING_SDK_LINUX_SAMPLE_WEBSOCKETCLIENT_H
+
+#include <sys/socket.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <openssl/ssl.h>
+
+#include "../util/Log.h"
+
+using namespace std;
+
+/**
+ * Client side of RFC 6455 over TCP, optionally TLS through OpenSSL.
+ *
+ * connect() does the TCP, TLS and HTTP upgrade handshakes blocking with a timeout, which
+ * is fine on the egress thread that owns the client. From then on the socket is
+ * non-blocking and driven by its owner's poll loop: sends are masked into an output
+ * buffer that flush() writes as far as the socket takes it, and receive() returns every
+ * complete message, answering pings and close frames on its own.
+ */
+class WebSocketClient {
+public:
+    enum class Opcode : uint8_t {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        Close = 0x8,
+        Ping = 0x9,
+        Pong = 0xA
+    };
+
+    struct Message {
+        bool text = true;
+        string data;
+    };
+
+private:
+    const size_t c_readSize = 16 * 1024;
+    const size_t c_maxHeader = 16 * 1024;
+    const size_t c_maxMessage = 1024 * 1024;
+
+    int m_fd = -1;
+    SSL_CTX* m_ctx = nullptr;
+    SSL* m_ssl = nullptr;
+    string m_caFile;
+
+    bool m_open = false;
+    string m_error;
+
+    string m_out;
+    size_t m_outOffset = 0;
+
+    string m_in;
+    string m_fragments;
+    bool m_fragmentText = false;
+
+    bool connectTcp(const string& host, const string& port, int timeoutMs);
+    bool connectTls(const string& host);
+    bool upgrade(const string& host, const string& target, const vector<string>& headers);
+
+    ssize_t readSome(char* buf, size_t len);
+    ssize_t writeSome(const char* buf, size_t len);
+    bool writeAll(const string& data);
+
+    void queueFrame(Opcode opcode, const char* buf, size_t len);
+    bool parse(vector<Message>& messages);
+    bool fail(const string& error);
+
+    static string base64(const unsigned char* buf, size_t len);
+
+public:
+    WebSocketClient() = default;
+    ~WebSocketClient();
+
+    WebSocketClient(const WebSocketClient&) = delete;
+    WebSocketClient& operator=(const WebSocketClient&) = delete;
+
+    /**
+     * Trust only this CA bundle instead of the system store, e.g. for a self-hosted endpoint
+     */
+    void setCaFile(const string& path);
+
+    /**
+     * Open a connection and upgrade it to a websocket
+     * @param tls wss instead of ws
+     * @param host server name, also checked against its certificate
+     * @param port TCP port
+     * @param target request path with query string
+     * @param headers extra request header lines without line break, e.g. "Authorization: Token ..."
+     * @param timeoutMs bound on each step of the handshake
+     * @return false with error() set if any step fails
+     */
+    bool connect(bool tls, const string& host, const string& port, const string& target,
+                 const vector<string>& headers, int timeoutMs);
+
+    bool sendBinary(const char* buf, size_t len);
+    bool sendText(const string& text);
+
+    /**
+     * Read whatever the socket has and parse it into messages
+     * @return false once the connection is gone, after appending the messages it delivered
+     */
+    bool receive(vector<Message>& messages);
+
+    /**
+     * Write queued frames until the socket would block
+     * @return false if the connection failed
+     */
+    bool flush();
+
+    /**
+     * Send a close frame if still open, then tear the connection down
+     */
+    void close();
+
+    bool wantsWrite() const;
+    size_t pending() const;
+    bool isOpen() const;
+    int fd() const;
+    const string& error() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_WEBSOCKETCLIENT_H
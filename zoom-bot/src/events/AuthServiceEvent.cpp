@@ -36,6 +36,15 @@ void AuthServiceEvent::onAuthenticationReturn(AuthResult result) {
     return;
 }
 
+void AuthServiceEvent::onZoomAuthIdentityExpired() {
+    if (m_onZoomAuthIdentityExpired)
+        m_onZoomAuthIdentityExpired();
+}
+
+void AuthServiceEvent::setOnZoomAuthIdentityExpired(const function<void()>& callback) {
+    m_onZoomAuthIdentityExpired = callback;
+}
+
 void AuthServiceEvent::setOnAuthenticationReturn(const function<void(AuthResult)>& callback) {
     m_onAuthenticationReturn = callback;
 }
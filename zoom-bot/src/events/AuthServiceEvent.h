@@ -53,11 +53,12 @@ public:
      * callback used when Zoom authentication identity will be expired in 10 minutes
      * when triggered please re-auth
      */
-    void onZoomAuthIdentityExpired() override {};
+    void onZoomAuthIdentityExpired() override;
 
     /* Setters for Callbacks */
     void setOnAuth(const function<void()> callback);
     void setOnAuthenticationReturn(const function<void(AuthResult)>& callback);
+    void setOnZoomAuthIdentityExpired(const function<void()>& callback);
 };
 
 
@@ -0,0 +1,19 @@
+#include "MeetingAudioCtrlEvent.h"
+
+void MeetingAudioCtrlEvent::onUserActiveAudioChange(IList<unsigned int>* plstActiveAudio) {
+    if (!m_onActiveAudioChange)
+        return;
+
+    vector<unsigned int> ids;
+    if (plstActiveAudio) {
+        ids.reserve(plstActiveAudio->GetCount());
+        for (int i = 0; i < plstActiveAudio->GetCount(); i++)
+            ids.push_back(plstActiveAudio->GetItem(i));
+    }
+
+    m_onActiveAudioChange(ids);
+}
+
+void MeetingAudioCtrlEvent::setOnActiveAudioChange(const function<void(const vector<unsigned int>&)>& callback) {
+    m_onActiveAudioChange = callback;
+}
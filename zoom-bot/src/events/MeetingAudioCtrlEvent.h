@@ -0,0 +1,36 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_MEETINGAUDIOCTRLEVENT_H
+#define MEETING_SDK_LINUX_SAMPLE_MEETINGAUDIOCTRLEVENT_H
+
+#include <iostream>
+#include <functional>
+#include <vector>
+#include "meeting_service_components/meeting_audio_interface.h"
+
+using namespace std;
+using namespace ZOOMSDK;
+
+class MeetingAudioCtrlEvent : public IMeetingAudioCtrlEvent {
+    function<void(const vector<unsigned int>&)> m_onActiveAudioChange;
+
+public:
+    MeetingAudioCtrlEvent() {};
+    ~MeetingAudioCtrlEvent() {};
+
+    void onUserAudioStatusChange(IList<IUserAudioStatus*>* lstAudioStatusChange, const zchar_t* strAudioStatusList = nullptr) override {};
+
+    /**
+     * Fires when the users who are talking change
+     * @param plstActiveAudio user IDs of everyone talking right now
+     */
+    void onUserActiveAudioChange(IList<unsigned int>* plstActiveAudio) override;
+
+    void onHostRequestStartAudio(IRequestStartAudioHandler* handler_) override {};
+    void onJoin3rdPartyTelephonyAudio(const zchar_t* audioInfo) override {};
+    void onMuteOnEntryStatusChange(bool bEnabled) override {};
+
+    /* Setters for Callbacks */
+    void setOnActiveAudioChange(const function<void(const vector<unsigned int>&)>& callback);
+};
+
+
+#endif //MEETING_SDK_LINUX_SAMPLE_MEETINGAUDIOCTRLEVENT_H
@@ -0,0 +1,31 @@
+#include "MeetingParticipantsCtrlEvent.h"
+
+vector<unsigned int> MeetingParticipantsCtrlEvent::toVector(IList<unsigned int>* list) {
+    vector<unsigned int> ids;
+    if (!list)
+        return ids;
+
+    ids.reserve(list->GetCount());
+    for (int i = 0; i < list->GetCount(); i++)
+        ids.push_back(list->GetItem(i));
+
+    return ids;
+}
+
+void MeetingParticipantsCtrlEvent::onUserJoin(IList<unsigned int>* lstUserID, const zchar_t* strUserList) {
+    if (m_onUserJoin)
+        m_onUserJoin(toVector(lstUserID));
+}
+
+void MeetingParticipantsCtrlEvent::onUserLeft(IList<unsigned int>* lstUserID, const zchar_t* strUserList) {
+    if (m_onUserLeft)
+        m_onUserLeft(toVector(lstUserID));
+}
+
+void MeetingParticipantsCtrlEvent::setOnUserJoin(const function<void(const vector<unsigned int>&)>& callback) {
+    m_onUserJoin = callback;
+}
+
+void MeetingParticipantsCtrlEvent::setOnUserLeft(const function<void(const vector<unsigned int>&)>& callback) {
+    m_onUserLeft = callback;
+}
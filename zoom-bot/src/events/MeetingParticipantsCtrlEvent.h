@@ -0,0 +1,64 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_MEETINGPARTICIPANTSCTRLEVENT_H
+#define MEETING_SDK_LINUX_SAMPLE_MEETINGPARTICIPANTSCTRLEVENT_H
+
+#include <iostream>
+#include <functional>
+#include <vector>
+#include "meeting_service_components/meeting_participants_ctrl_interface.h"
+
+using namespace std;
+using namespace ZOOMSDK;
+
+class MeetingParticipantsCtrlEvent : public IMeetingParticipantsCtrlEvent {
+    function<void(const vector<unsigned int>&)> m_onUserJoin;
+    function<void(const vector<unsigned int>&)> m_onUserLeft;
+
+    static vector<unsigned int> toVector(IList<unsigned int>* list);
+
+public:
+    MeetingParticipantsCtrlEvent() {};
+    ~MeetingParticipantsCtrlEvent() {};
+
+    /**
+     * Fires when users join the meeting
+     * @param lstUserID list of user IDs that joined
+     * @param strUserList user list in json format
+     */
+    void onUserJoin(IList<unsigned int>* lstUserID, const zchar_t* strUserList = nullptr) override;
+
+    /**
+     * Fires when users leave the meeting
+     * @param lstUserID list of user IDs that left
+     * @param strUserList user list in json format
+     */
+    void onUserLeft(IList<unsigned int>* lstUserID, const zchar_t* strUserList = nullptr) override;
+
+    void onHostChangeNotification(unsigned int userId) override {};
+    void onLowOrRaiseHandStatusChanged(bool bLow, unsigned int userid) override {};
+    void onUserNamesChanged(IList<unsigned int>* lstUserID) override {};
+    void onCoHostChangeNotification(unsigned int userId, bool isCoHost) override {};
+    void onInvalidReclaimHostkey() override {};
+    void onAllHandsLowered() override {};
+    void onLocalRecordingStatusChanged(unsigned int user_id, RecordingStatus status) override {};
+    void onAllowParticipantsRenameNotification(bool bAllow) override {};
+    void onAllowParticipantsUnmuteSelfNotification(bool bAllow) override {};
+    void onAllowParticipantsStartVideoNotification(bool bAllow) override {};
+    void onAllowParticipantsShareWhiteBoardNotification(bool bAllow) override {};
+    void onRequestLocalRecordingPrivilegeChanged(LocalRecordingRequestPrivilegeStatus status) override {};
+    void onAllowParticipantsRequestCloudRecording(bool bAllow) override {};
+    void onInMeetingUserAvatarPathUpdated(unsigned int userID) override {};
+    void onParticipantProfilePictureStatusChange(bool bHidden) override {};
+    void onFocusModeStateChanged(bool bEnabled) override {};
+    void onFocusModeShareTypeChanged(FocusModeShareType type) override {};
+    void onRobotRelationChanged(unsigned int authorizeUserID) override {};
+    void onVirtualNameTagStatusChanged(bool bOn, unsigned int userID) override {};
+    void onVirtualNameTagRosterInfoUpdated(unsigned int userID) override {};
+    void onGrantCoOwnerPrivilegeChanged(bool canGrantOther) override {};
+
+    /* Setters for Callbacks */
+    void setOnUserJoin(const function<void(const vector<unsigned int>&)>& callback);
+    void setOnUserLeft(const function<void(const vector<unsigned int>&)>& callback);
+};
+
+
+#endif //MEETING_SDK_LINUX_SAMPLE_MEETINGPARTICIPANTSCTRLEVENT_H
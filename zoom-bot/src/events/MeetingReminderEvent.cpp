@@ -2,11 +2,11 @@
 
 void MeetingReminderEvent::onReminderNotify(IMeetingReminderContent* content, IMeetingReminderHandler* handle) {
     if (content) {
-        cout << "Reminder Notification Received" << endl;
-        cout << "Type: " << content->GetType() << endl;
-        cout << "Title: " << content->GetTitle() << endl;
-        cout << "Content: " << content->GetContent() << endl;
-        cout << "Is Blocking?: " << content->IsBlocking() << endl;
+        Log::info("Reminder Notification Received");
+        Log::info("Type: ", content->GetType());
+        Log::info("Title: ", content->GetTitle());
+        Log::info("Content: ", content->GetContent());
+        Log::info("Is Blocking?: ", content->IsBlocking());
     }
 
     if (handle)
@@ -6,6 +6,8 @@
 #include <iostream>
 #include "meeting_service_components/meeting_reminder_ctrl_interface.h"
 
+#include "../util/Log.h"
+
 using namespace std;
 using namespace ZOOMSDK;
 
@@ -1,6 +1,9 @@
 #include "MeetingServiceEvent.h"
 
 void MeetingServiceEvent::onMeetingStatusChanged(MeetingStatus status, int iResult) {
+    if (m_onStatus)
+        m_onStatus(status, iResult);
+
     if (m_onMeetingStatusChanged) {
         m_onMeetingStatusChanged(status, iResult);
         return;
@@ -51,3 +54,7 @@ void MeetingServiceEvent::setOnMeetingEnd(const function<void()>& callback) {
 void MeetingServiceEvent::setOnMeetingStatusChanged(const function<void(MeetingStatus, int)>& callback) {
     m_onMeetingStatusChanged = callback;
 }
+
+void MeetingServiceEvent::setOnStatus(const function<void(MeetingStatus, int)>& callback) {
+    m_onStatus = callback;
+}
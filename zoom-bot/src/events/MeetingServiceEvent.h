@@ -16,6 +16,7 @@ class MeetingServiceEvent : public IMeetingServiceEvent {
     function<void()> m_onMeetingJoin;
     function<void()> m_onMeetingEnd;
     function<void(MeetingStatus status, int iResult)> m_onMeetingStatusChanged;
+    function<void(MeetingStatus status, int iResult)> m_onStatus;
 
 public:
     MeetingServiceEvent() {};
@@ -78,6 +79,11 @@ public:
     void setOnMeetingJoin(const function<void()>& callback);
     void setOnMeetingEnd(const function<void()>& callback);
     void setOnMeetingStatusChanged(const function<void(MeetingStatus, int)>& callback);
+
+    /**
+     * Observe every status change without replacing the default handling
+     */
+    void setOnStatus(const function<void(MeetingStatus, int)>& callback);
 };
 
 #endif //MEETING_SDK_LINUX_SAMPLE_MEETINGSERVICEEVENT_H
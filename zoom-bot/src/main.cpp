@@ -1,5 +1,6 @@
 #include <csignal>
 #include <glib.h>
+#include <glib-unix.h>
 #include "Config.h"
 #include "Zoom.h"
 
@@ -9,17 +10,26 @@
  */
 void onExit() {
     auto* zoom = &Zoom::getInstance();
+
+    // the media goes out before the meeting ends, which would take the callbacks with it
+    zoom->drain();
     zoom->leave();
     zoom->clean();
 
-    cout << "exiting..." << endl;
+    Log::info("exiting...");
+    Log::flush();
 }
 
 /**
- * Callback fired when a signal is trapped
- * @param signal type of signal
+ * Callback fired on the event loop when SIGINT or SIGTERM is trapped, so the drain is not
+ * limited to what a signal handler may do
+ * @param data type of signal
+ * @return nothing, the process exits here
  */
-void onSignal(int signal) {
+gboolean onSignal(gpointer data) {
+    auto signal = GPOINTER_TO_INT(data);
+    Log::info("received signal ", signal, ", shutting down");
+
     onExit();
     _Exit(signal);
 }
@@ -44,8 +54,8 @@ SDKError run(int argc, char** argv) {
     SDKError err{SDKERR_SUCCESS};
     auto* zoom = &Zoom::getInstance();
 
-    signal(SIGINT, onSignal);
-    signal(SIGTERM, onSignal);
+    // a dead encoder or socket client should fail the write, not end the process
+    signal(SIGPIPE, SIG_IGN);
 
     atexit(onExit);
 
@@ -54,6 +64,14 @@ SDKError run(int argc, char** argv) {
     if (Zoom::hasError(err, "configure"))
         return err;
 
+    // fork meeting workers before the SDK starts any threads; only workers return here
+    if (zoom->isSupervisor())
+        zoom->supervise();
+
+    // the supervisor takes them from its own signalfd, a worker from here on
+    g_unix_signal_add(SIGINT, onSignal, GINT_TO_POINTER(SIGINT));
+    g_unix_signal_add(SIGTERM, onSignal, GINT_TO_POINTER(SIGTERM));
+
     // initialize the Zoom SDK
     err = zoom->init();
     if(Zoom::hasError(err, "initialize"))
@@ -74,6 +92,8 @@ int main(int argc, char **argv) {
     if (Zoom::hasError(err))
         return err;
 
+    ThreadRoles::assign(ThreadRole::Control);
+
     // Use an event loop to receive callbacks
     GMainLoop* eventLoop;
     eventLoop = g_main_loop_new(NULL, FALSE);
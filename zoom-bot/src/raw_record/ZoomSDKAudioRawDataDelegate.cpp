@@ -1,28 +1,341 @@
 #include "ZoomSDKAudioRawDataDelegate.h"
 
+#include <algorithm>
+
+#include <picojson/picojson.h>
+
+#include "../util/ThreadRoles.h"
+
 
 ZoomSDKAudioRawDataDelegate::ZoomSDKAudioRawDataDelegate(bool useMixedAudio = true, bool transcribe = false) : m_useMixedAudio(useMixedAudio), m_transcribe(transcribe){
+    m_emit = [this](const FrameHeader& header, const char* buf, size_t len) {
+        emit(header, buf, len);
+    };
+}
+
+void ZoomSDKAudioRawDataDelegate::start() {
     if (m_transcribe) {
         Log::info("Starting socket server for audio transcription...");
         server.start();
     }
+
+    if (m_transcribe && m_jitterOptions.enabled()) {
+        m_jitter = make_unique<JitterBuffer>(m_jitterOptions, [this](const FrameHeader& header, const char* buf, size_t len) {
+            forwardPaced(header, buf, len);
+        });
+
+        if (!m_jitter->start())
+            m_jitter.reset();
+    }
+
+    if (m_sink && !m_sink->start())
+        m_sink.reset();
+
+    if (m_keywordOptions.enabled()) {
+        m_keywords = KeywordSpotter::load(m_keywordOptions, m_onKeyword);
+        if (m_keywords)
+            m_keywords->start();
+    }
+
+    auto& codec = m_transcribe ? m_socketCodec : m_fileCodec;
+    if (codec.codec != AudioCodec::Pcm) {
+        if (m_transcribe)
+            m_encoder = make_unique<EncoderStage>(codec, [this](const FrameHeader& header, const char* buf, size_t len) {
+                server.writeFrame(header, buf, len);
+            });
+        else
+            m_encoder = make_unique<EncoderStage>(codec,
+                [this](const FrameHeader& header, const char* buf, size_t len) { writeEncoded(header, buf, len); },
+                [this](StreamType stream, uint32_t nodeId) { closeEncoded(stream, nodeId); });
+
+        m_encoder->start();
+    }
+}
+
+void ZoomSDKAudioRawDataDelegate::setEncoding(const EncoderOptions& socket, const EncoderOptions& file) {
+    m_socketCodec = socket;
+    m_fileCodec = file;
+}
+
+void ZoomSDKAudioRawDataDelegate::setDeepgram(const DeepgramOptions& options) {
+    if (!options.enabled)
+        return;
+
+    m_sink = make_unique<DeepgramSink>(options);
+    m_sink->setOnTranscript([this](const string& json) {
+        FrameHeader header;
+        header.stream = StreamType::Transcript;
+        header.format = PayloadFormat::Json;
+
+        server.writeMessage(header, json);
+    });
+}
+
+void ZoomSDKAudioRawDataDelegate::setKeywords(const KeywordOptions& options, const KeywordSpotter::Trigger& onKeyword) {
+    m_keywordOptions = options;
+    m_onKeyword = onKeyword;
+}
+
+void ZoomSDKAudioRawDataDelegate::emit(const FrameHeader& header, const char* buf, size_t len) {
+    // the encoder thread is the ring's only producer then
+    if (m_encoder)
+        m_encoder->write(header, buf, len);
+    else
+        server.writeFrame(header, buf, len);
+
+    if (m_sink && header.stream == StreamType::Mixed)
+        m_sink->write(header, buf, len);
+}
+
+void ZoomSDKAudioRawDataDelegate::setJitter(const JitterOptions& options) {
+    m_jitterOptions = options;
+}
+
+void ZoomSDKAudioRawDataDelegate::setRingOptions(size_t slots, OverflowPolicy policy) {
+    server.configureRing(slots, policy);
+}
+
+void ZoomSDKAudioRawDataDelegate::setSocketPath(const string& path) {
+    server.configurePath(path);
+}
+
+void ZoomSDKAudioRawDataDelegate::setSubscriberOptions(size_t queue, OverflowPolicy policy) {
+    server.configureSubscribers(queue, policy);
+}
+
+void ZoomSDKAudioRawDataDelegate::setOutputRate(unsigned int rate) {
+    m_outputRate = rate;
+}
+
+void ZoomSDKAudioRawDataDelegate::setParticipantAudio(bool participants) {
+    if (m_transcribe)
+        m_streamParticipants = participants;
+    else
+        m_useMixedAudio = !participants;
+}
+
+void ZoomSDKAudioRawDataDelegate::setStreamParticipants(bool enabled, unsigned int batchMs) {
+    m_streamParticipants = enabled;
+    if (enabled)
+        server.configureBatching(batchMs);
+}
+
+size_t ZoomSDKAudioRawDataDelegate::resample(unique_ptr<Resampler>& resampler, const FrameHeader& header,
+                                             const char* buf, size_t len, unsigned int outRate) {
+    auto rate = header.sampleRate;
+    auto channels = header.channels;
+
+    if (!resampler || !resampler->accepts(rate, channels) || resampler->outRate() != outRate) {
+        resampler = make_unique<Resampler>(rate, channels, outRate);
+
+        // participants share the format of the mixed stream, logging it once is enough
+        if (&resampler == &m_resampler)
+            Log::info("resampling ", rate, "Hz/", channels, "ch audio to ", outRate, "Hz mono (",
+                      AudioKernels::isa(), ")");
+    }
+
+    auto frames = len / (sizeof(int16_t) * channels);
+    return resampler->process(reinterpret_cast<const int16_t*>(buf), frames, m_resampled);
+}
+
+void ZoomSDKAudioRawDataDelegate::setVad(const VadOptions& mixed, const VadOptions& participants) {
+    m_mixedVad = mixed;
+    m_participantVad = participants;
+}
+
+void ZoomSDKAudioRawDataDelegate::setOnFirstAudio(const function<void()>& callback) {
+    m_onFirstAudio = callback;
+    m_firstAudioPending.store(true, memory_order_release);
+}
+
+void ZoomSDKAudioRawDataDelegate::setSegments(const SegmentOptions& options, const SegmentSequence::Finished& onFinished) {
+    m_segmentOptions = options;
+    m_onSegment = onFinished;
+}
+
+void ZoomSDKAudioRawDataDelegate::stream(FrameHeader header, unique_ptr<Resampler>& resampler, unique_ptr<VadGate>& gate,
+                                         const VadOptions& vad, AudioRawData* data) {
+    header.sampleRate = data->GetSampleRate();
+    header.channels = data->GetChannelNum();
+    header.timestamp = FrameHeader::now();
+
+    stream(header, resampler, gate, vad, data->GetBuffer(), data->GetBufferLen());
+}
+
+void ZoomSDKAudioRawDataDelegate::stream(FrameHeader header, unique_ptr<Resampler>& resampler, unique_ptr<VadGate>& gate,
+                                         const VadOptions& vad, const char* buf, size_t len) {
+    // the buffer's thread picks the resampler and gate again by stream and node
+    if (m_jitter)
+        return m_jitter->write(header, buf, len);
+
+    forward(header, resampler, gate, vad, buf, len);
+}
+
+void ZoomSDKAudioRawDataDelegate::forwardPaced(const FrameHeader& header, const char* buf, size_t len) {
+    if (header.stream == StreamType::Mixed)
+        return forward(header, m_resampler, m_mixedGate, m_mixedVad, buf, len);
+
+    lock_guard<mutex> lock(m_writersMutex);
+
+    // the participant may have left while the chunk was queued
+    if (header.stream == StreamType::OneWay && m_nodeResamplers.count(header.nodeId) == 0)
+        return;
+
+    forward(header, m_nodeResamplers[header.nodeId], m_nodeGates[header.nodeId], m_participantVad, buf, len);
+}
+
+void ZoomSDKAudioRawDataDelegate::forward(FrameHeader header, unique_ptr<Resampler>& resampler, unique_ptr<VadGate>& gate,
+                                          const VadOptions& vad, const char* buf, size_t len) {
+    if (m_firstAudioPending.load(memory_order_relaxed) && m_firstAudioPending.exchange(false, memory_order_acq_rel))
+        m_onFirstAudio();
+
+    auto outRate = m_outputRate.load(memory_order_relaxed);
+    if (outRate) {
+        auto samples = resample(resampler, header, buf, len, outRate);
+        header.sampleRate = outRate;
+        header.channels = 1;
+        buf = reinterpret_cast<const char*>(m_resampled.data());
+        len = samples * sizeof(int16_t);
+    }
+
+    if (vad.mode == VadMode::Off) {
+        emit(header, buf, len);
+        return;
+    }
+
+    if (!gate)
+        gate = make_unique<VadGate>(vad);
+
+    gate->process(header, buf, len, m_emit);
+}
+
+void ZoomSDKAudioRawDataDelegate::setStreamSpeakers(bool enabled, const SpeakerOptions& options) {
+    // kept even when off, so speaker mode can be switched on during the meeting
+    m_speakers = make_unique<SpeakerSelector>(options);
+    m_streamSpeakers = enabled;
+}
+
+void ZoomSDKAudioRawDataDelegate::setSpeakerAudio(bool speakers) {
+    if (!m_transcribe || !m_speakers)
+        return;
+
+    lock_guard<mutex> lock(m_writersMutex);
+    m_streamSpeakers = speakers;
+    announceSpeakers(FrameHeader::now());
+}
+
+void ZoomSDKAudioRawDataDelegate::setActiveSpeakers(const vector<pair<uint32_t, string>>& speakers) {
+    if (!m_speakers)
+        return;
+
+    vector<uint32_t> ids;
+    ids.reserve(speakers.size());
+
+    lock_guard<mutex> lock(m_writersMutex);
+    for (auto& [id, name] : speakers) {
+        ids.push_back(id);
+        if (!name.empty())
+            m_speakerNames[id] = name;
+    }
+
+    // followed even while off, so switching speaker mode on starts with who is talking
+    auto now = FrameHeader::now();
+    if (m_speakers->update(ids, now) && m_streamSpeakers)
+        announceSpeakers(now);
+}
+
+void ZoomSDKAudioRawDataDelegate::announceSpeakers(uint64_t now) {
+    auto current = m_streamSpeakers ? m_speakers->speakers() : vector<uint32_t>();
+
+    // a returning speaker starts a new turn, the resampler and gate of the last one would smear it
+    for (auto id : m_announced) {
+        if (find(current.begin(), current.end(), id) != current.end())
+            continue;
+
+        m_nodeResamplers.erase(id);
+        m_nodeGates.erase(id);
+    }
+
+    m_announced = current;
+    m_speakersAnnounced = now;
+
+    picojson::array list;
+    for (auto id : current) {
+        auto name = m_speakerNames.find(id);
+
+        picojson::object speaker;
+        speaker["node_id"] = picojson::value(static_cast<double>(id));
+        speaker["name"] = picojson::value(name == m_speakerNames.end() ? string() : name->second);
+        list.emplace_back(speaker);
+    }
+
+    picojson::object payload;
+    payload["speakers"] = picojson::value(list);
+
+    // queued next to the ring, so a new speaker's first chunks may arrive just before it
+    FrameHeader header;
+    header.stream = StreamType::Speakers;
+    header.format = PayloadFormat::Json;
+
+    server.writeMessage(header, picojson::value(payload).serialize());
+}
+
+void ZoomSDKAudioRawDataDelegate::streamSpeaker(AudioRawData* data, uint32_t nodeId) {
+    FrameHeader header;
+    header.stream = StreamType::OneWay;
+    header.nodeId = nodeId;
+    header.sampleRate = data->GetSampleRate();
+    header.channels = data->GetChannelNum();
+    header.timestamp = FrameHeader::now();
+
+    lock_guard<mutex> lock(m_writersMutex);
+
+    auto refresh = static_cast<uint64_t>(chrono::nanoseconds(c_speakersRefresh).count());
+    if (m_speakers->expire(header.timestamp) || header.timestamp - m_speakersAnnounced >= refresh)
+        announceSpeakers(header.timestamp);
+
+    // everyone else's audio is only kept for the pre-roll
+    if (!m_speakers->forwarding(nodeId))
+        return m_speakers->hold(header, data->GetBuffer(), data->GetBufferLen());
+
+    auto& resampler = m_nodeResamplers[nodeId];
+    auto& gate = m_nodeGates[nodeId];
+
+    m_speakers->drain(nodeId, header.timestamp, [&](const FrameHeader& pending, const char* buf, size_t len) {
+        stream(pending, resampler, gate, m_participantVad, buf, len);
+    });
+
+    stream(header, resampler, gate, m_participantVad, data->GetBuffer(), data->GetBufferLen());
 }
 
 void ZoomSDKAudioRawDataDelegate::onMixedAudioRawDataReceived(AudioRawData *data) {
+    ThreadRoles::assign(ThreadRole::AudioRt);
+    if (m_closed) return;
+
+    // ahead of the jitter buffer, whose delay would only add to the trigger's
+    if (m_keywords) {
+        FrameHeader header;
+        header.sampleRate = data->GetSampleRate();
+        header.channels = data->GetChannelNum();
+        header.timestamp = FrameHeader::now();
+
+        m_keywords->write(header, data->GetBuffer(), data->GetBufferLen());
+    }
+
     if (!m_useMixedAudio) return;
 
     // write to socket
     if (m_transcribe) {
         // Log audio format info periodically (every 1000 chunks)
         static int chunk_count = 0;
-        if (chunk_count++ % 1000 == 0) {
-            stringstream ss;
-            ss << "Audio format: " << data->GetSampleRate() << "Hz, "
-               << data->GetChannelNum() << " channels, "
-               << data->GetBufferLen() << " bytes/chunk";
-            Log::info(ss.str());
-        }
-        server.writeBuf(data->GetBuffer(), data->GetBufferLen());
+        if (chunk_count++ % 1000 == 0)
+            Log::info("Audio format: ", data->GetSampleRate(), "Hz, ", data->GetChannelNum(), " channels, ",
+                      data->GetBufferLen(), " bytes/chunk");
+
+        FrameHeader header;
+        header.stream = StreamType::Mixed;
+
+        stream(header, m_resampler, m_mixedGate, m_mixedVad, data);
         return;
     }
 
@@ -30,51 +343,190 @@ void ZoomSDKAudioRawDataDelegate::onMixedAudioRawDataReceived(AudioRawData *data
     if (m_dir.empty())
         return Log::error("Output Directory cannot be blank");
 
+    if (m_encoder)
+        return encodeToFile(StreamType::Mixed, 0, data);
 
-    if (m_filename.empty())
-        m_filename = "test.pcm";
-
+    if (!m_mixedWriter.isOpen()) {
+        if (m_filename.empty())
+            m_filename = "test.pcm";
 
-    stringstream path;
-    path << m_dir << "/" << m_filename;
+        if (!m_mixedWriter.open(pcmPath(m_filename), m_segmentOptions, m_onSegment))
+            return;
+    }
 
-    writeToFile(path.str(), data);
+    writeToFile(m_mixedWriter, data);
 }
 
 
 
 void ZoomSDKAudioRawDataDelegate::onOneWayAudioRawDataReceived(AudioRawData* data, uint32_t node_id) {
+    ThreadRoles::assign(ThreadRole::AudioRt);
+    if (m_closed) return;
+
+    if (m_transcribe && m_streamParticipants) {
+        lock_guard<mutex> lock(m_writersMutex);
+
+        FrameHeader header;
+        header.stream = StreamType::OneWay;
+        header.nodeId = node_id;
+
+        stream(header, m_nodeResamplers[node_id], m_nodeGates[node_id], m_participantVad, data);
+        return;
+    }
+
+    if (m_transcribe && m_streamSpeakers && m_speakers)
+        return streamSpeaker(data, node_id);
+
     if (m_useMixedAudio) return;
 
-    stringstream path;
-    path << m_dir << "/node-" << node_id << ".pcm";
-    writeToFile(path.str(), data);
+    if (m_encoder)
+        return encodeToFile(StreamType::OneWay, node_id, data);
+
+    lock_guard<mutex> lock(m_writersMutex);
+
+    auto it = m_writers.find(node_id);
+    if (it == m_writers.end()) {
+        SegmentedFileWriter writer;
+        if (!writer.open(pcmPath("node-" + to_string(node_id) + ".pcm"), m_segmentOptions, m_onSegment))
+            return;
+
+        it = m_writers.emplace(node_id, std::move(writer)).first;
+    }
+
+    writeToFile(it->second, data);
+
+    if (++m_oneWayChunks % c_idleSweepChunks == 0)
+        closeIdleWriters();
 }
 
 void ZoomSDKAudioRawDataDelegate::onShareAudioRawDataReceived(AudioRawData* data, unsigned int user_id) {
-    stringstream ss;
-    ss << "Shared Audio Raw data: " << data->GetBufferLen() / 10 << "k at " << data->GetSampleRate() << "Hz";
-    Log::info(ss.str());
+    // arrives every 10ms while someone shares audio
+    Log::debug("Shared Audio Raw data: ", data->GetBufferLen() / 10, "k at ", data->GetSampleRate(), "Hz");
+}
+
+
+void ZoomSDKAudioRawDataDelegate::encodeToFile(StreamType stream, uint32_t nodeId, AudioRawData* data) {
+    FrameHeader header;
+    header.stream = stream;
+    header.nodeId = nodeId;
+    header.sampleRate = data->GetSampleRate();
+    header.channels = data->GetChannelNum();
+    header.timestamp = FrameHeader::now();
+
+    m_encoder->write(header, data->GetBuffer(), data->GetBufferLen());
+}
+
+void ZoomSDKAudioRawDataDelegate::writeEncoded(const FrameHeader& header, const char* buf, size_t len) {
+    if (len == 0)
+        return;
+
+    auto key = static_cast<uint64_t>(header.stream) << 32 | header.nodeId;
+    auto it = m_encodedFiles.find(key);
+
+    if (it == m_encodedFiles.end()) {
+        EncodedFileWriter writer;
+        if (!writer.open(encodedPath(header), header.format, m_segmentOptions, m_onSegment))
+            return;
+
+        it = m_encodedFiles.emplace(key, std::move(writer)).first;
+    }
+
+    it->second.write(header, buf, len);
+}
+
+void ZoomSDKAudioRawDataDelegate::closeEncoded(StreamType stream, uint32_t nodeId) {
+    m_encodedFiles.erase(static_cast<uint64_t>(stream) << 32 | nodeId);
+}
+
+string ZoomSDKAudioRawDataDelegate::encodedPath(const FrameHeader& header) {
+    stringstream base;
+    base << m_dir << "/";
+
+    if (header.stream == StreamType::Mixed) {
+        auto name = m_filename.empty() ? string("test.pcm") : m_filename;
+        auto dot = name.rfind('.');
+        base << (dot == string::npos ? name : name.substr(0, dot));
+    } else {
+        base << "node-" << header.nodeId;
+    }
+
+    // a container cannot be appended to, so a participant who comes back gets a new file
+    auto part = ++m_fileParts[base.str()];
+    if (part > 1)
+        base << "-" << part;
+
+    return base.str() + EncodedFileWriter::extension(header.format);
 }
 
+string ZoomSDKAudioRawDataDelegate::pcmPath(const string& name) const {
+    if (!m_segmentOptions.enabled())
+        return m_dir + "/" + name;
+
+    // segments are played on their own, so each gets a WAV header
+    auto dot = name.rfind('.');
+    return m_dir + "/" + (dot == string::npos ? name : name.substr(0, dot)) + ".wav";
+}
 
-void ZoomSDKAudioRawDataDelegate::writeToFile(const string &path, AudioRawData *data)
+void ZoomSDKAudioRawDataDelegate::writeToFile(SegmentedFileWriter& writer, AudioRawData *data)
 {
-    static std::ofstream file;
-	file.open(path, std::ios::out | std::ios::binary | std::ios::app);
+    writer.write(data->GetBuffer(), data->GetBufferLen(), data->GetSampleRate(), data->GetChannelNum());
+}
+
+void ZoomSDKAudioRawDataDelegate::closeIdleWriters() {
+    // catches participants whose leave event we missed
+    for (auto it = m_writers.begin(); it != m_writers.end();) {
+        if (it->second.idle() > c_idleTimeout)
+            it = m_writers.erase(it);
+        else
+            ++it;
+    }
+}
+
+void ZoomSDKAudioRawDataDelegate::closeParticipant(uint32_t node_id) {
+    if (m_encoder)
+        m_encoder->close(StreamType::OneWay, node_id);
+
+    lock_guard<mutex> lock(m_writersMutex);
+    m_writers.erase(node_id);
+    m_nodeResamplers.erase(node_id);
+    m_nodeGates.erase(node_id);
+
+    if (!m_speakers)
+        return;
+
+    auto forwarded = m_speakers->forwarding(node_id);
+    m_speakers->remove(node_id);
+    m_speakerNames.erase(node_id);
+
+    if (forwarded && m_streamSpeakers)
+        announceSpeakers(FrameHeader::now());
+}
+
+void ZoomSDKAudioRawDataDelegate::close(chrono::steady_clock::time_point deadline) {
+    m_closed = true;
+
+    // a keyword heard while leaving would only trigger a reaction nobody sees
+    if (m_keywords)
+        m_keywords->stop();
+
+    // hands on what it still holds, so it goes before the encoder
+    if (m_jitter)
+        m_jitter->stop();
 
-	if (!file.is_open())
-        return Log::error("failed to open audio file path: " + path);
-	
-    file.write(data->GetBuffer(), data->GetBufferLen());
+    // finishes every encoded stream, which closes its file
+    if (m_encoder)
+        m_encoder->stop();
 
-    file.close();
-	file.flush();
+    // the last results go out on the socket, so Deepgram finishes before it
+    if (m_sink)
+        m_sink->stop();
 
-    stringstream ss;
-    ss << "Writing " << data->GetBufferLen() << "b to " << path << " at " << data->GetSampleRate() << "Hz";
+    if (m_transcribe)
+        server.drain(deadline);
 
-    //Log::info(ss.str());
+    lock_guard<mutex> lock(m_writersMutex);
+    m_writers.clear();
+    m_mixedWriter.close();
 }
 
 string ZoomSDKAudioRawDataDelegate::dir() const 
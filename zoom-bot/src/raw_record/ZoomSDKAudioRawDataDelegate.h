@@ -2,35 +2,264 @@
 #ifndef MEETING_SDK_LINUX_SAMPLE_ZOOMSDKAUDIORAWDATADELEGATE_H
 #define MEETING_SDK_LINUX_SAMPLE_ZOOMSDKAUDIORAWDATADELEGATE_H
 
+#include <atomic>
+#include <functional>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "zoom_sdk_raw_data_def.h"
 #include "rawdata/rawdata_audio_helper_interface.h"
 
 #include "../util/Log.h"
 #include "../util/SocketServer.h"
+#include "../storage/SegmentedFileWriter.h"
+#include "../audio/Resampler.h"
+#include "../audio/VadGate.h"
+#include "../audio/SpeakerSelector.h"
+#include "../audio/EncoderStage.h"
+#include "../audio/EncodedFileWriter.h"
+#include "../audio/JitterBuffer.h"
+#include "../audio/KeywordSpotter.h"
+#include "../egress/DeepgramSink.h"
 
 using namespace std;
 using namespace ZOOMSDK;
 
 class ZoomSDKAudioRawDataDelegate : public IZoomSDKAudioRawDataDelegate {
+    const chrono::seconds c_idleTimeout{30};
+    const unsigned int c_idleSweepChunks = 1000;
+    // speaker lists are messages a late subscriber misses, so they are repeated
+    const chrono::seconds c_speakersRefresh{5};
+
     SocketServer server;
 
     string m_dir = "out";
     string m_filename = "test.pcm";
-    bool m_useMixedAudio;
+    // switched at runtime by control commands, read on the SDK audio thread
+    atomic<bool> m_useMixedAudio;
     bool m_transcribe;
 
-    void writeToFile(const string& path, AudioRawData* data);
+    atomic<unsigned int> m_outputRate{0};
+    unique_ptr<Resampler> m_resampler;
+    vector<int16_t> m_resampled;
+
+    // one-way audio of every node multiplexed over the socket, guarded by m_writersMutex
+    atomic<bool> m_streamParticipants{false};
+    unordered_map<uint32_t, unique_ptr<Resampler>> m_nodeResamplers;
+
+    // or only the one-way audio of whoever is talking, also guarded by m_writersMutex
+    atomic<bool> m_streamSpeakers{false};
+    unique_ptr<SpeakerSelector> m_speakers;
+    unordered_map<uint32_t, string> m_speakerNames;
+    vector<uint32_t> m_announced;
+    uint64_t m_speakersAnnounced = 0;
+
+    // silence suppression, configured separately for the mixed and the one-way streams
+    VadOptions m_mixedVad;
+    VadOptions m_participantVad;
+    unique_ptr<VadGate> m_mixedGate;
+    unordered_map<uint32_t, unique_ptr<VadGate>> m_nodeGates;
+    VadGate::Emit m_emit;
+
+    // the bot's own stream of the mixed audio to Deepgram
+    unique_ptr<DeepgramSink> m_sink;
+
+    // listens to the mixed audio whatever is recorded or streamed
+    KeywordOptions m_keywordOptions;
+    KeywordSpotter::Trigger m_onKeyword;
+    unique_ptr<KeywordSpotter> m_keywords;
+
+    // encoded files, only touched on the encoder thread
+    unordered_map<uint64_t, EncodedFileWriter> m_encodedFiles;
+    unordered_map<string, unsigned int> m_fileParts;
+
+    // codecs between the audio and the socket or the files, pcm leaves them out; declared
+    // after what its thread writes to, so it stops first
+    EncoderOptions m_socketCodec;
+    EncoderOptions m_fileCodec;
+    unique_ptr<EncoderStage> m_encoder;
+
+    // armed per meeting, fired from the SDK audio thread by the first chunk bound for the socket
+    function<void()> m_onFirstAudio;
+    atomic<bool> m_firstAudioPending{false};
+
+    // set by close(), so a callback the SDK still delivers queues nothing behind the drain
+    atomic<bool> m_closed{false};
+
+    // files are cut into segments handed to m_onSegment when finished, if configured
+    SegmentOptions m_segmentOptions;
+    SegmentSequence::Finished m_onSegment;
+
+    SegmentedFileWriter m_mixedWriter;
+
+    // one long-lived writer per participant node in --separate-participants mode
+    unordered_map<uint32_t, SegmentedFileWriter> m_writers;
+    mutex m_writersMutex;
+    unsigned int m_oneWayChunks = 0;
+
+    // re-paces the socket audio before anything else touches it; declared last, so it
+    // stops before everything its thread feeds
+    JitterOptions m_jitterOptions;
+    unique_ptr<JitterBuffer> m_jitter;
+
+    void writeToFile(SegmentedFileWriter& writer, AudioRawData* data);
+    string pcmPath(const string& name) const;
+    void closeIdleWriters();
+    size_t resample(unique_ptr<Resampler>& resampler, const FrameHeader& header, const char* buf, size_t len,
+                    unsigned int outRate);
+    void emit(const FrameHeader& header, const char* buf, size_t len);
+    void encodeToFile(StreamType stream, uint32_t nodeId, AudioRawData* data);
+    void writeEncoded(const FrameHeader& header, const char* buf, size_t len);
+    void closeEncoded(StreamType stream, uint32_t nodeId);
+    string encodedPath(const FrameHeader& header);
+    void stream(FrameHeader header, unique_ptr<Resampler>& resampler, unique_ptr<VadGate>& gate,
+                const VadOptions& vad, AudioRawData* data);
+
+    /**
+     * @param header complete header of the chunk as captured, including its timestamp
+     */
+    void stream(FrameHeader header, unique_ptr<Resampler>& resampler, unique_ptr<VadGate>& gate,
+                const VadOptions& vad, const char* buf, size_t len);
+
+    /**
+     * Resample, gate and send a chunk on; from stream(), or from the jitter buffer's thread
+     */
+    void forward(FrameHeader header, unique_ptr<Resampler>& resampler, unique_ptr<VadGate>& gate,
+                 const VadOptions& vad, const char* buf, size_t len);
+    void forwardPaced(const FrameHeader& header, const char* buf, size_t len);
+    void streamSpeaker(AudioRawData* data, uint32_t nodeId);
+
+    /**
+     * Tell subscribers whose one-way audio they are getting; call with m_writersMutex held
+     */
+    void announceSpeakers(uint64_t now);
 public:
     ZoomSDKAudioRawDataDelegate(bool useMixedAudio, bool transcribe);
+
+    /**
+     * Start the socket server and the Deepgram stream when transcribing; call after
+     * configuring the delegate
+     */
+    void start();
+
+    void setRingOptions(size_t slots, OverflowPolicy policy);
+
+    /**
+     * Path of the socket the transcription audio is served on
+     */
+    void setSocketPath(const string& path);
+
+    /**
+     * Default send queue of each socket subscriber
+     * @param queue chunks that can wait for a slow subscriber
+     * @param policy which chunk a slow subscriber loses
+     */
+    void setSubscriberOptions(size_t queue, OverflowPolicy policy);
+
+    /**
+     * Resample and downmix socket audio to mono at this rate, 0 keeps the SDK format.
+     * Takes effect with the next chunk, so it can change during a meeting.
+     */
+    void setOutputRate(unsigned int rate);
+
+    /**
+     * Switch between the mixed audio and each participant's audio during a meeting.
+     * When transcribing this turns the one-way socket streams on or off next to the
+     * mixed one, which are only batched if batching was configured before start().
+     * Otherwise it picks the mixed file or one file per participant.
+     */
+    void setParticipantAudio(bool participants);
+
+    /**
+     * Also send the one-way audio of every participant over the socket, tagged with its node
+     * @param batchMs period at which each node's chunks are coalesced into one frame
+     */
+    void setStreamParticipants(bool enabled, unsigned int batchMs);
+
+    /**
+     * Send only the one-way audio of the current speakers over the socket, each list of
+     * them named in a Speakers frame
+     */
+    void setStreamSpeakers(bool enabled, const SpeakerOptions& options);
+
+    /**
+     * Switch speaker mode on or off during a meeting; only when transcribing
+     */
+    void setSpeakerAudio(bool speakers);
+
+    /**
+     * Follow the SDK's active speaker changes
+     * @param speakers user IDs of everyone talking with their display names, in the SDK's order
+     */
+    void setActiveSpeakers(const vector<pair<uint32_t, string>>& speakers);
+
+    /**
+     * Gate silence out of the socket streams
+     * @param mixed options for the mixed stream
+     * @param participants options for each participant's one-way stream
+     */
+    void setVad(const VadOptions& mixed, const VadOptions& participants);
+
+    /**
+     * Also stream the mixed audio to Deepgram and relay its results as transcript frames
+     */
+    void setDeepgram(const DeepgramOptions& options);
+
+    /**
+     * Spot keywords in the mixed audio; call before start()
+     * @param onKeyword runs on the spotter's thread for every keyword heard
+     */
+    void setKeywords(const KeywordOptions& options, const KeywordSpotter::Trigger& onKeyword);
+
+    /**
+     * Pace the mixed socket stream through a jitter buffer; call before start(). Resampling,
+     * gating and encoding of every socket stream then run on the buffer's thread.
+     */
+    void setJitter(const JitterOptions& options);
+
+    /**
+     * Encode the audio before it leaves, on a worker thread with one encoder per stream
+     * @param socket codec of every socket stream when transcribing
+     * @param file codec of the mixed and per-participant files otherwise
+     */
+    void setEncoding(const EncoderOptions& socket, const EncoderOptions& file);
+
+    /**
+     * Call back once when the next chunk of audio reaches the socket
+     * @param callback runs on the SDK audio thread, or the jitter buffer's
+     */
+    void setOnFirstAudio(const function<void()>& callback);
+
+    /**
+     * Record into segments instead of one growing file per stream; call before start().
+     * Linear16 segments become WAV files, encoded ones complete Ogg or FLAC streams.
+     * @param onFinished called with each finished segment, on the thread that wrote it
+     */
+    void setSegments(const SegmentOptions& options, const SegmentSequence::Finished& onFinished);
     string dir() const;
     void setDir(const string& dir);
     string filename() const;
     void setFilename(const string& filename);
 
+    /**
+     * Flush and close the file of a participant that left the meeting
+     * @param node_id node of the participant
+     */
+    void closeParticipant(uint32_t node_id);
+
+    /**
+     * Stop taking callbacks and drain every stage: the jitter buffer, the encoder, Deepgram
+     * and the socket subscribers, which get an end-of-stream frame; then close the files
+     * @param deadline subscribers that have not read their audio by then lose the rest
+     */
+    void close(chrono::steady_clock::time_point deadline = chrono::steady_clock::now());
+
     void onMixedAudioRawDataReceived(AudioRawData* data) override;
     void onOneWayAudioRawDataReceived(AudioRawData* data, uint32_t node_id) override;
     void onShareAudioRawDataReceived(AudioRawData* data,  unsigned int user_id) override;
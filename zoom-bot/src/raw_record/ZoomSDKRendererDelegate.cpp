@@ -1,71 +1,404 @@
 #include "ZoomSDKRendererDelegate.h"
 
+#include <sys/stat.h>
 
-ZoomSDKRendererDelegate::ZoomSDKRendererDelegate() {
-    if (!m_cascade.load("/usr/share/opencv4/haarcascades/haarcascade_frontalface_default.xml"))
-        Log::error("failed to load cascade file");
+#include "../util/ThreadRoles.h"
 
-    m_faces.reserve(2);
-}
+
+ZoomSDKRendererDelegate::ZoomSDKRendererDelegate() : m_matAllocator(CountingMatAllocator::install()) {}
 
 ZoomSDKRendererDelegate::~ZoomSDKRendererDelegate() {
-    if (m_videoWriter.isOpened()) {
-        m_videoWriter.release();
+    if (m_collector)
+        Metrics::getInstance().removeCollector(m_collector);
+
+    // finish the frames already handed to the workers before closing the file
+    if (m_workers)
+        m_workers->stop();
+
+    if (m_encoder)
+        closeEncoder();
+}
+
+void ZoomSDKRendererDelegate::configureWorkers(size_t workers, size_t queueSize, OverflowPolicy skip) {
+    m_workerCount = max<size_t>(workers, 1);
+    m_queueSize = max<size_t>(queueSize, 1);
+    m_frameSkip = skip;
+}
+
+void ZoomSDKRendererDelegate::configureDetection(const DetectionOptions& options) {
+    m_detectionOptions = options;
+}
+
+void ZoomSDKRendererDelegate::setDetector(const DetectorOptions& options) {
+    m_detectorOptions = options;
+}
+
+void ZoomSDKRendererDelegate::startWorkers() {
+    m_detector = FaceDetector::shared(m_detectorOptions);
+    m_detection.configure(m_detectionOptions, m_workerCount);
+
+    m_contexts.resize(m_workerCount);
+    for (auto& ctx : m_contexts) {
+        ctx.faces.reserve(16);
+        ctx.tracks.reserve(16);
+    }
+
+    // every frame is either queued, on a worker or waiting for its turn at the writer
+    auto inFlight = m_workerCount * 2 + m_queueSize + 1;
+    m_framePool = make_unique<FramePool>(inFlight);
+
+    m_workers = make_unique<WorkerPool<FramePtr>>(m_workerCount, m_queueSize, m_frameSkip, ThreadRole::VideoWorker,
+        [this](FramePtr& frame, size_t worker) {
+            processFrame(frame, worker);
+            auto seq = frame->seq;
+            completeFrame(seq, std::move(frame));
+        },
+        [this](FramePtr& frame) {
+            auto seq = frame->seq;
+            m_framePool->release(std::move(frame));
+            completeFrame(seq, nullptr);
+        });
+
+    m_collector = Metrics::getInstance().addCollector([this](MetricsText& text) { collect(text); });
+}
+
+
+void ZoomSDKRendererDelegate::setEncoder(const string& backend, const string& vaapiDevice) {
+    m_encoderBackend = backend;
+    m_vaapiDevice = vaapiDevice;
+}
+
+void ZoomSDKRendererDelegate::setSegments(const SegmentOptions& options, const SegmentSequence::Finished& onFinished) {
+    m_segmentOptions = options;
+    m_onSegment = onFinished;
+}
+
+string ZoomSDKRendererDelegate::outputPath() {
+    auto path = m_dir + "/" + m_filename;
+    if (!m_segmentOptions.enabled())
+        return path;
+
+    if (!m_segments.enabled())
+        m_segments = SegmentSequence(path, m_segmentOptions, m_onSegment);
+
+    return m_segments.next();
+}
+
+void ZoomSDKRendererDelegate::closeEncoder() {
+    m_encoder->close();
+    m_encoder.reset();
+
+    if (m_segments.enabled())
+        m_segments.finish();
+}
+
+uint64_t ZoomSDKRendererDelegate::segmentBytes() const {
+    struct stat st;
+    if (m_segmentOptions.bytes == 0 || stat(m_segments.current().c_str(), &st) != 0)
+        return 0;
+
+    return st.st_size;
+}
+
+bool ZoomSDKRendererDelegate::nextSegment() {
+    auto backend = m_encoder->name();
+    closeEncoder();
+
+    // the backends before this one already failed to open
+    m_encoderChain = VideoEncoder::chain(m_encoderBackend, m_vaapiDevice);
+    auto it = find(m_encoderChain.begin(), m_encoderChain.end(), backend);
+    if (it != m_encoderChain.end())
+        m_encoderChain.erase(m_encoderChain.begin(), it);
+
+    return openEncoder(m_encoderWidth, m_encoderHeight, 30);
+}
+
+bool ZoomSDKRendererDelegate::openEncoder(unsigned int frameWidth, unsigned int frameHeight, double fps) {
+    if (m_encoderChain.empty() && !m_encoder)
+        m_encoderChain = VideoEncoder::chain(m_encoderBackend, m_vaapiDevice);
+
+    auto path = outputPath();
+
+    while (!m_encoderChain.empty()) {
+        auto backend = m_encoderChain.front();
+        m_encoderChain.erase(m_encoderChain.begin());
+
+        m_encoder = VideoEncoder::create(backend, m_vaapiDevice);
+        if (m_encoder->open(path, frameWidth, frameHeight, fps)) {
+            stringstream ss;
+            ss << "encoding " << frameWidth << "x" << frameHeight << " video with " << backend;
+            Log::info(ss.str());
+
+            m_encoderWidth = frameWidth;
+            m_encoderHeight = frameHeight;
+            m_encodedFrames = 0;
+            return true;
+        }
+
+        Log::error("failed to open " + backend + " video encoder");
     }
+
+    m_encoder.reset();
+    if (m_segments.enabled())
+        unlink(path.c_str());
+    m_encoderFailed = true;
+    Log::error("no usable video encoder, video will not be recorded");
+
+    return false;
 }
 
+void ZoomSDKRendererDelegate::encodeFrame(const VideoFrame& frame) {
+    if (m_encoderFailed)
+        return;
+
+    if (isRawOutput())
+        return writeRaw(frame);
+
+    if (!m_encoder && !openEncoder(frame.width, frame.height, 30))
+        return;
 
-void ZoomSDKRendererDelegate::initializeVideoWriter(int frameWidth, int frameHeight, double fps) {
-    int fourcc = VideoWriter::fourcc('a','v','c','1');
-    std::string filename = "out/" + m_filename;
-    m_videoWriter.open(filename, fourcc, fps, Size(frameWidth, frameHeight), true);
+    if (m_segments.due(segmentBytes()) && !nextSegment())
+        return;
+
+    if (m_encoder->write(scaleFrame(frame))) {
+        m_encodedFrames++;
+        return;
+    }
+
+    auto name = m_encoder->name();
+    closeEncoder();
+
+    // a backend that dies right away is unusable here, one that dies later lost its device
+    if (m_encodedFrames < c_probeFrames) {
+        Log::error(name + " video encoder failed, falling back");
+        if (openEncoder(m_encoderWidth, m_encoderHeight, 30))
+            m_encoder->write(scaleFrame(frame));
+    } else {
+        Log::error(name + " video encoder failed after " + to_string(m_encodedFrames) + " frames");
+        m_encoderFailed = true;
+    }
+}
+
+const VideoFrame& ZoomSDKRendererDelegate::scaleFrame(const VideoFrame& frame) {
+    if (frame.width == m_encoderWidth && frame.height == m_encoderHeight)
+        return frame;
+
+    auto w = m_encoderWidth, h = m_encoderHeight;
+    auto len = I420View::bytes(w, h);
+    if (m_scaled.capacity < len) {
+        m_scaled.data = make_unique<char[]>(len);
+        m_scaled.capacity = len;
+    }
+    m_scaled.len = len;
+    m_scaled.width = w;
+    m_scaled.height = h;
+
+    // scale each plane on its own
+    auto src = I420View::of(frame);
+    auto dst = I420View::of(m_scaled);
+
+    Mat dstY = dst.y.mat(), dstU = dst.u.mat(), dstV = dst.v.mat();
+    resize(src.y.mat(), dstY, dstY.size());
+    resize(src.u.mat(), dstU, dstU.size());
+    resize(src.v.mat(), dstV, dstV.size());
+
+    return m_scaled;
 }
 
 void ZoomSDKRendererDelegate::onRawDataFrameReceived(YUVRawDataI420 *data)
 {
-    if (!m_videoWriter.isOpened()) {
-        initializeVideoWriter(data->GetStreamWidth(), data->GetStreamHeight(), 30);
+    ThreadRoles::assign(ThreadRole::VideoWorker);
+
+    if (!m_workers)
+        startWorkers();
+
+    m_detection.frameArrived();
+
+    auto width = data->GetStreamWidth();
+    auto height = data->GetStreamHeight();
+
+    if (width != m_width || height != m_height) {
+        Log::info("video resolution ", width, "x", height);
+
+        m_framePool->setResolution(width, height);
+        m_width = width;
+        m_height = height;
     }
 
-    auto res = async(launch::async, [&]{
-        Mat I420(data->GetStreamHeight() * 3/2, data->GetStreamWidth(), CV_8UC1, data->GetBuffer());
-        Mat small, gray;
+    // the SDK owns data only for the duration of this callback, so copy its planes out
+    auto planes = I420View::of(data);
+    auto frame = m_framePool->acquire(width, height, planes.bytes());
+    if (!frame)
+        return;
 
-        cvtColor(I420, gray, COLOR_YUV2GRAY_I420);
-        resize(gray, small, Size(), m_fx, m_fx, INTER_LINEAR);
-        equalizeHist(small, small);
+    planes.copyTo(frame->data.get());
 
-        m_cascade.detectMultiScale(small, m_faces, 1.1, 2, 0|CASCADE_SCALE_IMAGE, Size(30, 30));
+    {
+        lock_guard<mutex> lock(m_writerMutex);
+        frame->seq = m_frameCount++;
+    }
 
-        Scalar color = Scalar(0, 0, 255);
-        for (size_t i = 0; i < m_faces.size(); i++) {
-            Rect r = m_faces[i];
-            rectangle(gray, Point(cvRound(r.x*m_scale), cvRound(r.y*m_scale)),
-                        Point(cvRound((r.x + r.width-1)*m_scale),
-                            cvRound((r.y + r.height-1)*m_scale)), color, 3, 8, 0);
-        }
+    m_workers->submit(std::move(frame));
 
-        if (m_videoWriter.isOpened()) {
-            Mat colorFrame;
-            cvtColor(gray, colorFrame, COLOR_GRAY2BGR);
-            m_videoWriter.write(colorFrame);
+    if (m_frameCount % c_statsInterval == 0)
+        logStats();
+}
+
+void ZoomSDKRendererDelegate::onRawDataStatusChanged(RawDataStatus status) {
+    // nothing arrives while raw data is off, give the cached buffers back
+    if (status == RawData_Off && m_framePool)
+        m_framePool->trim();
+}
+
+void ZoomSDKRendererDelegate::prepareContext(WorkerContext& ctx, unsigned int width, unsigned int height) {
+    if (ctx.width == width && ctx.height == height)
+        return;
+
+    ctx.small.create(Size(cvRound(width * m_fx), cvRound(height * m_fx)), CV_8UC1);
+    ctx.width = width;
+    ctx.height = height;
+}
+
+void ZoomSDKRendererDelegate::logStats() {
+    auto matAllocations = m_matAllocator.allocations();
+
+    stringstream ss;
+    ss << "video frames: " << m_frameCount << " received, " << m_workers->dropped() << " skipped, "
+       << m_framePool->exhausted() << " without a buffer, " << m_framePool->hits() << " pooled; allocations: "
+       << m_framePool->allocations() << " frame, " << matAllocations << " Mat (+"
+       << matAllocations - m_reportedAllocations << ")";
+    Log::info(ss.str());
+
+    m_reportedAllocations = matAllocations;
+
+    stringstream stages;
+    stages << "video stages: " << m_prepareStats.report("prepare", m_prepareReported) << ", "
+           << m_detectStats.report("detect", m_detectReported) << ", "
+           << m_trackStats.report("track", m_trackReported) << ", "
+           << m_drawStats.report("draw", m_drawReported) << ", "
+           << m_encodeStats.report("encode", m_encodeReported) << "; detecting every "
+           << m_detection.interval() << " frames, " << m_detection.sceneChanges() << " scene changes, "
+           << m_detection.lostTracks() << " lost tracks";
+    Log::info(stages.str());
+}
+
+void ZoomSDKRendererDelegate::collect(MetricsText& text) {
+    auto stream = MetricsText::labels({{"stream", m_filename}});
+
+    // runs on the reader's thread, the frame count is guarded like on the writer side
+    unsigned int frames;
+    {
+        lock_guard<mutex> lock(m_writerMutex);
+        frames = m_frameCount;
+    }
+
+    text.counter("zoombot_video_frames_total", "Video frames received from the SDK", stream, frames);
+    text.counter("zoombot_video_frames_skipped_total", "Video frames skipped because the workers fell behind",
+                 stream, m_workers->dropped());
+    text.gauge("zoombot_video_detect_interval", "Frames between two runs of the face detector", stream,
+               m_detection.interval());
+
+    const pair<const char*, const StageStats*> stages[] = {
+        {"prepare", &m_prepareStats}, {"detect", &m_detectStats}, {"track", &m_trackStats},
+        {"draw", &m_drawStats}, {"encode", &m_encodeStats}};
+
+    for (auto& [name, stats] : stages)
+        text.summary("zoombot_video_stage_seconds", "Time a video frame spent in one processing stage",
+                     MetricsText::labels({{"stream", m_filename}, {"stage", name}}),
+                     stats->histogram().snapshot(), 1e-9);
+}
+
+void ZoomSDKRendererDelegate::processFrame(FramePtr& frame, size_t worker) {
+    auto& ctx = m_contexts[worker];
+    prepareContext(ctx, frame->width, frame->height);
+
+    // the Y plane of an I420 frame is the grayscale image
+    Mat gray = I420View::of(*frame).y.mat();
+    auto seq = frame->seq;
+
+    DetectionScheduler::Action action;
+    {
+        StageTimer timer(m_prepareStats);
+        resize(gray, ctx.small, ctx.small.size(), 0, 0, INTER_LINEAR);
+        equalizeHist(ctx.small, ctx.small);
+
+        action = m_detection.plan(seq, ctx.small, ctx.thumb, ctx.tracks);
+        m_detection.prepared(timer.elapsed());
+    }
+
+    if (action == DetectionScheduler::Action::Detect) {
+        StageTimer timer(m_detectStats);
+        if (!m_detector || !m_detector->detect(ctx.small, ctx.faces))
+            ctx.faces.clear();
+        m_detection.detected(seq, ctx.small, ctx.faces, timer.elapsed());
+    } else {
+        StageTimer timer(m_trackStats);
+        auto found = m_detection.track(ctx.small, ctx.tracks, ctx.scores);
+        m_detection.tracked(seq, ctx.tracks, !found, timer.elapsed());
+
+        ctx.faces.clear();
+        for (auto& track : ctx.tracks)
+            ctx.faces.push_back(track.box);
+    }
+
+    StageTimer timer(m_drawStats);
+    Scalar color = Scalar(0, 0, 255);
+    for (size_t i = 0; i < ctx.faces.size(); i++) {
+        Rect r = ctx.faces[i];
+        rectangle(gray, Point(cvRound(r.x*m_scale), cvRound(r.y*m_scale)),
+                    Point(cvRound((r.x + r.width-1)*m_scale),
+                        cvRound((r.y + r.height-1)*m_scale)), color, 3, 8, 0);
+    }
+}
+
+void ZoomSDKRendererDelegate::completeFrame(uint64_t seq, FramePtr frame) {
+    lock_guard<mutex> lock(m_writerMutex);
+
+    m_reorder.emplace(seq, std::move(frame));
+
+    // write every frame whose predecessors are done, skipped frames leave an empty entry
+    for (auto it = m_reorder.begin(); it != m_reorder.end() && it->first == m_nextSeq; it = m_reorder.begin()) {
+        auto ready = std::move(it->second);
+        m_reorder.erase(it);
+        m_nextSeq++;
+
+        if (!ready)
+            continue;
+
+        {
+            StageTimer timer(m_encodeStats);
+            encodeFrame(*ready);
         }
-    });
+        m_framePool->release(std::move(ready));
+    }
 }
 
 
 
-void ZoomSDKRendererDelegate::writeToFile(const string &path, YUVRawDataI420 *data)
-{
+void ZoomSDKRendererDelegate::writeRaw(const VideoFrame& frame) {
+    if (!m_rawWriter.isOpen()) {
+        auto path = m_dir + "/" + m_filename;
+        if (!m_rawWriter.open(path, m_segmentOptions, m_onSegment)) {
+            m_encoderFailed = true;
+            return;
+        }
 
-	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::app);
-	if (!file.is_open())
-        return Log::error("failed to open video output file: " + path);
+        // a raw stream has no header, so every frame has to keep the first size
+        m_encoderWidth = frame.width;
+        m_encoderHeight = frame.height;
 
-	file.write(data->GetBuffer(), data->GetBufferLen());
+        stringstream ss;
+        ss << "writing raw " << frame.width << "x" << frame.height << " I420 video to " << path;
+        Log::info(ss.str());
+    }
+
+    auto& out = scaleFrame(frame);
+    m_rawWriter.write(out.data.get(), out.len);
+}
 
-	file.close();
-	file.flush();
+bool ZoomSDKRendererDelegate::isRawOutput() const {
+    auto ext = string(".yuv");
+    return m_filename.size() >= ext.size() && m_filename.compare(m_filename.size() - ext.size(), ext.size(), ext) == 0;
 }
 
 string ZoomSDKRendererDelegate::dir() const {
@@ -7,7 +7,9 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
-#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #include <opencv2/objdetect.hpp>
 #include <opencv2/highgui.hpp>
@@ -19,12 +21,45 @@
 
 #include "../util/SocketServer.h"
 #include "../util/Log.h"
+#include "../util/WorkerPool.h"
+#include "../util/StageStats.h"
+#include "../storage/SegmentedFileWriter.h"
+#include "../video/FramePool.h"
+#include "../video/I420View.h"
+#include "../video/CountingMatAllocator.h"
+#include "../video/VideoEncoder.h"
+#include "../video/DetectionScheduler.h"
+#include "../video/FaceDetector.h"
 
 using namespace cv;
 using namespace std;
 using namespace ZOOMSDK;
 
 class ZoomSDKRendererDelegate : public IZoomSDKRendererDelegate {
+    typedef unique_ptr<VideoFrame> FramePtr;
+
+    /**
+     * Detection state and scratch buffers owned by a single frame worker,
+     * sized once per resolution so steady-state frames allocate nothing
+     */
+    struct WorkerContext {
+        vector<Rect> faces;
+
+        unsigned int width = 0;
+        unsigned int height = 0;
+        Mat small;
+
+        // scene change thumbnail, template match scores and the faces being followed
+        Mat thumb;
+        Mat scores;
+        vector<DetectionScheduler::Track> tracks;
+    };
+
+    const unsigned int c_statsInterval = 900;
+
+    // a backend that fails within this many frames is replaced by the next one in the chain
+    const uint64_t c_probeFrames = 30;
+
     const string c_window = "Face_Detection";
     string m_dir = "out";
     string m_filename = "meeting-video.yuv";
@@ -33,27 +68,134 @@ class ZoomSDKRendererDelegate : public IZoomSDKRendererDelegate {
     double m_scale=3;
     double m_fx = 1/m_scale;
 
-    vector<Rect> m_faces;
-    CascadeClassifier m_cascade;
-    cv::VideoWriter m_videoWriter;
+    size_t m_workerCount = 2;
+    size_t m_queueSize = 4;
+    OverflowPolicy m_frameSkip = OverflowPolicy::DropOldest;
+
+    vector<WorkerContext> m_contexts;
+    unique_ptr<FramePool> m_framePool;
+    unique_ptr<WorkerPool<FramePtr>> m_workers;
+
+    DetectorOptions m_detectorOptions;
+    shared_ptr<FaceDetector> m_detector;
+    DetectionOptions m_detectionOptions;
+    DetectionScheduler m_detection;
+
+    // time spent per frame in each step, reported with the frame counters
+    StageStats m_prepareStats;
+    StageStats m_detectStats;
+    StageStats m_trackStats;
+    StageStats m_drawStats;
+    StageStats m_encodeStats;
+    StageStats::Snapshot m_prepareReported;
+    StageStats::Snapshot m_detectReported;
+    StageStats::Snapshot m_trackReported;
+    StageStats::Snapshot m_drawReported;
+    StageStats::Snapshot m_encodeReported;
+
+    // stage times and frame counters of this stream in the metrics export
+    uint64_t m_collector = 0;
+
+    CountingMatAllocator& m_matAllocator;
+    uint64_t m_reportedAllocations = 0;
+
+    // frames come back from the workers out of order, the writer needs them in sequence;
+    // skipped frames keep advancing seq while a slow one is still on a worker, so how far
+    // ahead a frame can be has no bound and the frames waiting are keyed by seq, a skipped
+    // one with an empty entry
+    mutex m_writerMutex;
+    map<uint64_t, FramePtr> m_reorder;
+    uint64_t m_nextSeq = 0;
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+
+    string m_encoderBackend = Encoder::automatic;
+    string m_vaapiDevice = "/dev/dri/renderD128";
+    vector<string> m_encoderChain;
+    unique_ptr<VideoEncoder> m_encoder;
+    unsigned int m_encoderWidth = 0;
+    unsigned int m_encoderHeight = 0;
+    uint64_t m_encodedFrames = 0;
+    bool m_encoderFailed = false;
+
+    // frames of a different size are scaled to the size the encoder was opened with
+    VideoFrame m_scaled;
+
+    // a .yuv output gets the raw I420 frames instead of an encoded video
+    SegmentedFileWriter m_rawWriter;
+
+    // the encoder is reopened for every segment, which ffmpeg writes as fragmented MP4
+    SegmentOptions m_segmentOptions;
+    SegmentSequence::Finished m_onSegment;
+    SegmentSequence m_segments;
 
     SocketServer m_socketServer;
 
+    void startWorkers();
+    void processFrame(FramePtr& frame, size_t worker);
+    void completeFrame(uint64_t seq, FramePtr frame);
+    void prepareContext(WorkerContext& ctx, unsigned int width, unsigned int height);
+    void encodeFrame(const VideoFrame& frame);
+    string outputPath();
+    void closeEncoder();
+    uint64_t segmentBytes() const;
+    bool nextSegment();
+    void writeRaw(const VideoFrame& frame);
+    bool isRawOutput() const;
+    const VideoFrame& scaleFrame(const VideoFrame& frame);
+    void logStats();
+    void collect(MetricsText& text);
+
 public:
     ZoomSDKRendererDelegate();
     ~ZoomSDKRendererDelegate();
 
-    void writeToFile(const string& path, YUVRawDataI420* data);
+    /**
+     * Size the frame worker pool; call before the first frame arrives
+     * @param workers number of frame worker threads
+     * @param queueSize frames that can wait for a worker
+     * @param skip which frame to skip when the workers fall behind
+     */
+    void configureWorkers(size_t workers, size_t queueSize, OverflowPolicy skip);
+
+    /**
+     * Choose how often the full face detector runs between tracked frames; call before
+     * the first frame arrives
+     */
+    void configureDetection(const DetectionOptions& options);
+
+    /**
+     * Choose the face detector backend; call before the first frame arrives. Every
+     * delegate with the same options shares one detector.
+     */
+    void setDetector(const DetectorOptions& options);
+
+    /**
+     * Choose the video encoder; call before the first frame arrives
+     * @param backend auto, vaapi, nvenc, x264 or opencv
+     * @param vaapiDevice DRM render node used by the vaapi backend
+     */
+    void setEncoder(const string& backend, const string& vaapiDevice);
+
+    /**
+     * Record into segments instead of one growing file; call before the first frame arrives
+     * @param onFinished called with each finished segment, on the frame writer
+     */
+    void setSegments(const SegmentOptions& options, const SegmentSequence::Finished& onFinished);
 
     string dir() const;
     void setDir(const string& dir);
     string filename() const;
     void setFilename(const string& filename);
 
-    void initializeVideoWriter(int frameWidth, int frameHeight, double fps);
+    /**
+     * Open the first backend of the encoder chain that accepts the output file
+     * @return true if an encoder is ready for frames
+     */
+    bool openEncoder(unsigned int frameWidth, unsigned int frameHeight, double fps);
 
     void onRawDataFrameReceived(YUVRawDataI420* data) override;
-    void onRawDataStatusChanged(RawDataStatus status) override {};
+    void onRawDataStatusChanged(RawDataStatus status) override;
     void onRendererBeDestroyed() override {};
 };
 
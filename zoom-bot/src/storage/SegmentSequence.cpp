@@ -0,0 +1,112 @@
+#include "SegmentSequence.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <ctime>
+#include <regex>
+
+#include "../util/Log.h"
+
+static const string c_partMarker = ".part";
+
+// position of the extension dot in the file name, or the end if it has none
+static size_t extensionStart(const string& path) {
+    auto slash = path.rfind('/');
+    auto dot = path.rfind('.');
+
+    if (dot == string::npos || (slash != string::npos && dot < slash))
+        return path.size();
+
+    return dot;
+}
+
+SegmentSequence::SegmentSequence(const string& path, const SegmentOptions& options, const Finished& onFinished) :
+        m_options(options), m_onFinished(onFinished) {
+    auto dot = extensionStart(path);
+    m_ext = path.substr(dot);
+
+    char start[32];
+    auto now = time(nullptr);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    strftime(start, sizeof(start), "%Y%m%dT%H%M%SZ", &utc);
+
+    m_base = path.substr(0, dot) + "-" + start;
+}
+
+string SegmentSequence::next() {
+    char index[16];
+    snprintf(index, sizeof(index), "-%05u", ++m_index);
+
+    m_current = m_base + index + c_partMarker + m_ext;
+    m_started = clock::now();
+
+    return m_current;
+}
+
+bool SegmentSequence::due(uint64_t bytes) const {
+    if (m_current.empty())
+        return false;
+
+    if (m_options.bytes > 0 && bytes >= m_options.bytes)
+        return true;
+
+    return m_options.seconds > 0 && clock::now() - m_started >= chrono::seconds(m_options.seconds);
+}
+
+string SegmentSequence::finish() {
+    if (m_current.empty())
+        return "";
+
+    auto part = m_current;
+    m_current.clear();
+
+    struct stat st;
+    if (stat(part.c_str(), &st) != 0)
+        return "";
+
+    // an encoder that failed on its first frame leaves nothing worth uploading
+    if (st.st_size == 0) {
+        unlink(part.c_str());
+        return "";
+    }
+
+    auto path = finishedPath(part);
+    if (rename(part.c_str(), path.c_str()) != 0) {
+        Log::error("unable to finish segment ", part);
+        return "";
+    }
+
+    if (m_onFinished)
+        m_onFinished(path);
+
+    return path;
+}
+
+bool SegmentSequence::enabled() const {
+    return m_options.enabled() && !m_base.empty();
+}
+
+const string& SegmentSequence::current() const {
+    return m_current;
+}
+
+bool SegmentSequence::isPart(const string& path) {
+    auto dot = extensionStart(path);
+    return dot >= c_partMarker.size() && path.compare(dot - c_partMarker.size(), c_partMarker.size(), c_partMarker) == 0;
+}
+
+bool SegmentSequence::isSegment(const string& path) {
+    static const regex segment(R"(-\d{8}T\d{6}Z-\d{5,}(\.part)?(\.[^./]*)?$)");
+    return regex_search(path.substr(path.rfind('/') + 1), segment);
+}
+
+string SegmentSequence::finishedPath(const string& partPath) {
+    if (!isPart(partPath))
+        return partPath;
+
+    auto dot = extensionStart(partPath);
+    return partPath.substr(0, dot - c_partMarker.size()) + partPath.substr(dot);
+}
@@ -0,0 +1,93 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_SEGMENTSEQUENCE_H
+#define MEETING_SDK_LINUX_SAMPLE_SEGMENTSEQUENCE_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+using namespace std;
+
+struct SegmentOptions {
+    // a segment is finished after this many seconds or bytes, whichever comes first;
+    // with neither a recording stays one file
+    unsigned int seconds = 0;
+    uint64_t bytes = 0;
+
+    bool enabled() const { return seconds > 0 || bytes > 0; }
+};
+
+/**
+ * Names and times the segments of one recording.
+ *
+ * Segment n of <dir>/<stem><ext> is <dir>/<stem>-<start>-<n><ext>, start being the UTC
+ * time the recording began, so a later recording never reuses the name of one that was
+ * uploaded and deleted. A segment is written as <name>.part<ext> and only renamed once it
+ * is complete: after a crash the .part files are the only ones cut short.
+ */
+class SegmentSequence {
+public:
+    /**
+     * Called with the final path of every finished segment
+     */
+    typedef function<void(const string& path)> Finished;
+
+private:
+    typedef chrono::steady_clock clock;
+
+    SegmentOptions m_options;
+    Finished m_onFinished;
+
+    string m_base;
+    string m_ext;
+    unsigned int m_index = 0;
+
+    string m_current;
+    clock::time_point m_started;
+
+public:
+    SegmentSequence() = default;
+
+    /**
+     * @param path file the recording would be written to without segments
+     */
+    SegmentSequence(const string& path, const SegmentOptions& options, const Finished& onFinished);
+
+    /**
+     * Start the next segment
+     * @return its .part path
+     */
+    string next();
+
+    /**
+     * @param bytes written to the current segment so far
+     * @return true if the current segment is full
+     */
+    bool due(uint64_t bytes) const;
+
+    /**
+     * Rename the current segment to its final name and hand it on; an empty one is deleted
+     * @return the final path, empty if there was nothing to keep
+     */
+    string finish();
+
+    bool enabled() const;
+    const string& current() const;
+
+    /**
+     * @return true for the name of a segment that is still being written
+     */
+    static bool isPart(const string& path);
+
+    /**
+     * @return true for the name of any segment, finished or not
+     */
+    static bool isSegment(const string& path);
+
+    /**
+     * @return the name a .part file gets when it is finished
+     */
+    static string finishedPath(const string& partPath);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_SEGMENTSEQUENCE_H
@@ -0,0 +1,336 @@
+#include "SegmentUploader.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+
+#include "SegmentSequence.h"
+#include "SegmentedFileWriter.h"
+#include "../util/Log.h"
+#include "../util/ThreadRoles.h"
+
+static string dirName(const string& path) {
+    auto slash = path.rfind('/');
+    return slash == string::npos ? "." : path.substr(0, slash);
+}
+
+static string baseName(const string& path) {
+    return path.substr(path.rfind('/') + 1);
+}
+
+SegmentUploader::SegmentUploader() :
+        m_uploaded(Metrics::getInstance().counter("zoombot_segments_uploaded_total",
+                                                  "Recording segments uploaded to the bucket")),
+        m_uploadedBytes(Metrics::getInstance().counter("zoombot_segment_upload_bytes_total",
+                                                       "Bytes of recording segments uploaded to the bucket")),
+        m_failed(Metrics::getInstance().counter("zoombot_segment_upload_failures_total",
+                                                "Segment uploads that failed and will be retried")),
+        m_evicted(Metrics::getInstance().counter("zoombot_segments_evicted_total",
+                                                 "Segments deleted to stay within the disk limit")),
+        m_disk(Metrics::getInstance().gauge("zoombot_segment_disk_bytes",
+                                            "Bytes of finished segments on disk")),
+        m_pending(Metrics::getInstance().gauge("zoombot_segments_pending",
+                                               "Finished segments waiting to be uploaded")),
+        m_duration(Metrics::getInstance().histogram("zoombot_segment_upload_seconds",
+                                                    "Time to upload one segment")) {}
+
+SegmentUploader::~SegmentUploader() {
+    stop();
+}
+
+void SegmentUploader::start(const UploadOptions& options, const vector<string>& dirs) {
+    stop();
+
+    m_options = options;
+    m_stopping = false;
+
+    if (!m_options.prefix.empty() && m_options.prefix.back() != '/')
+        m_options.prefix += '/';
+
+    vector<string> unique;
+    for (auto& dir : dirs) {
+        auto name = dir.empty() ? string(".") : dir;
+        if (std::find(unique.begin(), unique.end(), name) == unique.end())
+            unique.push_back(name);
+    }
+
+    for (auto& dir : unique)
+        recover(dir);
+
+    if (m_options.s3.bucket.empty())
+        return;
+
+    auto threads = max(m_options.concurrency, 1u);
+    for (unsigned int i = 0; i < threads; i++)
+        m_threads.emplace_back(&SegmentUploader::run, this);
+
+    Log::info("uploading segments to ", m_options.s3.bucket, " with ", threads, " threads");
+}
+
+void SegmentUploader::stop() {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+    m_threads.clear();
+
+    for (auto fd : m_locks)
+        ::close(fd);
+    m_locks.clear();
+}
+
+void SegmentUploader::drain(chrono::steady_clock::time_point deadline) {
+    if (!m_threads.empty()) {
+        unique_lock<mutex> lock(m_mutex);
+
+        // the last chance for segments that failed before, they do not wait for their backoff
+        for (auto& segment : m_segments)
+            segment.notBefore = clock::now();
+        m_wake.notify_all();
+
+        if (!m_uploadDone.wait_until(lock, deadline, [this] { return pending() == 0; }))
+            Log::error(pending(), " segments are not uploaded yet, they are left for the next start");
+    }
+
+    stop();
+}
+
+void SegmentUploader::add(const string& path) {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        track(path, false);
+    }
+    m_wake.notify_one();
+}
+
+bool SegmentUploader::isRunning() const {
+    return !m_threads.empty();
+}
+
+void SegmentUploader::recover(const string& dir) {
+    mkdir(dir.c_str(), 0755);
+
+    auto lockPath = dir + "/.recording.lock";
+    auto fd = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        Log::error("unable to lock ", dir, ", its old segments are not recovered");
+        return;
+    }
+
+    m_locks.push_back(fd);
+
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        Log::info("another recorder is using ", dir, ", leaving its segments alone");
+        flock(fd, LOCK_SH);
+        return;
+    }
+
+    struct Found {
+        string path;
+        time_t mtime;
+        bool uploaded;
+    };
+    vector<Found> found;
+
+    for (auto uploaded : {false, true}) {
+        auto path = uploaded ? dir + "/uploaded" : dir;
+        auto* d = opendir(path.c_str());
+        if (!d)
+            continue;
+
+        while (auto* entry = readdir(d)) {
+            auto file = path + "/" + entry->d_name;
+            struct stat st;
+
+            if (SegmentSequence::isSegment(file) && stat(file.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+                found.push_back({file, st.st_mtime, uploaded});
+        }
+
+        closedir(d);
+    }
+
+    // the oldest recordings go first, whichever stream they belong to
+    sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.mtime < b.mtime; });
+
+    size_t recovered = 0;
+    lock_guard<mutex> lock(m_mutex);
+
+    for (auto& segment : found) {
+        auto path = segment.path;
+
+        if (SegmentSequence::isPart(path)) {
+            // cut short when the process died, a WAV header still has the open sizes
+            SegmentedFileWriter::repairWav(path);
+
+            auto finished = SegmentSequence::finishedPath(path);
+            if (rename(path.c_str(), finished.c_str()) != 0) {
+                Log::error("unable to recover segment ", path);
+                continue;
+            }
+
+            path = finished;
+            recovered++;
+        }
+
+        track(path, segment.uploaded);
+    }
+
+    if (!found.empty())
+        Log::info("found ", found.size(), " segments in ", dir, ", ", recovered, " of them cut short");
+
+    flock(fd, LOCK_SH);
+}
+
+void SegmentUploader::track(const string& path, bool uploaded) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return;
+
+    Segment segment;
+    segment.path = path;
+    segment.bytes = st.st_size;
+    segment.uploaded = uploaded;
+
+    m_segments.push_back(segment);
+    m_diskBytes += segment.bytes;
+
+    enforceLimit();
+    updateGauges();
+}
+
+void SegmentUploader::enforceLimit() {
+    while (m_options.maxDiskBytes > 0 && m_diskBytes > m_options.maxDiskBytes) {
+        auto victim = find_if(m_segments.begin(), m_segments.end(),
+                              [](const Segment& s) { return s.uploaded && !s.busy; });
+        if (victim == m_segments.end())
+            victim = find_if(m_segments.begin(), m_segments.end(), [](const Segment& s) { return !s.busy; });
+        if (victim == m_segments.end())
+            break;
+
+        if (!victim->uploaded && !m_options.s3.bucket.empty())
+            Log::error("disk limit reached, deleting ", victim->path, " before it was uploaded");
+
+        unlink(victim->path.c_str());
+        m_diskBytes -= victim->bytes;
+        m_segments.erase(victim);
+        m_evicted.add();
+    }
+}
+
+void SegmentUploader::updateGauges() {
+    m_disk.set(m_diskBytes);
+    m_pending.set(pending());
+}
+
+size_t SegmentUploader::pending() const {
+    return count_if(m_segments.begin(), m_segments.end(), [](const Segment& s) { return !s.uploaded; });
+}
+
+deque<SegmentUploader::Segment>::iterator SegmentUploader::find(const string& path) {
+    return find_if(m_segments.begin(), m_segments.end(), [&](const Segment& s) { return s.path == path; });
+}
+
+string SegmentUploader::key(const string& path) const {
+    return m_options.prefix + baseName(path);
+}
+
+void SegmentUploader::run() {
+    ThreadRoles::assign(ThreadRole::Io);
+
+    S3Client client(m_options.s3);
+    unique_lock<mutex> lock(m_mutex);
+
+    while (!m_stopping) {
+        auto now = clock::now();
+        auto wakeAt = clock::time_point::max();
+
+        auto it = m_segments.begin();
+        for (; it != m_segments.end(); ++it) {
+            if (it->uploaded || it->busy)
+                continue;
+            if (it->notBefore <= now)
+                break;
+            wakeAt = min(wakeAt, it->notBefore);
+        }
+
+        if (it == m_segments.end()) {
+            if (wakeAt == clock::time_point::max())
+                m_wake.wait(lock);
+            else
+                m_wake.wait_until(lock, wakeAt);
+            continue;
+        }
+
+        it->busy = true;
+        auto path = it->path;
+        auto bytes = it->bytes;
+
+        lock.unlock();
+        upload(path, bytes, client);
+        lock.lock();
+    }
+}
+
+void SegmentUploader::upload(const string& path, uint64_t bytes, S3Client& client) {
+    auto started = clock::now();
+    auto ok = client.upload(key(path), path, bytes);
+    auto missing = !ok && access(path.c_str(), F_OK) != 0;
+
+    string kept;
+    if (ok) {
+        m_duration.record(chrono::duration_cast<chrono::nanoseconds>(clock::now() - started).count());
+        m_uploaded.add();
+        m_uploadedBytes.add(bytes);
+
+        if (m_options.keep) {
+            auto dir = dirName(path) + "/uploaded";
+            mkdir(dir.c_str(), 0755);
+
+            kept = dir + "/" + baseName(path);
+            if (rename(path.c_str(), kept.c_str()) != 0)
+                kept = path;
+        } else {
+            unlink(path.c_str());
+        }
+
+        Log::info("uploaded ", path, " to ", key(path));
+    } else if (!missing) {
+        m_failed.add();
+        Log::error("unable to upload ", path, ": ", client.error());
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    m_uploadDone.notify_all();
+
+    auto it = find(path);
+    if (it == m_segments.end())
+        return;
+
+    it->busy = false;
+
+    if (ok && m_options.keep) {
+        it->path = kept;
+        it->uploaded = true;
+    } else if (ok || missing) {
+        // deleted after the upload, or by someone else before it
+        m_diskBytes -= it->bytes;
+        m_segments.erase(it);
+    } else {
+        auto backoff = min<chrono::seconds>(c_minBackoff * (1u << min(it->attempts, 8u)), c_maxBackoff);
+        it->attempts++;
+        it->notBefore = clock::now() + backoff;
+    }
+
+    // whatever was held back while this one was busy
+    enforceLimit();
+    updateGauges();
+}
@@ -0,0 +1,123 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_SEGMENTUPLOADER_H
+#define MEETING_SDK_LINUX_SAMPLE_SEGMENTUPLOADER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../egress/S3Client.h"
+#include "../util/Metrics.h"
+
+using namespace std;
+
+struct UploadOptions {
+    // no bucket keeps the segments on disk, still within maxDiskBytes
+    S3Options s3;
+    string prefix;
+    unsigned int concurrency = 2;
+    // move uploaded segments to uploaded/ instead of deleting them
+    bool keep = false;
+    // finished segments are deleted oldest first, uploaded ones before the rest; 0 for no bound
+    uint64_t maxDiskBytes = 0;
+};
+
+/**
+ * Takes finished recording segments off the media threads and uploads them from a pool
+ * of I/O threads, each with its own S3 connection.
+ *
+ * A segment that fails is retried with a growing delay for as long as it is on disk. What
+ * bounds the disk is maxDiskBytes: once the finished segments take more, the oldest are
+ * deleted, those already uploaded first. The segments being written come on top, one
+ * per stream.
+ *
+ * recover() picks up what a killed process left in a directory. It only runs when no
+ * other live process records there: each one holds a shared lock on the directory, and
+ * recovery needs it exclusively, so a segment still being written is never touched.
+ */
+class SegmentUploader {
+    typedef chrono::steady_clock clock;
+
+    const chrono::seconds c_minBackoff{2};
+    const chrono::seconds c_maxBackoff{300};
+
+    struct Segment {
+        string path;
+        uint64_t bytes = 0;
+        bool uploaded = false;
+        bool busy = false;
+        unsigned int attempts = 0;
+        clock::time_point notBefore;
+    };
+
+    UploadOptions m_options;
+
+    mutex m_mutex;
+    condition_variable m_wake;
+    // signalled whenever an upload ends, for drain()
+    condition_variable m_uploadDone;
+    bool m_stopping = false;
+    deque<Segment> m_segments;
+    uint64_t m_diskBytes = 0;
+    vector<thread> m_threads;
+    vector<int> m_locks;
+
+    Counter& m_uploaded;
+    Counter& m_uploadedBytes;
+    Counter& m_failed;
+    Counter& m_evicted;
+    Gauge& m_disk;
+    Gauge& m_pending;
+    Histogram& m_duration;
+
+    void run();
+    void upload(const string& path, uint64_t bytes, S3Client& client);
+    void recover(const string& dir);
+    void track(const string& path, bool uploaded);
+
+    /**
+     * Delete segments until the finished ones fit maxDiskBytes; call with m_mutex held
+     */
+    void enforceLimit();
+    void updateGauges();
+    size_t pending() const;
+    deque<Segment>::iterator find(const string& path);
+    string key(const string& path) const;
+
+public:
+    SegmentUploader();
+    ~SegmentUploader();
+
+    SegmentUploader(const SegmentUploader&) = delete;
+    SegmentUploader& operator=(const SegmentUploader&) = delete;
+
+    /**
+     * Recover the given recording directories and start the upload threads
+     * @param dirs directories the segments are written to
+     */
+    void start(const UploadOptions& options, const vector<string>& dirs);
+
+    /**
+     * Let the uploads in flight finish and stop; what is left stays on disk for the next start
+     */
+    void stop();
+
+    /**
+     * Keep uploading until nothing is pending or the deadline has passed, then stop; for a
+     * shutdown, which should take the last segments along
+     */
+    void drain(chrono::steady_clock::time_point deadline);
+
+    /**
+     * Queue a finished segment, from any thread
+     */
+    void add(const string& path);
+
+    bool isRunning() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_SEGMENTUPLOADER_H
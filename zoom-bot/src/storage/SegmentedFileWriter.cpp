@@ -0,0 +1,138 @@
+#include "SegmentedFileWriter.h"
+
+#include <sys/stat.h>
+
+static void putLE(char* out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++)
+        out[i] = static_cast<char>(value >> (8 * i));
+}
+
+SegmentedFileWriter::~SegmentedFileWriter() {
+    close();
+}
+
+bool SegmentedFileWriter::open(const string& path, const SegmentOptions& options,
+                               const SegmentSequence::Finished& onFinished) {
+    close();
+    m_segments = SegmentSequence();
+
+    if (!options.enabled())
+        return m_file.open(path);
+
+    auto ext = string(".wav");
+    m_wav = path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+    m_segments = SegmentSequence(path, options, onFinished);
+
+    return true;
+}
+
+bool SegmentedFileWriter::openSegment(uint32_t sampleRate, uint16_t channels) {
+    auto path = m_segments.next();
+    if (!m_file.open(path, true))
+        return false;
+
+    m_bytes = 0;
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+
+    if (!m_wav)
+        return true;
+
+    // sizes as large as they go until finishSegment() knows them
+    char header[c_wavHeader];
+    uint16_t blockAlign = channels * 2;
+
+    memcpy(header, "RIFF", 4);
+    putLE(header + 4, 0xFFFFFFFF, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    putLE(header + 16, 16, 4);
+    putLE(header + 20, 1, 2);
+    putLE(header + 22, channels, 2);
+    putLE(header + 24, sampleRate, 4);
+    putLE(header + 28, sampleRate * blockAlign, 4);
+    putLE(header + 32, blockAlign, 2);
+    putLE(header + 34, 16, 2);
+    memcpy(header + 36, "data", 4);
+    putLE(header + 40, 0xFFFFFFFF - 36, 4);
+
+    return m_file.write(header, sizeof(header));
+}
+
+void SegmentedFileWriter::finishSegment() {
+    m_file.close();
+
+    if (m_wav)
+        repairWav(m_segments.current());
+
+    m_segments.finish();
+}
+
+bool SegmentedFileWriter::write(const char* buf, size_t len, uint32_t sampleRate, uint16_t channels) {
+    if (!m_segments.enabled())
+        return m_file.write(buf, len);
+
+    if (m_file.isOpen()) {
+        auto formatChanged = m_wav && (sampleRate != m_sampleRate || channels != m_channels);
+        if (formatChanged || m_segments.due(m_bytes))
+            finishSegment();
+    }
+
+    if (!m_file.isOpen() && !openSegment(sampleRate, channels))
+        return false;
+
+    m_bytes += len;
+    return m_file.write(buf, len);
+}
+
+void SegmentedFileWriter::close() {
+    if (!m_file.isOpen())
+        return;
+
+    if (m_segments.enabled())
+        finishSegment();
+    else
+        m_file.close();
+}
+
+bool SegmentedFileWriter::isOpen() const {
+    return m_file.isOpen() || m_segments.enabled();
+}
+
+chrono::steady_clock::duration SegmentedFileWriter::idle() const {
+    return m_file.idle();
+}
+
+bool SegmentedFileWriter::repairWav(const string& path) {
+    auto fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    char header[c_wavHeader];
+    struct stat st;
+
+    auto valid = fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(c_wavHeader) &&
+                 pread(fd, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                 memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0 &&
+                 memcmp(header + 36, "data", 4) == 0;
+
+    if (!valid) {
+        ::close(fd);
+        return false;
+    }
+
+    // a crash can leave half a sample frame at the end
+    auto blockAlign = static_cast<uint8_t>(header[32]) | static_cast<uint8_t>(header[33]) << 8;
+    uint64_t data = st.st_size - c_wavHeader;
+    if (blockAlign > 0)
+        data -= data % blockAlign;
+
+    putLE(header + 4, static_cast<uint32_t>(data + 36), 4);
+    putLE(header + 40, static_cast<uint32_t>(data), 4);
+
+    auto ok = ftruncate(fd, c_wavHeader + data) == 0 &&
+              pwrite(fd, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+              fdatasync(fd) == 0;
+    ::close(fd);
+
+    return ok;
+}
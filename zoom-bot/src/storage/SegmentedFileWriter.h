@@ -0,0 +1,76 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_SEGMENTEDFILEWRITER_H
+#define MEETING_SDK_LINUX_SAMPLE_SEGMENTEDFILEWRITER_H
+
+#include <cstdint>
+#include <string>
+
+#include "../util/BufferedFileWriter.h"
+#include "SegmentSequence.h"
+
+using namespace std;
+
+/**
+ * Append-only recording through a BufferedFileWriter that rolls over into segments.
+ *
+ * Without segment options it appends to the one file it was opened with. With them every
+ * segment is a file of its own, and a recording to a .wav path gets linear16 WAV segments:
+ * the header goes out first with open sizes and is completed when the segment is finished,
+ * or by repairWav() if the process died first. A format change also starts a new segment.
+ */
+class SegmentedFileWriter {
+    static const size_t c_wavHeader = 44;
+
+    BufferedFileWriter m_file;
+    SegmentSequence m_segments;
+
+    bool m_wav = false;
+    uint32_t m_sampleRate = 0;
+    uint16_t m_channels = 0;
+    uint64_t m_bytes = 0;
+
+    bool openSegment(uint32_t sampleRate, uint16_t channels);
+    void finishSegment();
+
+public:
+    SegmentedFileWriter() = default;
+    ~SegmentedFileWriter();
+
+    SegmentedFileWriter(SegmentedFileWriter&& other) noexcept = default;
+    SegmentedFileWriter& operator=(SegmentedFileWriter&& other) noexcept = default;
+
+    /**
+     * @param path file to append to, or the name the segments are derived from
+     * @param onFinished called with every finished segment
+     * @return true if the file is open; segments are only created by the first write
+     */
+    bool open(const string& path, const SegmentOptions& options = SegmentOptions(),
+              const SegmentSequence::Finished& onFinished = nullptr);
+
+    /**
+     * Append bytes, finishing the current segment first if it is full
+     * @param sampleRate rate of the linear16 audio in buf, for WAV segments
+     * @param channels channels of the audio in buf, for WAV segments
+     * @return false if the data could not be written
+     */
+    bool write(const char* buf, size_t len, uint32_t sampleRate = 0, uint16_t channels = 0);
+
+    /**
+     * Flush and close the file, finishing the current segment
+     */
+    void close();
+
+    bool isOpen() const;
+
+    /**
+     * @return time since the last write, used to retire idle handles
+     */
+    chrono::steady_clock::duration idle() const;
+
+    /**
+     * Fill in the sizes of a WAV file from its length
+     * @return false if it is not a WAV file or cannot be written
+     */
+    static bool repairWav(const string& path);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_SEGMENTEDFILEWRITER_H
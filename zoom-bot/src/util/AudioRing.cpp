@@ -0,0 +1,155 @@
+#include "AudioRing.h"
+
+AudioRing::AudioRing(size_t slots, size_t slotSize, OverflowPolicy policy) :
+        m_slotSize(slotSize), m_policy(policy) {
+    // round up to a power of two so positions map to slots with a mask
+    m_capacity = 2;
+    while (m_capacity < slots)
+        m_capacity <<= 1;
+
+    m_slots = make_unique<Slot[]>(m_capacity);
+    m_storage = make_unique<char[]>(m_capacity * m_slotSize);
+
+    for (size_t i = 0; i < m_capacity; i++) {
+        m_slots[i].seq.store(i, memory_order_relaxed);
+        m_slots[i].len = 0;
+        m_slots[i].data = m_storage.get() + i * m_slotSize;
+    }
+
+    m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+AudioRing::~AudioRing() {
+    if (m_eventFd != -1)
+        close(m_eventFd);
+}
+
+bool AudioRing::push(const char* buf, size_t len) {
+    return push(nullptr, 0, buf, len);
+}
+
+bool AudioRing::push(const void* head, size_t headLen, const char* buf, size_t len) {
+    if (headLen + len > m_slotSize) {
+        m_droppedNewest.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    auto pos = m_head.load(memory_order_relaxed);
+    auto& slot = m_slots[pos & (m_capacity - 1)];
+
+    if (slot.seq.load(memory_order_acquire) != pos) {
+        // full: the slot still holds data from one lap ago. Once the tail moved past it the
+        // consumer has it claimed, and evicting the oldest would free a slot we cannot use
+        auto claimed = m_tail.load(memory_order_acquire) + m_capacity > pos;
+        auto evicted = m_policy == OverflowPolicy::DropOldest && !claimed && evictOldest();
+
+        if (!evicted || slot.seq.load(memory_order_acquire) != pos) {
+            m_droppedNewest.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+    }
+
+    if (headLen > 0)
+        memcpy(slot.data, head, headLen);
+    if (len > 0)
+        memcpy(slot.data + headLen, buf, len);
+    slot.len = headLen + len;
+    slot.seq.store(pos + 1, memory_order_release);
+    m_head.store(pos + 1, memory_order_release);
+
+    // pairs with the fence in sleep(): either we see the consumer asleep or it sees this slot
+    atomic_thread_fence(memory_order_seq_cst);
+    if (m_sleeping.load(memory_order_relaxed) && m_sleeping.exchange(false, memory_order_acq_rel))
+        wake();
+
+    return true;
+}
+
+bool AudioRing::evictOldest() {
+    auto pos = m_tail.load(memory_order_acquire);
+    auto& slot = m_slots[pos & (m_capacity - 1)];
+
+    if (slot.seq.load(memory_order_acquire) != pos + 1)
+        return false;
+
+    // race the consumer for the oldest slot; if it wins, it is already draining
+    if (!m_tail.compare_exchange_strong(pos, pos + 1, memory_order_acq_rel))
+        return false;
+
+    slot.seq.store(pos + m_capacity, memory_order_release);
+    m_droppedOldest.fetch_add(1, memory_order_relaxed);
+
+    return true;
+}
+
+AudioRing::Slot* AudioRing::acquire() {
+    for (;;) {
+        auto pos = m_tail.load(memory_order_acquire);
+        auto& slot = m_slots[pos & (m_capacity - 1)];
+        auto seq = slot.seq.load(memory_order_acquire);
+
+        if (seq == pos)
+            return nullptr;
+
+        if (seq == pos + 1 && m_tail.compare_exchange_weak(pos, pos + 1, memory_order_acq_rel)) {
+            m_claimed = pos;
+            return &slot;
+        }
+        // the producer evicted the slot under us, try the next one
+    }
+}
+
+void AudioRing::release(Slot* slot) {
+    slot->seq.store(m_claimed + m_capacity, memory_order_release);
+}
+
+bool AudioRing::sleep() {
+    m_sleeping.store(true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (occupancy() == 0)
+        return true;
+
+    m_sleeping.store(false, memory_order_relaxed);
+    return false;
+}
+
+void AudioRing::clear() {
+    eventfd_t value;
+    eventfd_read(m_eventFd, &value);
+}
+
+void AudioRing::wake() {
+    eventfd_write(m_eventFd, 1);
+}
+
+int AudioRing::fd() const {
+    return m_eventFd;
+}
+
+size_t AudioRing::capacity() const {
+    return m_capacity;
+}
+
+size_t AudioRing::slotSize() const {
+    return m_slotSize;
+}
+
+size_t AudioRing::occupancy() const {
+    auto head = m_head.load(memory_order_acquire);
+    auto tail = m_tail.load(memory_order_acquire);
+
+    return head > tail ? head - tail : 0;
+}
+
+OverflowPolicy AudioRing::policy() const {
+    return m_policy;
+}
+
+uint64_t AudioRing::droppedOldest() const {
+    return m_droppedOldest.load(memory_order_relaxed);
+}
+
+uint64_t AudioRing::droppedNewest() const {
+    return m_droppedNewest.load(memory_order_relaxed);
+}
@@ -0,0 +1,124 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_AUDIORING_H
+#define MEETING_SDK_LINUX_SAMPLE_AUDIORING_H
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "OverflowPolicy.h"
+
+using namespace std;
+
+/**
+ * Bounded single-producer/single-consumer ring of preallocated PCM slots.
+ *
+ * The producer is the SDK audio callback thread and only ever copies into a free slot.
+ * The consumer claims a slot, works on it in place and releases it. Each slot carries a
+ * sequence number, so with DropOldest the producer can evict the oldest unclaimed slot
+ * without ever touching one the consumer is still working on. While the consumer holds the
+ * slot the producer would write next, the newest chunk is dropped and nothing is evicted.
+ *
+ * The consumer sleeps on an eventfd, so it can wait for audio in the same epoll set as its
+ * sockets; the producer only pays for the eventfd write when the consumer is asleep.
+ */
+class AudioRing {
+public:
+    struct Slot {
+        atomic<uint64_t> seq;
+        uint32_t len;
+        char* data;
+    };
+
+private:
+    alignas(64) atomic<uint64_t> m_head{0};
+    alignas(64) atomic<uint64_t> m_tail{0};
+    alignas(64) atomic<bool> m_sleeping{false};
+    int m_eventFd;
+
+    alignas(64) atomic<uint64_t> m_droppedOldest{0};
+    atomic<uint64_t> m_droppedNewest{0};
+
+    uint64_t m_claimed = 0;
+
+    size_t m_capacity;
+    size_t m_slotSize;
+    OverflowPolicy m_policy;
+
+    unique_ptr<Slot[]> m_slots;
+    unique_ptr<char[]> m_storage;
+
+    bool evictOldest();
+
+public:
+    AudioRing(size_t slots, size_t slotSize, OverflowPolicy policy);
+    ~AudioRing();
+
+    AudioRing(const AudioRing&) = delete;
+    AudioRing& operator=(const AudioRing&) = delete;
+
+    /**
+     * Copy a buffer into the next free slot. Producer side only.
+     * @param buf bytes to copy
+     * @param len number of bytes, at most slotSize()
+     * @return false if the buffer was dropped
+     */
+    bool push(const char* buf, size_t len);
+
+    /**
+     * Copy a header followed by a buffer into the next free slot. Producer side only.
+     * @param head header bytes
+     * @param headLen header size
+     * @param buf payload bytes
+     * @param len payload size, headLen + len must fit slotSize()
+     * @return false if the buffer was dropped
+     */
+    bool push(const void* head, size_t headLen, const char* buf, size_t len);
+
+    /**
+     * Claim the oldest filled slot. Consumer side only.
+     * @return the slot, or nullptr when the ring is empty
+     */
+    Slot* acquire();
+
+    /**
+     * Hand a claimed slot back to the producer
+     * @param slot slot returned by acquire()
+     */
+    void release(Slot* slot);
+
+    /**
+     * Announce that the consumer is about to block on fd(). Consumer side only.
+     * @return false if slots arrived in the meantime and the consumer should not block
+     */
+    bool sleep();
+
+    /**
+     * Reset fd() after it became readable. Consumer side only.
+     */
+    void clear();
+
+    /**
+     * Make fd() readable regardless of the ring, e.g. to stop the consumer
+     */
+    void wake();
+
+    /**
+     * @return eventfd that becomes readable when a sleeping consumer has work
+     */
+    int fd() const;
+
+    size_t capacity() const;
+    size_t slotSize() const;
+    size_t occupancy() const;
+
+    OverflowPolicy policy() const;
+
+    uint64_t droppedOldest() const;
+    uint64_t droppedNewest() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_AUDIORING_H
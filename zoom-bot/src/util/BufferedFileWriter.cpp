@@ -0,0 +1,152 @@
+#include "BufferedFileWriter.h"
+
+BufferedFileWriter::BufferedFileWriter(size_t capacity, chrono::milliseconds syncInterval) :
+        m_capacity(capacity), m_syncInterval(syncInterval) {}
+
+BufferedFileWriter::~BufferedFileWriter() {
+    close();
+}
+
+BufferedFileWriter::BufferedFileWriter(BufferedFileWriter&& other) noexcept {
+    *this = std::move(other);
+}
+
+BufferedFileWriter& BufferedFileWriter::operator=(BufferedFileWriter&& other) noexcept {
+    if (this == &other)
+        return *this;
+
+    close();
+
+    m_fd = other.m_fd;
+    m_path = std::move(other.m_path);
+    m_buf = std::move(other.m_buf);
+    m_capacity = other.m_capacity;
+    m_len = other.m_len;
+    m_syncInterval = other.m_syncInterval;
+    m_lastWrite = other.m_lastWrite;
+    m_lastSync = other.m_lastSync;
+
+    other.m_fd = -1;
+    other.m_len = 0;
+
+    return *this;
+}
+
+bool BufferedFileWriter::open(const string& path, bool truncate) {
+    close();
+
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : O_APPEND), 0644);
+    if (m_fd == -1) {
+        Log::error("failed to open file path: " + path);
+        return false;
+    }
+
+    if (!m_buf)
+        m_buf = make_unique<char[]>(m_capacity);
+
+    m_path = path;
+    m_len = 0;
+    m_lastWrite = m_lastSync = clock::now();
+
+    return true;
+}
+
+bool BufferedFileWriter::write(const char* buf, size_t len) {
+    if (m_fd == -1)
+        return false;
+
+    m_lastWrite = clock::now();
+
+    if (m_len + len <= m_capacity) {
+        memcpy(m_buf.get() + m_len, buf, len);
+        m_len += len;
+
+        if (m_len == m_capacity)
+            return flush(m_lastWrite - m_lastSync >= m_syncInterval);
+
+        return true;
+    }
+
+    // buffer and new chunk leave together in a single syscall
+    struct iovec iov[2] = {
+        {m_buf.get(), m_len},
+        {const_cast<char*>(buf), len}
+    };
+
+    auto ok = writeAll(iov, 2);
+    m_len = 0;
+
+    if (ok && m_lastWrite - m_lastSync >= m_syncInterval) {
+        fdatasync(m_fd);
+        m_lastSync = m_lastWrite;
+    }
+
+    return ok;
+}
+
+bool BufferedFileWriter::flush(bool sync) {
+    if (m_fd == -1)
+        return false;
+
+    auto ok = true;
+    if (m_len > 0) {
+        struct iovec iov = {m_buf.get(), m_len};
+        ok = writeAll(&iov, 1);
+        m_len = 0;
+    }
+
+    if (ok && sync) {
+        fdatasync(m_fd);
+        m_lastSync = clock::now();
+    }
+
+    return ok;
+}
+
+bool BufferedFileWriter::writeAll(struct iovec* iov, int count) {
+    while (count > 0) {
+        auto ret = writev(m_fd, iov, count);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+
+            Log::error("failed to write file: " + m_path);
+            return false;
+        }
+
+        // advance past whatever the kernel took
+        size_t written = ret;
+        while (count > 0 && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+
+    return true;
+}
+
+void BufferedFileWriter::close() {
+    if (m_fd == -1)
+        return;
+
+    flush(true);
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+bool BufferedFileWriter::isOpen() const {
+    return m_fd != -1;
+}
+
+const string& BufferedFileWriter::path() const {
+    return m_path;
+}
+
+BufferedFileWriter::clock::duration BufferedFileWriter::idle() const {
+    return clock::now() - m_lastWrite;
+}
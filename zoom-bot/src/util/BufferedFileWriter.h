@@ -0,0 +1,86 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_BUFFEREDFILEWRITER_H
+#define MEETING_SDK_LINUX_SAMPLE_BUFFEREDFILEWRITER_H
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "Log.h"
+
+using namespace std;
+
+/**
+ * Long-lived append-only file handle with a large userspace buffer.
+ *
+ * Chunks are collected in the buffer and leave in one writev() together with the chunk
+ * that no longer fits, and the file is fdatasync'ed at most once per sync interval.
+ */
+class BufferedFileWriter {
+    typedef chrono::steady_clock clock;
+
+    int m_fd = -1;
+    string m_path;
+
+    unique_ptr<char[]> m_buf;
+    size_t m_capacity;
+    size_t m_len = 0;
+
+    clock::duration m_syncInterval;
+    clock::time_point m_lastWrite;
+    clock::time_point m_lastSync;
+
+    bool writeAll(struct iovec* iov, int count);
+
+public:
+    BufferedFileWriter(size_t capacity = 256 * 1024, chrono::milliseconds syncInterval = chrono::seconds(5));
+    ~BufferedFileWriter();
+
+    BufferedFileWriter(BufferedFileWriter&& other) noexcept;
+    BufferedFileWriter& operator=(BufferedFileWriter&& other) noexcept;
+
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+    BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+    /**
+     * Open a file for appending, creating it if needed
+     * @param path file path
+     * @param truncate start the file over, for containers that cannot be appended to
+     * @return true if the file is open
+     */
+    bool open(const string& path, bool truncate = false);
+
+    /**
+     * Append bytes to the file through the buffer
+     * @param buf bytes to write
+     * @param len number of bytes
+     * @return false if a flush to disk failed
+     */
+    bool write(const char* buf, size_t len);
+
+    /**
+     * Write the buffer to the file and optionally sync it to disk
+     * @param sync call fdatasync after writing
+     */
+    bool flush(bool sync = false);
+
+    /**
+     * Flush, sync and close the file
+     */
+    void close();
+
+    bool isOpen() const;
+    const string& path() const;
+
+    /**
+     * @return time since the last write, used to retire idle handles
+     */
+    clock::duration idle() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_BUFFEREDFILEWRITER_H
@@ -0,0 +1,44 @@
+#include "ChunkPool.h"
+
+ChunkPool::ChunkPool(size_t chunkSize) : m_chunkSize(chunkSize) {}
+
+Chunk* ChunkPool::acquire() {
+    Chunk* chunk;
+
+    if (m_free.empty()) {
+        // grows until it covers the deepest subscriber queues, then stays there
+        auto fresh = make_unique<Chunk>();
+        fresh->data = make_unique<char[]>(m_chunkSize);
+        fresh->owner = this;
+        chunk = fresh.get();
+
+        m_chunks.push_back(std::move(fresh));
+        m_free.reserve(m_chunks.size());
+    } else {
+        chunk = m_free.back();
+        m_free.pop_back();
+    }
+
+    chunk->refs = 1;
+    chunk->len = 0;
+    chunk->headerLen = 0;
+
+    return chunk;
+}
+
+void ChunkPool::ref(Chunk* chunk) {
+    chunk->refs++;
+}
+
+void ChunkPool::unref(Chunk* chunk) {
+    if (--chunk->refs == 0)
+        chunk->owner->m_free.push_back(chunk);
+}
+
+size_t ChunkPool::chunkSize() const {
+    return m_chunkSize;
+}
+
+size_t ChunkPool::allocated() const {
+    return m_chunks.size();
+}
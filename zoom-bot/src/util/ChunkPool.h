@@ -0,0 +1,56 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_CHUNKPOOL_H
+#define MEETING_SDK_LINUX_SAMPLE_CHUNKPOOL_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+class ChunkPool;
+
+/**
+ * Reference counted buffer queued to any number of subscribers at once
+ */
+struct Chunk {
+    uint32_t refs = 0;
+    uint32_t len = 0;
+    // bytes at the front that only framed subscribers receive
+    uint32_t headerLen = 0;
+    unique_ptr<char[]> data;
+    ChunkPool* owner = nullptr;
+};
+
+/**
+ * Free list of fixed-size chunks shared by the subscribers of one server.
+ *
+ * A chunk is filled once and queued by pointer to every subscriber; it goes back to the
+ * free list when the last one has sent it. The pool is owned by a single thread, so the
+ * reference counts are plain integers.
+ */
+class ChunkPool {
+    size_t m_chunkSize;
+
+    vector<unique_ptr<Chunk>> m_chunks;
+    vector<Chunk*> m_free;
+
+public:
+    explicit ChunkPool(size_t chunkSize);
+
+    /**
+     * Take a chunk with one reference held by the caller
+     */
+    Chunk* acquire();
+
+    static void ref(Chunk* chunk);
+
+    /**
+     * Drop a reference, returning the chunk to the free list of its pool with the last one
+     */
+    static void unref(Chunk* chunk);
+
+    size_t chunkSize() const;
+    size_t allocated() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_CHUNKPOOL_H
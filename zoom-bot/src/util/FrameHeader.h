@@ -0,0 +1,93 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_FRAMEHEADER_H
+#define MEETING_SDK_LINUX_SAMPLE_FRAMEHEADER_H
+
+#include <time.h>
+
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * Kind of data carried by a frame
+ */
+enum class StreamType : uint8_t {
+    Mixed = 0,
+    OneWay = 1,
+    Share = 2,
+    // results of the bot's own transcription, relayed as they arrive
+    Transcript = 3,
+    // JSON list of the nodes whose one-way audio follows, with their display names
+    Speakers = 4
+};
+
+/**
+ * Encoding of the frame payload
+ */
+enum class PayloadFormat : uint8_t {
+    Linear16 = 0,
+    Json = 1,
+    // one codec packet per frame, after a codec header frame
+    Opus = 2,
+    Flac = 3
+};
+
+/**
+ * Fixed little-endian header in front of every chunk of a framed socket subscriber.
+ *
+ *     offset  size  field
+ *          0     4  magic "ZMAF"
+ *          4     1  version
+ *          5     1  stream type
+ *          6     1  payload format
+ *          7     1  channels
+ *          8     4  payload length in bytes
+ *         12     4  node_id, 0 for the mixed stream
+ *         16     4  sample rate in Hz
+ *         20     4  flags: 1 chunks missing before or inside this one,
+ *                   2 speech start, 4 speech end, 8 silence keepalive; markers
+ *                   have no payload; 16 codec header (OpusHead, FLAC metadata)
+ *                   ahead of a stream's first packet; 32 silence inserted by the
+ *                   jitter buffer for audio that arrived late or not at all;
+ *                   64 end of stream, the last frame before the bot closes the
+ *                   socket on shutdown, a marker without sequence number
+ *         24     8  sequence number, per stream and node
+ *         32     8  CLOCK_MONOTONIC capture time in nanoseconds
+ *
+ * Python: struct.Struct("<4sBBBBIIIIQQ")
+ */
+struct __attribute__((packed)) FrameHeader {
+    static constexpr uint32_t c_magic = 0x46414d5a;  // "ZMAF" in little endian
+    static constexpr uint8_t c_version = 1;
+    static constexpr uint32_t c_flagDiscontinuity = 1;
+    static constexpr uint32_t c_flagSpeechStart = 2;
+    static constexpr uint32_t c_flagSpeechEnd = 4;
+    static constexpr uint32_t c_flagSilence = 8;
+    static constexpr uint32_t c_flagCodecHeader = 16;
+    static constexpr uint32_t c_flagConcealed = 32;
+    static constexpr uint32_t c_flagEndOfStream = 64;
+
+    uint32_t magic = c_magic;
+    uint8_t version = c_version;
+    StreamType stream = StreamType::Mixed;
+    PayloadFormat format = PayloadFormat::Linear16;
+    uint8_t channels = 1;
+    uint32_t length = 0;
+    uint32_t nodeId = 0;
+    uint32_t sampleRate = 0;
+    uint32_t flags = 0;
+    uint64_t seq = 0;
+    uint64_t timestamp = 0;
+
+    /**
+     * @return the current CLOCK_MONOTONIC time in nanoseconds
+     */
+    static uint64_t now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    }
+};
+
+static_assert(sizeof(FrameHeader) == 40, "FrameHeader is part of the socket protocol");
+
+#endif //MEETING_SDK_LINUX_SAMPLE_FRAMEHEADER_H
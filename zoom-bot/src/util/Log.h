@@ -1,31 +1,150 @@
 #ifndef MEETING_SDK_LINUX_SAMPLE_LOG_H
 #define MEETING_SDK_LINUX_SAMPLE_LOG_H
 
+#include <charconv>
+#include <cstring>
 #include <string>
-#include <iostream>
+#include <string_view>
+#include <type_traits>
+
+#include "LogWriter.h"
 
 using namespace std;
 
-namespace Emoji {
-    const string checkMark = "✅";
-    const string crossMark = "❌";
-    const string hourglass = "⏳";
+// levels below this are compiled out, e.g. -DLOG_MIN_LEVEL=1 drops every Log::debug
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+namespace LogOption {
+    const string debug = "debug";
+    const string info = "info";
+    const string success = "success";
+    const string error = "error";
+
+    const string text = "text";
+    const string json = "json";
+
+    inline LogLevel parseLevel(const string& name) {
+        if (name == debug) return LogLevel::Debug;
+        if (name == success) return LogLevel::Success;
+        if (name == error) return LogLevel::Error;
+        return LogLevel::Info;
+    }
+
+    inline LogFormat parseFormat(const string& name) {
+        return name == json ? LogFormat::Json : LogFormat::Text;
+    }
 }
 
+/**
+ * Log lines are formatted into a fixed-size record by the calling thread and printed by
+ * LogWriter on its own thread, so logging never blocks on stdout or stderr.
+ *
+ * Every argument is appended as it is, strings verbatim and numbers in their shortest
+ * form, which saves building a stringstream on the calling thread:
+ *
+ *     Log::info("video resolution ", width, "x", height);
+ *
+ * Nothing is formatted for a level that is switched off at runtime, and levels below
+ * LOG_MIN_LEVEL do not even leave a call behind.
+ */
 class Log {
-    public:
-        static void success(const string& message) {
-            cout << Emoji::checkMark << " " << message << endl;
+    struct Cursor {
+        char* data;
+        size_t length;
+        bool truncated;
+
+        void append(const char* text, size_t len) {
+            auto room = LogRecord::c_textSize - length;
+            if (len > room) {
+                len = room;
+                truncated = true;
+            }
+
+            memcpy(data + length, text, len);
+            length += len;
         }
 
-        static void info(const std::string& message) {
-            cout << Emoji::hourglass << " " << message << endl;
+        template <typename T>
+        void number(T value) {
+            // straight into the record, a number that does not fit is left out
+            auto result = to_chars(data + length, data + LogRecord::c_textSize, value);
+            if (result.ec != errc())
+                truncated = true;
+            else
+                length = result.ptr - data;
+        }
+    };
 
+    template <typename T>
+    static void append(Cursor& cursor, const T& value) {
+        if constexpr (is_same_v<T, bool>) {
+            append(cursor, value ? "true" : "false");
+        } else if constexpr (is_same_v<T, const char*> || is_same_v<T, char*>) {
+            // C strings handed over by the SDK may be null
+            string_view text = value ? value : "(null)";
+            cursor.append(text.data(), text.size());
+        } else if constexpr (is_convertible_v<const T&, string_view>) {
+            string_view text = value;
+            cursor.append(text.data(), text.size());
+        } else if constexpr (is_enum_v<T>) {
+            append(cursor, static_cast<underlying_type_t<T>>(value));
+        } else if constexpr (is_arithmetic_v<T>) {
+            cursor.number(value);
+        } else {
+            static_assert(is_arithmetic_v<T>, "Log takes strings, numbers and enums");
         }
+    }
 
-        static void error(const string& message) {
-            cerr << Emoji::crossMark << " " << message << endl;
+public:
+    template <LogLevel level, typename... Args>
+    static void write(const Args&... args) {
+        if constexpr (static_cast<int>(level) >= LOG_MIN_LEVEL) {
+            auto& writer = LogWriter::getInstance();
+            if (!writer.enabled(level))
+                return;
+
+            auto* slot = writer.claim(level);
+            if (!slot)
+                return;
+
+            auto& record = slot->record;
+            Cursor cursor{record.text, 0, false};
+            (append(cursor, args), ...);
+
+            record.length = cursor.length;
+            record.truncated = cursor.truncated;
+            writer.publish(slot);
         }
+    }
+
+    template <typename... Args>
+    static void debug(const Args&... args) {
+        write<LogLevel::Debug>(args...);
+    }
+
+    template <typename... Args>
+    static void success(const Args&... args) {
+        write<LogLevel::Success>(args...);
+    }
+
+    template <typename... Args>
+    static void info(const Args&... args) {
+        write<LogLevel::Info>(args...);
+    }
+
+    template <typename... Args>
+    static void error(const Args&... args) {
+        write<LogLevel::Error>(args...);
+    }
+
+    /**
+     * Wait until every line logged so far is printed, e.g. before _Exit()
+     */
+    static void flush() {
+        LogWriter::getInstance().flush();
+    }
 };
 
 
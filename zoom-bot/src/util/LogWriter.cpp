@@ -0,0 +1,267 @@
+#include "LogWriter.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "ThreadRoles.h"
+
+thread_local uint32_t LogWriter::t_threadId = 0;
+
+LogWriter::LogWriter() : m_slots(make_unique<Slot[]>(c_slots)) {
+    m_out.reserve(c_batchBytes);
+    m_err.reserve(c_batchBytes);
+
+    start();
+
+    atexit([] { getInstance().flush(); });
+    pthread_atfork(nullptr, nullptr, afterFork);
+}
+
+LogWriter& LogWriter::getInstance() {
+    // never destroyed, see the class comment
+    static auto* instance = new LogWriter();
+    return *instance;
+}
+
+void LogWriter::start() {
+    for (size_t i = 0; i < c_slots; i++)
+        m_slots[i].seq.store(i, memory_order_relaxed);
+
+    m_head.store(0, memory_order_relaxed);
+    m_tail.store(0, memory_order_relaxed);
+    m_written.store(0, memory_order_relaxed);
+    m_sleeping.store(false, memory_order_relaxed);
+
+    m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    // the writer lives as long as the process, nobody ever joins it
+    thread(&LogWriter::run, this).detach();
+}
+
+void LogWriter::afterFork() {
+    // the writer thread did not survive the fork, and a producer may have been halfway
+    // through a slot; the parent prints the copies of everything queued so far
+    auto& writer = getInstance();
+    close(writer.m_eventFd);
+
+    t_threadId = 0;
+    writer.m_out.clear();
+    writer.m_err.clear();
+    writer.start();
+}
+
+LogWriter::Slot* LogWriter::claim(LogLevel level) {
+    auto pos = m_head.load(memory_order_relaxed);
+
+    for (;;) {
+        auto& slot = m_slots[pos & (c_slots - 1)];
+        auto seq = slot.seq.load(memory_order_acquire);
+        auto diff = static_cast<int64_t>(seq - pos);
+
+        if (diff == 0) {
+            if (m_head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            // full: the slot still holds a line from one lap ago
+            m_dropped.fetch_add(1, memory_order_relaxed);
+            return nullptr;
+        } else {
+            pos = m_head.load(memory_order_relaxed);
+        }
+    }
+
+    auto& slot = m_slots[pos & (c_slots - 1)];
+    slot.record.timestamp = now();
+    slot.record.thread = threadId();
+    slot.record.level = level;
+    slot.record.length = 0;
+    slot.record.truncated = false;
+
+    return &slot;
+}
+
+void LogWriter::publish(Slot* slot) {
+    // the slot was claimed at seq == pos, published it reads pos + 1
+    slot->seq.store(slot->seq.load(memory_order_relaxed) + 1, memory_order_release);
+
+    // pairs with the fence in sleep(): either we see the writer asleep or it sees this line
+    atomic_thread_fence(memory_order_seq_cst);
+    if (m_sleeping.load(memory_order_relaxed) && m_sleeping.exchange(false, memory_order_acq_rel))
+        eventfd_write(m_eventFd, 1);
+}
+
+void LogWriter::run() {
+    ThreadRoles::assign(ThreadRole::Io);
+
+    for (;;) {
+        if (!drain())
+            sleep();
+    }
+}
+
+bool LogWriter::drain() {
+    auto pos = m_tail.load(memory_order_relaxed);
+    auto any = false;
+
+    for (;;) {
+        auto& slot = m_slots[pos & (c_slots - 1)];
+        if (slot.seq.load(memory_order_acquire) != pos + 1)
+            break;
+
+        print(slot.record);
+        slot.seq.store(pos + c_slots, memory_order_release);
+        pos++;
+        any = true;
+
+        if (m_out.size() >= c_batchBytes || m_err.size() >= c_batchBytes)
+            break;
+    }
+
+    auto dropped = m_dropped.load(memory_order_relaxed);
+    if (dropped != m_reportedDrops) {
+        m_err += "log ring full, dropped " + to_string(dropped - m_reportedDrops) + " lines\n";
+        m_reportedDrops = dropped;
+    }
+
+    m_tail.store(pos, memory_order_relaxed);
+    writeAll(STDOUT_FILENO, m_out);
+    writeAll(STDERR_FILENO, m_err);
+    m_written.store(pos, memory_order_release);
+
+    return any;
+}
+
+void LogWriter::sleep() {
+    m_sleeping.store(true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    auto pos = m_tail.load(memory_order_relaxed);
+    if (m_slots[pos & (c_slots - 1)].seq.load(memory_order_acquire) == pos + 1) {
+        m_sleeping.store(false, memory_order_relaxed);
+        return;
+    }
+
+    struct pollfd pfd = {m_eventFd, POLLIN, 0};
+    poll(&pfd, 1, c_idleMs);
+
+    eventfd_t value;
+    eventfd_read(m_eventFd, &value);
+    m_sleeping.store(false, memory_order_relaxed);
+}
+
+void LogWriter::print(const LogRecord& record) {
+    // errors keep going to stderr as they always did
+    auto& out = record.level == LogLevel::Error ? m_err : m_out;
+
+    if (m_format.load(memory_order_relaxed) == LogFormat::Json)
+        printJson(record, out);
+    else
+        printText(record, out);
+}
+
+void LogWriter::printText(const LogRecord& record, string& out) {
+    switch (record.level) {
+        case LogLevel::Success:
+            out += Emoji::checkMark + " ";
+            break;
+        case LogLevel::Error:
+            out += Emoji::crossMark + " ";
+            break;
+        case LogLevel::Info:
+            out += Emoji::hourglass + " ";
+            break;
+        case LogLevel::Debug:
+            out += "   ";
+            break;
+    }
+
+    out.append(record.text, record.length);
+    if (record.truncated)
+        out += "...";
+    out += '\n';
+}
+
+void LogWriter::printJson(const LogRecord& record, string& out) {
+    static const char* levels[] = {"debug", "info", "success", "error"};
+
+    auto seconds = static_cast<time_t>(record.timestamp / 1000000000ull);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+
+    char time[40];
+    auto len = strftime(time, sizeof(time), "%Y-%m-%dT%H:%M:%S", &utc);
+    snprintf(time + len, sizeof(time) - len, ".%06uZ", static_cast<unsigned>(record.timestamp % 1000000000ull / 1000));
+
+    out += "{\"time\":\"";
+    out += time;
+    out += "\",\"level\":\"";
+    out += levels[static_cast<int>(record.level)];
+    out += "\",\"thread\":";
+    out += to_string(record.thread);
+    out += ",\"message\":\"";
+
+    for (size_t i = 0; i < record.length; i++) {
+        auto c = record.text[i];
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+
+    out += "\"";
+    if (record.truncated)
+        out += ",\"truncated\":true";
+    out += "}\n";
+}
+
+void LogWriter::writeAll(int fd, string& buffer) {
+    size_t written = 0;
+    while (written < buffer.size()) {
+        auto ret = ::write(fd, buffer.data() + written, buffer.size() - written);
+        if (ret == -1 && errno == EINTR)
+            continue;
+
+        // nobody reads the stream anymore, the lines are lost either way
+        if (ret <= 0)
+            break;
+
+        written += ret;
+    }
+
+    buffer.clear();
+}
+
+void LogWriter::setLevel(LogLevel level) {
+    m_level.store(level, memory_order_relaxed);
+}
+
+void LogWriter::setFormat(LogFormat format) {
+    m_format.store(format, memory_order_relaxed);
+}
+
+void LogWriter::flush() {
+    auto target = m_head.load(memory_order_acquire);
+
+    if (m_sleeping.exchange(false, memory_order_acq_rel))
+        eventfd_write(m_eventFd, 1);
+
+    for (int i = 0; i < 1000 && m_written.load(memory_order_acquire) < target; i++)
+        usleep(1000);
+}
+
+uint64_t LogWriter::dropped() const {
+    return m_dropped.load(memory_order_relaxed);
+}
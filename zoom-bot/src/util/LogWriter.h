@@ -0,0 +1,154 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_LOGWRITER_H
+#define MEETING_SDK_LINUX_SAMPLE_LOGWRITER_H
+
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace Emoji {
+    const string checkMark = "✅";
+    const string crossMark = "❌";
+    const string hourglass = "⏳";
+}
+
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Success = 2,
+    Error = 3,
+};
+
+enum class LogFormat : uint8_t {
+    Text,
+    Json,
+};
+
+/**
+ * Fixed-size log line, formatted by the thread that logs and printed by the writer
+ */
+struct LogRecord {
+    static const size_t c_size = 512;
+    static const size_t c_textSize = c_size - 16;
+
+    uint64_t timestamp;
+    uint32_t thread;
+    uint16_t length;
+    LogLevel level;
+    bool truncated;
+    char text[c_textSize];
+};
+
+static_assert(sizeof(LogRecord) == LogRecord::c_size, "LogRecord fills its slot exactly");
+
+/**
+ * Background writer behind Log.
+ *
+ * Any thread claims a slot of a bounded multi-producer ring, formats its line right into
+ * it and publishes it; one writer thread prints whatever is published in a single write()
+ * per stream. A full ring drops the line and counts it instead of blocking, so neither
+ * SDK callbacks nor the media threads ever wait for stdout. Like AudioRing, a producer
+ * only wakes the writer's eventfd when the writer is asleep.
+ *
+ * The writer is never destroyed, so objects logging from their destructors at exit still
+ * have it; an atexit() handler flushes what is left. A forked child starts with an empty
+ * ring and its own writer thread, the parent prints the lines queued before the fork.
+ */
+class LogWriter {
+public:
+    struct Slot {
+        atomic<uint64_t> seq;
+        LogRecord record;
+    };
+
+private:
+    static const size_t c_slots = 2048;
+    static const size_t c_batchBytes = 64 * 1024;
+    static const int c_idleMs = 200;
+
+    alignas(64) atomic<uint64_t> m_head{0};
+    alignas(64) atomic<uint64_t> m_tail{0};
+    alignas(64) atomic<bool> m_sleeping{false};
+    atomic<uint64_t> m_written{0};
+    atomic<uint64_t> m_dropped{0};
+
+    atomic<LogLevel> m_level{LogLevel::Info};
+    atomic<LogFormat> m_format{LogFormat::Text};
+
+    unique_ptr<Slot[]> m_slots;
+    int m_eventFd = -1;
+
+    string m_out;
+    string m_err;
+    uint64_t m_reportedDrops = 0;
+
+    LogWriter();
+
+    void start();
+    void run();
+    bool drain();
+    void print(const LogRecord& record);
+    void printText(const LogRecord& record, string& out);
+    void printJson(const LogRecord& record, string& out);
+    void sleep();
+    static void writeAll(int fd, string& buffer);
+    static void afterFork();
+
+public:
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    static LogWriter& getInstance();
+
+    bool enabled(LogLevel level) const {
+        return level >= m_level.load(memory_order_relaxed);
+    }
+
+    /**
+     * Reserve the next record; fill it in and hand it to publish()
+     * @return nullptr if the ring is full and the line has to be dropped
+     */
+    Slot* claim(LogLevel level);
+    void publish(Slot* slot);
+
+    void setLevel(LogLevel level);
+    void setFormat(LogFormat format);
+
+    /**
+     * Wait, at most about a second, until everything logged so far is printed
+     */
+    void flush();
+
+    uint64_t dropped() const;
+
+    /**
+     * @return CLOCK_REALTIME in nanoseconds
+     */
+    static uint64_t now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    }
+
+    static uint32_t threadId() {
+        if (t_threadId == 0)
+            t_threadId = static_cast<uint32_t>(syscall(SYS_gettid));
+        return t_threadId;
+    }
+
+private:
+    // cleared in a forked child, whose only thread has a new id
+    static thread_local uint32_t t_threadId;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_LOGWRITER_H
@@ -0,0 +1,240 @@
+#include "Metrics.h"
+
+#include <iomanip>
+#include <sstream>
+
+void Counter::add(uint64_t n) {
+    m_shards[shard()].value.fetch_add(n, memory_order_relaxed);
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (auto& shard : m_shards)
+        total += shard.value.load(memory_order_relaxed);
+
+    return total;
+}
+
+size_t Counter::shard() {
+    static atomic<size_t> next{0};
+    thread_local size_t index = next.fetch_add(1, memory_order_relaxed) % c_shards;
+
+    return index;
+}
+
+size_t Histogram::index(uint64_t value) {
+    if (value < c_subBuckets)
+        return value;
+
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent >= c_maxExponent)
+        return c_buckets - 1;
+
+    // the bits right below the leading one pick the linear bucket
+    auto sub = (value >> (exponent - c_subBits)) & (c_subBuckets - 1);
+    return (exponent - c_subBits + 1) * c_subBuckets + sub;
+}
+
+uint64_t Histogram::upperBound(size_t index) {
+    if (index < c_subBuckets)
+        return index;
+
+    auto exponent = index / c_subBuckets + c_subBits - 1;
+    auto sub = index % c_subBuckets;
+
+    return ((c_subBuckets + sub + 1) << (exponent - c_subBits)) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    m_buckets[index(value)].fetch_add(1, memory_order_relaxed);
+    m_sum.fetch_add(value, memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.buckets.resize(c_buckets);
+
+    for (size_t i = 0; i < c_buckets; i++) {
+        snapshot.buckets[i] = m_buckets[i].load(memory_order_relaxed);
+        snapshot.count += snapshot.buckets[i];
+    }
+
+    // counted from the buckets, so the quantiles always add up to the count
+    snapshot.sum = m_sum.load(memory_order_relaxed);
+    return snapshot;
+}
+
+uint64_t Histogram::Snapshot::quantile(double q) const {
+    if (count == 0)
+        return 0;
+
+    auto rank = static_cast<uint64_t>(q * (count - 1)) + 1;
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return upperBound(i);
+    }
+
+    return upperBound(buckets.size() - 1);
+}
+
+MetricsText::Family& MetricsText::family(const string& name, const string& type, const string& help) {
+    auto& family = m_families[name];
+    if (family.type.empty()) {
+        family.type = type;
+        family.help = help;
+    }
+
+    return family;
+}
+
+void MetricsText::counter(const string& name, const string& help, const string& labels, uint64_t value) {
+    family(name, "counter", help).samples.push_back(name + labels + " " + to_string(value));
+}
+
+void MetricsText::counterSeconds(const string& name, const string& help, const string& labels, uint64_t nanoseconds) {
+    stringstream ss;
+    ss << name << labels << " " << nanoseconds / 1000000000ull << "." << setw(9) << setfill('0')
+       << nanoseconds % 1000000000ull;
+    family(name, "counter", help).samples.push_back(ss.str());
+}
+
+void MetricsText::gauge(const string& name, const string& help, const string& labels, double value) {
+    stringstream ss;
+    ss << name << labels << " " << value;
+    family(name, "gauge", help).samples.push_back(ss.str());
+}
+
+void MetricsText::summary(const string& name, const string& help, const string& labels,
+                          const Histogram::Snapshot& snapshot, double scale) {
+    auto& samples = family(name, "summary", help).samples;
+
+    // the quantile label joins whatever labels the series already has
+    auto prefix = labels.empty() ? string("{") : labels.substr(0, labels.size() - 1) + ",";
+
+    for (auto q : {0.5, 0.9, 0.99, 0.999}) {
+        stringstream ss;
+        ss << name << prefix << "quantile=\"" << q << "\"} " << snapshot.quantile(q) * scale;
+        samples.push_back(ss.str());
+    }
+
+    stringstream sum;
+    sum << name << "_sum" << labels << " " << fixed << setprecision(9) << snapshot.sum * scale;
+    samples.push_back(sum.str());
+    samples.push_back(name + "_count" + labels + " " + to_string(snapshot.count));
+}
+
+string MetricsText::str() const {
+    string out;
+    for (auto& [name, family] : m_families) {
+        out += "# HELP " + name + " " + family.help + "\n";
+        out += "# TYPE " + name + " " + family.type + "\n";
+
+        for (auto& sample : family.samples)
+            out += sample + "\n";
+    }
+
+    return out;
+}
+
+string MetricsText::labels(const vector<pair<string, string>>& pairs) {
+    if (pairs.empty())
+        return "";
+
+    string out = "{";
+    for (auto& [key, value] : pairs) {
+        if (out.size() > 1)
+            out += ",";
+
+        out += key + "=\"";
+        for (auto c : value) {
+            if (c == '\\' || c == '"')
+                out += '\\';
+            out += c == '\n' ? 'n' : c;
+        }
+        out += "\"";
+    }
+
+    return out + "}";
+}
+
+Metrics::Entry& Metrics::entry(const string& name, const string& help, const string& labels) {
+    for (auto& entry : m_entries)
+        if (entry->name == name && entry->labels == labels)
+            return *entry;
+
+    auto created = make_unique<Entry>();
+    created->name = name;
+    created->help = help;
+    created->labels = labels;
+
+    m_entries.push_back(std::move(created));
+    return *m_entries.back();
+}
+
+Counter& Metrics::counter(const string& name, const string& help, const string& labels) {
+    lock_guard<mutex> lock(m_mutex);
+
+    auto& e = entry(name, help, labels);
+    if (!e.counter)
+        e.counter = make_unique<Counter>();
+
+    return *e.counter;
+}
+
+Gauge& Metrics::gauge(const string& name, const string& help, const string& labels) {
+    lock_guard<mutex> lock(m_mutex);
+
+    auto& e = entry(name, help, labels);
+    if (!e.gauge)
+        e.gauge = make_unique<Gauge>();
+
+    return *e.gauge;
+}
+
+Histogram& Metrics::histogram(const string& name, const string& help, const string& labels, double scale) {
+    lock_guard<mutex> lock(m_mutex);
+
+    auto& e = entry(name, help, labels);
+    if (!e.histogram) {
+        e.histogram = make_unique<Histogram>();
+        e.scale = scale;
+    }
+
+    return *e.histogram;
+}
+
+uint64_t Metrics::addCollector(const Collector& collector) {
+    lock_guard<mutex> lock(m_mutex);
+
+    auto id = m_nextCollector++;
+    m_collectors[id] = collector;
+
+    return id;
+}
+
+void Metrics::removeCollector(uint64_t id) {
+    lock_guard<mutex> lock(m_mutex);
+    m_collectors.erase(id);
+}
+
+string Metrics::render() const {
+    MetricsText text;
+
+    lock_guard<mutex> lock(m_mutex);
+    for (auto& e : m_entries) {
+        if (e->counter)
+            text.counter(e->name, e->help, e->labels, e->counter->value());
+        else if (e->gauge)
+            text.gauge(e->name, e->help, e->labels, e->gauge->value());
+        else if (e->histogram)
+            text.summary(e->name, e->help, e->labels, e->histogram->snapshot(), e->scale);
+    }
+
+    for (auto& [id, collector] : m_collectors)
+        collector(text);
+
+    return text.str();
+}
@@ -0,0 +1,186 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_METRICS_H
+#define MEETING_SDK_LINUX_SAMPLE_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Singleton.h"
+
+using namespace std;
+
+/**
+ * Monotonic count of an event, split into cache-line sized shards so threads counting
+ * the same event never write the same line
+ */
+class Counter {
+public:
+    static const size_t c_shards = 8;
+
+private:
+    struct alignas(64) Shard {
+        atomic<uint64_t> value{0};
+    };
+
+    array<Shard, c_shards> m_shards;
+
+public:
+    void add(uint64_t n = 1);
+    uint64_t value() const;
+
+    /**
+     * Shard of the calling thread, assigned round robin on its first use
+     */
+    static size_t shard();
+};
+
+/**
+ * Level that goes up and down, e.g. the fill of a queue
+ */
+class Gauge {
+    atomic<int64_t> m_value{0};
+
+public:
+    void set(int64_t value) { m_value.store(value, memory_order_relaxed); }
+    void add(int64_t delta) { m_value.fetch_add(delta, memory_order_relaxed); }
+    int64_t value() const { return m_value.load(memory_order_relaxed); }
+};
+
+/**
+ * Latency histogram in the manner of HdrHistogram: every power of two is split into
+ * c_subBuckets linear buckets, so any recorded value is known to within 1/c_subBuckets
+ * of itself from nanoseconds to minutes. Recording is an index computation and one
+ * relaxed increment.
+ */
+class Histogram {
+public:
+    static const int c_subBits = 4;
+    static const uint64_t c_subBuckets = 1 << c_subBits;
+    // values of 2^40ns and more, about 18 minutes, share the last bucket
+    static const int c_maxExponent = 40;
+    static const size_t c_buckets = (c_maxExponent - c_subBits + 1) * c_subBuckets;
+
+    struct Snapshot {
+        vector<uint64_t> buckets;
+        uint64_t count = 0;
+        uint64_t sum = 0;
+
+        /**
+         * @param q quantile between 0 and 1
+         * @return upper bound of the bucket holding the quantile
+         */
+        uint64_t quantile(double q) const;
+    };
+
+private:
+    array<atomic<uint64_t>, c_buckets> m_buckets{};
+    atomic<uint64_t> m_sum{0};
+
+    static size_t index(uint64_t value);
+
+public:
+    void record(uint64_t value);
+    Snapshot snapshot() const;
+
+    /**
+     * @return largest value that falls into a bucket
+     */
+    static uint64_t upperBound(size_t index);
+};
+
+/**
+ * Prometheus text exposition, with the samples of a family grouped under its HELP and
+ * TYPE lines whichever collector adds them
+ */
+class MetricsText {
+    struct Family {
+        string type;
+        string help;
+        vector<string> samples;
+    };
+
+    map<string, Family> m_families;
+
+    Family& family(const string& name, const string& type, const string& help);
+
+public:
+    void counter(const string& name, const string& help, const string& labels, uint64_t value);
+    // a counter of nanoseconds, exported in seconds
+    void counterSeconds(const string& name, const string& help, const string& labels, uint64_t nanoseconds);
+    void gauge(const string& name, const string& help, const string& labels, double value);
+
+    /**
+     * A histogram as a summary of its 0.5, 0.9, 0.99 and 0.999 quantiles
+     * @param scale factor from recorded values to the exported unit, e.g. 1e-9 for seconds
+     */
+    void summary(const string& name, const string& help, const string& labels,
+                 const Histogram::Snapshot& snapshot, double scale);
+
+    string str() const;
+
+    /**
+     * Render label pairs, escaping the values
+     */
+    static string labels(const vector<pair<string, string>>& pairs);
+};
+
+/**
+ * Process-wide registry of counters, gauges and histograms.
+ *
+ * Metrics are registered once, off the hot path, and live as long as the process, so
+ * whoever records keeps a reference and never looks them up again. Figures that belong
+ * to objects coming and going, like subscribers or video streams, are added by collectors
+ * that run only when the metrics are read.
+ */
+class Metrics : public Singleton<Metrics> {
+    friend class Singleton<Metrics>;
+
+public:
+    typedef function<void(MetricsText& text)> Collector;
+
+private:
+    struct Entry {
+        string name;
+        string help;
+        string labels;
+        unique_ptr<Counter> counter;
+        unique_ptr<Gauge> gauge;
+        unique_ptr<Histogram> histogram;
+        double scale = 1;
+    };
+
+    mutable mutex m_mutex;
+    vector<unique_ptr<Entry>> m_entries;
+    map<uint64_t, Collector> m_collectors;
+    uint64_t m_nextCollector = 1;
+
+    Entry& entry(const string& name, const string& help, const string& labels);
+
+public:
+    Counter& counter(const string& name, const string& help, const string& labels = "");
+    Gauge& gauge(const string& name, const string& help, const string& labels = "");
+
+    /**
+     * @param scale factor from recorded values to the exported unit
+     */
+    Histogram& histogram(const string& name, const string& help, const string& labels = "", double scale = 1e-9);
+
+    /**
+     * @return id to remove the collector with
+     */
+    uint64_t addCollector(const Collector& collector);
+    void removeCollector(uint64_t id);
+
+    /**
+     * Every metric in the Prometheus text format
+     */
+    string render() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_METRICS_H
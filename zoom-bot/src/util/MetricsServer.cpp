@@ -0,0 +1,151 @@
+#include "MetricsServer.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include "ThreadRoles.h"
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(uint16_t port) {
+    if (m_running)
+        return true;
+
+    m_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listenFd == -1) {
+        Log::error("unable to create metrics socket");
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(m_listenFd, (const struct sockaddr*) &addr, sizeof(addr)) == -1 || listen(m_listenFd, 8) == -1) {
+        Log::error("unable to listen for metrics on port " + to_string(port));
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+
+    m_stopFd = eventfd(0, EFD_CLOEXEC);
+    m_running = true;
+    m_thread = thread(&MetricsServer::run, this);
+
+    Log::info("serving metrics on port " + to_string(port));
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (m_running.exchange(false)) {
+        eventfd_write(m_stopFd, 1);
+        m_thread.join();
+    }
+
+    if (m_listenFd != -1) {
+        close(m_listenFd);
+        m_listenFd = -1;
+    }
+
+    if (m_stopFd != -1) {
+        close(m_stopFd);
+        m_stopFd = -1;
+    }
+}
+
+void MetricsServer::run() {
+    ThreadRoles::assign(ThreadRole::Control);
+
+    struct pollfd fds[2] = {{m_listenFd, POLLIN, 0}, {m_stopFd, POLLIN, 0}};
+
+    while (m_running) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) continue;
+
+            Log::error("metrics server poll failed");
+            break;
+        }
+
+        if (fds[1].revents)
+            break;
+
+        if (!(fds[0].revents & POLLIN))
+            continue;
+
+        auto fd = accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd == -1)
+            continue;
+
+        // a scraper that stalls must not keep the endpoint for longer than this
+        struct timeval timeout = {c_timeoutMs / 1000, (c_timeoutMs % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        serve(fd);
+        close(fd);
+    }
+}
+
+void MetricsServer::serve(int fd) {
+    string request;
+    char buffer[1024];
+
+    // only the request line matters, headers and body are never looked at
+    while (request.find("\r\n") == string::npos && request.size() < c_maxRequest) {
+        auto ret = recv(fd, buffer, sizeof(buffer), 0);
+        if (ret == -1 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return;
+
+        request.append(buffer, ret);
+    }
+
+    auto line = request.substr(0, request.find("\r\n"));
+    auto methodEnd = line.find(' ');
+    auto pathEnd = line.find(' ', methodEnd + 1);
+    if (methodEnd == string::npos) {
+        sendAll(fd, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        return;
+    }
+
+    auto method = line.substr(0, methodEnd);
+    auto path = line.substr(methodEnd + 1, pathEnd == string::npos ? string::npos : pathEnd - methodEnd - 1);
+    path = path.substr(0, path.find('?'));
+
+    if (method != "GET") {
+        sendAll(fd, "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        return;
+    }
+
+    if (path != "/metrics" && path != "/") {
+        sendAll(fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        return;
+    }
+
+    auto body = Metrics::getInstance().render();
+    sendAll(fd, "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                + to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+}
+
+bool MetricsServer::sendAll(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        auto ret = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (ret == -1 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+
+        sent += ret;
+    }
+
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_METRICSSERVER_H
+#define MEETING_SDK_LINUX_SAMPLE_METRICSSERVER_H
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "Log.h"
+#include "Metrics.h"
+
+using namespace std;
+
+/**
+ * Minimal HTTP endpoint serving the Metrics registry to a Prometheus scraper.
+ *
+ * A scrape is a rare, short request, so a single thread answers one connection at a
+ * time and closes it, and the hot paths never wait for a reader.
+ */
+class MetricsServer {
+    const int c_timeoutMs = 2000;
+    const size_t c_maxRequest = 4096;
+
+    int m_listenFd = -1;
+    int m_stopFd = -1;
+
+    thread m_thread;
+    atomic<bool> m_running{false};
+
+    void run();
+    void serve(int fd);
+    static bool sendAll(int fd, const string& data);
+
+public:
+    MetricsServer() = default;
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * Listen on all interfaces and start serving /metrics
+     * @param port TCP port
+     * @return false if the port cannot be bound
+     */
+    bool start(uint16_t port);
+
+    void stop();
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_METRICSSERVER_H
@@ -0,0 +1,29 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_OVERFLOWPOLICY_H
+#define MEETING_SDK_LINUX_SAMPLE_OVERFLOWPOLICY_H
+
+#include <string>
+
+using namespace std;
+
+/**
+ * What a bounded queue does when a producer finds it full
+ */
+enum class OverflowPolicy {
+    DropOldest,
+    DropNewest
+};
+
+namespace Overflow {
+    const string dropOldest = "drop-oldest";
+    const string dropNewest = "drop-newest";
+
+    inline OverflowPolicy parse(const string& name) {
+        return name == dropNewest ? OverflowPolicy::DropNewest : OverflowPolicy::DropOldest;
+    }
+
+    inline const string& name(OverflowPolicy policy) {
+        return policy == OverflowPolicy::DropNewest ? dropNewest : dropOldest;
+    }
+}
+
+#endif //MEETING_SDK_LINUX_SAMPLE_OVERFLOWPOLICY_H
@@ -0,0 +1,112 @@
+#include "ShmRing.h"
+
+static size_t align8(size_t len) {
+    return (len + 7) & ~static_cast<size_t>(7);
+}
+
+ShmRing::~ShmRing() {
+    if (m_header)
+        munmap(m_header, m_size);
+
+    if (m_memFd != -1)
+        close(m_memFd);
+
+    if (m_eventFd != -1)
+        close(m_eventFd);
+}
+
+unique_ptr<ShmRing> ShmRing::create(const string& name, size_t capacity) {
+    unique_ptr<ShmRing> ring(new ShmRing());
+
+    ring->m_capacity = c_minCapacity;
+    while (ring->m_capacity < min(capacity, c_maxCapacity))
+        ring->m_capacity <<= 1;
+    ring->m_size = c_dataOffset + ring->m_capacity;
+
+    ring->m_memFd = memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (ring->m_memFd == -1) {
+        Log::error("unable to create shared memory for " + name);
+        return nullptr;
+    }
+
+    if (ftruncate(ring->m_memFd, ring->m_size) == -1) {
+        Log::error("unable to size shared memory for " + name);
+        return nullptr;
+    }
+
+    // the subscriber maps the same size, so neither side may resize it under the other
+    fcntl(ring->m_memFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    auto* mem = mmap(nullptr, ring->m_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->m_memFd, 0);
+    if (mem == MAP_FAILED) {
+        Log::error("unable to map shared memory for " + name);
+        return nullptr;
+    }
+
+    ring->m_header = new (mem) Header();
+    ring->m_header->magic = c_magic;
+    ring->m_header->version = c_version;
+    ring->m_header->capacity = ring->m_capacity;
+    ring->m_header->dataOffset = c_dataOffset;
+    ring->m_header->head.store(0, memory_order_relaxed);
+    ring->m_header->tail.store(0, memory_order_relaxed);
+    ring->m_data = static_cast<char*>(mem) + c_dataOffset;
+
+    ring->m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ring->m_eventFd == -1) {
+        Log::error("unable to create the wakeup eventfd for " + name);
+        return nullptr;
+    }
+
+    return ring;
+}
+
+bool ShmRing::fits(size_t len) const {
+    // a record may also need the padding up to the end, keep it well below capacity
+    return align8(len) <= m_capacity / 2;
+}
+
+bool ShmRing::write(const char* buf, size_t len) {
+    auto record = align8(len);
+    auto pos = m_head & (m_capacity - 1);
+    auto toEnd = m_capacity - pos;
+    auto pad = toEnd < record ? toEnd : 0;
+
+    auto tail = m_header->tail.load(memory_order_acquire);
+    if (m_head + pad + record - tail > m_capacity)
+        return false;
+
+    if (pad) {
+        memcpy(m_data + pos, &c_padMagic, sizeof(c_padMagic));
+        m_head += pad;
+        pos = 0;
+    }
+
+    memcpy(m_data + pos, buf, len);
+    m_head += record;
+    m_header->head.store(m_head, memory_order_release);
+
+    return true;
+}
+
+void ShmRing::notify() {
+    uint64_t one = 1;
+    if (::write(m_eventFd, &one, sizeof(one)) == -1 && errno != EAGAIN)
+        Log::error("failed to wake shared memory subscriber");
+}
+
+int ShmRing::memFd() const {
+    return m_memFd;
+}
+
+int ShmRing::eventFd() const {
+    return m_eventFd;
+}
+
+size_t ShmRing::size() const {
+    return m_size;
+}
+
+size_t ShmRing::capacity() const {
+    return m_capacity;
+}
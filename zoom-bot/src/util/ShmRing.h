@@ -0,0 +1,121 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_SHMRING_H
+#define MEETING_SDK_LINUX_SAMPLE_SHMRING_H
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "Log.h"
+
+using namespace std;
+
+/**
+ * Byte ring in a memfd shared with one co-located subscriber.
+ *
+ * The socket server copies whole frames (FrameHeader and payload) into the mapping and
+ * the subscriber parses them in place, so audio crosses no kernel buffer. The writer
+ * only advances head and the reader only advances tail; a full ring is left to the
+ * subscriber's queue and overflow policy, exactly like a full socket.
+ *
+ *     offset  size  field
+ *          0     4  magic "ZMSR"
+ *          4     4  version
+ *          8     8  capacity of the data area in bytes, a power of two
+ *         16     8  offset of the data area
+ *         64     8  head: bytes written, advanced by the bot
+ *        128     8  tail: bytes consumed, advanced by the subscriber
+ *
+ * Records start on 8 byte boundaries and never wrap; when one does not fit before the
+ * end of the data area the writer leaves the magic "ZPAD" there and starts over at 0.
+ * An eventfd, sent together with the memfd, becomes readable after new records.
+ *
+ * Python: struct.Struct("<4sIQQ") at 0, "<Q" at 64 and 128
+ */
+class ShmRing {
+public:
+    static constexpr uint32_t c_magic = 0x52534d5a;  // "ZMSR" in little endian
+    static constexpr uint32_t c_padMagic = 0x4441505a;  // "ZPAD"
+    static constexpr uint32_t c_version = 1;
+    static constexpr size_t c_dataOffset = 256;
+    static constexpr size_t c_minCapacity = 64 * 1024;
+    static constexpr size_t c_maxCapacity = 64 * 1024 * 1024;
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t capacity;
+        uint64_t dataOffset;
+        alignas(64) atomic<uint64_t> head;
+        alignas(64) atomic<uint64_t> tail;
+    };
+
+    static_assert(sizeof(Header) <= c_dataOffset, "ShmRing header overlaps the data area");
+    static_assert(atomic<uint64_t>::is_always_lock_free, "ShmRing positions are shared with another process");
+
+    int m_memFd = -1;
+    int m_eventFd = -1;
+
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+
+    Header* m_header = nullptr;
+    char* m_data = nullptr;
+
+    // writer's copy of head, published with each record
+    uint64_t m_head = 0;
+
+    ShmRing() = default;
+
+public:
+    ~ShmRing();
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    /**
+     * Create, size and map a sealed memfd
+     * @param name name of the memfd, shown in /proc/<pid>/fd
+     * @param capacity bytes of audio the ring holds, rounded up to a power of two
+     * @return nullptr if the memfd or the eventfd cannot be set up
+     */
+    static unique_ptr<ShmRing> create(const string& name, size_t capacity);
+
+    /**
+     * Copy one record into the ring and publish it. Writer side only.
+     * @param buf FrameHeader followed by its payload
+     * @param len record size
+     * @return false if the subscriber has not made room for it yet
+     */
+    bool write(const char* buf, size_t len);
+
+    /**
+     * @return true if a record of this size can ever fit
+     */
+    bool fits(size_t len) const;
+
+    /**
+     * Wake the subscriber after one or more writes
+     */
+    void notify();
+
+    int memFd() const;
+    int eventFd() const;
+
+    /**
+     * @return size of the whole mapping, header included
+     */
+    size_t size() const;
+    size_t capacity() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_SHMRING_H
@@ -1,84 +1,767 @@
 #include "SocketServer.h"
 
-SocketServer::SocketServer() {
-    pthread_mutex_init(&m_mutex, NULL);
-}
-
-SocketServer::~SocketServer() {
-    cleanup();
-}
+#include <algorithm>
+#include <cctype>
 
-void* SocketServer::threadCreate(void *obj) {
-    return reinterpret_cast<SocketServer*>(obj)->run();
-}
+#include "ThreadRoles.h"
 
-void SocketServer::threadKill(int sig, siginfo_t *info, void *ctx) {
-    auto* self = &SocketServer::getInstance();
+SocketServer::SocketServer()
+    : m_chunks(c_slotSize), m_messageChunks(sizeof(FrameHeader) + c_maxMessage),
+      m_latency(Metrics::getInstance().histogram("zoombot_audio_socket_latency_seconds",
+                                                 "Time from the SDK callback until a chunk was sent")),
+      m_bytesOut(Metrics::getInstance().counter("zoombot_audio_socket_bytes_total",
+                                                "Bytes sent to all audio subscribers")) {}
 
-    self->stop();
+SocketServer::~SocketServer() {
+    stop();
 }
 
-void* SocketServer::run() {
-    if (pthread_mutex_trylock(&m_mutex) != 0) {
-        Log::error("Unable to lock mutex");
-        return nullptr;
-    }
-
+bool SocketServer::listenSocket() {
     cleanup();
 
-    m_listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    m_listenSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (m_listenSocket == -1) {
         Log::error("unable to create listen socket");
-        return nullptr;
+        return false;
     }
 
     memset(&m_addr, 0, sizeof(struct sockaddr_un));
 
     m_addr.sun_family = AF_UNIX;
-    strncpy(m_addr.sun_path, c_socketPath.c_str(), sizeof(m_addr.sun_path) - 1);
+    strncpy(m_addr.sun_path, m_socketPath.c_str(), sizeof(m_addr.sun_path) - 1);
 
     auto ret = bind(m_listenSocket, (const struct sockaddr *) &m_addr,
                     sizeof(struct sockaddr_un));
     if (ret == -1) {
         Log::error("unable to bind socket");
-        return nullptr;
+        return false;
     }
 
     ret = listen(m_listenSocket, 20);
     if (ret == -1) {
         Log::error("unable to listen on socket");
-        return nullptr;
+        return false;
     }
 
     Log::info("started socket server");
-    Log::info("listening on socket " + c_socketPath);
+    Log::info("listening on socket " + m_socketPath);
+
+    return true;
+}
+
+void SocketServer::run() {
+    ThreadRoles::assign(ThreadRole::AudioRt);
+
+    struct epoll_event events[c_maxEvents];
+
+    uint64_t reported = 0;
+    auto lastReport = chrono::steady_clock::now();
+    auto lastPublish = lastReport;
+
+    while (m_running) {
+        if (m_draining) {
+            finish();
+            break;
+        }
+
+        auto pending = admitPending();
+        if (pump())
+            flushAll();
+        logDrops(reported, lastReport);
+        publishStats(lastPublish);
+
+        // only block once the ring is empty, otherwise the producer would not wake us
+        auto timeout = m_ring->sleep() ? (pending >= 0 ? pending : 1000) : 0;
+        auto n = epoll_wait(m_epollFd, events, c_maxEvents, timeout);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+
+            Log::error("socket server epoll failed");
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            auto fd = events[i].data.fd;
+            auto flags = events[i].events;
+
+            if (fd == m_ring->fd()) {
+                m_ring->clear();
+                continue;
+            }
+
+            if (fd == m_listenSocket) {
+                accept();
+                continue;
+            }
+
+            if (fd == m_timerFd) {
+                pump();
+                tick();
+                continue;
+            }
+
+            auto it = m_subscribers.find(fd);
+            if (it == m_subscribers.end())
+                continue;
+
+            auto& sub = it->second;
+            if (flags & EPOLLIN)
+                read(sub);
+
+            if (m_subscribers.count(fd) && (flags & EPOLLOUT) && !flush(sub))
+                remove(fd);
+            else if (m_subscribers.count(fd) && (flags & (EPOLLERR | EPOLLHUP)))
+                remove(fd);
+        }
+    }
+}
+
+void SocketServer::accept() {
+    for (;;) {
+        auto fd = accept4(m_listenSocket, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                Log::error("failed to accept connection");
+            return;
+        }
+
+        auto& sub = m_subscribers[fd];
+        sub.fd = fd;
+        sub.id = m_nextId++;
+        sub.policy = m_subscriberOverflow;
+        sub.queue.assign(max<size_t>(m_subscriberQueue, 1), nullptr);
+        sub.connected = chrono::steady_clock::now();
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev);
+
+        m_subscriberCount = m_subscribers.size();
+
+        stringstream ss;
+        ss << "subscriber " << sub.id << " connected to audio socket (" << m_subscribers.size() << " connected)";
+        Log::success(ss.str());
+    }
+}
+
+int SocketServer::admitPending() {
+    auto now = chrono::steady_clock::now();
+    auto next = -1;
+
+    for (auto& [fd, sub] : m_subscribers) {
+        if (sub.greeted)
+            continue;
+
+        auto waited = now - sub.connected;
+        if (waited >= c_helloGrace) {
+            // no hello, a legacy client that expects raw PCM
+            sub.greeted = true;
+            continue;
+        }
+
+        auto left = chrono::duration_cast<chrono::milliseconds>(c_helloGrace - waited).count() + 1;
+        if (next == -1 || left < next)
+            next = left;
+    }
+
+    return next;
+}
+
+bool SocketServer::pump() {
+    auto queued = pumpMessages();
+
+    while (auto* slot = m_ring->acquire()) {
+        if (m_subscribers.empty()) {
+            m_ring->release(slot);
+            continue;
+        }
+
+        FrameHeader header;
+        memcpy(&header, slot->data, sizeof(header));
+
+        // codec packets cannot be concatenated, they leave as they are
+        if (header.stream == StreamType::OneWay && m_batchMs > 0 && header.format == PayloadFormat::Linear16) {
+            if (header.length > 0) {
+                batch(header, slot);
+                m_ring->release(slot);
+                continue;
+            }
+
+            // a marker must not overtake the audio batched before it, and shares its numbering
+            auto& batch = m_batches[header.nodeId];
+            batch.lastAudio = chrono::steady_clock::now();
+            flushBatch(batch);
+
+            batch.expected = header.seq + 1;
+            header.seq = batch.batches++;
+            memcpy(slot->data, &header, sizeof(header));
+        }
+
+        // one copy out of the ring, every subscriber then shares the same chunk
+        auto* chunk = m_chunks.acquire();
+        memcpy(chunk->data.get(), slot->data, slot->len);
+        chunk->len = slot->len;
+        chunk->headerLen = sizeof(FrameHeader);
+        m_ring->release(slot);
+
+        broadcast(chunk, header.stream);
+        ChunkPool::unref(chunk);
+        queued = true;
+    }
+
+    return queued;
+}
+
+bool SocketServer::pumpMessages() {
+    deque<Message> messages;
+    {
+        lock_guard<mutex> lock(m_messagesMutex);
+        if (m_messages.empty())
+            return false;
+        messages.swap(m_messages);
+    }
+
+    for (auto& message : messages) {
+        auto& header = message.header;
+        header.length = message.payload.size();
+        header.seq = m_messageSequences[static_cast<uint8_t>(header.stream)]++;
+
+        auto* chunk = m_messageChunks.acquire();
+        memcpy(chunk->data.get(), &header, sizeof(header));
+        memcpy(chunk->data.get() + sizeof(header), message.payload.data(), message.payload.size());
+        chunk->len = sizeof(header) + message.payload.size();
+        chunk->headerLen = sizeof(FrameHeader);
+
+        broadcast(chunk, header.stream);
+        ChunkPool::unref(chunk);
+    }
+
+    return true;
+}
+
+void SocketServer::broadcast(Chunk* chunk, StreamType stream) {
+    for (auto& [fd, sub] : m_subscribers)
+        if (sub.greeted && sub.wants(stream))
+            enqueue(sub, chunk);
+}
+
+void SocketServer::flushAll() {
+    // everything queued since the last pass leaves in one writev per subscriber
+    vector<int> failed;
+    for (auto& [fd, sub] : m_subscribers)
+        if (!sub.waiting && sub.count > 0 && !flush(sub))
+            failed.push_back(fd);
+
+    for (auto fd : failed)
+        remove(fd);
+}
+
+void SocketServer::finish() {
+    // nobody new is let in, and a batch timer nobody reads must not keep waking the loop
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, m_listenSocket, nullptr);
+    if (m_timerFd != -1)
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, m_timerFd, nullptr);
+
+    // the producers have stopped, so this is the last of their audio
+    pump();
+    for (auto& [node, batch] : m_batches)
+        flushBatch(batch);
+
+    FrameHeader end;
+    end.flags = FrameHeader::c_flagEndOfStream;
+    end.timestamp = FrameHeader::now();
+
+    auto* chunk = m_messageChunks.acquire();
+    memcpy(chunk->data.get(), &end, sizeof(end));
+    chunk->len = sizeof(end);
+    chunk->headerLen = sizeof(FrameHeader);
+
+    // whichever streams they asked for; raw subscribers learn about the end from the closed socket
+    size_t ended = 0;
+    for (auto& [fd, sub] : m_subscribers) {
+        if (sub.greeted && sub.framed) {
+            enqueue(sub, chunk);
+            ended++;
+        }
+    }
+    ChunkPool::unref(chunk);
+
+    struct epoll_event events[c_maxEvents];
 
     for (;;) {
-        Log::info("Waiting for client connection...");
-        m_dataSocket = accept(m_listenSocket, NULL, NULL);
-        if (m_dataSocket == -1) {
-            Log::error("failed to accept connection");
-            m_clientConnected = false;
-            return nullptr;
-        }
-
-        Log::success("Client connected to audio socket!");
-        m_clientConnected = true;
-
-        // Keep connection open - audio data is written via writeBuf()
-        // Just wait for client disconnect
-        char buffer[c_bufferSize];
-        for(;;) {
-            auto ret = read(m_dataSocket, buffer, c_bufferSize);
-            if (ret <= 0) {
-                Log::info("Client disconnected from audio socket");
-                m_clientConnected = false;
-                break;  // Break inner loop to accept new connection
+        vector<int> failed;
+        size_t queued = 0;
+
+        for (auto& [fd, sub] : m_subscribers) {
+            if (sub.count > 0 && !flush(sub))
+                failed.push_back(fd);
+            else
+                queued += sub.count;
+        }
+
+        for (auto fd : failed)
+            remove(fd);
+
+        auto left = chrono::duration_cast<chrono::milliseconds>(m_drainDeadline - chrono::steady_clock::now()).count();
+        if (queued == 0 || left <= 0) {
+            if (queued > 0)
+                Log::error("audio subscribers did not take their last ", queued, " chunks in time");
+            break;
+        }
+
+        auto n = epoll_wait(m_epollFd, events, c_maxEvents, min<long long>(left, c_drainPollMs));
+        for (int i = 0; i < n; i++) {
+            auto fd = events[i].data.fd;
+
+            if (fd == m_ring->fd()) {
+                m_ring->clear();
+                continue;
             }
+
+            auto it = m_subscribers.find(fd);
+            if (it != m_subscribers.end() && (events[i].events & EPOLLIN))
+                read(it->second);
+            else if (it != m_subscribers.end() && (events[i].events & (EPOLLERR | EPOLLHUP)))
+                remove(fd);
+        }
+    }
+
+    Log::info("ended the audio stream for ", ended, " subscribers");
+}
+
+void SocketServer::batch(const FrameHeader& header, const AudioRing::Slot* slot) {
+    auto& batch = m_batches[header.nodeId];
+    batch.lastAudio = chrono::steady_clock::now();
+
+    auto payload = slot->len - sizeof(FrameHeader);
+    auto& pending = batch.header;
+
+    // a format change or a full buffer closes the batch early
+    if (batch.chunk && (pending.sampleRate != header.sampleRate || pending.channels != header.channels
+                        || batch.chunk->len + payload > m_batchChunks->chunkSize()))
+        flushBatch(batch);
+
+    if (!batch.chunk) {
+        batch.chunk = m_batchChunks->acquire();
+        batch.chunk->len = sizeof(FrameHeader);
+        batch.chunk->headerLen = sizeof(FrameHeader);
+
+        pending = header;
+        pending.length = 0;
+        pending.flags = 0;
+        pending.seq = batch.batches++;
+    }
+
+    // the ring dropped chunks of this node, let the consumer know the audio is not contiguous
+    if (batch.expected != 0 && header.seq != batch.expected)
+        pending.flags |= FrameHeader::c_flagDiscontinuity;
+    batch.expected = header.seq + 1;
+
+    memcpy(batch.chunk->data.get() + batch.chunk->len, slot->data + sizeof(FrameHeader), payload);
+    batch.chunk->len += payload;
+    pending.length += payload;
+}
+
+void SocketServer::flushBatch(NodeBatch& batch) {
+    if (!batch.chunk)
+        return;
+
+    memcpy(batch.chunk->data.get(), &batch.header, sizeof(FrameHeader));
+    broadcast(batch.chunk, StreamType::OneWay);
+
+    ChunkPool::unref(batch.chunk);
+    batch.chunk = nullptr;
+}
+
+void SocketServer::tick() {
+    uint64_t expirations;
+    if (::read(m_timerFd, &expirations, sizeof(expirations)) == -1 && errno != EAGAIN)
+        Log::error("failed to read batch timer");
+
+    auto now = chrono::steady_clock::now();
+    for (auto it = m_batches.begin(); it != m_batches.end();) {
+        auto& batch = it->second;
+        flushBatch(batch);
+
+        // forget nodes that stopped sending, e.g. participants that left
+        if (now - batch.lastAudio > c_batchIdle)
+            it = m_batches.erase(it);
+        else
+            ++it;
+    }
+
+    flushAll();
+}
+
+void SocketServer::enqueue(Subscriber& sub, Chunk* chunk) {
+    if (sub.count == sub.queue.size()) {
+        sub.dropped++;
+        m_subscriberDrops++;
+
+        // a partly sent chunk has to finish or the stream loses sample alignment
+        size_t victim = sub.offset > 0 ? 1 : 0;
+        if (sub.policy == OverflowPolicy::DropNewest || victim >= sub.count)
+            return;
+
+        ChunkPool::unref(sub.at(victim));
+        if (victim == 1)
+            sub.at(1) = sub.at(0);
+
+        sub.head = (sub.head + 1) % sub.queue.size();
+        sub.count--;
+    }
+
+    ChunkPool::ref(chunk);
+    sub.at(sub.count) = chunk;
+    sub.count++;
+}
+
+bool SocketServer::flush(Subscriber& sub) {
+    if (sub.shm) {
+        flushShm(sub);
+        return true;
+    }
+
+    while (sub.count > 0) {
+        struct iovec iov[c_maxIov];
+        auto n = min<size_t>(sub.count, c_maxIov);
+
+        // raw subscribers get the same buffer without its header
+        for (size_t i = 0; i < n; i++) {
+            auto* chunk = sub.at(i);
+            auto skip = sub.skip(chunk);
+            iov[i].iov_base = chunk->data.get() + skip;
+            iov[i].iov_len = chunk->len - skip;
+        }
+        iov[0].iov_base = static_cast<char*>(iov[0].iov_base) + sub.offset;
+        iov[0].iov_len -= sub.offset;
+
+        struct msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n;
+
+        auto ret = sendmsg(sub.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watch(sub, true);
+                return true;
+            }
+
+            return false;
+        }
+
+        sub.bytes += ret;
+        m_bytesOut.add(ret);
+
+        // release every chunk the kernel took completely
+        auto now = FrameHeader::now();
+        size_t left = ret + sub.offset;
+        while (sub.count > 0 && left >= sub.at(0)->len - sub.skip(sub.at(0))) {
+            left -= sub.at(0)->len - sub.skip(sub.at(0));
+            sent(sub.at(0), now);
+            ChunkPool::unref(sub.at(0));
+            sub.head = (sub.head + 1) % sub.queue.size();
+            sub.count--;
+        }
+        sub.offset = left;
+    }
+
+    watch(sub, false);
+    return true;
+}
+
+void SocketServer::flushShm(Subscriber& sub) {
+    auto written = false;
+    auto now = FrameHeader::now();
+
+    // whatever does not fit stays queued and is retried on the next pass, so the
+    // subscriber's overflow policy decides what a slow reader loses
+    while (sub.count > 0) {
+        auto* chunk = sub.at(0);
+
+        if (!sub.shm->fits(chunk->len)) {
+            sub.dropped++;
+            m_subscriberDrops++;
+        } else if (!sub.shm->write(chunk->data.get(), chunk->len)) {
+            break;
+        } else {
+            written = true;
+            sub.bytes += chunk->len;
+            m_bytesOut.add(chunk->len);
+            sent(chunk, now);
+        }
+
+        ChunkPool::unref(chunk);
+        sub.head = (sub.head + 1) % sub.queue.size();
+        sub.count--;
+    }
+
+    if (written)
+        sub.shm->notify();
+}
+
+bool SocketServer::offerShm(Subscriber& sub, size_t size) {
+    auto ring = ShmRing::create("zoom-audio-" + to_string(sub.id), size);
+    if (!ring)
+        return false;
+
+    auto line = "SHM size=" + to_string(ring->size()) + "\n";
+    struct iovec iov = {const_cast<char*>(line.data()), line.size()};
+
+    int fds[2] = {ring->memFd(), ring->eventFd()};
+    char control[CMSG_SPACE(sizeof(fds))] = {};
+
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    // the first bytes on a fresh connection, so a short or blocked send means a broken peer
+    if (sendmsg(sub.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT) != static_cast<ssize_t>(line.size())) {
+        Log::error("unable to hand shared memory to subscriber " + to_string(sub.id));
+        return false;
+    }
+
+    sub.shm = std::move(ring);
+    return true;
+}
+
+void SocketServer::watch(Subscriber& sub, bool writable) {
+    if (sub.waiting == writable)
+        return;
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    if (writable)
+        ev.events |= EPOLLOUT;
+    ev.data.fd = sub.fd;
+    epoll_ctl(m_epollFd, EPOLL_CTL_MOD, sub.fd, &ev);
+
+    sub.waiting = writable;
+}
+
+void SocketServer::read(Subscriber& sub) {
+    char buffer[c_bufferSize];
+
+    for (;;) {
+        auto ret = recv(sub.fd, buffer, c_bufferSize, MSG_DONTWAIT);
+        if (ret == -1 && errno == EINTR)
+            continue;
+
+        if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+
+        if (ret <= 0) {
+            remove(sub.fd);
+            return;
+        }
+
+        // clients only ever send the optional hello line, the rest is ignored
+        if (sub.greeted)
+            continue;
+
+        sub.hello.append(buffer, ret);
+
+        auto end = sub.hello.find('\n');
+        if (end != string::npos || sub.hello.size() >= c_maxHello) {
+            parseHello(sub, sub.hello.substr(0, end));
+            sub.hello.clear();
+            sub.greeted = true;
         }
     }
+}
+
+static uint32_t parseStreams(const string& list) {
+    uint32_t streams = 0;
+    stringstream names(list);
+    string name;
+
+    while (getline(names, name, ',')) {
+        if (name == "mixed")
+            streams |= 1 << static_cast<int>(StreamType::Mixed);
+        else if (name == "one-way")
+            streams |= 1 << static_cast<int>(StreamType::OneWay);
+        else if (name == "share")
+            streams |= 1 << static_cast<int>(StreamType::Share);
+        else if (name == "transcript")
+            streams |= 1 << static_cast<int>(StreamType::Transcript);
+        else if (name == "speakers")
+            streams |= 1 << static_cast<int>(StreamType::Speakers);
+    }
+
+    return streams;
+}
+
+void SocketServer::parseHello(Subscriber& sub, const string& line) {
+    stringstream tokens(line);
+    string token;
+
+    auto shm = false;
+    auto shmSize = c_shmSize;
+
+    if (!(tokens >> token) || token != "SUB")
+        return;
+
+    while (tokens >> token) {
+        auto eq = token.find('=');
+        if (eq == string::npos)
+            continue;
+
+        auto key = token.substr(0, eq);
+        auto value = token.substr(eq + 1);
+
+        if (key == "framing")
+            sub.framed = value == "1";
+        else if (key == "streams")
+            sub.streams = parseStreams(value);
+        else if (key == "overflow" && (value == Overflow::dropOldest || value == Overflow::dropNewest))
+            sub.policy = Overflow::parse(value);
+        else if (key == "queue")
+            parseQueue(sub, value);
+        else if (key == "transport")
+            shm = value == "shm";
+        else if (key == "shm-size")
+            shmSize = strtoull(value.c_str(), nullptr, 10);
+    }
+
+    // the ring carries whole frames, a raw stream would lose its boundaries
+    if (shm && sub.framed && !offerShm(sub, shmSize))
+        Log::info("subscriber " + to_string(sub.id) + " falls back to the socket");
+
+    stringstream ss;
+    ss << "subscriber " << sub.id << " uses " << (sub.framed ? "framed" : "raw") << " mode";
+    if (sub.shm)
+        ss << " over " << sub.shm->capacity() / 1024 << "KiB of shared memory";
+    ss << ", a " << sub.queue.size() << " chunk queue, "
+       << Overflow::name(sub.policy) << " on overflow";
+    Log::info(ss.str());
+}
+
+void SocketServer::parseQueue(Subscriber& sub, const string& value) {
+    char* end = nullptr;
+    errno = 0;
+    auto chunks = strtoull(value.c_str(), &end, 10);
+
+    if (value.empty() || !isdigit(static_cast<unsigned char>(value[0])) || *end != '\0' || errno == ERANGE) {
+        Log::error("subscriber ", sub.id, " asked for a queue of ", value, " chunks, keeping ", sub.queue.size());
+        return;
+    }
+
+    auto limit = max(m_subscriberQueue, c_maxQueue);
+    resize(sub, clamp<unsigned long long>(chunks, 1, limit));
+}
+
+void SocketServer::resize(Subscriber& sub, size_t limit) {
+    // keep the newest chunks, plus the front one if it is partly sent
+    while (sub.count > limit) {
+        size_t victim = sub.offset > 0 ? 1 : 0;
+        ChunkPool::unref(sub.at(victim));
+        if (victim == 1)
+            sub.at(1) = sub.at(0);
+
+        sub.head = (sub.head + 1) % sub.queue.size();
+        sub.count--;
+    }
+
+    vector<Chunk*> queue(limit, nullptr);
+    for (size_t i = 0; i < sub.count; i++)
+        queue[i] = sub.at(i);
+
+    sub.queue = std::move(queue);
+    sub.head = 0;
+}
+
+void SocketServer::remove(int fd) {
+    auto it = m_subscribers.find(fd);
+    if (it == m_subscribers.end())
+        return;
+
+    auto& sub = it->second;
+    for (size_t i = 0; i < sub.count; i++)
+        ChunkPool::unref(sub.at(i));
+
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+
+    stringstream ss;
+    ss << "subscriber " << sub.id << " disconnected from audio socket";
+    if (sub.dropped > 0)
+        ss << " after losing " << sub.dropped << " chunks";
+    Log::info(ss.str());
+
+    m_subscribers.erase(it);
+    m_subscriberCount = m_subscribers.size();
+}
+
+void SocketServer::logDrops(uint64_t& reported, chrono::steady_clock::time_point& lastReport) {
+    auto dropped = droppedOldest() + droppedNewest() + m_subscriberDrops;
+    auto now = chrono::steady_clock::now();
+    if (dropped == reported || now - lastReport < chrono::seconds(1))
+        return;
+
+    stringstream ss;
+    ss << "audio ring overflow (" << Overflow::name(m_ring->policy()) << "): "
+       << droppedOldest() << " oldest, " << droppedNewest() << " newest chunks dropped; "
+       << m_subscriberDrops << " dropped for slow subscribers";
+    Log::error(ss.str());
+
+    reported = dropped;
+    lastReport = now;
+}
+
+void SocketServer::publishStats(chrono::steady_clock::time_point& lastPublish) {
+    auto now = chrono::steady_clock::now();
+    if (now - lastPublish < chrono::seconds(1))
+        return;
+
+    vector<SubscriberStats> stats;
+    stats.reserve(m_subscribers.size());
+    for (auto& [fd, sub] : m_subscribers)
+        stats.push_back({sub.id, sub.framed, sub.shm != nullptr, sub.bytes, sub.dropped, sub.count});
+
+    lock_guard<mutex> lock(m_statsMutex);
+    m_stats.swap(stats);
+    lastPublish = now;
+}
+
+void SocketServer::sent(const Chunk* chunk, uint64_t now) {
+    uint64_t timestamp;
+    memcpy(&timestamp, chunk->data.get() + offsetof(FrameHeader, timestamp), sizeof(timestamp));
+
+    if (timestamp > 0 && now > timestamp)
+        m_latency.record(now - timestamp);
+}
+
+void SocketServer::collect(MetricsText& text) {
+    text.gauge("zoombot_audio_ring_occupancy", "Chunks waiting in the ring for the server thread",
+               "", m_ring->occupancy());
+    text.gauge("zoombot_audio_ring_capacity", "Chunk slots of the ring", "", m_ring->capacity());
+    text.counter("zoombot_audio_ring_dropped_total", "Chunks the ring dropped because the server thread fell behind",
+                 MetricsText::labels({{"policy", Overflow::dropOldest}}), droppedOldest());
+    text.counter("zoombot_audio_ring_dropped_total", "Chunks the ring dropped because the server thread fell behind",
+                 MetricsText::labels({{"policy", Overflow::dropNewest}}), droppedNewest());
+    text.gauge("zoombot_audio_subscribers", "Connected audio subscribers", "", m_subscriberCount);
+
+    lock_guard<mutex> lock(m_statsMutex);
+    for (auto& sub : m_stats) {
+        auto labels = MetricsText::labels({{"subscriber", to_string(sub.id)},
+                                           {"transport", sub.shm ? "shm" : sub.framed ? "framed" : "raw"}});
 
-    return nullptr;
+        text.counter("zoombot_audio_subscriber_bytes_total", "Bytes sent to a subscriber", labels, sub.bytes);
+        text.counter("zoombot_audio_subscriber_dropped_total", "Chunks a subscriber lost to its overflow policy",
+                     labels, sub.dropped);
+        text.gauge("zoombot_audio_subscriber_queued", "Chunks waiting in a subscriber's queue", labels, sub.queued);
+    }
 }
 
 bool SocketServer::isReady() {
@@ -86,36 +769,119 @@ bool SocketServer::isReady() {
 }
 
 
-int SocketServer::writeBuf(const char* buf, int len) {
-    if (!m_clientConnected || m_dataSocket <= 0) {
+int SocketServer::writeFrame(FrameHeader header, const char* buf, int len) {
+    if (m_subscriberCount == 0 || !m_ring) {
         return -1;  // No client connected, silently skip
     }
-    auto ret = write(m_dataSocket, buf, len);
-    if (ret == -1) {
-        Log::error("failed to write data");
-        m_clientConnected = false;
-        return -1;
+
+    if (header.timestamp == 0)
+        header.timestamp = FrameHeader::now();
+
+    auto key = static_cast<uint64_t>(header.stream) << 32 | header.nodeId;
+    auto& seq = m_sequences[key];
+
+    // split on whole sample frames so every piece carries the timestamp of its first sample
+    size_t frameBytes = sizeof(int16_t) * max<uint8_t>(header.channels, 1);
+    auto room = m_ring->slotSize() - sizeof(FrameHeader);
+    room -= room % frameBytes;
+
+    // markers are a header without payload
+    if (len == 0) {
+        header.length = 0;
+        header.seq = seq++;
+        return m_ring->push(&header, sizeof(header), nullptr, 0) ? 0 : -1;
     }
 
-    return 0;
-}
+    // a codec packet has to stay whole
+    if (header.format != PayloadFormat::Linear16) {
+        if (static_cast<size_t>(len) > room) {
+            Log::error("dropped a " + to_string(len) + " byte packet, too large for a ring slot");
+            return -1;
+        }
 
-int SocketServer::writeBuf(const unsigned char* buf, int len) {
-    if (!m_clientConnected || m_dataSocket <= 0) {
-        return -1;  // No client connected, silently skip
+        header.length = len;
+        header.seq = seq++;
+        return m_ring->push(&header, sizeof(header), buf, len) ? 0 : -1;
     }
-    auto ret = write(m_dataSocket, buf, len);
-    if (ret == -1) {
-        Log::error("failed to write data");
-        m_clientConnected = false;
+
+    // only copy here, the server thread does the socket writes
+    auto ret = 0;
+    for (size_t offset = 0; offset < static_cast<size_t>(len); offset += room) {
+        auto size = min(room, len - offset);
+
+        auto piece = header;
+        piece.length = size;
+        piece.seq = seq++;
+        if (header.sampleRate > 0)
+            piece.timestamp += offset / frameBytes * 1000000000ull / header.sampleRate;
+
+        if (!m_ring->push(&piece, sizeof(piece), buf + offset, size))
+            ret = -1;
+    }
+
+    return ret;
+}
+
+int SocketServer::writeMessage(FrameHeader header, const string& payload) {
+    if (m_subscriberCount == 0 || !m_running)
         return -1;
+
+    if (payload.size() > c_maxMessage) {
+        Log::error("dropped a " + to_string(payload.size()) + " byte message, too large for the socket");
+        return -1;
+    }
+
+    header.timestamp = FrameHeader::now();
+    {
+        lock_guard<mutex> lock(m_messagesMutex);
+
+        // a server thread that stopped draining must not grow this without bound
+        if (m_messages.size() >= c_maxQueuedMessages)
+            return -1;
+
+        m_messages.push_back({header, payload});
     }
 
+    m_ring->wake();
     return 0;
 }
 
+int SocketServer::writeBuf(const char* buf, int len) {
+    return writeFrame(FrameHeader(), buf, len);
+}
+
+int SocketServer::writeBuf(const unsigned char* buf, int len) {
+    return writeBuf(reinterpret_cast<const char*>(buf), len);
+}
+
 bool SocketServer::hasClient() {
-    return m_clientConnected;
+    return m_subscriberCount > 0;
+}
+
+uint64_t SocketServer::droppedOldest() const {
+    return m_ring ? m_ring->droppedOldest() : 0;
+}
+
+uint64_t SocketServer::droppedNewest() const {
+    return m_ring ? m_ring->droppedNewest() : 0;
+}
+
+void SocketServer::configureRing(size_t slots, OverflowPolicy policy) {
+    m_ringSlots = slots;
+    m_overflow = policy;
+}
+
+void SocketServer::configureSubscribers(size_t queue, OverflowPolicy policy) {
+    m_subscriberQueue = max<size_t>(queue, 1);
+    m_subscriberOverflow = policy;
+}
+
+void SocketServer::configurePath(const string& path) {
+    m_socketPath = path;
+}
+
+void SocketServer::configureBatching(unsigned int batchMs) {
+    m_batchMs = batchMs;
 }
 
 int SocketServer::writeStr(const string& str) {
@@ -124,36 +890,119 @@ int SocketServer::writeStr(const string& str) {
 }
 
 void SocketServer::cleanup () {
-    if (access(c_socketPath.c_str(), F_OK) != -1) {
-        unlink(c_socketPath.c_str());
+    if (access(m_socketPath.c_str(), F_OK) != -1) {
+        unlink(m_socketPath.c_str());
     }
 }
 
 
 int SocketServer::start() {
-    if (pthread_create(&m_pid, NULL, &(SocketServer::threadCreate), this) != 0) {
-        Log::error("unable to start thread");
+    if (m_running)
+        return true;
+
+    if (!m_ring)
+        m_ring = make_unique<AudioRing>(m_ringSlots, c_slotSize, m_overflow);
+
+    if (!listenSocket())
         return false;
+
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd == -1) {
+        Log::error("unable to create epoll instance");
+        return false;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = m_listenSocket;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenSocket, &ev);
+
+    ev.data.fd = m_ring->fd();
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_ring->fd(), &ev);
+
+    if (m_batchMs > 0) {
+        // room for a full period of 48kHz stereo plus one late chunk
+        auto bytes = 48000 * 2 * sizeof(int16_t) * m_batchMs / 1000 + c_slotSize;
+        m_batchChunks = make_unique<ChunkPool>(bytes);
+
+        m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (m_timerFd == -1) {
+            Log::error("unable to create batch timer");
+            return false;
+        }
+
+        struct itimerspec period = {};
+        period.it_interval.tv_sec = m_batchMs / 1000;
+        period.it_interval.tv_nsec = (m_batchMs % 1000) * 1000000L;
+        period.it_value = period.it_interval;
+        timerfd_settime(m_timerFd, 0, &period, nullptr);
+
+        ev.data.fd = m_timerFd;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_timerFd, &ev);
     }
+
+    m_running = true;
+    m_draining = false;
+    m_thread = thread(&SocketServer::run, this);
+    ready = true;
+
+    m_collector = Metrics::getInstance().addCollector([this](MetricsText& text) { collect(text); });
+
     return true;
 }
 
+void SocketServer::drain(chrono::steady_clock::time_point deadline) {
+    if (!m_running)
+        return;
+
+    m_drainDeadline = deadline;
+    m_draining = true;
+    m_ring->wake();
+
+    // the server thread leaves its loop by itself once it is done
+    m_thread.join();
+    m_running = false;
+
+    stop();
+}
+
 void SocketServer::stop() {
-    pthread_mutex_destroy(&m_mutex);
-    if (m_pid) {
-        pthread_cancel(m_pid);
-        m_pid = 0;
+    if (m_collector) {
+        Metrics::getInstance().removeCollector(m_collector);
+        m_collector = 0;
+    }
+
+    if (m_running.exchange(false)) {
+        m_ring->wake();
+        m_thread.join();
+    }
+
+    // the thread is gone, so its state can be torn down from here
+    for (auto& [node, batch] : m_batches)
+        if (batch.chunk)
+            ChunkPool::unref(batch.chunk);
+    m_batches.clear();
+
+    while (!m_subscribers.empty())
+        remove(m_subscribers.begin()->first);
+
+    if (m_timerFd != -1) {
+        close(m_timerFd);
+        m_timerFd = -1;
     }
-    if (m_listenSocket) {
+
+    if (m_listenSocket != -1) {
         close(m_listenSocket);
-        m_listenSocket = 0;
+        m_listenSocket = -1;
+
+        Log::info("Stopped Socket Server");
+        cleanup();
     }
 
-    if (m_dataSocket) {
-        close(m_dataSocket);
-        m_dataSocket = 0;
+    if (m_epollFd != -1) {
+        close(m_epollFd);
+        m_epollFd = -1;
     }
 
-    Log::info("Stopped Socket Server");
-    cleanup();
-}
\ No newline at end of file
+    ready = false;
+}
@@ -4,40 +4,228 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
-#include <signal.h>
-#include <pthread.h>
+#include <errno.h>
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "Singleton.h"
 #include "Log.h"
+#include "AudioRing.h"
+#include "ChunkPool.h"
+#include "FrameHeader.h"
+#include "Metrics.h"
+#include "ShmRing.h"
 
 using namespace std;
 
 
+/**
+ * Unix socket server that fans audio out to any number of subscribers.
+ *
+ * The SDK callback copies each chunk into a lock-free ring. A single epoll thread accepts
+ * subscribers, moves chunks from the ring into refcounted buffers and queues the same buffer
+ * to every subscriber. Each subscriber has its own bounded queue and overflow policy and is
+ * written with non-blocking writev(), so a slow reader only loses its own chunks.
+ *
+ * A subscriber may send a single line right after connecting to override its defaults:
+ *
+ *     SUB framing=1 overflow=drop-newest queue=100
+ *
+ * framing=1 puts a FrameHeader in front of every chunk. Subscribers that send nothing
+ * within c_helloGrace keep receiving raw PCM, as before.
+ *
+ * Framed subscribers can also ask for per-participant audio with streams=mixed,one-way.
+ * One-way chunks are coalesced per node on the server thread and sent on a timer, so all
+ * participants of one tick leave in a single writev per subscriber.
+ *
+ * Messages like transcripts (streams=transcript) and the speaker lists that name the
+ * one-way streams in speaker mode (streams=speakers) can be queued from any thread. They are
+ * rare and may be larger than a ring slot, so they bypass the ring and wake the server
+ * thread instead.
+ *
+ * A co-located subscriber can ask for transport=shm (optionally shm-size=<bytes>). It is
+ * then answered with a single "SHM size=<bytes>" line carrying a memfd and an eventfd as
+ * SCM_RIGHTS, and its frames are copied into that ShmRing instead of being written to the
+ * socket, which stays open only to tell when the subscriber goes away. If the ring cannot
+ * be set up the subscriber gets framed audio over the socket instead.
+ *
+ * drain() is the way out without losing audio: the server thread sends what is still
+ * queued, ends every framed stream with an end-of-stream marker and only then closes.
+ */
 class SocketServer : public Singleton<SocketServer> {
     friend class Singleton<SocketServer>;
 
-    const string c_socketPath = "/tmp/audio/meeting.sock";
+    /**
+     * Connected client with its own send queue of shared chunks
+     */
+    struct Subscriber {
+        int fd = -1;
+        unsigned int id = 0;
+
+        OverflowPolicy policy = OverflowPolicy::DropOldest;
+        vector<Chunk*> queue;
+        size_t head = 0;
+        size_t count = 0;
+
+        // bytes of the front chunk already sent, that chunk can no longer be dropped
+        size_t offset = 0;
+        bool waiting = false;
+
+        // chunks only start flowing once the hello arrived or the grace period ended
+        string hello;
+        bool greeted = false;
+        bool framed = false;
+        uint32_t streams = 1 << static_cast<int>(StreamType::Mixed);
+        chrono::steady_clock::time_point connected;
+        uint64_t dropped = 0;
+        uint64_t bytes = 0;
+
+        // frames go here instead of the socket once the subscriber asked for shared memory
+        unique_ptr<ShmRing> shm;
+
+        Chunk*& at(size_t i) { return queue[(head + i) % queue.size()]; }
+
+        size_t skip(const Chunk* chunk) const { return framed ? 0 : chunk->headerLen; }
+
+        // raw PCM cannot be demultiplexed, so raw subscribers only get the mixed stream
+        bool wants(StreamType stream) const {
+            return framed ? (streams >> static_cast<int>(stream)) & 1 : stream == StreamType::Mixed;
+        }
+    };
+
+    /**
+     * One-way audio of a single node collected until the next scheduler tick
+     */
+    struct NodeBatch {
+        Chunk* chunk = nullptr;
+        FrameHeader header;
+        uint64_t batches = 0;
+        uint64_t expected = 0;
+        chrono::steady_clock::time_point lastAudio;
+    };
+
+    const string c_defaultPath = "/tmp/audio/meeting.sock";
     const int c_bufferSize = 256;
+    const size_t c_slotSize = 4096;
+    const int c_maxEvents = 64;
+    const int c_maxIov = 64;
+    const size_t c_maxHello = 256;
+    const size_t c_shmSize = 1024 * 1024;
+    const size_t c_maxMessage = 64 * 1024;
+    const size_t c_maxQueuedMessages = 256;
+    // a hello can ask for a longer queue than --subscriber-queue, but not for this many chunks
+    const size_t c_maxQueue = 4096;
+    const chrono::milliseconds c_helloGrace{100};
+    const chrono::seconds c_batchIdle{30};
+    // shared memory readers have nothing to wait on while draining, so they are polled
+    const int c_drainPollMs = 10;
 
+    string m_socketPath = c_defaultPath;
     struct sockaddr_un m_addr;
 
-    int m_listenSocket = 0;
-    int m_dataSocket = 0;
+    int m_listenSocket = -1;
+    int m_epollFd = -1;
+    int m_timerFd = -1;
+
+    size_t m_ringSlots = 64;
+    OverflowPolicy m_overflow = OverflowPolicy::DropOldest;
+    unique_ptr<AudioRing> m_ring;
+
+    // owned by the producer, one counter per stream and node
+    unordered_map<uint64_t, uint64_t> m_sequences;
+
+    size_t m_subscriberQueue = 200;
+    OverflowPolicy m_subscriberOverflow = OverflowPolicy::DropOldest;
+
+    // owned by the server thread
+    unordered_map<int, Subscriber> m_subscribers;
+    ChunkPool m_chunks;
+    unsigned int m_nextId = 1;
 
-    pthread_t m_pid = 0;
-    pthread_mutex_t m_mutex;
+    unsigned int m_batchMs = 0;
+    unique_ptr<ChunkPool> m_batchChunks;
+    unordered_map<uint32_t, NodeBatch> m_batches;
+    atomic<uint64_t> m_subscriberDrops{0};
+
+    // the server thread copies its subscribers here for the metrics collector once a second
+    struct SubscriberStats {
+        unsigned int id;
+        bool framed;
+        bool shm;
+        uint64_t bytes;
+        uint64_t dropped;
+        size_t queued;
+    };
+    mutex m_statsMutex;
+    vector<SubscriberStats> m_stats;
+    uint64_t m_collector = 0;
+
+    // messages queued by other threads, guarded by m_messagesMutex
+    struct Message {
+        FrameHeader header;
+        string payload;
+    };
+    mutex m_messagesMutex;
+    deque<Message> m_messages;
+    ChunkPool m_messageChunks;
+    unordered_map<uint8_t, uint64_t> m_messageSequences;
+
+    // time from writeFrame() until the kernel took the whole chunk, and what left
+    Histogram& m_latency;
+    Counter& m_bytesOut;
+
+    thread m_thread;
+    atomic<bool> m_running{false};
+    atomic<size_t> m_subscriberCount{0};
+
+    // set before m_draining, read by the server thread once it sees it
+    chrono::steady_clock::time_point m_drainDeadline;
+    atomic<bool> m_draining{false};
 
     bool ready = false;
-    bool m_clientConnected = false;
 
-    void* run();
-    static void* threadCreate(void* obj);
-    static void threadKill(int sig, siginfo_t* info, void* ctx);
+    bool listenSocket();
+    void run();
+    void accept();
+    int admitPending();
+    bool pump();
+    bool pumpMessages();
+    void batch(const FrameHeader& header, const AudioRing::Slot* slot);
+    void flushBatch(NodeBatch& batch);
+    void tick();
+    void broadcast(Chunk* chunk, StreamType stream);
+    void flushAll();
+    void finish();
+    void read(Subscriber& sub);
+    void parseHello(Subscriber& sub, const string& line);
+    void enqueue(Subscriber& sub, Chunk* chunk);
+    void parseQueue(Subscriber& sub, const string& value);
+    void resize(Subscriber& sub, size_t limit);
+    bool flush(Subscriber& sub);
+    void flushShm(Subscriber& sub);
+    bool offerShm(Subscriber& sub, size_t size);
+    void remove(int fd);
+    void watch(Subscriber& sub, bool writable);
+    void logDrops(uint64_t& reported, chrono::steady_clock::time_point& lastReport);
+    void publishStats(chrono::steady_clock::time_point& lastPublish);
+    void sent(const Chunk* chunk, uint64_t now);
+    void collect(MetricsText& text);
 
 public:
     SocketServer();
@@ -45,6 +233,56 @@ public:
     int start();
     void stop();
 
+    /**
+     * Send everything queued, end the stream of every framed subscriber and stop; call once
+     * nothing writes any more, the frames written meanwhile may be lost
+     * @param deadline subscribers that have not taken their frames by then lose the rest
+     */
+    void drain(chrono::steady_clock::time_point deadline);
+
+    /**
+     * Size the ring between the SDK callback and the server thread; call before start()
+     * @param slots number of preallocated chunk slots
+     * @param policy which chunk to drop when the server thread falls behind
+     */
+    void configureRing(size_t slots, OverflowPolicy policy);
+
+    /**
+     * Defaults for each subscriber's send queue; call before start()
+     * @param queue chunks that can wait for a slow subscriber
+     * @param policy which chunk that subscriber loses when its queue is full
+     */
+    void configureSubscribers(size_t queue, OverflowPolicy policy);
+
+    /**
+     * Listen on another path than /tmp/audio/meeting.sock; call before start()
+     */
+    void configurePath(const string& path);
+
+    /**
+     * Coalesce one-way audio per node and send it every batchMs; call before start()
+     * @param batchMs scheduler period in milliseconds, 0 sends every chunk on its own
+     */
+    void configureBatching(unsigned int batchMs);
+
+    /**
+     * Queue one chunk of audio for every subscriber. Called from the SDK audio thread only.
+     * @param header stream, node and format of the chunk; length, seq and timestamp
+     *        are filled in here, and a zero timestamp means now
+     * @param buf PCM bytes
+     * @param len number of bytes
+     * @return -1 if there is no subscriber or part of the chunk was dropped
+     */
+    int writeFrame(FrameHeader header, const char* buf, int len);
+
+    /**
+     * Queue a message for every subscriber of its stream. Safe to call from any thread.
+     * @param header stream and format of the message; length, seq and timestamp are filled in here
+     * @param payload message bytes, at most 64KiB
+     * @return -1 if there is no subscriber or the message was dropped
+     */
+    int writeMessage(FrameHeader header, const string& payload);
+
     int writeBuf(const unsigned char* buf, int len);
     int writeBuf(const char* buf, int len);
     int writeStr(const string& str);
@@ -52,7 +290,10 @@ public:
     bool isReady();
     bool hasClient();
 
+    uint64_t droppedOldest() const;
+    uint64_t droppedNewest() const;
+
     void cleanup();
 };
 
-#endif //MEETINGSDK_HEADLESS_LINUX_SAMPLE_SOCKETSERVER_H
\ No newline at end of file
+#endif //MEETINGSDK_HEADLESS_LINUX_SAMPLE_SOCKETSERVER_H
@@ -0,0 +1,90 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_STAGESTATS_H
+#define MEETING_SDK_LINUX_SAMPLE_STAGESTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "Metrics.h"
+
+using namespace std;
+
+/**
+ * Run count and time spent in one processing stage, updated lock-free from any thread.
+ *
+ * Totals only grow, so a reader takes the difference between two snapshots to get the
+ * figures of an interval. The distribution of all runs is kept for the metrics export.
+ */
+class StageStats {
+    atomic<uint64_t> m_runs{0};
+    atomic<uint64_t> m_totalNs{0};
+    atomic<uint64_t> m_maxNs{0};
+    Histogram m_histogram;
+
+public:
+    struct Snapshot {
+        uint64_t runs = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+
+        double averageMs() const { return runs ? totalNs / 1e6 / runs : 0.0; }
+    };
+
+    void add(uint64_t ns) {
+        m_runs.fetch_add(1, memory_order_relaxed);
+        m_totalNs.fetch_add(ns, memory_order_relaxed);
+
+        auto max = m_maxNs.load(memory_order_relaxed);
+        while (ns > max && !m_maxNs.compare_exchange_weak(max, ns, memory_order_relaxed)) {}
+
+        m_histogram.record(ns);
+    }
+
+    const Histogram& histogram() const { return m_histogram; }
+
+    Snapshot snapshot() const {
+        return {m_runs.load(memory_order_relaxed), m_totalNs.load(memory_order_relaxed),
+                m_maxNs.load(memory_order_relaxed)};
+    }
+
+    /**
+     * Summarize the runs since the last report and start a new interval
+     * @param last snapshot taken by the last report, moved forward
+     */
+    string report(const string& name, Snapshot& last) {
+        auto now = snapshot();
+        Snapshot delta{now.runs - last.runs, now.totalNs - last.totalNs, now.maxNs};
+        last = now;
+        m_maxNs.store(0, memory_order_relaxed);
+
+        stringstream ss;
+        ss << name << " " << fixed << setprecision(1) << delta.averageMs() << "ms avg/"
+           << delta.maxNs / 1e6 << "ms max (" << delta.runs << ")";
+        return ss.str();
+    }
+};
+
+/**
+ * Adds the lifetime of a scope to a stage
+ */
+class StageTimer {
+    StageStats& m_stats;
+    chrono::steady_clock::time_point m_start;
+
+public:
+    explicit StageTimer(StageStats& stats) : m_stats(stats), m_start(chrono::steady_clock::now()) {}
+
+    ~StageTimer() { m_stats.add(elapsed()); }
+
+    uint64_t elapsed() const {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - m_start).count();
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_STAGESTATS_H
@@ -0,0 +1,295 @@
+#include "ThreadRoles.h"
+
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "Log.h"
+#include "Metrics.h"
+
+thread_local ThreadRoles::Registration ThreadRoles::t_registration;
+
+static pid_t currentTid() {
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+static size_t slot(ThreadRole role) {
+    return static_cast<size_t>(role);
+}
+
+bool Role::parse(const string& name, ThreadRole& role) {
+    for (size_t i = 0; i < count; i++) {
+        if (name == Role::name(static_cast<ThreadRole>(i))) {
+            role = static_cast<ThreadRole>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const string& Role::name(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::AudioRt: return audioRt;
+        case ThreadRole::Io: return io;
+        case ThreadRole::VideoWorker: return videoWorker;
+        default: return control;
+    }
+}
+
+ThreadRoles::Registration::~Registration() {
+    if (assigned)
+        ThreadRoles::getInstance().retire();
+}
+
+ThreadRoles::ThreadRoles() {
+    pthread_atfork(beforeFork, afterForkParent, afterForkChild);
+    Metrics::getInstance().addCollector([this](MetricsText& text) { collect(text); });
+}
+
+ThreadRoles& ThreadRoles::getInstance() {
+    // never destroyed, see the class comment
+    static auto* instance = new ThreadRoles();
+    return *instance;
+}
+
+void ThreadRoles::configure(const ThreadRoleOptions& options) {
+    lock_guard<mutex> lock(m_mutex);
+
+    m_options = options;
+
+    for (size_t i = 0; i < Role::count; i++) {
+        auto role = static_cast<ThreadRole>(i);
+        auto& roleOptions = options[role];
+
+        m_nodes[i] = options.numaLocal ? nodeOf(roleOptions.cpus) : -1;
+        m_warned[i] = false;
+
+        if (roleOptions.cpus.empty() && roleOptions.fifoPriority == 0 && roleOptions.nice == 0)
+            continue;
+
+        stringstream ss;
+        ss << Role::name(role) << " threads";
+        if (!roleOptions.cpus.empty()) {
+            ss << " on CPUs";
+            for (auto cpu : roleOptions.cpus)
+                ss << " " << cpu;
+        }
+        if (roleOptions.fifoPriority > 0)
+            ss << ", SCHED_FIFO priority " << roleOptions.fifoPriority;
+        else if (roleOptions.nice != 0)
+            ss << ", nice " << roleOptions.nice;
+        if (m_nodes[i] >= 0)
+            ss << ", memory of node " << m_nodes[i];
+        else if (options.numaLocal && !roleOptions.cpus.empty())
+            ss << ", CPUs on several NUMA nodes so memory is not bound";
+
+        Log::info(ss.str());
+    }
+
+    for (auto& [tid, thread] : m_threads)
+        apply(tid, thread.role);
+}
+
+void ThreadRoles::assign(ThreadRole role) {
+    if (t_registration.assigned)
+        return;
+
+    getInstance().add(role);
+}
+
+void ThreadRoles::add(ThreadRole role) {
+    clockid_t clock;
+    if (pthread_getcpuclockid(pthread_self(), &clock) != 0)
+        return;
+
+    t_registration.assigned = true;
+    t_registration.role = role;
+
+    auto tid = currentTid();
+    lock_guard<mutex> lock(m_mutex);
+
+    m_threads[tid] = {role, clock};
+    apply(tid, role);
+    bindMemory(role);
+}
+
+void ThreadRoles::retire() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    lock_guard<mutex> lock(m_mutex);
+
+    auto it = m_threads.find(currentTid());
+    if (it == m_threads.end())
+        return;
+
+    m_retiredNs[slot(it->second.role)] += static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    m_threads.erase(it);
+}
+
+void ThreadRoles::apply(pid_t tid, ThreadRole role) {
+    auto& options = m_options[role];
+
+    if (!options.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto cpu : options.cpus)
+            CPU_SET(cpu, &set);
+
+        if (sched_setaffinity(tid, sizeof(set), &set) != 0)
+            warn(role, "pin");
+    }
+
+    if (options.fifoPriority > 0) {
+        struct sched_param param = {};
+        param.sched_priority = options.fifoPriority;
+
+        if (sched_setscheduler(tid, SCHED_FIFO, &param) != 0)
+            warn(role, "run SCHED_FIFO");
+    } else if (options.nice != 0 && setpriority(PRIO_PROCESS, tid, options.nice) != 0) {
+        warn(role, "renice");
+    }
+}
+
+void ThreadRoles::bindMemory(ThreadRole role) {
+    auto node = m_nodes[slot(role)];
+    if (node < 0)
+        return;
+
+    // preferred rather than bound, so a full node spills over instead of failing allocations
+    unsigned long mask = 1ul << node;
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * 8) != 0)
+        warn(role, "set the memory policy of");
+}
+
+void ThreadRoles::warn(ThreadRole role, const string& what) {
+    auto error = errno;
+
+    // one line per role is enough, the next thread of it would fail the same way
+    if (m_warned[slot(role)])
+        return;
+
+    m_warned[slot(role)] = true;
+    Log::error("unable to ", what, " the ", Role::name(role), " threads: ", strerror(error));
+}
+
+void ThreadRoles::collect(MetricsText& text) {
+    uint64_t ns[Role::count];
+    size_t threads[Role::count] = {};
+    {
+        lock_guard<mutex> lock(m_mutex);
+        copy(begin(m_retiredNs), end(m_retiredNs), ns);
+
+        for (auto& [tid, thread] : m_threads) {
+            struct timespec ts;
+            if (clock_gettime(thread.clock, &ts) != 0)
+                continue;
+
+            ns[slot(thread.role)] += static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+            threads[slot(thread.role)]++;
+        }
+    }
+
+    for (size_t i = 0; i < Role::count; i++) {
+        auto labels = MetricsText::labels({{"role", Role::name(static_cast<ThreadRole>(i))}});
+
+        text.counterSeconds("zoombot_thread_cpu_seconds_total", "CPU time of the bot's threads by role", labels, ns[i]);
+        text.gauge("zoombot_threads", "Threads of the bot by role", labels, threads[i]);
+    }
+}
+
+void ThreadRoles::beforeFork() {
+    getInstance().m_mutex.lock();
+}
+
+void ThreadRoles::afterForkParent() {
+    getInstance().m_mutex.unlock();
+}
+
+void ThreadRoles::afterForkChild() {
+    // only the forking thread made it into the child, with the same role under a new ID
+    auto& self = getInstance();
+    self.m_threads.clear();
+    fill(begin(self.m_retiredNs), end(self.m_retiredNs), 0);
+    self.m_mutex.unlock();
+
+    if (t_registration.assigned) {
+        t_registration.assigned = false;
+        self.add(t_registration.role);
+    }
+}
+
+int ThreadRoles::nodeOf(const vector<int>& cpus) {
+    if (cpus.empty())
+        return -1;
+
+    auto* dir = opendir("/sys/devices/system/node");
+    if (!dir)
+        return -1;
+
+    auto found = -1;
+    while (auto* entry = readdir(dir)) {
+        int node;
+        char rest;
+        if (sscanf(entry->d_name, "node%d%c", &node, &rest) != 1 || node < 0 || node >= 64)
+            continue;
+
+        ifstream file(string("/sys/devices/system/node/") + entry->d_name + "/cpulist");
+        string list;
+        vector<int> nodeCpus;
+        if (!getline(file, list) || !parseCpus(list, nodeCpus))
+            continue;
+
+        auto inside = all_of(cpus.begin(), cpus.end(), [&](int cpu) {
+            return find(nodeCpus.begin(), nodeCpus.end(), cpu) != nodeCpus.end();
+        });
+
+        if (inside) {
+            found = node;
+            break;
+        }
+    }
+
+    closedir(dir);
+    return found;
+}
+
+bool ThreadRoles::parseCpus(const string& list, vector<int>& cpus) {
+    cpus.clear();
+
+    stringstream ss(list);
+    string range;
+
+    while (getline(ss, range, ',')) {
+        if (range.empty())
+            continue;
+
+        int first, last;
+        char dash, rest;
+        auto n = sscanf(range.c_str(), "%d%c%d%c", &first, &dash, &last, &rest);
+
+        if (n == 1)
+            last = first;
+        else if (n != 3 || dash != '-')
+            return false;
+
+        if (first < 0 || last < first || last >= CPU_SETSIZE)
+            return false;
+
+        for (auto cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+    }
+
+    return !cpus.empty();
+}
@@ -0,0 +1,140 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_THREADROLES_H
+#define MEETING_SDK_LINUX_SAMPLE_THREADROLES_H
+
+#include <sys/types.h>
+#include <time.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class MetricsText;
+
+/**
+ * What a thread of the bot is there for, which decides where and how it is scheduled
+ */
+enum class ThreadRole : uint8_t {
+    // SDK audio callbacks, the jitter buffer, the encoder and the socket server
+    AudioRt = 0,
+    // Deepgram, segment uploads and the log writer
+    Io = 1,
+    // SDK video callbacks, frame workers, and model inference: face detection and the keyword spotter
+    VideoWorker = 2,
+    // the glib loop with the control socket, and the metrics server
+    Control = 3
+};
+
+namespace Role {
+    const size_t count = 4;
+
+    const string audioRt = "audio-rt";
+    const string io = "io";
+    const string videoWorker = "video-worker";
+    const string control = "control";
+
+    /**
+     * @return false if the name is none of the above
+     */
+    bool parse(const string& name, ThreadRole& role);
+    const string& name(ThreadRole role);
+}
+
+struct RoleOptions {
+    // CPUs the threads may run on, empty for all of them
+    vector<int> cpus;
+    // SCHED_FIFO priority from 1 to 99, 0 stays with the normal scheduler
+    int fifoPriority = 0;
+    // nice level under the normal scheduler
+    int nice = 0;
+};
+
+struct ThreadRoleOptions {
+    RoleOptions roles[Role::count];
+    // prefer memory on the NUMA node of a role's CPUs, if they are all on one
+    bool numaLocal = false;
+
+    RoleOptions& operator[](ThreadRole role) { return roles[static_cast<size_t>(role)]; }
+    const RoleOptions& operator[](ThreadRole role) const { return roles[static_cast<size_t>(role)]; }
+};
+
+/**
+ * Places every thread of the bot by its role.
+ *
+ * Each thread calls assign() once it runs, the SDK's callback threads on their first
+ * callback. A thread keeps the role it was given first, and the CPU time of all threads of
+ * a role is exported as zoombot_thread_cpu_seconds_total{role}. configure() applies the
+ * affinity, scheduler and nice level of a role to the threads that have it already and to
+ * every later one; the memory policy can only be set by a thread itself, so a thread
+ * started before configure(), like the log writer, keeps the default one.
+ *
+ * Raising the priority needs CAP_SYS_NICE; without it the bot logs it once per role and
+ * runs as before. Like the LogWriter, the instance is never destroyed, for the threads
+ * that exit after the static destructors ran.
+ */
+class ThreadRoles {
+    struct Thread {
+        ThreadRole role;
+        clockid_t clock;
+    };
+
+    // retires the thread from its thread_local destructor
+    struct Registration {
+        bool assigned = false;
+        ThreadRole role = ThreadRole::Control;
+
+        ~Registration();
+    };
+
+    static thread_local Registration t_registration;
+
+    mutex m_mutex;
+    ThreadRoleOptions m_options;
+    // node whose memory a role prefers, -1 for the default policy
+    int m_nodes[Role::count] = {-1, -1, -1, -1};
+    bool m_warned[Role::count] = {};
+
+    unordered_map<pid_t, Thread> m_threads;
+    uint64_t m_retiredNs[Role::count] = {};
+
+    ThreadRoles();
+
+    static void beforeFork();
+    static void afterForkParent();
+    static void afterForkChild();
+
+    /**
+     * Apply the options of a role to a thread; call with m_mutex held
+     */
+    void apply(pid_t tid, ThreadRole role);
+    void warn(ThreadRole role, const string& what);
+    void bindMemory(ThreadRole role);
+    void add(ThreadRole role);
+    void retire();
+    void collect(MetricsText& text);
+    static int nodeOf(const vector<int>& cpus);
+
+public:
+    static ThreadRoles& getInstance();
+
+    ThreadRoles(const ThreadRoles&) = delete;
+    ThreadRoles& operator=(const ThreadRoles&) = delete;
+
+    void configure(const ThreadRoleOptions& options);
+
+    /**
+     * Give the calling thread its role; later calls from the same thread return right away
+     */
+    static void assign(ThreadRole role);
+
+    /**
+     * @param list CPUs as in /sys, e.g. "0-3,8,10-11"
+     * @return false if the list is malformed
+     */
+    static bool parseCpus(const string& list, vector<int>& cpus);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_THREADROLES_H
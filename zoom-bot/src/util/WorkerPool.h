@@ -0,0 +1,149 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_WORKERPOOL_H
+#define MEETING_SDK_LINUX_SAMPLE_WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "OverflowPolicy.h"
+#include "ThreadRoles.h"
+
+using namespace std;
+
+/**
+ * Fixed set of worker threads fed from a bounded job queue.
+ *
+ * When the queue is full the overflow policy decides whether the oldest queued job or the
+ * submitted one is skipped; either way the skipped job goes to the drop handler so its
+ * resources can be reclaimed.
+ */
+template <typename Job>
+class WorkerPool {
+public:
+    typedef function<void(Job& job, size_t worker)> Handler;
+    typedef function<void(Job& job)> DropHandler;
+
+private:
+    Handler m_handler;
+    DropHandler m_onDrop;
+    OverflowPolicy m_policy;
+    ThreadRole m_role;
+
+    // fixed ring, so queueing never allocates
+    vector<Job> m_queue;
+    size_t m_head = 0;
+    size_t m_count = 0;
+
+    mutex m_mutex;
+    condition_variable m_cv;
+    bool m_stopping = false;
+
+    vector<thread> m_threads;
+    atomic<uint64_t> m_dropped{0};
+
+    void run(size_t worker) {
+        ThreadRoles::assign(m_role);
+
+        for (;;) {
+            Job job;
+            {
+                unique_lock<mutex> lock(m_mutex);
+                m_cv.wait(lock, [this] { return m_stopping || m_count > 0; });
+
+                if (m_count == 0)
+                    return;
+
+                job = std::move(m_queue[m_head]);
+                m_head = (m_head + 1) % m_queue.size();
+                m_count--;
+            }
+
+            m_handler(job, worker);
+        }
+    }
+
+public:
+    WorkerPool(size_t workers, size_t capacity, OverflowPolicy policy, ThreadRole role, Handler handler,
+               DropHandler onDrop = nullptr) :
+            m_handler(handler), m_onDrop(onDrop), m_policy(policy), m_role(role), m_queue(max<size_t>(capacity, 1)) {
+        for (size_t i = 0; i < max<size_t>(workers, 1); i++)
+            m_threads.emplace_back(&WorkerPool::run, this, i);
+    }
+
+    ~WorkerPool() {
+        stop();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Queue a job for the next free worker
+     * @param job job to run
+     * @return false if a job was skipped to make room or the submitted one was rejected
+     */
+    bool submit(Job job) {
+        Job skipped;
+        auto hasSkipped = false;
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (m_stopping) {
+                skipped = std::move(job);
+                hasSkipped = true;
+            } else if (m_count == m_queue.size()) {
+                hasSkipped = true;
+
+                if (m_policy == OverflowPolicy::DropNewest) {
+                    skipped = std::move(job);
+                } else {
+                    skipped = std::move(m_queue[m_head]);
+                    m_queue[m_head] = std::move(job);
+                    m_head = (m_head + 1) % m_queue.size();
+                }
+            } else {
+                m_queue[(m_head + m_count) % m_queue.size()] = std::move(job);
+                m_count++;
+            }
+        }
+
+        if (!hasSkipped) {
+            m_cv.notify_one();
+            return true;
+        }
+
+        m_dropped.fetch_add(1, memory_order_relaxed);
+        if (m_onDrop)
+            m_onDrop(skipped);
+
+        return false;
+    }
+
+    /**
+     * Finish the queued jobs and join the workers
+     */
+    void stop() {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_cv.notify_all();
+
+        for (auto& t : m_threads)
+            if (t.joinable()) t.join();
+
+        m_threads.clear();
+    }
+
+    size_t workers() const {
+        return m_threads.size();
+    }
+
+    uint64_t dropped() const {
+        return m_dropped.load(memory_order_relaxed);
+    }
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_WORKERPOOL_H
@@ -0,0 +1,31 @@
+#include "CountingMatAllocator.h"
+
+CountingMatAllocator::CountingMatAllocator() : m_std(Mat::getStdAllocator()) {}
+
+UMatData* CountingMatAllocator::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                         AccessFlag flags, UMatUsageFlags usageFlags) const {
+    if (!data)
+        m_allocations.fetch_add(1, memory_order_relaxed);
+
+    return m_std->allocate(dims, sizes, type, data, step, flags, usageFlags);
+}
+
+bool CountingMatAllocator::allocate(UMatData* data, AccessFlag accessflags, UMatUsageFlags usageFlags) const {
+    return m_std->allocate(data, accessflags, usageFlags);
+}
+
+void CountingMatAllocator::deallocate(UMatData* data) const {
+    m_std->deallocate(data);
+}
+
+uint64_t CountingMatAllocator::allocations() const {
+    return m_allocations.load(memory_order_relaxed);
+}
+
+CountingMatAllocator& CountingMatAllocator::install() {
+    static CountingMatAllocator instance;
+    static once_flag installed;
+
+    call_once(installed, [] { Mat::setDefaultAllocator(&instance); });
+    return instance;
+}
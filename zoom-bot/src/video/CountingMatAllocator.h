@@ -0,0 +1,37 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_COUNTINGMATALLOCATOR_H
+#define MEETING_SDK_LINUX_SAMPLE_COUNTINGMATALLOCATOR_H
+
+#include <atomic>
+#include <mutex>
+
+#include <opencv2/core.hpp>
+
+using namespace cv;
+using namespace std;
+
+/**
+ * Default Mat allocator that counts every buffer OpenCV allocates on our behalf,
+ * including the ones made inside cvtColor, resize and detectMultiScale.
+ * Headers over memory we own are not counted, so in steady state the count stays flat.
+ */
+class CountingMatAllocator : public MatAllocator {
+    MatAllocator* m_std;
+    mutable atomic<uint64_t> m_allocations{0};
+
+    CountingMatAllocator();
+
+public:
+    UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                       AccessFlag flags, UMatUsageFlags usageFlags) const override;
+    bool allocate(UMatData* data, AccessFlag accessflags, UMatUsageFlags usageFlags) const override;
+    void deallocate(UMatData* data) const override;
+
+    uint64_t allocations() const;
+
+    /**
+     * Install the counter as the process-wide default Mat allocator
+     */
+    static CountingMatAllocator& install();
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_COUNTINGMATALLOCATOR_H
@@ -0,0 +1,174 @@
+#include "DetectionScheduler.h"
+
+DetectionScheduler::DetectionScheduler() : m_interval(m_options.minInterval) {}
+
+void DetectionScheduler::configure(const DetectionOptions& options, size_t workers) {
+    lock_guard<mutex> lock(m_mutex);
+
+    m_options = options;
+    m_options.minInterval = max(m_options.minInterval, 1u);
+    m_options.maxInterval = max(m_options.maxInterval, m_options.minInterval);
+    m_workers = max<size_t>(workers, 1);
+    m_interval = m_options.minInterval;
+}
+
+void DetectionScheduler::frameArrived() {
+    auto now = chrono::steady_clock::now();
+
+    lock_guard<mutex> lock(m_mutex);
+    if (m_lastArrival.time_since_epoch().count()) {
+        auto ns = chrono::duration_cast<chrono::nanoseconds>(now - m_lastArrival).count();
+
+        // a pause in the stream says nothing about the frame rate
+        if (ns < 1000000000)
+            smooth(m_frameInterval, ns);
+    }
+    m_lastArrival = now;
+}
+
+DetectionScheduler::Action DetectionScheduler::plan(uint64_t seq, const Mat& small, Mat& thumb, vector<Track>& tracks) {
+    resize(small, thumb, c_thumbSize, 0, 0, INTER_AREA);
+
+    lock_guard<mutex> lock(m_mutex);
+
+    auto cut = sceneChanged(seq, thumb);
+    auto due = seq >= m_lastDetect + m_interval;
+
+    // the claim keeps the other workers tracking until this detection lands
+    if (!m_detected || m_detectNext || cut || due) {
+        m_lastDetect = seq;
+        m_detectNext = false;
+        return Action::Detect;
+    }
+
+    tracks = m_tracks;
+    return Action::Track;
+}
+
+bool DetectionScheduler::sceneChanged(uint64_t seq, const Mat& thumb) {
+    if (seq < m_thumbSeq)
+        return false;
+
+    auto changed = false;
+    if (!m_lastThumb.empty() && m_lastThumb.size() == thumb.size()) {
+        absdiff(thumb, m_lastThumb, m_diff);
+        changed = mean(m_diff)[0] > m_options.sceneThreshold;
+    }
+
+    thumb.copyTo(m_lastThumb);
+    m_thumbSeq = seq;
+
+    if (changed)
+        m_sceneChanges++;
+
+    return changed;
+}
+
+void DetectionScheduler::detected(uint64_t seq, const Mat& small, const vector<Rect>& faces, uint64_t ns) {
+    vector<Track> tracks;
+    tracks.reserve(faces.size());
+
+    // cloned so the patches outlive the worker's buffer and can be shared read-only
+    auto bounds = Rect(0, 0, small.cols, small.rows);
+    for (auto& face : faces) {
+        auto box = face & bounds;
+        if (box.area() > 0)
+            tracks.push_back({box, small(box).clone()});
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    smooth(m_detectCost, ns);
+    adapt();
+
+    m_detected = true;
+    if (seq < m_detectSeq)
+        return;
+
+    m_tracks = std::move(tracks);
+    m_detectSeq = seq;
+    m_trackSeq = seq;
+}
+
+bool DetectionScheduler::track(const Mat& small, vector<Track>& tracks, Mat& scratch) const {
+    auto bounds = Rect(0, 0, small.cols, small.rows);
+
+    for (auto& track : tracks) {
+        auto& box = track.box;
+
+        // faces move little between frames, half their size in every direction is plenty
+        auto window = Rect(box.x - box.width / 2, box.y - box.height / 2, box.width * 2, box.height * 2) & bounds;
+        if (window.width < track.patch.cols || window.height < track.patch.rows)
+            return false;
+
+        matchTemplate(small(window), track.patch, scratch, TM_CCOEFF_NORMED);
+
+        double score;
+        Point at;
+        minMaxLoc(scratch, nullptr, &score, nullptr, &at);
+
+        if (score < c_minMatch)
+            return false;
+
+        box.x = window.x + at.x;
+        box.y = window.y + at.y;
+    }
+
+    return true;
+}
+
+void DetectionScheduler::tracked(uint64_t seq, const vector<Track>& tracks, bool lost, uint64_t ns) {
+    lock_guard<mutex> lock(m_mutex);
+    smooth(m_trackCost, ns);
+    adapt();
+
+    if (lost) {
+        m_lostTracks++;
+        m_detectNext = true;
+        return;
+    }
+
+    if (seq <= m_trackSeq)
+        return;
+
+    m_tracks = tracks;
+    m_trackSeq = seq;
+}
+
+void DetectionScheduler::prepared(uint64_t ns) {
+    lock_guard<mutex> lock(m_mutex);
+    smooth(m_prepareCost, ns);
+}
+
+void DetectionScheduler::adapt() {
+    if (!m_frameInterval || !m_detectCost) {
+        m_interval = m_options.minInterval;
+        return;
+    }
+
+    // over N frames one detection and N-1 trackings have to fit into N per-frame budgets
+    auto budget = m_options.targetLoad * m_workers * m_frameInterval - m_prepareCost;
+    if (budget <= m_trackCost) {
+        m_interval = m_options.maxInterval;
+        return;
+    }
+
+    auto n = ceil((m_detectCost - m_trackCost) / (budget - m_trackCost));
+    m_interval = static_cast<unsigned int>(clamp<double>(n, m_options.minInterval, m_options.maxInterval));
+}
+
+void DetectionScheduler::smooth(double& average, double sample) const {
+    average = average ? average + (sample - average) * c_smoothing : sample;
+}
+
+unsigned int DetectionScheduler::interval() const {
+    lock_guard<mutex> lock(m_mutex);
+    return m_interval;
+}
+
+uint64_t DetectionScheduler::sceneChanges() const {
+    return m_sceneChanges;
+}
+
+uint64_t DetectionScheduler::lostTracks() const {
+    return m_lostTracks;
+}
@@ -0,0 +1,144 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_DETECTIONSCHEDULER_H
+#define MEETING_SDK_LINUX_SAMPLE_DETECTIONSCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+using namespace std;
+
+struct DetectionOptions {
+    // full detection runs at least every maxInterval frames and at most every minInterval
+    unsigned int minInterval = 2;
+    unsigned int maxInterval = 30;
+
+    // mean absolute difference between frame thumbnails, in gray levels, that counts as a cut
+    double sceneThreshold = 12;
+
+    // share of the workers' time that detection and tracking may take
+    double targetLoad = 0.5;
+};
+
+/**
+ * Decides per frame whether a frame worker runs the full face detector or only follows
+ * the faces found last time.
+ *
+ * Detection runs every N frames, on a scene change and after a face got lost. In between
+ * each face is followed by matching its patch from the last detection in a window around
+ * where it was, which costs a fraction of a cascade pass. N follows the measured costs: it
+ * is the smallest interval at which detection and tracking together stay within targetLoad
+ * of the time the workers have per frame.
+ *
+ * Workers finish frames out of order, so every update carries its frame number and older
+ * results never replace newer ones.
+ */
+class DetectionScheduler {
+public:
+    struct Track {
+        Rect box;
+        // the face as the detector saw it, never written after the detection
+        Mat patch;
+    };
+
+    enum class Action {
+        Detect,
+        Track
+    };
+
+private:
+    const Size c_thumbSize{64, 36};
+    const double c_minMatch = 0.5;
+    // weight of a new sample in the moving averages
+    const double c_smoothing = 0.1;
+
+    DetectionOptions m_options;
+    size_t m_workers = 1;
+
+    mutable mutex m_mutex;
+
+    vector<Track> m_tracks;
+    uint64_t m_detectSeq = 0;
+    uint64_t m_trackSeq = 0;
+    bool m_detected = false;
+    bool m_detectNext = true;
+    uint64_t m_lastDetect = 0;
+
+    Mat m_lastThumb;
+    Mat m_diff;
+    uint64_t m_thumbSeq = 0;
+
+    // moving averages in nanoseconds
+    double m_frameInterval = 0;
+    double m_detectCost = 0;
+    double m_trackCost = 0;
+    double m_prepareCost = 0;
+    chrono::steady_clock::time_point m_lastArrival;
+    unsigned int m_interval;
+
+    atomic<uint64_t> m_sceneChanges{0};
+    atomic<uint64_t> m_lostTracks{0};
+
+    bool sceneChanged(uint64_t seq, const Mat& thumb);
+    void adapt();
+    void smooth(double& average, double sample) const;
+
+public:
+    DetectionScheduler();
+
+    /**
+     * @param workers number of frame workers sharing the scheduler
+     */
+    void configure(const DetectionOptions& options, size_t workers);
+
+    /**
+     * Note the arrival of a frame to follow the frame rate; called from the SDK thread
+     */
+    void frameArrived();
+
+    /**
+     * Choose the work for a frame
+     * @param seq frame number
+     * @param small the downscaled grayscale frame detection would run on
+     * @param thumb scratch owned by the caller
+     * @param tracks receives the faces to follow when the answer is Track
+     */
+    Action plan(uint64_t seq, const Mat& small, Mat& thumb, vector<Track>& tracks);
+
+    /**
+     * Start following the faces a detection found
+     * @param ns time the detection took
+     */
+    void detected(uint64_t seq, const Mat& small, const vector<Rect>& faces, uint64_t ns);
+
+    /**
+     * Move the tracks to where their faces are in the frame
+     * @param scratch match scores, owned by the caller
+     * @return false if a face was lost
+     */
+    bool track(const Mat& small, vector<Track>& tracks, Mat& scratch) const;
+
+    /**
+     * Keep the tracks a worker followed; a lost face makes the next frame run detection
+     * @param ns time the tracking took
+     */
+    void tracked(uint64_t seq, const vector<Track>& tracks, bool lost, uint64_t ns);
+
+    /**
+     * Report the time spent on the steps every frame goes through
+     */
+    void prepared(uint64_t ns);
+
+    unsigned int interval() const;
+    uint64_t sceneChanges() const;
+    uint64_t lostTracks() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_DETECTIONSCHEDULER_H
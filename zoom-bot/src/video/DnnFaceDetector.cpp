@@ -0,0 +1,149 @@
+#include "DnnFaceDetector.h"
+
+#include "../util/Log.h"
+#include "../util/ThreadRoles.h"
+
+DnnFaceDetector::DnnFaceDetector(const DetectorOptions& options, dnn::Net net)
+    : m_options(options), m_name(Detector::dnn + "/" + options.target), m_net(std::move(net)) {
+    m_options.batch = max(m_options.batch, 1u);
+    m_thread = thread(&DnnFaceDetector::run, this);
+}
+
+DnnFaceDetector::~DnnFaceDetector() {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_queued.notify_all();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+unique_ptr<DnnFaceDetector> DnnFaceDetector::load(const DetectorOptions& options) {
+    if (options.model.empty()) {
+        Log::error("the dnn face detector needs a model");
+        return nullptr;
+    }
+
+    dnn::Net net;
+    try {
+        net = dnn::readNet(options.model, options.config);
+    } catch (const cv::Exception& e) {
+        Log::error("failed to read face detection model " + options.model + ": " + e.what());
+        return nullptr;
+    }
+
+    if (net.empty()) {
+        Log::error("failed to read face detection model " + options.model);
+        return nullptr;
+    }
+
+    // an unavailable target makes OpenCV run the layers on the CPU instead
+    if (options.target == Detector::opencl) {
+        net.setPreferableBackend(dnn::DNN_BACKEND_OPENCV);
+        net.setPreferableTarget(dnn::DNN_TARGET_OPENCL);
+    } else if (options.target == Detector::openvino) {
+        net.setPreferableBackend(dnn::DNN_BACKEND_INFERENCE_ENGINE);
+        net.setPreferableTarget(dnn::DNN_TARGET_CPU);
+    } else if (options.target == Detector::cuda || options.target == Detector::cudaFp16) {
+        net.setPreferableBackend(dnn::DNN_BACKEND_CUDA);
+        net.setPreferableTarget(options.target == Detector::cuda ? dnn::DNN_TARGET_CUDA : dnn::DNN_TARGET_CUDA_FP16);
+    } else {
+        net.setPreferableBackend(dnn::DNN_BACKEND_OPENCV);
+        net.setPreferableTarget(dnn::DNN_TARGET_CPU);
+    }
+
+    return make_unique<DnnFaceDetector>(options, std::move(net));
+}
+
+bool DnnFaceDetector::detect(const Mat& image, vector<Rect>& faces) {
+    Request request{&image, &faces};
+
+    unique_lock<mutex> lock(m_mutex);
+    if (!m_running)
+        return false;
+
+    m_queue.push_back(&request);
+    m_queued.notify_one();
+
+    m_finished.wait(lock, [&request] { return request.done; });
+    return request.ok;
+}
+
+void DnnFaceDetector::run() {
+    ThreadRoles::assign(ThreadRole::VideoWorker);
+
+    unique_lock<mutex> lock(m_mutex);
+
+    while (true) {
+        m_queued.wait(lock, [this] { return !m_running || !m_queue.empty(); });
+        if (m_queue.empty())
+            return;
+
+        m_batch.clear();
+        while (!m_queue.empty() && m_batch.size() < m_options.batch) {
+            m_batch.push_back(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        lock.unlock();
+        auto ok = infer();
+        lock.lock();
+
+        for (auto* request : m_batch) {
+            request->ok = ok;
+            request->done = true;
+        }
+        m_finished.notify_all();
+    }
+}
+
+bool DnnFaceDetector::infer() {
+    m_images.resize(m_batch.size());
+    for (size_t i = 0; i < m_batch.size(); i++) {
+        m_batch[i]->faces->clear();
+        cvtColor(*m_batch[i]->image, m_images[i], COLOR_GRAY2BGR);
+    }
+
+    Mat out;
+    try {
+        auto size = static_cast<int>(m_options.inputSize);
+        dnn::blobFromImages(m_images, m_blob, 1.0, Size(size, size), c_mean, false, false);
+        m_net.setInput(m_blob);
+        out = m_net.forward();
+    } catch (const cv::Exception& e) {
+        Log::error(string("face detection failed: ") + e.what());
+        return false;
+    }
+
+    // one row per detection of the whole batch: image, class, confidence and the corners
+    // relative to the image size
+    auto* rows = out.ptr<float>();
+    auto count = out.total() / 7;
+
+    for (size_t i = 0; i < count; i++) {
+        auto* row = rows + i * 7;
+
+        auto index = static_cast<int>(row[0]);
+        if (index < 0 || index >= static_cast<int>(m_batch.size()) || row[2] < m_options.confidence)
+            continue;
+
+        if (m_options.classId >= 0 && static_cast<int>(row[1]) != m_options.classId)
+            continue;
+
+        auto& image = *m_batch[index]->image;
+        auto left = cvRound(row[3] * image.cols), top = cvRound(row[4] * image.rows);
+        auto right = cvRound(row[5] * image.cols), bottom = cvRound(row[6] * image.rows);
+
+        auto box = Rect(left, top, right - left, bottom - top) & Rect(0, 0, image.cols, image.rows);
+        if (box.area() > 0)
+            m_batch[index]->faces->push_back(box);
+    }
+
+    return true;
+}
+
+const string& DnnFaceDetector::name() const {
+    return m_name;
+}
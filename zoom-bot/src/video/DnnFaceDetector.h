@@ -0,0 +1,67 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_DNNFACEDETECTOR_H
+#define MEETING_SDK_LINUX_SAMPLE_DNNFACEDETECTOR_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <opencv2/dnn.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "FaceDetector.h"
+
+/**
+ * cv::dnn network behind a single inference thread.
+ *
+ * Callers queue their frame and wait. The thread takes everything that queued up while
+ * the last inference ran, up to the batch size, and puts it through the network in one
+ * call, so several streams or workers detecting at the same time share a forward pass
+ * instead of running one each. Nothing waits for a batch to fill.
+ */
+class DnnFaceDetector : public FaceDetector {
+    struct Request {
+        const Mat* image;
+        vector<Rect>* faces;
+        bool done = false;
+        bool ok = false;
+    };
+
+    // mean of the res10 face model's training images, per BGR channel
+    const Scalar c_mean{104, 177, 123};
+
+    DetectorOptions m_options;
+    string m_name;
+    dnn::Net m_net;
+
+    mutex m_mutex;
+    condition_variable m_queued;
+    condition_variable m_finished;
+    deque<Request*> m_queue;
+    bool m_running = true;
+
+    // only touched by the inference thread
+    vector<Request*> m_batch;
+    vector<Mat> m_images;
+    Mat m_blob;
+
+    thread m_thread;
+
+    void run();
+    bool infer();
+
+public:
+    DnnFaceDetector(const DetectorOptions& options, dnn::Net net);
+    ~DnnFaceDetector();
+
+    bool detect(const Mat& image, vector<Rect>& faces) override;
+    const string& name() const override;
+
+    /**
+     * Read the network and bind it to the configured target
+     * @return nullptr if the model cannot be read
+     */
+    static unique_ptr<DnnFaceDetector> load(const DetectorOptions& options);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_DNNFACEDETECTOR_H
@@ -0,0 +1,161 @@
+#include "FFmpegVideoEncoder.h"
+
+#include <sstream>
+
+extern char** environ;
+
+FFmpegVideoEncoder::FFmpegVideoEncoder(const string& backend, const string& vaapiDevice) :
+        m_backend(backend), m_vaapiDevice(vaapiDevice) {}
+
+FFmpegVideoEncoder::~FFmpegVideoEncoder() {
+    close();
+}
+
+vector<string> FFmpegVideoEncoder::arguments(const string& path, unsigned int width, unsigned int height, double fps) const {
+    stringstream size, rate;
+    size << width << "x" << height;
+    rate << fps;
+
+    vector<string> args = {"ffmpeg", "-hide_banner", "-loglevel", "error", "-nostdin"};
+
+    if (m_backend == Encoder::vaapi)
+        args.insert(args.end(), {"-vaapi_device", m_vaapiDevice});
+
+    args.insert(args.end(), {
+        "-f", "rawvideo", "-pix_fmt", "yuv420p",
+        "-video_size", size.str(), "-framerate", rate.str(),
+        "-i", "pipe:0"
+    });
+
+    if (m_backend == Encoder::vaapi)
+        args.insert(args.end(), {"-vf", "format=nv12,hwupload", "-c:v", "h264_vaapi"});
+    else if (m_backend == Encoder::nvenc)
+        args.insert(args.end(), {"-c:v", "h264_nvenc", "-preset", "p4"});
+    else
+        args.insert(args.end(), {"-c:v", "libx264", "-preset", "veryfast", "-pix_fmt", "yuv420p"});
+
+    // a keyframe every two seconds starts a fragment, so a killed encoder loses at most
+    // the fragment in flight instead of the index of the whole file
+    auto ext = path.substr(path.rfind('.') + 1);
+    if (ext == "mp4" || ext == "mov" || ext == "m4v") {
+        stringstream gop;
+        gop << static_cast<int>(fps * 2);
+        args.insert(args.end(), {"-g", gop.str(), "-movflags", "+frag_keyframe+empty_moov+default_base_moof"});
+    }
+
+    args.insert(args.end(), {"-an", "-y", path});
+
+    return args;
+}
+
+bool FFmpegVideoEncoder::open(const string& path, unsigned int width, unsigned int height, double fps) {
+    close();
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        Log::error("failed to create encoder pipe");
+        return false;
+    }
+
+    fcntl(fds[1], F_SETPIPE_SZ, c_pipeSize);
+
+    // the child sees the read end as stdin, every other descriptor is close-on-exec
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+
+    auto args = arguments(path, width, height, fps);
+    vector<char*> argv;
+    for (auto& arg : args)
+        argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    auto err = posix_spawnp(&m_pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(fds[0]);
+
+    if (err != 0) {
+        Log::error("failed to start ffmpeg for " + m_backend + " encoding");
+        ::close(fds[1]);
+        m_pid = -1;
+        return false;
+    }
+
+    m_fd = fds[1];
+    return true;
+}
+
+bool FFmpegVideoEncoder::write(const VideoFrame& frame) {
+    if (m_fd == -1)
+        return false;
+
+    if (writeAll(frame.data.get(), frame.len))
+        return true;
+
+    // ffmpeg went away, typically because the device or codec is unusable
+    stringstream ss;
+    ss << "ffmpeg " << m_backend << " encoder exited with status " << reap();
+    Log::error(ss.str());
+
+    return false;
+}
+
+bool FFmpegVideoEncoder::writeAll(const char* buf, size_t len) {
+    while (len > 0) {
+        auto ret = ::write(m_fd, buf, len);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        buf += ret;
+        len -= ret;
+    }
+
+    return true;
+}
+
+int FFmpegVideoEncoder::reap() {
+    if (m_fd != -1) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    if (m_pid == -1)
+        return -1;
+
+    int status = 0;
+    while (waitpid(m_pid, &status, 0) == -1 && errno == EINTR);
+    m_pid = -1;
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+void FFmpegVideoEncoder::close() {
+    // EOF on stdin makes ffmpeg flush its encoder and finalize the container
+    auto status = reap();
+    if (status > 0)
+        Log::error("ffmpeg " + m_backend + " encoder did not finish cleanly");
+}
+
+bool FFmpegVideoEncoder::isOpen() const {
+    return m_fd != -1;
+}
+
+const string& FFmpegVideoEncoder::name() const {
+    return m_backend;
+}
+
+bool FFmpegVideoEncoder::available() {
+    auto* path = getenv("PATH");
+    if (!path)
+        return false;
+
+    stringstream dirs(path);
+    string dir;
+    while (getline(dirs, dir, ':'))
+        if (!dir.empty() && access((dir + "/ffmpeg").c_str(), X_OK) == 0)
+            return true;
+
+    return false;
+}
@@ -0,0 +1,51 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_FFMPEGVIDEOENCODER_H
+#define MEETING_SDK_LINUX_SAMPLE_FFMPEGVIDEOENCODER_H
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "VideoEncoder.h"
+#include "../util/Log.h"
+
+/**
+ * Streams raw I420 frames into an ffmpeg child over a pipe.
+ *
+ * The planes go to ffmpeg exactly as the SDK produced them, and ffmpeg uploads them to
+ * VAAPI or NVENC, or encodes them with libx264 on the CPU. No colour conversion happens in
+ * the bot.
+ */
+class FFmpegVideoEncoder : public VideoEncoder {
+    // larger than the default 64KiB so a 720p frame leaves in a few writes
+    const int c_pipeSize = 1024 * 1024;
+
+    string m_backend;
+    string m_vaapiDevice;
+
+    pid_t m_pid = -1;
+    int m_fd = -1;
+
+    vector<string> arguments(const string& path, unsigned int width, unsigned int height, double fps) const;
+    bool writeAll(const char* buf, size_t len);
+    int reap();
+
+public:
+    FFmpegVideoEncoder(const string& backend, const string& vaapiDevice);
+    ~FFmpegVideoEncoder();
+
+    bool open(const string& path, unsigned int width, unsigned int height, double fps) override;
+    bool write(const VideoFrame& frame) override;
+    void close() override;
+
+    bool isOpen() const override;
+    const string& name() const override;
+
+    /**
+     * @return true if an ffmpeg binary is on the PATH
+     */
+    static bool available();
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_FFMPEGVIDEOENCODER_H
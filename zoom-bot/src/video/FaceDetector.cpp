@@ -0,0 +1,40 @@
+#include "FaceDetector.h"
+
+#include <map>
+#include <mutex>
+
+#include "DnnFaceDetector.h"
+#include "HaarFaceDetector.h"
+#include "../util/Log.h"
+
+shared_ptr<FaceDetector> FaceDetector::shared(const DetectorOptions& options) {
+    static mutex loadMutex;
+    static map<string, shared_ptr<FaceDetector>> detectors;
+
+    auto key = options.backend == Detector::dnn
+        ? options.backend + ":" + options.model + ":" + options.config + ":" + options.target
+        : options.backend + ":" + options.cascade;
+
+    lock_guard<mutex> lock(loadMutex);
+
+    auto it = detectors.find(key);
+    if (it != detectors.end())
+        return it->second;
+
+    shared_ptr<FaceDetector> detector;
+    if (options.backend == Detector::dnn) {
+        detector = DnnFaceDetector::load(options);
+        if (!detector)
+            Log::error("falling back to the haar face detector");
+    }
+
+    if (!detector)
+        detector = HaarFaceDetector::load(options.cascade);
+
+    if (detector)
+        Log::info("detecting faces with " + detector->name());
+
+    // a failed load is remembered too, it would fail the same way for every stream
+    detectors.emplace(key, detector);
+    return detector;
+}
@@ -0,0 +1,69 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_FACEDETECTOR_H
+#define MEETING_SDK_LINUX_SAMPLE_FACEDETECTOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace Detector {
+    const string haar = "haar";
+    const string dnn = "dnn";
+
+    const string cpu = "cpu";
+    const string opencl = "opencl";
+    const string openvino = "openvino";
+    const string cuda = "cuda";
+    const string cudaFp16 = "cuda-fp16";
+}
+
+struct DetectorOptions {
+    string backend = Detector::haar;
+    string cascade = "/usr/share/opencv4/haarcascades/haarcascade_frontalface_default.xml";
+
+    // SSD-style network reporting DetectionOutput rows, e.g. the res10 face model
+    string model;
+    // network description, empty if the model file carries it
+    string config;
+    string target = Detector::cpu;
+
+    float confidence = 0.5f;
+    // class to report, -1 for every class, e.g. 15 for people with MobileNet-SSD
+    int classId = -1;
+    // frames of all streams that go through the network together
+    unsigned int batch = 4;
+    unsigned int inputSize = 300;
+};
+
+/**
+ * Finds faces or people in grayscale frames, shared by every frame worker of every video
+ * stream in the process
+ */
+class FaceDetector {
+public:
+    virtual ~FaceDetector() {};
+
+    /**
+     * Detect in one frame; safe to call from any number of threads at once
+     * @param image 8-bit grayscale frame
+     * @param faces receives the boxes in image coordinates
+     * @return false if the frame could not be processed
+     */
+    virtual bool detect(const Mat& image, vector<Rect>& faces) = 0;
+
+    virtual const string& name() const = 0;
+
+    /**
+     * The detector for these options, loaded on first use and kept for the life of the
+     * process so later meetings and streams reuse the model. A dnn model that fails to
+     * load falls back to the cascade.
+     * @return nullptr if no backend could be loaded
+     */
+    static shared_ptr<FaceDetector> shared(const DetectorOptions& options);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_FACEDETECTOR_H
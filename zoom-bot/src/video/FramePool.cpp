@@ -0,0 +1,92 @@
+#include "FramePool.h"
+
+FramePool::FramePool(size_t limit) : m_limit(limit) {}
+
+FramePool::Key FramePool::key(unsigned int width, unsigned int height) {
+    return (static_cast<Key>(width) << 32) | height;
+}
+
+unique_ptr<VideoFrame> FramePool::acquire(unsigned int width, unsigned int height, size_t bytes) {
+    unique_ptr<VideoFrame> frame;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_inUse == m_limit) {
+            m_exhausted.fetch_add(1, memory_order_relaxed);
+            return nullptr;
+        }
+
+        auto& free = m_free[key(width, height)];
+        if (!free.empty()) {
+            frame = std::move(free.back());
+            free.pop_back();
+        }
+
+        m_inUse++;
+    }
+
+    if (frame && frame->capacity >= bytes) {
+        m_hits.fetch_add(1, memory_order_relaxed);
+    } else {
+        if (!frame)
+            frame = make_unique<VideoFrame>();
+
+        frame->data = make_unique<char[]>(bytes);
+        frame->capacity = bytes;
+        m_allocations.fetch_add(1, memory_order_relaxed);
+    }
+
+    frame->len = bytes;
+    frame->width = width;
+    frame->height = height;
+
+    return frame;
+}
+
+void FramePool::release(unique_ptr<VideoFrame> frame) {
+    if (!frame)
+        return;
+
+    lock_guard<mutex> lock(m_mutex);
+    m_inUse--;
+
+    // frames of a resolution that is no longer current are simply freed
+    auto k = key(frame->width, frame->height);
+    if (m_current && k != m_current)
+        return;
+
+    auto& free = m_free[k];
+    if (free.capacity() < m_limit)
+        free.reserve(m_limit);
+
+    free.push_back(std::move(frame));
+}
+
+void FramePool::setResolution(unsigned int width, unsigned int height) {
+    lock_guard<mutex> lock(m_mutex);
+
+    m_current = key(width, height);
+    for (auto it = m_free.begin(); it != m_free.end();) {
+        if (it->first != m_current)
+            it = m_free.erase(it);
+        else
+            ++it;
+    }
+}
+
+void FramePool::trim() {
+    lock_guard<mutex> lock(m_mutex);
+    m_free.clear();
+    m_current = 0;
+}
+
+uint64_t FramePool::hits() const {
+    return m_hits.load(memory_order_relaxed);
+}
+
+uint64_t FramePool::allocations() const {
+    return m_allocations.load(memory_order_relaxed);
+}
+
+uint64_t FramePool::exhausted() const {
+    return m_exhausted.load(memory_order_relaxed);
+}
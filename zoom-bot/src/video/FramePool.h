@@ -0,0 +1,77 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_FRAMEPOOL_H
+#define MEETING_SDK_LINUX_SAMPLE_FRAMEPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A copy of one I420 frame that outlives the SDK callback
+ */
+struct VideoFrame {
+    unique_ptr<char[]> data;
+    size_t capacity = 0;
+    size_t len = 0;
+
+    unsigned int width = 0;
+    unsigned int height = 0;
+
+    uint64_t seq = 0;
+};
+
+/**
+ * Bounded pool of frame buffers keyed by resolution, shared by the SDK callback and the
+ * frame workers. After warm-up every acquire() is served from a free list; the counters
+ * make it visible when that stops being true.
+ */
+class FramePool {
+    typedef uint64_t Key;
+
+    mutex m_mutex;
+    unordered_map<Key, vector<unique_ptr<VideoFrame>>> m_free;
+    Key m_current = 0;
+
+    size_t m_limit;
+    size_t m_inUse = 0;
+
+    atomic<uint64_t> m_hits{0};
+    atomic<uint64_t> m_allocations{0};
+    atomic<uint64_t> m_exhausted{0};
+
+    static Key key(unsigned int width, unsigned int height);
+
+public:
+    explicit FramePool(size_t limit);
+
+    /**
+     * Take a buffer for a frame of the given resolution
+     * @return a frame buffer, or nullptr once every buffer is in flight
+     */
+    unique_ptr<VideoFrame> acquire(unsigned int width, unsigned int height, size_t bytes);
+
+    /**
+     * Return a buffer to the free list for its resolution
+     */
+    void release(unique_ptr<VideoFrame> frame);
+
+    /**
+     * Make a resolution current and free the buffers cached for any other one
+     */
+    void setResolution(unsigned int width, unsigned int height);
+
+    /**
+     * Free every cached buffer, e.g. while raw data is off
+     */
+    void trim();
+
+    uint64_t hits() const;
+    uint64_t allocations() const;
+    uint64_t exhausted() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_FRAMEPOOL_H
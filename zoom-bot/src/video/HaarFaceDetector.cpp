@@ -0,0 +1,57 @@
+#include "HaarFaceDetector.h"
+
+#include "../util/Log.h"
+
+HaarFaceDetector::HaarFaceDetector(const string& file) : m_file(file) {}
+
+unique_ptr<HaarFaceDetector> HaarFaceDetector::load(const string& file) {
+    auto cascade = make_unique<CascadeClassifier>();
+    if (!cascade->load(file)) {
+        Log::error("failed to load cascade file " + file);
+        return nullptr;
+    }
+
+    auto detector = make_unique<HaarFaceDetector>(file);
+    detector->release(std::move(cascade));
+
+    return detector;
+}
+
+unique_ptr<CascadeClassifier> HaarFaceDetector::acquire() {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_idle.empty()) {
+            auto cascade = std::move(m_idle.back());
+            m_idle.pop_back();
+            return cascade;
+        }
+    }
+
+    auto cascade = make_unique<CascadeClassifier>();
+    if (!cascade->load(m_file))
+        return nullptr;
+
+    return cascade;
+}
+
+void HaarFaceDetector::release(unique_ptr<CascadeClassifier> cascade) {
+    lock_guard<mutex> lock(m_mutex);
+    m_idle.push_back(std::move(cascade));
+}
+
+bool HaarFaceDetector::detect(const Mat& image, vector<Rect>& faces) {
+    auto cascade = acquire();
+    if (!cascade) {
+        faces.clear();
+        return false;
+    }
+
+    cascade->detectMultiScale(image, faces, 1.1, 2, 0|CASCADE_SCALE_IMAGE, Size(30, 30));
+    release(std::move(cascade));
+
+    return true;
+}
+
+const string& HaarFaceDetector::name() const {
+    return Detector::haar;
+}
@@ -0,0 +1,35 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_HAARFACEDETECTOR_H
+#define MEETING_SDK_LINUX_SAMPLE_HAARFACEDETECTOR_H
+
+#include <mutex>
+
+#include <opencv2/objdetect.hpp>
+
+#include "FaceDetector.h"
+
+/**
+ * Haar cascade on the CPU. A cascade cannot run two frames at once, so each concurrent
+ * caller borrows its own copy, and copies are loaded only as concurrency grows.
+ */
+class HaarFaceDetector : public FaceDetector {
+    string m_file;
+
+    mutex m_mutex;
+    vector<unique_ptr<CascadeClassifier>> m_idle;
+
+    unique_ptr<CascadeClassifier> acquire();
+    void release(unique_ptr<CascadeClassifier> cascade);
+
+public:
+    explicit HaarFaceDetector(const string& file);
+
+    bool detect(const Mat& image, vector<Rect>& faces) override;
+    const string& name() const override;
+
+    /**
+     * @return nullptr if the cascade file cannot be loaded
+     */
+    static unique_ptr<HaarFaceDetector> load(const string& file);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_HAARFACEDETECTOR_H
@@ -0,0 +1,105 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_I420VIEW_H
+#define MEETING_SDK_LINUX_SAMPLE_I420VIEW_H
+
+#include <cstddef>
+#include <cstring>
+
+#include <opencv2/core.hpp>
+
+#include "zoom_sdk_raw_data_def.h"
+
+#include "FramePool.h"
+
+using namespace cv;
+using namespace std;
+using namespace ZOOMSDK;
+
+/**
+ * One plane of an I420 frame, wherever its bytes live
+ */
+struct PlaneView {
+    uchar* data = nullptr;
+    int width = 0;
+    int height = 0;
+    size_t stride = 0;
+
+    /**
+     * A Mat header over the plane, without copying; the Y plane is the grayscale image
+     */
+    Mat mat() const { return Mat(height, width, CV_8UC1, data, stride); }
+
+    size_t bytes() const { return static_cast<size_t>(width) * height; }
+
+    void copyTo(uchar* dst) const {
+        if (stride == static_cast<size_t>(width)) {
+            memcpy(dst, data, bytes());
+            return;
+        }
+
+        for (int row = 0; row < height; row++)
+            memcpy(dst + row * width, data + row * stride, width);
+    }
+};
+
+/**
+ * The three planes of an I420 frame, either as the SDK hands them out or as a frame of
+ * the pool keeps them, one after another
+ */
+struct I420View {
+    PlaneView y;
+    PlaneView u;
+    PlaneView v;
+
+    size_t bytes() const { return y.bytes() + u.bytes() + v.bytes(); }
+
+    /**
+     * Pack the planes into one buffer of bytes(), the only copy a frame takes
+     */
+    void copyTo(char* dst) const {
+        auto* out = reinterpret_cast<uchar*>(dst);
+        y.copyTo(out);
+        u.copyTo(out + y.bytes());
+        v.copyTo(out + y.bytes() + u.bytes());
+    }
+
+    /**
+     * The planes of a frame still owned by the SDK, valid for the duration of its callback
+     */
+    static I420View of(YUVRawDataI420* data) {
+        int width = data->GetStreamWidth(), height = data->GetStreamHeight();
+        int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+
+        return {
+            {reinterpret_cast<uchar*>(data->GetYBuffer()), width, height, static_cast<size_t>(width)},
+            {reinterpret_cast<uchar*>(data->GetUBuffer()), chromaWidth, chromaHeight, static_cast<size_t>(chromaWidth)},
+            {reinterpret_cast<uchar*>(data->GetVBuffer()), chromaWidth, chromaHeight, static_cast<size_t>(chromaWidth)}
+        };
+    }
+
+    /**
+     * The planes of a pooled frame, which is writable, e.g. to draw into
+     */
+    static I420View of(const VideoFrame& frame) {
+        int width = frame.width, height = frame.height;
+        int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+
+        auto* base = reinterpret_cast<uchar*>(frame.data.get());
+        auto luma = static_cast<size_t>(width) * height;
+        auto chroma = static_cast<size_t>(chromaWidth) * chromaHeight;
+
+        return {
+            {base, width, height, static_cast<size_t>(width)},
+            {base + luma, chromaWidth, chromaHeight, static_cast<size_t>(chromaWidth)},
+            {base + luma + chroma, chromaWidth, chromaHeight, static_cast<size_t>(chromaWidth)}
+        };
+    }
+
+    /**
+     * Size of a packed frame of this resolution
+     */
+    static size_t bytes(unsigned int width, unsigned int height) {
+        return static_cast<size_t>(width) * height + 2 * static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+    }
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_I420VIEW_H
@@ -0,0 +1,27 @@
+#include "OpenCVVideoEncoder.h"
+
+bool OpenCVVideoEncoder::open(const string& path, unsigned int width, unsigned int height, double fps) {
+    int fourcc = VideoWriter::fourcc('a','v','c','1');
+    return m_writer.open(path, fourcc, fps, Size(width, height), true);
+}
+
+bool OpenCVVideoEncoder::write(const VideoFrame& frame) {
+    Mat i420(frame.height * 3/2, frame.width, CV_8UC1, frame.data.get());
+    cvtColor(i420, m_bgr, COLOR_YUV2BGR_I420);
+    m_writer.write(m_bgr);
+
+    return true;
+}
+
+void OpenCVVideoEncoder::close() {
+    if (m_writer.isOpened())
+        m_writer.release();
+}
+
+bool OpenCVVideoEncoder::isOpen() const {
+    return m_writer.isOpened();
+}
+
+const string& OpenCVVideoEncoder::name() const {
+    return Encoder::opencv;
+}
@@ -0,0 +1,27 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_OPENCVVIDEOENCODER_H
+#define MEETING_SDK_LINUX_SAMPLE_OPENCVVIDEOENCODER_H
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "VideoEncoder.h"
+
+using namespace cv;
+
+/**
+ * CPU fallback through cv::VideoWriter, which needs the frame as BGR
+ */
+class OpenCVVideoEncoder : public VideoEncoder {
+    VideoWriter m_writer;
+    Mat m_bgr;
+
+public:
+    bool open(const string& path, unsigned int width, unsigned int height, double fps) override;
+    bool write(const VideoFrame& frame) override;
+    void close() override;
+
+    bool isOpen() const override;
+    const string& name() const override;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_OPENCVVIDEOENCODER_H
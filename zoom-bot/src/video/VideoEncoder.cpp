@@ -0,0 +1,36 @@
+#include "VideoEncoder.h"
+
+#include <unistd.h>
+
+#include "FFmpegVideoEncoder.h"
+#include "OpenCVVideoEncoder.h"
+
+unique_ptr<VideoEncoder> VideoEncoder::create(const string& backend, const string& vaapiDevice) {
+    if (backend == Encoder::opencv)
+        return make_unique<OpenCVVideoEncoder>();
+
+    return make_unique<FFmpegVideoEncoder>(backend, vaapiDevice);
+}
+
+vector<string> VideoEncoder::chain(const string& backend, const string& vaapiDevice) {
+    vector<string> backends;
+
+    if (FFmpegVideoEncoder::available()) {
+        if (backend == Encoder::automatic) {
+            // only offer hardware that is actually mapped into the container
+            if (access(vaapiDevice.c_str(), R_OK | W_OK) == 0)
+                backends.push_back(Encoder::vaapi);
+            if (access("/dev/nvidia0", R_OK | W_OK) == 0)
+                backends.push_back(Encoder::nvenc);
+        } else if (backend != Encoder::opencv && backend != Encoder::x264) {
+            backends.push_back(backend);
+        }
+
+        if (backend != Encoder::opencv)
+            backends.push_back(Encoder::x264);
+    }
+
+    backends.push_back(Encoder::opencv);
+
+    return backends;
+}
@@ -0,0 +1,64 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_VIDEOENCODER_H
+#define MEETING_SDK_LINUX_SAMPLE_VIDEOENCODER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FramePool.h"
+
+using namespace std;
+
+namespace Encoder {
+    const string automatic = "auto";
+    const string vaapi = "vaapi";
+    const string nvenc = "nvenc";
+    const string x264 = "x264";
+    const string opencv = "opencv";
+}
+
+/**
+ * Backend that turns I420 frames into a video file
+ */
+class VideoEncoder {
+public:
+    virtual ~VideoEncoder() {};
+
+    /**
+     * Open the output file
+     * @param path output file path
+     * @param width frame width in pixels
+     * @param height frame height in pixels
+     * @param fps nominal frame rate
+     * @return true if the encoder is ready for frames
+     */
+    virtual bool open(const string& path, unsigned int width, unsigned int height, double fps) = 0;
+
+    /**
+     * Encode one frame of the size passed to open()
+     * @param frame contiguous I420 planes
+     * @return false if the encoder failed and should be replaced
+     */
+    virtual bool write(const VideoFrame& frame) = 0;
+
+    /**
+     * Flush pending frames and finalize the container
+     */
+    virtual void close() = 0;
+
+    virtual bool isOpen() const = 0;
+    virtual const string& name() const = 0;
+
+    /**
+     * Create an encoder by backend name
+     * @param backend one of the Encoder names
+     */
+    static unique_ptr<VideoEncoder> create(const string& backend, const string& vaapiDevice);
+
+    /**
+     * Backends to try in order for a configured backend, hardware first and CPU last
+     */
+    static vector<string> chain(const string& backend, const string& vaapiDevice);
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_VIDEOENCODER_H
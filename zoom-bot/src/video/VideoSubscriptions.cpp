@@ -0,0 +1,234 @@
+#include "VideoSubscriptions.h"
+
+VideoSubscriptions::VideoSubscriptions(IMeetingParticipantsController* participants, const SubscriptionOptions& options,
+                                       const Configure& configure)
+    : m_options(options), m_participants(participants), m_configure(configure) {
+    m_options.maxStreams = max<size_t>(m_options.maxStreams, 1);
+}
+
+VideoSubscriptions::~VideoSubscriptions() {
+    stop();
+}
+
+bool VideoSubscriptions::start() {
+    m_active = true;
+    fill();
+
+    auto* list = m_participants->GetParticipantsList();
+    auto others = 0;
+    for (int i = 0; list && i < list->GetCount(); i++)
+        others += !isSelf(list->GetItem(i));
+
+    if (m_streams.empty() && !others)
+        Log::info("no participant video yet, subscribing as participants join");
+
+    return !m_streams.empty() || !others;
+}
+
+void VideoSubscriptions::stop() {
+    for (auto& [userId, stream] : m_streams) {
+        stream.renderer->unSubscribe();
+        destroyRenderer(stream.renderer);
+    }
+
+    m_streams.clear();
+    m_speaker = 0;
+    m_active = false;
+}
+
+void VideoSubscriptions::release() {
+    for (auto& [userId, stream] : m_streams)
+        destroyRenderer(stream.renderer);
+
+    m_streams.clear();
+    m_speaker = 0;
+    m_active = false;
+
+    // user IDs are only valid within their meeting, and the next one names its first file again
+    m_delegates.clear();
+    m_named = false;
+}
+
+void VideoSubscriptions::joined(const vector<unsigned int>& userIds) {
+    if (m_active)
+        fill();
+}
+
+void VideoSubscriptions::left(const vector<unsigned int>& userIds) {
+    for (auto id : userIds) {
+        unsubscribe(id);
+        m_delegates.erase(id);
+    }
+
+    // someone who did not fit before may get the free stream
+    if (m_active)
+        fill();
+}
+
+void VideoSubscriptions::speaking(const vector<unsigned int>& userIds) {
+    auto it = find_if(userIds.begin(), userIds.end(), [this](unsigned int id) { return !isSelf(id); });
+    if (it == userIds.end())
+        return;
+
+    auto id = *it;
+    auto now = chrono::steady_clock::now();
+
+    auto stream = m_streams.find(id);
+    if (stream != m_streams.end())
+        stream->second.lastSpoke = now;
+
+    if (id == m_speaker || !m_active)
+        return;
+
+    if (m_speaker && now - m_speakerSince < m_options.hold)
+        return;
+
+    auto previous = m_speaker;
+    m_speaker = id;
+
+    if (stream == m_streams.end()) {
+        if (m_streams.size() >= m_options.maxStreams)
+            evictFor(id);
+
+        if (!subscribe(id)) {
+            m_speaker = previous;
+            return;
+        }
+    }
+
+    // the previous speaker has just been talking, so it is the last to lose its stream
+    auto last = m_streams.find(previous);
+    if (last != m_streams.end())
+        last->second.lastSpoke = now;
+
+    m_speakerSince = now;
+    applyResolutions();
+}
+
+void VideoSubscriptions::fill() {
+    auto* list = m_participants->GetParticipantsList();
+
+    for (int i = 0; list && i < list->GetCount() && m_streams.size() < m_options.maxStreams; i++) {
+        auto id = list->GetItem(i);
+        if (!m_streams.count(id) && !isSelf(id))
+            subscribe(id);
+    }
+
+    applyResolutions();
+}
+
+bool VideoSubscriptions::subscribe(unsigned int userId) {
+    // until someone talks, the first participant counts as the speaker
+    if (!m_speaker) {
+        m_speaker = userId;
+        m_speakerSince = chrono::steady_clock::now();
+    }
+
+    auto& target = delegate(userId);
+    auto resolution = userId == m_speaker ? m_options.speaker : m_options.others;
+
+    IZoomSDKRenderer* renderer = nullptr;
+    auto err = createRenderer(&renderer, &target);
+    if (err != SDKERR_SUCCESS) {
+        Log::error("failed to create a video renderer for user " + to_string(userId) + " with status " + to_string(err));
+        return false;
+    }
+
+    renderer->setRawDataResolution(resolution);
+    err = renderer->subscribe(userId, RAW_DATA_TYPE_VIDEO);
+    if (err != SDKERR_SUCCESS) {
+        Log::error("failed to subscribe to the video of user " + to_string(userId) + " with status " + to_string(err));
+        destroyRenderer(renderer);
+
+        if (m_speaker == userId)
+            m_speaker = 0;
+        return false;
+    }
+
+    m_streams[userId] = {renderer, resolution, {}};
+
+    Log::info("receiving the video of user " + to_string(userId) + " at " + Resolution::name(resolution) +
+              ", writing to " + target.dir() + "/" + target.filename());
+    return true;
+}
+
+void VideoSubscriptions::unsubscribe(unsigned int userId) {
+    auto it = m_streams.find(userId);
+    if (it == m_streams.end())
+        return;
+
+    it->second.renderer->unSubscribe();
+    destroyRenderer(it->second.renderer);
+    m_streams.erase(it);
+
+    if (m_speaker == userId)
+        m_speaker = 0;
+}
+
+void VideoSubscriptions::evictFor(unsigned int userId) {
+    auto oldest = m_streams.end();
+    for (auto it = m_streams.begin(); it != m_streams.end(); ++it) {
+        if (oldest == m_streams.end() || it->second.lastSpoke < oldest->second.lastSpoke)
+            oldest = it;
+    }
+
+    if (oldest == m_streams.end())
+        return;
+
+    Log::info("user " + to_string(oldest->first) + " gives up its video stream to user " + to_string(userId));
+
+    // the delegate stays, its file continues if the participant gets a stream again
+    oldest->second.renderer->unSubscribe();
+    destroyRenderer(oldest->second.renderer);
+    m_streams.erase(oldest);
+}
+
+void VideoSubscriptions::applyResolutions() {
+    for (auto& [userId, stream] : m_streams) {
+        auto resolution = userId == m_speaker ? m_options.speaker : m_options.others;
+        if (resolution == stream.resolution)
+            continue;
+
+        auto err = stream.renderer->setRawDataResolution(resolution);
+        if (err != SDKERR_SUCCESS) {
+            Log::error("failed to switch the video of user " + to_string(userId) + " to " + Resolution::name(resolution));
+            continue;
+        }
+
+        Log::info("receiving the video of user " + to_string(userId) + " at " + Resolution::name(resolution));
+        stream.resolution = resolution;
+    }
+}
+
+ZoomSDKRendererDelegate& VideoSubscriptions::delegate(unsigned int userId) {
+    auto it = m_delegates.find(userId);
+    if (it != m_delegates.end())
+        return *it->second;
+
+    auto created = make_unique<ZoomSDKRendererDelegate>();
+    m_configure(*created);
+
+    // the first participant keeps the configured name, everyone after gets their ID added
+    if (m_named) {
+        auto name = created->filename();
+        auto dot = name.rfind('.');
+        auto suffix = "-" + to_string(userId);
+        created->setFilename(dot == string::npos ? name + suffix : name.substr(0, dot) + suffix + name.substr(dot));
+    }
+    m_named = true;
+
+    return *m_delegates.emplace(userId, std::move(created)).first->second;
+}
+
+bool VideoSubscriptions::isSelf(unsigned int userId) const {
+    auto* user = m_participants->GetUserByUserID(userId);
+    return user && user->IsMySelf();
+}
+
+bool VideoSubscriptions::isActive() const {
+    return m_active;
+}
+
+size_t VideoSubscriptions::size() const {
+    return m_streams.size();
+}
@@ -0,0 +1,145 @@
+#ifndef MEETING_SDK_LINUX_SAMPLE_VIDEOSUBSCRIPTIONS_H
+#define MEETING_SDK_LINUX_SAMPLE_VIDEOSUBSCRIPTIONS_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zoom_sdk_def.h"
+#include "rawdata/zoom_rawdata_api.h"
+#include "rawdata/rawdata_renderer_interface.h"
+#include "meeting_service_components/meeting_participants_ctrl_interface.h"
+
+#include "../raw_record/ZoomSDKRendererDelegate.h"
+
+using namespace std;
+using namespace ZOOMSDK;
+
+namespace Resolution {
+    const string p90 = "90p";
+    const string p180 = "180p";
+    const string p360 = "360p";
+    const string p720 = "720p";
+    const string p1080 = "1080p";
+
+    inline ZoomSDKResolution parse(const string& name) {
+        if (name == p90) return ZoomSDKResolution_90P;
+        if (name == p180) return ZoomSDKResolution_180P;
+        if (name == p360) return ZoomSDKResolution_360P;
+        if (name == p1080) return ZoomSDKResolution_1080P;
+        return ZoomSDKResolution_720P;
+    }
+
+    inline const string& name(ZoomSDKResolution resolution) {
+        switch (resolution) {
+            case ZoomSDKResolution_90P: return p90;
+            case ZoomSDKResolution_180P: return p180;
+            case ZoomSDKResolution_360P: return p360;
+            case ZoomSDKResolution_1080P: return p1080;
+            default: return p720;
+        }
+    }
+}
+
+struct SubscriptionOptions {
+    // participants whose video is received at once
+    size_t maxStreams = 1;
+
+    ZoomSDKResolution speaker = ZoomSDKResolution_720P;
+    ZoomSDKResolution others = ZoomSDKResolution_180P;
+
+    // the speaker keeps the large stream at least this long, so crosstalk does not flap it
+    chrono::milliseconds hold{2000};
+};
+
+/**
+ * Raw video of several participants, each through its own renderer and delegate.
+ *
+ * The active speaker is received at the speaker resolution and everyone else as a
+ * thumbnail, which keeps decoding and face detection affordable for a whole gallery.
+ * Resolutions follow the speaker as it changes. When there are more participants than
+ * streams, a new speaker takes the stream of whoever spoke longest ago.
+ *
+ * A delegate outlives its subscription, so a participant whose stream comes back keeps
+ * writing the same file; it is only closed when the participant leaves. All calls come
+ * from the SDK's main loop.
+ */
+class VideoSubscriptions {
+public:
+    typedef function<void(ZoomSDKRendererDelegate& delegate)> Configure;
+
+private:
+    struct Stream {
+        IZoomSDKRenderer* renderer = nullptr;
+        ZoomSDKResolution resolution = ZoomSDKResolution_NoUse;
+        chrono::steady_clock::time_point lastSpoke;
+    };
+
+    SubscriptionOptions m_options;
+    IMeetingParticipantsController* m_participants;
+    Configure m_configure;
+
+    bool m_active = false;
+    map<unsigned int, Stream> m_streams;
+    map<unsigned int, unique_ptr<ZoomSDKRendererDelegate>> m_delegates;
+    bool m_named = false;
+
+    unsigned int m_speaker = 0;
+    chrono::steady_clock::time_point m_speakerSince;
+
+    bool subscribe(unsigned int userId);
+    void unsubscribe(unsigned int userId);
+    void fill();
+    void applyResolutions();
+    void evictFor(unsigned int userId);
+    ZoomSDKRendererDelegate& delegate(unsigned int userId);
+    bool isSelf(unsigned int userId) const;
+
+public:
+    /**
+     * @param configure sets up each new delegate before its first frame
+     */
+    VideoSubscriptions(IMeetingParticipantsController* participants, const SubscriptionOptions& options,
+                       const Configure& configure);
+    ~VideoSubscriptions();
+
+    VideoSubscriptions(const VideoSubscriptions&) = delete;
+    VideoSubscriptions& operator=(const VideoSubscriptions&) = delete;
+
+    /**
+     * Subscribe to the participants in the meeting, up to the stream limit
+     * @return false if no stream could be subscribed while there was someone to receive
+     */
+    bool start();
+
+    /**
+     * Unsubscribe every stream and keep the delegates for a later start()
+     */
+    void stop();
+
+    /**
+     * Forget the renderers of a meeting that ended, the SDK has dropped them already
+     */
+    void release();
+
+    void joined(const vector<unsigned int>& userIds);
+
+    /**
+     * Drop the streams of participants who left and close their files
+     */
+    void left(const vector<unsigned int>& userIds);
+
+    /**
+     * Give the large stream to the first of these who is not the bot
+     * @param userIds everyone talking right now
+     */
+    void speaking(const vector<unsigned int>& userIds);
+
+    bool isActive() const;
+    size_t size() const;
+};
+
+#endif //MEETING_SDK_LINUX_SAMPLE_VIDEOSUBSCRIPTIONS_H